@@ -0,0 +1,29 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in uint drawId;
+layout (location = 0) out vec3 vColor;
+
+layout (location = 0) uniform mat4 uViewProj;
+
+struct Object {
+  vec4 rotation;
+  vec4 translationScale;
+  vec4 color;
+};
+
+layout (binding = 0, std430) readonly buffer Objects {
+  Object object[];
+} uObjects;
+
+vec3 rotate(vec4 q, vec3 v) {
+  return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+  Object o = uObjects.object[drawId];
+  vec3 p = rotate(o.rotation, position * o.translationScale.w) + o.translationScale.xyz;
+
+  gl_Position = uViewProj * vec4(p, 1.0);
+  vColor = o.color.rgb * (0.6 + 0.4 * normalize(position).y);
+}
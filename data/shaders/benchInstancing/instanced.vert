@@ -0,0 +1,27 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+layout (location = 0) out vec3 vColor;
+
+layout (location = 0) uniform mat4 uViewProj;
+
+struct Instance {
+  vec4 rotation;
+  vec4 translationScale;
+};
+
+layout (binding = 0, std430) readonly buffer Instances {
+  Instance instance[];
+} uInstances;
+
+vec3 rotate(vec4 q, vec3 v) {
+  return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+  Instance i = uInstances.instance[gl_InstanceID];
+  vec3 p = rotate(i.rotation, position * i.translationScale.w) + i.translationScale.xyz;
+
+  gl_Position = uViewProj * vec4(p, 1.0);
+  vColor = abs(normalize(position)) * (0.5 + 0.5 * fract(float(gl_InstanceID) * 0.618034));
+}
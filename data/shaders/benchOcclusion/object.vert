@@ -0,0 +1,23 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+layout (location = 0) out vec3 vColor;
+
+layout (location = 0) uniform mat4 uViewProj;
+layout (location = 1) uniform uint uObject;
+
+struct Object {
+  mat4 model;
+  vec4 color;
+};
+
+layout (binding = 0, std430) readonly buffer Objects {
+  Object object[];
+} uObjects;
+
+void main() {
+  Object o = uObjects.object[uObject];
+
+  gl_Position = uViewProj * o.model * vec4(position, 1.0);
+  vColor = o.color.rgb * (0.7 + 0.3 * position.y);
+}
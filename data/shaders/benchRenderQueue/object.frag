@@ -0,0 +1,14 @@
+#version 450
+
+layout (location = 0) in vec2 vTexCoord;
+layout (location = 0) out vec4 fColor;
+
+layout (binding = 0) uniform sampler2D uImage;
+
+layout (binding = 1, std140) uniform Material {
+  vec4 color;
+} uMaterial;
+
+void main() {
+  fColor = uMaterial.color * texture(uImage, vTexCoord);
+}
@@ -0,0 +1,13 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+layout (location = 0) out vec2 vTexCoord;
+
+layout (binding = 0, std140) uniform ObjectData {
+  mat4 mvp;
+} uObject;
+
+void main() {
+  gl_Position = uObject.mvp * vec4(position, 1.0);
+  vTexCoord = position.xy * 0.5 + 0.5;
+}
@@ -0,0 +1,18 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 texcoord;
+layout (location = 2) in vec3 normal;
+layout (location = 0) out vec2 vTexCoord;
+layout (location = 1) out vec3 vNormal;
+
+layout (location = 0) uniform mat4 uViewProj;
+layout (location = 1) uniform vec2 uGrid;
+
+void main() {
+  vec2 cell = vec2(gl_InstanceID % int(uGrid.y), gl_InstanceID / int(uGrid.y)) * uGrid.x;
+
+  gl_Position = uViewProj * vec4(position + vec3(cell.x, 0.0, cell.y), 1.0);
+  vTexCoord = texcoord;
+  vNormal = normal;
+}
@@ -0,0 +1,27 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 texcoord;
+layout (location = 2) in vec2 normal;
+layout (location = 0) out vec2 vTexCoord;
+layout (location = 1) out vec3 vNormal;
+
+layout (location = 0) uniform mat4 uViewProj;
+layout (location = 1) uniform vec2 uGrid;
+layout (location = 2) uniform vec3 uPositionOffset;
+layout (location = 3) uniform vec3 uPositionScale;
+
+vec3 decodeNormal(vec2 f) {
+  vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+  float t = clamp(-n.z, 0.0, 1.0);
+  n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+  return normalize(n);
+}
+
+void main() {
+  vec2 cell = vec2(gl_InstanceID % int(uGrid.y), gl_InstanceID / int(uGrid.y)) * uGrid.x;
+
+  gl_Position = uViewProj * vec4(uPositionOffset + position * uPositionScale + vec3(cell.x, 0.0, cell.y), 1.0);
+  vTexCoord = texcoord;
+  vNormal = decodeNormal(normal);
+}
@@ -0,0 +1,12 @@
+#version 450
+
+layout (location = 0) in vec2 vTexCoord;
+layout (location = 1) in vec3 vNormal;
+layout (location = 0) out vec4 fColor;
+
+void main() {
+  vec3 n = normalize(vNormal);
+  float checker = mod(floor(vTexCoord.x * 64.0) + floor(vTexCoord.y * 16.0), 2.0);
+
+  fColor = vec4((n * 0.5 + 0.5) * (0.75 + 0.25 * checker), 1.0);
+}
@@ -0,0 +1,169 @@
+#version 450
+
+layout (location = 0) out vec4 fColor;
+
+layout (location = 0) uniform mat4 uInvProj;
+
+layout (binding = 0) uniform sampler2D uAlbedoSpecular;
+layout (binding = 1) uniform sampler2D uNormalPower;
+layout (binding = 2) uniform sampler2D uDepth;
+
+layout (binding = 0, std140) uniform CameraData {
+  mat4 mvp;
+  mat4 normal;
+  mat4 world;
+  vec4 eye;
+  int numPointLights;
+  int numSpotLights;
+} uCamera;
+
+struct Material {
+  float specularIntensity;
+  float specularPower;
+};
+
+const float MAX_SPECULAR_POWER_LOG2 = 10.0;
+
+vec3 gWorldPos;
+Material gMaterial;
+
+layout (binding = 2, std140) uniform DirectionalLight {
+  vec4 color;
+  vec4 direction;
+  float ambientIntensity;
+  float diffuseIntensity;
+} uSun;
+
+struct PointLight {
+  vec4 color;
+  vec4 position;
+  float ambientIntensity;
+  float diffuseIntensity;
+  float attenuationConstant;
+  float attenuationLinear;
+  float attenuationExponential;
+};
+
+layout (binding = 0, std430) readonly buffer PointLights {
+  PointLight light[];
+} uPointLights;
+
+struct SpotLight {
+  vec4 color;
+  vec4 position;
+  vec4 direction;
+  float ambientIntensity;
+  float diffuseIntensity;
+  float attenuationConstant;
+  float attenuationLinear;
+  float attenuationExponential;
+  float cutoff;
+};
+
+layout (binding = 1, std430) readonly buffer SpotLights {
+  SpotLight light[];
+} uSpotLights;
+
+vec3 calcLight(in vec3 color, in float ambientIntensity, in float diffuseIntensity, in vec3 direction, in vec3 normal) {
+  vec3 ambientColor = color * ambientIntensity;
+  float diffuseFactor = dot(normal, -direction);
+  vec3 diffuseColor = vec3(0.0);
+  vec3 specularColor = vec3(0.0);
+
+  if (diffuseFactor > 0.0) {
+    diffuseColor = color * diffuseIntensity * diffuseFactor;
+
+    vec3 vertexToEye = normalize(uCamera.eye.xyz - gWorldPos);
+    vec3 lightReflect = normalize(reflect(direction, normal));
+    float specularFactor = dot(vertexToEye, lightReflect);
+
+    if (specularFactor > 0.0) {
+      specularFactor = pow(specularFactor, gMaterial.specularPower);
+      specularColor = color * gMaterial.specularIntensity * specularFactor;
+    }
+  }
+
+  return ambientColor + diffuseColor + specularColor;
+}
+
+vec3 calcDirectionalLight(in vec3 normal) {
+  return calcLight(uSun.color.rgb, uSun.ambientIntensity, uSun.diffuseIntensity, uSun.direction.xyz, normal);
+}
+
+vec3 calcPointLight(
+    in vec3 color, in vec3 position, 
+    in float ambientIntensity, in float diffuseIntensity, 
+    in float attenuationConstant, in float attenuationLinear, in float attenuationExponential, 
+    in vec3 normal) {
+
+  vec3 lightDirection = gWorldPos - position;
+  float distance = length(lightDirection);
+
+  lightDirection = normalize(lightDirection);
+
+  vec3 result = calcLight(color, ambientIntensity, diffuseIntensity, lightDirection, normal);
+  float attenuation = attenuationConstant + attenuationLinear * distance + attenuationExponential * distance * distance;
+
+  return result / attenuation;
+}
+
+vec3 calcSpotLight(
+    in vec3 color, in vec3 position, in vec3 direction,
+    in float ambientIntensity, in float diffuseIntensity, 
+    in float attenuationConstant, in float attenuationLinear, in float attenuationExponential,
+    in float cutoff, 
+    in vec3 normal) {
+
+  vec3 lightToPixel = normalize(gWorldPos - position);
+  float spotFactor = dot(lightToPixel, direction);
+  if (spotFactor > cutoff) {
+    vec3 result = calcPointLight(color, position, ambientIntensity, diffuseIntensity, attenuationConstant, attenuationLinear, attenuationExponential, normal);
+    return result * (1.0 - (1.0 - spotFactor) * 1.0 / (1.0 - cutoff));
+  } else {
+    return vec3(0.0);
+  }
+}
+
+vec3 decodeNormal(in vec2 f) {
+  f = f * 2.0 - 1.0;
+
+  vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+  float t = clamp(-n.z, 0.0, 1.0);
+
+  n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+
+  return normalize(n);
+}
+
+void main() {
+  ivec2 texel = ivec2(gl_FragCoord.xy);
+  float depth = texelFetch(uDepth, texel, 0).r;
+
+  if (depth >= 1.0) {
+    discard;
+  }
+
+  vec4 albedoSpecular = texelFetch(uAlbedoSpecular, texel, 0);
+  vec4 normalPower = texelFetch(uNormalPower, texel, 0);
+  vec4 ndc = vec4(vec3(gl_FragCoord.xy / vec2(textureSize(uDepth, 0)), depth) * 2.0 - 1.0, 1.0);
+  vec4 position = uInvProj * ndc;
+
+  gWorldPos = position.xyz / position.w;
+  gMaterial.specularIntensity = albedoSpecular.a;
+  gMaterial.specularPower = exp2(normalPower.b * MAX_SPECULAR_POWER_LOG2);
+
+  vec3 normal = decodeNormal(normalPower.rg);
+  vec3 totalLight = calcDirectionalLight(normal);
+
+  for (int i = 0; i < uCamera.numPointLights; i++) {
+    PointLight light = uPointLights.light[i];
+    totalLight += calcPointLight(light.color.rgb, light.position.xyz, light.ambientIntensity, light.diffuseIntensity, light.attenuationConstant, light.attenuationLinear, light.attenuationExponential, normal);
+  }
+
+  for (int i = 0; i < uCamera.numSpotLights; i++) {
+    SpotLight light = uSpotLights.light[i];
+    totalLight += calcSpotLight(light.color.rgb, light.position.xyz, light.direction.xyz, light.ambientIntensity, light.diffuseIntensity, light.attenuationConstant, light.attenuationLinear, light.attenuationExponential, light.cutoff, normal);
+  }
+
+  fColor = vec4(albedoSpecular.rgb * totalLight, 1.0);
+}
@@ -0,0 +1,38 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+
+// Must decode exactly like lighting.vert for the GL_EQUAL shading pass.
+layout (location = 0) uniform vec3 uPositionOffset;
+layout (location = 1) uniform vec3 uPositionScale;
+
+layout (binding = 0, std140) uniform CameraData {
+  mat4 mvp;
+  mat4 normal;
+  mat4 world;
+  vec4 eye;
+  int numPointLights;
+  int numSpotLights;
+} uCamera;
+
+struct Instance {
+  vec4 rotation;
+  vec4 translationScale;
+};
+
+layout (binding = 3, std430) readonly buffer Instances {
+  Instance instance[];
+} uInstances;
+
+vec3 rotate(vec4 q, vec3 v) {
+  return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+invariant gl_Position;
+
+void main() {
+  Instance i = uInstances.instance[gl_InstanceID];
+  vec3 p = rotate(i.rotation, (uPositionOffset + position * uPositionScale) * i.translationScale.w) + i.translationScale.xyz;
+
+  gl_Position = uCamera.mvp * vec4(p, 1.0);
+}
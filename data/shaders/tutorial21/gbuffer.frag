@@ -0,0 +1,35 @@
+#version 450
+
+layout (location = 0) in vec2 vTexCoord;
+layout (location = 1) in vec3 vNormal;
+layout (location = 2) in vec3 vWorldPos;
+layout (location = 0) out vec4 gAlbedoSpecular;
+layout (location = 1) out vec4 gNormalPower;
+
+layout (binding = 0) uniform sampler2D uImage;
+
+layout (binding = 1, std140) uniform Material {
+  float specularIntensity;
+  float specularPower;
+} uMaterial;
+
+const float MAX_SPECULAR_POWER_LOG2 = 10.0;
+
+vec2 octWrap(in vec2 v) {
+  return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 encodeNormal(in vec3 n) {
+  n /= abs(n.x) + abs(n.y) + abs(n.z);
+  n.xy = n.z >= 0.0 ? n.xy : octWrap(n.xy);
+
+  return n.xy * 0.5 + 0.5;
+}
+
+void main() {
+  vec3 normal = normalize(vNormal);
+  float power = clamp(log2(max(uMaterial.specularPower, 1.0)) / MAX_SPECULAR_POWER_LOG2, 0.0, 1.0);
+
+  gAlbedoSpecular = vec4(texture(uImage, vTexCoord).rgb, uMaterial.specularIntensity);
+  gNormalPower = vec4(encodeNormal(normal), power, 0.0);
+}
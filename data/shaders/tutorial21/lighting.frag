@@ -0,0 +1,136 @@
+#version 450
+
+layout (location = 0) in vec2 vTexCoord;
+layout (location = 1) in vec3 vNormal;
+layout (location = 2) in vec3 vWorldPos;
+layout (location = 0) out vec4 fColor;
+
+uniform sampler2D uImage;
+
+layout (binding = 0, std140) uniform CameraData {
+  mat4 mvp;
+  mat4 normal;
+  mat4 world;
+  vec4 eye;
+  int numPointLights;
+  int numSpotLights;
+} uCamera;
+
+layout (binding = 1, std140) uniform Material {
+  float specularIntensity;
+  float specularPower;
+} uMaterial;
+
+layout (binding = 2, std140) uniform DirectionalLight {
+  vec4 color;
+  vec4 direction;
+  float ambientIntensity;
+  float diffuseIntensity;
+} uSun;
+
+struct PointLight {
+  vec4 color;
+  vec4 position;
+  float ambientIntensity;
+  float diffuseIntensity;
+  float attenuationConstant;
+  float attenuationLinear;
+  float attenuationExponential;
+};
+
+layout (binding = 0, std430) readonly buffer PointLights {
+  PointLight light[];
+} uPointLights;
+
+struct SpotLight {
+  vec4 color;
+  vec4 position;
+  vec4 direction;
+  float ambientIntensity;
+  float diffuseIntensity;
+  float attenuationConstant;
+  float attenuationLinear;
+  float attenuationExponential;
+  float cutoff;
+};
+
+layout (binding = 1, std430) readonly buffer SpotLights {
+  SpotLight light[];
+} uSpotLights;
+
+vec3 calcLight(in vec3 color, in float ambientIntensity, in float diffuseIntensity, in vec3 direction, in vec3 normal) {
+  vec3 ambientColor = color * ambientIntensity;
+  float diffuseFactor = dot(normal, -direction);
+  vec3 diffuseColor = vec3(0.0);
+  vec3 specularColor = vec3(0.0);
+
+  if (diffuseFactor > 0.0) {
+    diffuseColor = color * diffuseIntensity * diffuseFactor;
+
+    vec3 vertexToEye = normalize(uCamera.eye.xyz - vWorldPos);
+    vec3 lightReflect = normalize(reflect(direction, normal));
+    float specularFactor = dot(vertexToEye, lightReflect);
+
+    if (specularFactor > 0.0) {
+      specularFactor = pow(specularFactor, uMaterial.specularPower);
+      specularColor = color * uMaterial.specularIntensity * specularFactor;
+    }
+  }
+
+  return ambientColor + diffuseColor + specularColor;
+}
+
+vec3 calcDirectionalLight(in vec3 normal) {
+  return calcLight(uSun.color.rgb, uSun.ambientIntensity, uSun.diffuseIntensity, uSun.direction.xyz, normal);
+}
+
+vec3 calcPointLight(
+    in vec3 color, in vec3 position, 
+    in float ambientIntensity, in float diffuseIntensity, 
+    in float attenuationConstant, in float attenuationLinear, in float attenuationExponential, 
+    in vec3 normal) {
+
+  vec3 lightDirection = vWorldPos - position;
+  float distance = length(lightDirection);
+
+  lightDirection = normalize(lightDirection);
+
+  vec3 result = calcLight(color, ambientIntensity, diffuseIntensity, lightDirection, normal);
+  float attenuation = attenuationConstant + attenuationLinear * distance + attenuationExponential * distance * distance;
+
+  return result / attenuation;
+}
+
+vec3 calcSpotLight(
+    in vec3 color, in vec3 position, in vec3 direction,
+    in float ambientIntensity, in float diffuseIntensity, 
+    in float attenuationConstant, in float attenuationLinear, in float attenuationExponential,
+    in float cutoff, 
+    in vec3 normal) {
+
+  vec3 lightToPixel = normalize(vWorldPos - position);
+  float spotFactor = dot(lightToPixel, direction);
+  if (spotFactor > cutoff) {
+    vec3 result = calcPointLight(color, position, ambientIntensity, diffuseIntensity, attenuationConstant, attenuationLinear, attenuationExponential, normal);
+    return result * (1.0 - (1.0 - spotFactor) * 1.0 / (1.0 - cutoff));
+  } else {
+    return vec3(0.0);
+  }
+}
+
+void main() {
+  vec3 normal = normalize(vNormal);
+  vec3 totalLight = calcDirectionalLight(normal);
+
+  for (int i = 0; i < uCamera.numPointLights; i++) {
+    PointLight light = uPointLights.light[i];
+    totalLight += calcPointLight(light.color.rgb, light.position.xyz, light.ambientIntensity, light.diffuseIntensity, light.attenuationConstant, light.attenuationLinear, light.attenuationExponential, normal);
+  }
+
+  for (int i = 0; i < uCamera.numSpotLights; i++) {
+    SpotLight light = uSpotLights.light[i];
+    totalLight += calcSpotLight(light.color.rgb, light.position.xyz, light.direction.xyz, light.ambientIntensity, light.diffuseIntensity, light.attenuationConstant, light.attenuationLinear, light.attenuationExponential, light.cutoff, normal);
+  }
+
+  fColor = texture(uImage, vTexCoord) * vec4(totalLight, 1.0);
+}
@@ -0,0 +1,54 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 texcoord;
+layout (location = 2) in vec2 normal;
+layout (location = 0) out vec2 vTexCoord;
+layout (location = 1) out vec3 vNormal;
+layout (location = 2) out vec3 vWorldPos;
+
+// Positions arrive as UNORM16 over the mesh bounds.
+layout (location = 0) uniform vec3 uPositionOffset;
+layout (location = 1) uniform vec3 uPositionScale;
+
+layout (binding = 0, std140) uniform CameraData {
+  mat4 mvp;
+  mat4 normal;
+  mat4 world;
+  vec4 eye;
+  int numPointLights;
+  int numSpotLights;
+} uCamera;
+
+struct Instance {
+  vec4 rotation;
+  vec4 translationScale;
+};
+
+layout (binding = 3, std430) readonly buffer Instances {
+  Instance instance[];
+} uInstances;
+
+vec3 rotate(vec4 q, vec3 v) {
+  return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// Octahedral decode of the SNORM16 normal.
+vec3 decodeNormal(vec2 f) {
+  vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+  float t = clamp(-n.z, 0.0, 1.0);
+  n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+  return normalize(n);
+}
+
+invariant gl_Position;
+
+void main() {
+  Instance i = uInstances.instance[gl_InstanceID];
+  vec3 p = rotate(i.rotation, (uPositionOffset + position * uPositionScale) * i.translationScale.w) + i.translationScale.xyz;
+
+  gl_Position = uCamera.mvp * vec4(p, 1.0);
+  vTexCoord = texcoord;
+  vNormal = mat3(uCamera.normal) * rotate(i.rotation, decodeNormal(normal));
+  vWorldPos = (uCamera.world * vec4(p, 1.0)).xyz;
+}
@@ -0,0 +1,9 @@
+#version 450
+
+layout (location = 0) out vec4 fColor;
+
+const float OVERDRAW_SCALE = 1.0 / 8.0;
+
+void main() {
+  fColor = vec4(OVERDRAW_SCALE, OVERDRAW_SCALE * 0.5, OVERDRAW_SCALE * 0.25, 1.0);
+}
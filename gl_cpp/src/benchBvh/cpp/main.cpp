@@ -0,0 +1,340 @@
+/**
+ * benchBvh - BVH scene index build and query benchmark
+ *
+ * Scatters boxes of mixed sizes through a field as a gfx::Scene, at 10k, 100k and 1M objects.
+ * For each size it times a build on the calling thread and one across a gfx::ThreadPool, then
+ * the per-frame update after a tenth of the objects move (a refit, or a rebuild once the tree has
+ * degraded), then frustum, ray and sphere queries against brute-force loops over the same bounds.
+ * Every checked query must return exactly what brute force does, and a ray grazing a box along
+ * its edge must hit it.
+ *
+ * Options: --objects N (a single size instead of the sweep), --threads N (default: one per core),
+ * --queries N (default 1000).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "context.hpp"
+#include "frustum_culler.hpp"
+#include "scene.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+    constexpr float FIELD_SIZE = 1000.0F;
+    constexpr float SPHERE_RADIUS = 10.0F;
+    constexpr unsigned int UPDATE_FRAMES = 20;
+    constexpr unsigned int MAX_BRUTE_FORCE_QUERIES = 20;
+
+    struct BenchOptions {
+        std::vector<std::size_t> objects;
+        unsigned int threads;
+        unsigned int queries;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { { 10000, 100000, 1000000 }, 0, 1000 };
+
+        for (int i = 1; i < argc; i++) {
+            if (0 == std::strcmp("--objects", argv[i])) {
+                options.objects = { gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--objects") };
+            } else if (0 == std::strcmp("--threads", argv[i])) {
+                options.threads = static_cast<unsigned int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--threads"));
+            } else if (0 == std::strcmp("--queries", argv[i])) {
+                options.queries = static_cast<unsigned int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--queries"));
+            }
+        }
+
+        if (0 == options.objects.front() || 0 == options.queries) {
+            throw std::runtime_error("Expected at least one object and one query!");
+        }
+
+        return options;
+    }
+
+    struct Query {
+        glm::mat4 viewProj;
+        glm::vec3 origin;
+        glm::vec3 direction;
+    };
+
+    double getMs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+    }
+
+    // The brute-force references repeat the tests the BVH applies at its leaves.
+    void queryFrustumBruteForce(const gfx::Scene& scene, const glm::mat4& viewProj, std::vector<std::uint32_t>& objects) {
+        auto planes = gfx::FrustumCuller::extractPlanes(viewProj);
+
+        for (std::uint32_t i = 0; i < scene.size(); i++) {
+            const auto& bounds = scene.getBounds(i);
+            auto center = (bounds.min + bounds.max) * 0.5F;
+            auto extent = (bounds.max - bounds.min) * 0.5F;
+            auto visible = true;
+
+            for (const auto& plane : planes) {
+                auto normal = glm::vec3(plane);
+                visible = visible && glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), extent) > 0.0F;
+            }
+
+            if (visible) {
+                objects.push_back(i);
+            }
+        }
+    }
+
+    void querySphereBruteForce(const gfx::Scene& scene, const glm::vec3& center, float radius, std::vector<std::uint32_t>& objects) {
+        for (std::uint32_t i = 0; i < scene.size(); i++) {
+            const auto& bounds = scene.getBounds(i);
+            auto offset = center - glm::min(glm::max(center, bounds.min), bounds.max);
+
+            if (glm::dot(offset, offset) <= radius * radius) {
+                objects.push_back(i);
+            }
+        }
+    }
+
+    bool intersectBox(const gfx::Aabb& bounds, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance) {
+        auto exit = maxDistance;
+
+        distance = 0.0F;
+
+        for (int axis = 0; axis < 3; axis++) {
+            if (std::isinf(inverseDirection[axis])) {
+                if (origin[axis] < bounds.min[axis] || origin[axis] > bounds.max[axis]) {
+                    return false;
+                }
+
+                continue;
+            }
+
+            auto t0 = (bounds.min[axis] - origin[axis]) * inverseDirection[axis];
+            auto t1 = (bounds.max[axis] - origin[axis]) * inverseDirection[axis];
+
+            distance = std::max(distance, std::min(t0, t1));
+            exit = std::min(exit, std::max(t0, t1));
+        }
+
+        return distance <= exit;
+    }
+
+    bool intersectRayBruteForce(const gfx::Scene& scene, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, gfx::RayHit& hit) {
+        auto inverseDirection = glm::vec3(1.0F) / direction;
+        auto found = false;
+
+        hit.distance = maxDistance;
+
+        for (std::uint32_t i = 0; i < scene.size(); i++) {
+            auto enter = 0.0F;
+
+            if (intersectBox(scene.getBounds(i), origin, inverseDirection, hit.distance, enter) && (!found || enter < hit.distance)) {
+                hit = { i, enter };
+                found = true;
+            }
+        }
+
+        return found;
+    }
+
+    bool sameObjects(std::vector<std::uint32_t>& a, std::vector<std::uint32_t>& b) {
+        std::sort(a.begin(), a.end());
+        std::sort(b.begin(), b.end());
+
+        return a == b;
+    }
+
+    void printQuery(const char * name, double bvhMs, double bruteForceMs, double results) {
+        std::cout << "  " << std::setw(8) << name << std::setw(12) << bvhMs * 1000.0 << " us per query"
+            << std::setw(12) << bruteForceMs * 1000.0 << " us brute force"
+            << std::setw(10) << bruteForceMs / bvhMs << "x faster"
+            << std::setw(12) << results << " results" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+    auto pThreadPool = std::make_unique<gfx::ThreadPool> (options.threads);
+    auto trProj = glm::perspective(glm::radians(60.0F), 16.0F / 9.0F, 0.1F, FIELD_SIZE * 0.25F);
+
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (auto count : options.objects) {
+        auto pScene = std::make_unique<gfx::Scene> ();
+        auto random = std::mt19937(1234);
+        auto unit = std::uniform_real_distribution<float> (0.0F, 1.0F);
+        auto localBounds = gfx::Aabb { glm::vec3(-1.0F), glm::vec3(1.0F) };
+
+        for (std::size_t i = 0; i < count; i++) {
+            auto center = (glm::vec3(unit(random), unit(random), unit(random)) - 0.5F) * FIELD_SIZE;
+            auto halfSize = glm::vec3(unit(random), unit(random), unit(random)) * 4.0F + 0.25F;
+
+            pScene->add(localBounds, glm::scale(glm::translate(glm::mat4(1.0F), center), halfSize));
+        }
+
+        std::cout << count << " objects" << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        pScene->rebuild();
+        auto serialMs = getMs(start);
+
+        start = std::chrono::steady_clock::now();
+        pScene->rebuild(pThreadPool.get());
+        auto parallelMs = getMs(start);
+
+        std::cout << "  build " << serialMs << " ms on 1 thread, " << parallelMs << " ms on " << pThreadPool->getThreadCount()
+            << " threads, " << pScene->getBvh().getNodes().size() << " nodes, SAH cost " << pScene->getBvh().getSahCost() << std::endl;
+
+        auto updateMs = 0.0;
+        auto rebuilds = 0U;
+        auto moved = std::max(count / 10, std::size_t(1));
+
+        for (unsigned int frame = 0; frame < UPDATE_FRAMES; frame++) {
+            start = std::chrono::steady_clock::now();
+
+            for (std::size_t i = 0; i < moved; i++) {
+                auto object = static_cast<std::uint32_t> ((i * 10 + frame) % pScene->size());
+                auto offset = (glm::vec3(unit(random), unit(random), unit(random)) - 0.5F) * 4.0F;
+
+                pScene->setTransform(object, glm::translate(glm::mat4(1.0F), offset) * pScene->getTransform(object));
+            }
+
+            rebuilds += pScene->update(pThreadPool.get()) ? 1 : 0;
+            updateMs += getMs(start);
+        }
+
+        std::cout << "  update " << updateMs / UPDATE_FRAMES << " ms per frame with " << moved << " moved, " << rebuilds
+            << " rebuilds in " << UPDATE_FRAMES << " frames, SAH cost " << pScene->getBvh().getSahCost()
+            << " (built " << pScene->getBvh().getBuiltSahCost() << ")" << std::endl;
+
+        auto queries = std::vector<Query> (options.queries);
+
+        for (auto& query : queries) {
+            auto yaw = unit(random) * 6.2831853F;
+            auto forward = glm::vec3(std::sin(yaw), unit(random) - 0.5F, -std::cos(yaw));
+
+            query.origin = (glm::vec3(unit(random), unit(random), unit(random)) - 0.5F) * FIELD_SIZE;
+            query.direction = glm::normalize(forward);
+            query.viewProj = trProj * glm::lookAt(query.origin, query.origin + forward, glm::vec3(0.0F, 1.0F, 0.0F));
+        }
+
+        const auto& bvh = pScene->getBvh();
+        auto bruteForceQueries = std::min(options.queries, MAX_BRUTE_FORCE_QUERIES);
+        auto objects = std::vector<std::uint32_t> ();
+        auto reference = std::vector<std::uint32_t> ();
+        auto results = 0.0;
+        auto hit = gfx::RayHit {};
+        auto referenceHit = gfx::RayHit {};
+
+        start = std::chrono::steady_clock::now();
+
+        for (const auto& query : queries) {
+            objects.clear();
+            bvh.queryFrustum(query.viewProj, objects);
+            results += objects.size();
+        }
+
+        auto bvhMs = getMs(start) / options.queries;
+
+        start = std::chrono::steady_clock::now();
+
+        for (unsigned int i = 0; i < bruteForceQueries; i++) {
+            reference.clear();
+            queryFrustumBruteForce(*pScene, queries[i].viewProj, reference);
+        }
+
+        printQuery("frustum", bvhMs, getMs(start) / bruteForceQueries, results / options.queries);
+
+        for (unsigned int i = 0; i < bruteForceQueries; i++) {
+            objects.clear();
+            reference.clear();
+            bvh.queryFrustum(queries[i].viewProj, objects);
+            queryFrustumBruteForce(*pScene, queries[i].viewProj, reference);
+
+            if (!sameObjects(objects, reference)) {
+                std::cerr << "[ERROR]: frustum query " << i << " differs from brute force" << std::endl;
+                return 1;
+            }
+        }
+
+        results = 0.0;
+        start = std::chrono::steady_clock::now();
+
+        for (const auto& query : queries) {
+            results += bvh.intersectRay(query.origin, query.direction, FIELD_SIZE, hit) ? 1 : 0;
+        }
+
+        bvhMs = getMs(start) / options.queries;
+        start = std::chrono::steady_clock::now();
+
+        for (unsigned int i = 0; i < bruteForceQueries; i++) {
+            intersectRayBruteForce(*pScene, queries[i].origin, queries[i].direction, FIELD_SIZE, referenceHit);
+        }
+
+        printQuery("ray", bvhMs, getMs(start) / bruteForceQueries, results / options.queries);
+
+        for (unsigned int i = 0; i < bruteForceQueries; i++) {
+            auto found = bvh.intersectRay(queries[i].origin, queries[i].direction, FIELD_SIZE, hit);
+
+            if (found != intersectRayBruteForce(*pScene, queries[i].origin, queries[i].direction, FIELD_SIZE, referenceHit)
+                    || (found && hit.distance != referenceHit.distance)) {
+                std::cerr << "[ERROR]: ray query " << i << " differs from brute force" << std::endl;
+                return 1;
+            }
+        }
+
+        // Runs along the box's top edge, lying on two of its slab planes, and enters it one unit in.
+        const auto& grazed = pScene->getBounds(0);
+
+        if (!bvh.intersectRay(glm::vec3(grazed.min.x - 1.0F, grazed.max.y, grazed.max.z), glm::vec3(1.0F, 0.0F, 0.0F), FIELD_SIZE, hit)
+                || 1.0F < hit.distance) {
+            std::cerr << "[ERROR]: ray along the edge of object 0 missed it" << std::endl;
+            return 1;
+        }
+
+        results = 0.0;
+        start = std::chrono::steady_clock::now();
+
+        for (const auto& query : queries) {
+            objects.clear();
+            bvh.querySphere(query.origin, SPHERE_RADIUS, objects);
+            results += objects.size();
+        }
+
+        bvhMs = getMs(start) / options.queries;
+        start = std::chrono::steady_clock::now();
+
+        for (unsigned int i = 0; i < bruteForceQueries; i++) {
+            reference.clear();
+            querySphereBruteForce(*pScene, queries[i].origin, SPHERE_RADIUS, reference);
+        }
+
+        printQuery("sphere", bvhMs, getMs(start) / bruteForceQueries, results / options.queries);
+
+        for (unsigned int i = 0; i < bruteForceQueries; i++) {
+            objects.clear();
+            reference.clear();
+            bvh.querySphere(queries[i].origin, SPHERE_RADIUS, objects);
+            querySphereBruteForce(*pScene, queries[i].origin, SPHERE_RADIUS, reference);
+
+            if (!sameObjects(objects, reference)) {
+                std::cerr << "[ERROR]: sphere query " << i << " differs from brute force" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/**
+ * benchFrustumCulling - CPU frustum culling microbenchmark
+ *
+ * Fills gfx::FrustumCuller with a random mix of boxes and spheres and culls them against a
+ * turning camera at 100k, 250k, 500k and 1M objects, once per SIMD level the CPU supports,
+ * on the calling thread alone and partitioned across a gfx::ThreadPool.
+ * Prints the mean time per cull and the visible fraction; every configuration must produce
+ * the same visible list as the scalar single-threaded reference.
+ *
+ * Options: --objects N (a single size instead of the sweep), --threads N (default: one per core),
+ * --iterations N (default 100).
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "frustum_culler.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+    constexpr float FIELD_SIZE = 200.0F;
+
+    struct BenchOptions {
+        std::vector<std::size_t> objects;
+        unsigned int threads;
+        unsigned int iterations;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { { 100000, 250000, 500000, 1000000 }, 0, 100 };
+
+        for (int i = 1; i < argc; i++) {
+            auto hasValue = i + 1 < argc;
+
+            if (0 == std::strcmp("--objects", argv[i]) && hasValue) {
+                options.objects = { std::strtoul(argv[++i], nullptr, 10) };
+            } else if (0 == std::strcmp("--threads", argv[i]) && hasValue) {
+                options.threads = static_cast<unsigned int> (std::strtoul(argv[++i], nullptr, 10));
+            } else if (0 == std::strcmp("--iterations", argv[i]) && hasValue) {
+                options.iterations = static_cast<unsigned int> (std::strtoul(argv[++i], nullptr, 10));
+            }
+        }
+
+        if (0 == options.objects.front() || 0 == options.iterations) {
+            throw std::runtime_error("Expected at least one object and one iteration!");
+        }
+
+        return options;
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+    auto pThreadPool = std::make_unique<gfx::ThreadPool> (options.threads);
+    auto trProj = glm::perspective(glm::radians(60.0F), 16.0F / 9.0F, 0.1F, FIELD_SIZE * 0.5F);
+
+    std::cout << std::setw(10) << "objects" << std::setw(8) << "simd" << std::setw(9) << "threads"
+        << std::setw(10) << "ms" << std::setw(11) << "visible %" << std::endl;
+
+    for (auto count : options.objects) {
+        auto pCuller = std::make_unique<gfx::FrustumCuller> (count);
+        auto random = std::mt19937(1234);
+        auto unit = std::uniform_real_distribution<float> (0.0F, 1.0F);
+
+        for (std::size_t i = 0; i < count; i++) {
+            auto center = (glm::vec3(unit(random), unit(random), unit(random)) - 0.5F) * FIELD_SIZE;
+            auto size = 0.5F + unit(random) * 2.0F;
+
+            if (i % 2) {
+                pCuller->setSphere(i, center, size);
+            } else {
+                pCuller->setBox(i, center - size, center + glm::vec3(size, size * 0.5F, size));
+            }
+        }
+
+        auto reference = std::vector<std::uint32_t> ();
+        auto visible = std::vector<std::uint32_t> ();
+
+        for (auto level : { gfx::SimdLevel::SCALAR, gfx::SimdLevel::SSE, gfx::SimdLevel::AVX2 }) {
+            if (level > gfx::getBestSimdLevel()) {
+                continue;
+            }
+
+            pCuller->setSimdLevel(level);
+
+            for (auto pPool : { static_cast<gfx::ThreadPool *> (nullptr), pThreadPool.get() }) {
+                auto visibleSum = 0.0;
+                auto start = std::chrono::steady_clock::now();
+
+                for (unsigned int i = 0; i < options.iterations; i++) {
+                    auto t = i * 0.01F;
+                    auto trView = glm::lookAt(glm::vec3(0.0F), glm::vec3(std::sin(t), 0.0F, -std::cos(t)), glm::vec3(0.0F, 1.0F, 0.0F));
+
+                    pCuller->cull(trProj * trView, visible, pPool);
+                    visibleSum += visible.size();
+
+                    // The first configuration is scalar and single-threaded; it checks all the others on one view.
+                    if (0 == i && reference.empty()) {
+                        reference = visible;
+                    } else if (0 == i && reference != visible) {
+                        std::cerr << "[ERROR]: " << gfx::getSimdLevelName(level) << " result differs from the scalar reference" << std::endl;
+                        return 1;
+                    }
+                }
+
+                auto ms = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+
+                std::cout << std::fixed << std::setprecision(3) << std::setw(10) << count
+                    << std::setw(8) << gfx::getSimdLevelName(level)
+                    << std::setw(9) << (nullptr == pPool ? 1 : pPool->getThreadCount())
+                    << std::setw(10) << ms / options.iterations
+                    << std::setw(11) << 100.0 * visibleSum / (static_cast<double> (count) * options.iterations) << std::endl;
+            }
+        }
+    }
+
+    return 0;
+}
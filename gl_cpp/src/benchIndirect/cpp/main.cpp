@@ -0,0 +1,336 @@
+/**
+ * benchIndirect - Multi-draw indirect benchmark (OpenGL 4.5)
+ *
+ * Scatters cubes, octahedra and pyramids from one shared vertex/index buffer around a slowly
+ * turning camera and submits them either one glDrawElements* call per object, as a single
+ * glMultiDrawElementsIndirect, as a multi-draw whose commands a compute pass frustum-culls
+ * on the GPU first, or one call per object that survives gfx::FrustumCuller on the CPU.
+ * Per-object data lives in an SSBO indexed by the draw id.
+ * Reports the CPU submission time per frame and the GPU time of the cull and draw passes.
+ *
+ * Options: --objects N (default 50000), --mode direct|indirect|culled|cpu (default culled),
+ * plus the gfx::Context options.
+ */
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "context.hpp"
+#include "debug_logger.hpp"
+#include "frustum_culler.hpp"
+#include "gpu_profiler.hpp"
+#include "indirect_batch.hpp"
+#include "shader_program.hpp"
+#include "storage_buffer.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+    constexpr float FIELD_SIZE = 200.0F;
+    constexpr float MESH_RADIUS = 1.7320508F;
+
+    enum class SubmitMode {
+        DIRECT,
+        INDIRECT,
+        CULLED,
+        CPU
+    };
+
+    struct alignas(sizeof(glm::vec4)) ObjectT {
+        glm::vec4 rotation;
+        glm::vec4 translationScale;
+        glm::vec4 color;
+    };
+
+    struct Mesh {
+        GLuint count;
+        GLuint firstIndex;
+        GLint baseVertex;
+    };
+
+    struct BenchOptions {
+        unsigned int objects;
+        SubmitMode mode;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { 50000, SubmitMode::CULLED };
+
+        for (int i = 1; i < argc; i++) {
+            if (0 == std::strcmp("--objects", argv[i]) && i + 1 < argc) {
+                options.objects = static_cast<unsigned int> (gfx::parseNumber(argv[++i], "--objects"));
+            } else if (0 == std::strcmp("--mode", argv[i]) && i + 1 < argc) {
+                auto mode = std::string(argv[++i]);
+
+                if ("direct" == mode) {
+                    options.mode = SubmitMode::DIRECT;
+                } else if ("indirect" == mode) {
+                    options.mode = SubmitMode::INDIRECT;
+                } else if ("culled" == mode) {
+                    options.mode = SubmitMode::CULLED;
+                } else if ("cpu" == mode) {
+                    options.mode = SubmitMode::CPU;
+                } else {
+                    throw std::runtime_error("Expected --mode direct, indirect, culled or cpu!");
+                }
+            }
+        }
+
+        if (0 == options.objects) {
+            throw std::runtime_error("Expected at least one object!");
+        }
+
+        return options;
+    }
+
+    const char * getModeName(SubmitMode mode) {
+        switch (mode) {
+            case SubmitMode::DIRECT:
+                return "direct";
+
+            case SubmitMode::INDIRECT:
+                return "indirect";
+
+            case SubmitMode::CPU:
+                return "cpu";
+
+            default:
+                return "culled";
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+    auto pContext = gfx::Context::create(gfx::parseContextInfo(argc, argv, "benchIndirect"));
+    auto pDebugLogger = std::make_unique<gfx::DebugLogger> ();
+
+    auto pDrawProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_VERTEX_SHADER, "data/shaders/benchIndirect/object.vert" },
+            { GL_FRAGMENT_SHADER, "data/shaders/benchIndirect/object.frag" }
+        }));
+
+    auto pCullProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_COMPUTE_SHADER, "data/shaders/benchIndirect/cull.comp" }
+        }));
+
+    // Cube, octahedron and square pyramid, packed into one vertex and one index buffer.
+    const auto positions = std::array<glm::vec3, 19> ({{
+        { -1.0F, -1.0F, -1.0F }, { 1.0F, -1.0F, -1.0F }, { 1.0F, 1.0F, -1.0F }, { -1.0F, 1.0F, -1.0F },
+        { -1.0F, -1.0F, 1.0F }, { 1.0F, -1.0F, 1.0F }, { 1.0F, 1.0F, 1.0F }, { -1.0F, 1.0F, 1.0F },
+        { 1.0F, 0.0F, 0.0F }, { -1.0F, 0.0F, 0.0F }, { 0.0F, 1.0F, 0.0F },
+        { 0.0F, -1.0F, 0.0F }, { 0.0F, 0.0F, 1.0F }, { 0.0F, 0.0F, -1.0F },
+        { -1.0F, -1.0F, -1.0F }, { 1.0F, -1.0F, -1.0F }, { 1.0F, -1.0F, 1.0F }, { -1.0F, -1.0F, 1.0F },
+        { 0.0F, 1.0F, 0.0F }
+    }});
+
+    const auto indices = std::array<GLushort, 78> ({{
+        0, 2, 1, 0, 3, 2,
+        4, 5, 6, 4, 6, 7,
+        0, 1, 5, 0, 5, 4,
+        3, 6, 2, 3, 7, 6,
+        0, 4, 7, 0, 7, 3,
+        1, 2, 6, 1, 6, 5,
+
+        0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4,
+        2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5,
+
+        0, 1, 2, 0, 2, 3,
+        0, 4, 1, 1, 4, 2, 2, 4, 3, 3, 4, 0
+    }});
+
+    const auto meshes = std::array<Mesh, 3> ({{
+        { 36, 0, 0 },
+        { 24, 36, 8 },
+        { 18, 60, 14 }
+    }});
+
+    GLuint vbo;
+    glCreateBuffers(1, &vbo);
+    glNamedBufferData(vbo, sizeof(positions), positions.data(), GL_STATIC_DRAW);
+
+    GLuint ibo;
+    glCreateBuffers(1, &ibo);
+    glNamedBufferData(ibo, sizeof(indices), indices.data(), GL_STATIC_DRAW);
+
+    auto pBatch = std::make_unique<gfx::IndirectBatch> (options.objects);
+
+    GLuint vao;
+    glCreateVertexArrays(1, &vao);
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vao, 0, 0);
+    glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(glm::vec3));
+    glVertexArrayElementBuffer(vao, ibo);
+    pBatch->attachDrawIds(vao, 1, 1);
+
+    auto random = std::mt19937(1234);
+    auto unit = std::uniform_real_distribution<float> (0.0F, 1.0F);
+
+    auto pObjects = std::make_unique<gfx::StorageBuffer<ObjectT>> (options.objects);
+    auto pBounds = std::make_unique<gfx::StorageBuffer<glm::vec4>> (options.objects);
+    auto pCuller = std::make_unique<gfx::FrustumCuller> (options.objects);
+
+    for (unsigned int i = 0; i < options.objects; i++) {
+        const auto& mesh = meshes[random() % meshes.size()];
+        auto position = (glm::vec3(unit(random), unit(random), unit(random)) - 0.5F) * FIELD_SIZE;
+        auto scale = 0.3F + unit(random) * 0.7F;
+        auto rotation = glm::angleAxis(unit(random) * 6.28F, glm::normalize(glm::vec3(unit(random), unit(random), 0.1F)));
+        auto drawId = pBatch->add(mesh.count, mesh.firstIndex, mesh.baseVertex);
+
+        pObjects->write(drawId, {
+            glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w),
+            glm::vec4(position, scale),
+            glm::vec4(unit(random), unit(random), unit(random), 1.0F)
+        });
+
+        pBounds->write(drawId, glm::vec4(position, scale * MESH_RADIUS));
+        pCuller->setSphere(drawId, position, scale * MESH_RADIUS);
+    }
+
+    pObjects->flush();
+    pBounds->flush();
+    pBatch->flush();
+
+    auto pGpuProfiler = std::make_unique<gfx::GpuProfiler> ();
+    auto pThreadPool = std::make_unique<gfx::ThreadPool> ();
+    auto visible = std::vector<std::uint32_t> ();
+
+    glClearColor(0.0F, 0.0F, 0.0F, 0.0F);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    auto trProj = glm::perspective(glm::radians(60.0F), static_cast<float> (pContext->getWidth()) / pContext->getHeight(), 0.1F, FIELD_SIZE);
+    auto frames = 0UL;
+    auto submitMs = 0.0;
+    auto t = 0.0F;
+
+    while (!pContext->shouldClose()) {
+        pGpuProfiler->beginFrame();
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        auto direction = glm::vec3(std::sin(t), 0.0F, -std::cos(t));
+        auto trViewProj = trProj * glm::lookAt(glm::vec3(0.0F), direction, glm::vec3(0.0F, 1.0F, 0.0F));
+
+        auto start = std::chrono::steady_clock::now();
+
+        if (SubmitMode::CULLED == options.mode) {
+            GFX_GPU_SCOPE(*pGpuProfiler, "cull");
+
+            auto planes = gfx::FrustumCuller::extractPlanes(trViewProj);
+
+            glUseProgram(pCullProgram->getHandle());
+            glUniform4fv(0, static_cast<GLsizei> (planes.size()), glm::value_ptr(planes[0]));
+            glUniform1ui(6, pBatch->size());
+            pBounds->bind(1);
+            pBatch->bindForCulling(2, 3);
+            glDispatchCompute((pBatch->size() + 63) / 64, 1, 1);
+            glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+        }
+
+        if (SubmitMode::CPU == options.mode) {
+            pCuller->cull(trViewProj, visible, pThreadPool.get());
+        }
+
+        {
+            GFX_GPU_SCOPE(*pGpuProfiler, "draw");
+
+            glUseProgram(pDrawProgram->getHandle());
+            glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(trViewProj));
+            pObjects->bind(0);
+            glBindVertexArray(vao);
+
+            switch (options.mode) {
+                case SubmitMode::DIRECT:
+                    for (const auto& command : pBatch->getCommands()) {
+                        glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, GL_UNSIGNED_SHORT,
+                            reinterpret_cast<const void *> (command.firstIndex * sizeof(GLushort)), 1, command.baseVertex, command.baseInstance);
+                    }
+                    break;
+
+                case SubmitMode::INDIRECT:
+                    pBatch->draw(GL_UNSIGNED_SHORT);
+                    break;
+
+                case SubmitMode::CULLED:
+                    pBatch->drawCulled(GL_UNSIGNED_SHORT);
+                    break;
+
+                case SubmitMode::CPU:
+                    for (auto index : visible) {
+                        const auto& command = pBatch->getCommands()[index];
+
+                        glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, GL_UNSIGNED_SHORT,
+                            reinterpret_cast<const void *> (command.firstIndex * sizeof(GLushort)), 1, command.baseVertex, command.baseInstance);
+                    }
+                    break;
+            }
+        }
+
+        submitMs += std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+        frames++;
+
+        pContext->swapBuffers();
+        pContext->pollEvents();
+        pGpuProfiler->endFrame();
+
+        t += 0.005F;
+    }
+
+    std::cout.precision(3);
+    std::cout << std::fixed << options.objects << " objects, " << getModeName(options.mode) << ": submit "
+        << submitMs / frames << " ms per frame" << std::endl;
+
+    if (SubmitMode::CULLED == options.mode) {
+        auto commands = std::vector<gfx::DrawElementsIndirectCommand> (pBatch->size());
+
+        // The culling shader wrote these; GL_COMMAND_BARRIER_BIT only covers reading them as draw commands.
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glGetNamedBufferSubData(pBatch->getCulledHandle(), 0, commands.size() * sizeof(gfx::DrawElementsIndirectCommand), commands.data());
+
+        auto visibleCount = std::count_if(commands.begin(), commands.end(), [] (const gfx::DrawElementsIndirectCommand& command) {
+            return command.instanceCount > 0;
+        });
+
+        std::cout << "visible in the last frame: " << visibleCount << " of " << commands.size() << std::endl;
+    } else if (SubmitMode::CPU == options.mode) {
+        std::cout << "visible in the last frame: " << visible.size() << " of " << pCuller->size() << std::endl;
+    }
+
+    pGpuProfiler->report(std::cout);
+
+    pThreadPool = nullptr;
+    pGpuProfiler = nullptr;
+    pCuller = nullptr;
+    pBounds = nullptr;
+    pObjects = nullptr;
+    pBatch = nullptr;
+
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ibo);
+
+    pCullProgram = nullptr;
+    pDrawProgram = nullptr;
+    pDebugLogger = nullptr;
+    pContext = nullptr;
+
+    return 0;
+}
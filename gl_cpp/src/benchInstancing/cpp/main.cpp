@@ -0,0 +1,240 @@
+/**
+ * benchInstancing - Instanced rendering scaling benchmark (OpenGL 4.5)
+ *
+ * Draws 1, 10, 100, ... up to --max-instances cubes with a single glDrawElementsInstanced.
+ * Per-instance transforms are compact TRS records (quaternion, translation, uniform scale) in
+ * an SSBO, re-streamed every frame unless --static is given. For each step prints the mean CPU
+ * time spent updating, uploading and submitting, and the mean GPU time of the draw.
+ *
+ * Options: --max-instances N (default 1000000), --step-frames N (default 50), --static,
+ * plus the gfx::Context options.
+ */
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "context.hpp"
+#include "debug_logger.hpp"
+#include "shader_program.hpp"
+#include "storage_buffer.hpp"
+
+namespace {
+    constexpr unsigned int WARMUP_FRAMES = 10;
+
+    struct alignas(sizeof(glm::vec4)) InstanceT {
+        glm::vec4 rotation;
+        glm::vec4 translationScale;
+    };
+
+    struct BenchOptions {
+        unsigned long maxInstances;
+        unsigned int stepFrames;
+        bool streamed;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { 1000000, 50, true };
+
+        for (int i = 1; i < argc; i++) {
+            auto hasValue = i + 1 < argc;
+
+            if (0 == std::strcmp("--static", argv[i])) {
+                options.streamed = false;
+            } else if (0 == std::strcmp("--max-instances", argv[i]) && hasValue) {
+                options.maxInstances = gfx::parseNumber(argv[++i], "--max-instances");
+            } else if (0 == std::strcmp("--step-frames", argv[i]) && hasValue) {
+                options.stepFrames = static_cast<unsigned int> (gfx::parseNumber(argv[++i], "--step-frames"));
+            }
+        }
+
+        if (0 == options.maxInstances || 0 == options.stepFrames) {
+            throw std::runtime_error("Expected at least one instance and one frame per step!");
+        }
+
+        return options;
+    }
+
+    InstanceT makeInstance(GLsizei index, GLsizei side, float t) {
+        auto x = index % side;
+        auto y = (index / side) % side;
+        auto z = index / (side * side);
+        auto rotation = glm::angleAxis(t * (1.0F + (index % 5) * 0.3F), glm::vec3(0.0F, 1.0F, 0.0F));
+
+        return {
+            glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w),
+            glm::vec4(x - side * 0.5F, y - side * 0.5F, z - side * 0.5F, 0.35F)
+        };
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+    auto steps = std::vector<GLsizei> ();
+
+    for (unsigned long count = 1; count <= options.maxInstances; count *= 10) {
+        steps.push_back(static_cast<GLsizei> (count));
+    }
+
+    auto info = gfx::parseContextInfo(argc, argv, "benchInstancing");
+    info.frames = static_cast<unsigned int> (steps.size()) * (WARMUP_FRAMES + options.stepFrames);
+
+    auto pContext = gfx::Context::create(info);
+    auto pDebugLogger = std::make_unique<gfx::DebugLogger> ();
+
+    auto pProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_VERTEX_SHADER, "data/shaders/benchInstancing/instanced.vert" },
+            { GL_FRAGMENT_SHADER, "data/shaders/benchInstancing/instanced.frag" }
+        }));
+
+    const auto positions = std::array<glm::vec3, 8> ({{
+        { -1.0F, -1.0F, -1.0F }, { 1.0F, -1.0F, -1.0F }, { 1.0F, 1.0F, -1.0F }, { -1.0F, 1.0F, -1.0F },
+        { -1.0F, -1.0F, 1.0F }, { 1.0F, -1.0F, 1.0F }, { 1.0F, 1.0F, 1.0F }, { -1.0F, 1.0F, 1.0F }
+    }});
+
+    const auto indices = std::array<GLushort, 36> ({{
+        0, 2, 1, 0, 3, 2,
+        4, 5, 6, 4, 6, 7,
+        0, 1, 5, 0, 5, 4,
+        3, 6, 2, 3, 7, 6,
+        0, 4, 7, 0, 7, 3,
+        1, 2, 6, 1, 6, 5
+    }});
+
+    GLuint vbo;
+    glCreateBuffers(1, &vbo);
+    glNamedBufferData(vbo, sizeof(positions), positions.data(), GL_STATIC_DRAW);
+
+    GLuint ibo;
+    glCreateBuffers(1, &ibo);
+    glNamedBufferData(ibo, sizeof(indices), indices.data(), GL_STATIC_DRAW);
+
+    GLuint vao;
+    glCreateVertexArrays(1, &vao);
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vao, 0, 0);
+    glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(glm::vec3));
+    glVertexArrayElementBuffer(vao, ibo);
+
+    auto queries = std::vector<GLuint> (options.stepFrames);
+    glCreateQueries(GL_TIME_ELAPSED, static_cast<GLsizei> (queries.size()), queries.data());
+
+    auto pInstances = std::make_unique<gfx::StorageBuffer<InstanceT>> (1);
+    auto cpuTimes = std::vector<double> ();
+    auto step = std::size_t(0);
+    auto stepFrame = 0U;
+    auto side = GLsizei(1);
+    auto t = 0.0F;
+
+    glClearColor(0.0F, 0.0F, 0.0F, 0.0F);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    std::cout << std::setw(10) << "instances" << std::setw(12) << "cpu ms" << std::setw(12) << "gpu ms"
+        << (options.streamed ? "  (streamed)" : "  (static)") << std::endl;
+
+    while (!pContext->shouldClose() && step < steps.size()) {
+        auto count = steps[step];
+
+        if (0 == stepFrame) {
+            side = static_cast<GLsizei> (std::ceil(std::cbrt(static_cast<double> (count))));
+            pInstances->resize(count);
+
+            for (GLsizei i = 0; i < count; i++) {
+                pInstances->write(i, makeInstance(i, side, t));
+            }
+
+            cpuTimes.clear();
+        }
+
+        auto extent = std::max(static_cast<float> (side), 2.0F);
+        auto trView = glm::lookAt(glm::vec3(0.0F, extent * 0.5F, extent * 1.5F), glm::vec3(0.0F), glm::vec3(0.0F, 1.0F, 0.0F));
+        auto trProj = glm::perspective(glm::radians(60.0F), static_cast<float> (pContext->getWidth()) / pContext->getHeight(), 0.1F, extent * 4.0F);
+        auto trViewProj = trProj * trView;
+
+        auto measured = stepFrame >= WARMUP_FRAMES;
+        auto query = measured ? queries[stepFrame - WARMUP_FRAMES] : 0;
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        auto start = std::chrono::steady_clock::now();
+
+        if (options.streamed) {
+            for (GLsizei i = 0; i < count; i++) {
+                pInstances->write(i, makeInstance(i, side, t));
+            }
+        }
+
+        pInstances->flush();
+
+        if (measured) {
+            glBeginQuery(GL_TIME_ELAPSED, query);
+        }
+
+        glUseProgram(pProgram->getHandle());
+        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(trViewProj));
+        pInstances->bind(0);
+        glBindVertexArray(vao);
+        glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei> (indices.size()), GL_UNSIGNED_SHORT, 0, count);
+
+        if (measured) {
+            glEndQuery(GL_TIME_ELAPSED);
+            cpuTimes.push_back(std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count());
+        }
+
+        pContext->swapBuffers();
+        pContext->pollEvents();
+
+        t += 0.01F;
+
+        if (++stepFrame == WARMUP_FRAMES + options.stepFrames) {
+            auto gpuMs = 0.0;
+
+            for (auto q : queries) {
+                GLuint64 elapsed;
+                glGetQueryObjectui64v(q, GL_QUERY_RESULT, &elapsed);
+
+                gpuMs += static_cast<double> (elapsed) * 1e-6;
+            }
+
+            auto cpuMs = std::accumulate(cpuTimes.begin(), cpuTimes.end(), 0.0);
+
+            std::cout << std::fixed << std::setprecision(3) << std::setw(10) << count
+                << std::setw(12) << cpuMs / cpuTimes.size() << std::setw(12) << gpuMs / queries.size() << std::endl;
+
+            stepFrame = 0;
+            step++;
+        }
+    }
+
+    pInstances = nullptr;
+    pProgram = nullptr;
+
+    glDeleteQueries(static_cast<GLsizei> (queries.size()), queries.data());
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ibo);
+
+    pDebugLogger = nullptr;
+    pContext = nullptr;
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * benchMeshImport - OBJ / glTF import benchmark
+ *
+ * Imports a mesh on the calling thread alone and across a gfx::ThreadPool, and prints the time,
+ * throughput and the resulting vertex and index counts. Without --file, a w x w grid of quads with
+ * positions, texcoords and normals is written as OBJ text in memory; every grid point is shared by up to
+ * four quads, so the import has to merge it back into exactly one vertex. The generated grid is checked
+ * triangle by triangle, and the threaded import must match the single-threaded one exactly.
+ *
+ * Options: --file path (.obj or .glb), --triangles N (generated grid, default 2000000), --threads N (default: one per core),
+ * --iterations N (default 3).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "context.hpp"
+#include "mesh_importer.hpp"
+#include "test_meshes.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+    constexpr float TOLERANCE = 1e-5F;
+
+    struct BenchOptions {
+        std::string file;
+        std::size_t triangles;
+        unsigned int threads;
+        unsigned int iterations;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { "", 2000000, 0, 3 };
+
+        for (int i = 1; i < argc; i++) {
+            if (0 == std::strcmp("--file", argv[i])) {
+                options.file = gfx::getOptionValue(argc, argv, i);
+            } else if (0 == std::strcmp("--triangles", argv[i])) {
+                options.triangles = gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--triangles");
+            } else if (0 == std::strcmp("--threads", argv[i])) {
+                options.threads = static_cast<unsigned int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--threads"));
+            } else if (0 == std::strcmp("--iterations", argv[i])) {
+                options.iterations = static_cast<unsigned int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--iterations"));
+            }
+        }
+
+        if (options.triangles < 2 || 0 == options.iterations) {
+            throw std::runtime_error("Expected at least two triangles and one iteration!");
+        }
+
+        return options;
+    }
+
+    float getError(const glm::vec3& a, const glm::vec3& b) {
+        auto difference = glm::abs(a - b);
+
+        return std::max(std::max(difference.x, difference.y), difference.z);
+    }
+
+    bool checkGrid(const gfx::Mesh& mesh, std::size_t width) {
+        if (mesh.vertices.size() != (width + 1) * (width + 1) || mesh.indices.size() != width * width * 6 || !mesh.hasNormals || !mesh.hasTexcoords) {
+            std::cerr << "[ERROR]: expected " << (width + 1) * (width + 1) << " vertices and " << width * width * 6 << " indices" << std::endl;
+            return false;
+        }
+
+        const std::size_t fan[] = { 0, 1, 2, 0, 2, 3 };
+        const std::size_t offsets[][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+        for (std::size_t quad = 0; quad < width * width; quad++) {
+            for (std::size_t k = 0; k < 6; k++) {
+                auto x = quad % width + offsets[fan[k]][0];
+                auto y = quad / width + offsets[fan[k]][1];
+                const auto& vertex = mesh.vertices[mesh.indices[quad * 6 + k]];
+                auto error = std::max(getError(vertex.position, gfx::getGridPosition(x, y, width)),
+                    getError(glm::vec3(vertex.texcoord, 0.0F), glm::vec3(gfx::getGridTexcoord(x, y, width), 0.0F)));
+
+                if (error > TOLERANCE || 1.0F != vertex.normal.y) {
+                    std::cerr << "[ERROR]: corner " << k << " of quad " << quad << " imported wrong" << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool isSameMesh(const gfx::Mesh& a, const gfx::Mesh& b) {
+        return a.indices == b.indices && a.vertices.size() == b.vertices.size()
+            && 0 == std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(gfx::Vertex));
+    }
+
+    std::vector<char> readFile(const std::string& path) {
+        auto file = std::ifstream(path.c_str(), std::ios::binary | std::ios::ate);
+
+        if (!file) {
+            throw std::runtime_error("Failed to load file: \"" + path + "\"");
+        }
+
+        auto data = std::vector<char> (static_cast<std::size_t> (file.tellg()));
+
+        file.seekg(0);
+        file.read(data.data(), data.size());
+
+        return data;
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+    auto pThreadPool = std::make_unique<gfx::ThreadPool> (options.threads);
+    auto width = static_cast<std::size_t> (std::sqrt(options.triangles / 2.0));
+    auto isGlb = options.file.size() > 4 && ".glb" == options.file.substr(options.file.size() - 4);
+    auto data = std::vector<char> ();
+
+    if (options.file.empty()) {
+        auto text = gfx::writeGridObj(width);
+        data.assign(text.begin(), text.end());
+        std::cout << "generated " << width << " x " << width << " grid, " << 2 * width * width << " triangles" << std::endl;
+    } else {
+        data = readFile(options.file);
+    }
+
+    auto megabytes = data.size() / (1024.0 * 1024.0);
+
+    std::cout << std::fixed << std::setprecision(1) << megabytes << " MB of " << (isGlb ? "glTF" : "OBJ") << std::endl;
+    std::cout << std::setw(9) << "threads" << std::setw(10) << "ms" << std::setw(10) << "MB/s" << std::setw(12) << "vertices"
+        << std::setw(12) << "indices" << std::setw(8) << "index" << std::endl;
+
+    auto meshes = std::vector<gfx::Mesh> ();
+
+    for (auto pPool : { static_cast<gfx::ThreadPool *> (nullptr), pThreadPool.get() }) {
+        auto best = 0.0;
+        auto mesh = gfx::Mesh {};
+
+        for (unsigned int i = 0; i < options.iterations; i++) {
+            auto start = std::chrono::steady_clock::now();
+
+            mesh = isGlb ? gfx::parseGlb(reinterpret_cast<const std::uint8_t *> (data.data()), data.size()) : gfx::parseObj(data.data(), data.size(), pPool);
+
+            auto ms = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+
+            best = 0 == i ? ms : std::min(best, ms);
+        }
+
+        std::cout << std::setw(9) << (nullptr == pPool ? 1 : pPool->getThreadCount()) << std::setw(10) << std::setprecision(1) << best
+            << std::setw(10) << megabytes * 1000.0 / best << std::setw(12) << mesh.vertices.size() << std::setw(12) << mesh.indices.size()
+            << std::setw(8) << mesh.getIndexSize() * 8 << std::endl;
+
+        meshes.push_back(std::move(mesh));
+    }
+
+    if (!isSameMesh(meshes[0], meshes[1])) {
+        std::cerr << "[ERROR]: threaded import differs from the single-threaded one" << std::endl;
+        return 1;
+    }
+
+    if (options.file.empty() && !checkGrid(meshes[0], width)) {
+        return 1;
+    }
+
+    return 0;
+}
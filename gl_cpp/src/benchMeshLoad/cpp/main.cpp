@@ -0,0 +1,185 @@
+/**
+ * benchMeshLoad - mesh startup-time benchmark (OpenGL 4.5)
+ *
+ * Compares the two ways of getting a mesh from disk into GL buffers:
+ *
+ *   import  gfx::importMesh on the source .obj or .glb, then interleave and glNamedBufferData.
+ *   mapped  gfx::MeshFile maps the converted mesh file and gfx::MeshBuffers hands the mapping straight
+ *           to glNamedBufferStorage.
+ *
+ * Each run ends with glFinish, so the times cover the upload too. The mesh file is written once before
+ * timing (as convertMesh would) and the page cache is warm for both paths; the mapped buffers are read
+ * back and checked against the imported mesh.
+ *
+ * Options: --file path (.obj or .glb; default: a generated grid OBJ of --triangles N, default 2000000),
+ * --output path (the mesh file, default benchMeshLoad.mesh), --iterations N (default 5),
+ * plus the gfx::Context options.
+ */
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "context.hpp"
+#include "debug_logger.hpp"
+#include "mesh_file.hpp"
+#include "mesh_importer.hpp"
+#include "test_meshes.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+    struct BenchOptions {
+        std::string file;
+        std::string output;
+        std::size_t triangles;
+        unsigned int iterations;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { "", "benchMeshLoad.mesh", 2000000, 5 };
+
+        for (int i = 1; i < argc; i++) {
+            if (0 == std::strcmp("--file", argv[i])) {
+                options.file = gfx::getOptionValue(argc, argv, i);
+            } else if (0 == std::strcmp("--output", argv[i])) {
+                options.output = gfx::getOptionValue(argc, argv, i);
+            } else if (0 == std::strcmp("--triangles", argv[i])) {
+                options.triangles = gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--triangles");
+            } else if (0 == std::strcmp("--iterations", argv[i])) {
+                options.iterations = static_cast<unsigned int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--iterations"));
+            }
+        }
+
+        if (options.triangles < 2 || 0 == options.iterations) {
+            throw std::runtime_error("Expected at least two triangles and one iteration!");
+        }
+
+        return options;
+    }
+
+    void writeGridObj(const std::string& path, std::size_t width) {
+        auto text = gfx::writeGridObj(width);
+        auto file = std::ofstream(path.c_str(), std::ios::binary | std::ios::trunc);
+
+        file.write(text.data(), text.size());
+
+        if (!file) {
+            throw std::runtime_error("Failed to write " + path);
+        }
+    }
+
+    double getMilliseconds(const std::chrono::steady_clock::time_point& start) {
+        return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool checkBuffers(const gfx::MeshBuffers& buffers, const gfx::Mesh& mesh) {
+        auto positions = std::vector<glm::vec3> (mesh.vertices.size());
+        auto indices = std::vector<std::uint8_t> (mesh.indices.size() * mesh.getIndexSize());
+
+        glGetNamedBufferSubData(buffers.getVertexBuffer(0), 0, positions.size() * sizeof(glm::vec3), positions.data());
+        glGetNamedBufferSubData(buffers.getIndexBuffer(), 0, indices.size(), indices.data());
+
+        for (std::size_t i = 0; i < positions.size(); i++) {
+            if (positions[i] != mesh.vertices[i].position) {
+                std::cerr << "[ERROR]: position " << i << " differs from the imported mesh" << std::endl;
+                return false;
+            }
+        }
+
+        if (indices != mesh.packIndices() || buffers.getIndexType() != mesh.getIndexType()) {
+            std::cerr << "[ERROR]: indices differ from the imported mesh" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+    auto pContext = gfx::Context::create(gfx::parseContextInfo(argc, argv, "benchMeshLoad"));
+    auto pDebugLogger = std::make_unique<gfx::DebugLogger> ();
+    auto pThreadPool = std::make_unique<gfx::ThreadPool> ();
+
+    if (options.file.empty()) {
+        auto width = static_cast<std::size_t> (std::sqrt(options.triangles / 2.0));
+
+        options.file = "benchMeshLoad.obj";
+        writeGridObj(options.file, width);
+        std::cout << "generated " << options.file << ": " << width << " x " << width << " grid, " << 2 * width * width << " triangles" << std::endl;
+    }
+
+    auto reference = gfx::importMesh(options.file, pThreadPool.get());
+
+    gfx::writeMeshFile(options.output, reference);
+
+    auto bestImport = 0.0;
+    auto bestMap = 0.0;
+    auto bestMapped = 0.0;
+
+    for (unsigned int i = 0; i < options.iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        auto mesh = gfx::importMesh(options.file, pThreadPool.get());
+        auto indices = mesh.packIndices();
+
+        GLuint buffers[2];
+        glCreateBuffers(2, buffers);
+        glNamedBufferData(buffers[0], mesh.vertices.size() * sizeof(gfx::Vertex), mesh.vertices.data(), GL_STATIC_DRAW);
+        glNamedBufferData(buffers[1], indices.size(), indices.data(), GL_STATIC_DRAW);
+        glFinish();
+
+        auto importMs = getMilliseconds(start);
+
+        glDeleteBuffers(2, buffers);
+
+        start = std::chrono::steady_clock::now();
+
+        auto pFile = std::make_unique<gfx::MeshFile> (options.output);
+        auto mapMs = getMilliseconds(start);
+        auto pBuffers = std::make_unique<gfx::MeshBuffers> (*pFile);
+
+        glFinish();
+
+        auto mappedMs = getMilliseconds(start);
+
+        if (0 == i && !checkBuffers(*pBuffers, reference)) {
+            return 1;
+        }
+
+        pBuffers = nullptr;
+        pFile = nullptr;
+
+        bestImport = 0 == i ? importMs : std::min(bestImport, importMs);
+        bestMap = 0 == i ? mapMs : std::min(bestMap, mapMs);
+        bestMapped = 0 == i ? mappedMs : std::min(bestMapped, mappedMs);
+    }
+
+    auto pFile = std::make_unique<gfx::MeshFile> (options.output);
+    const auto& header = pFile->getHeader();
+
+    std::cout << header.vertexCount << " vertices, " << header.indexCount / 3 << " triangles, "
+        << std::fixed << std::setprecision(1) << header.fileSize / (1024.0 * 1024.0) << " MB mesh file" << std::endl;
+    std::cout << std::setw(8) << "path" << std::setw(12) << "ms" << std::setw(10) << "speedup" << std::endl;
+    std::cout << std::setw(8) << "import" << std::setw(12) << std::setprecision(2) << bestImport << std::setw(10) << 1.0 << std::endl;
+    std::cout << std::setw(8) << "mapped" << std::setw(12) << bestMapped << std::setw(10) << bestImport / bestMapped
+        << "  (" << bestMap << " ms to map and validate)" << std::endl;
+
+    pFile = nullptr;
+    pThreadPool = nullptr;
+    pDebugLogger = nullptr;
+    pContext = nullptr;
+
+    return 0;
+}
@@ -0,0 +1,283 @@
+/**
+ * benchMeshNormals - vertex normal and tangent generation benchmark
+ *
+ * Builds a torus split along its seams (gfx::createTorus) with texcoords running around both of its circles and times:
+ *
+ *   loop     the tutorials' per-triangle loop, accumulating glm::cross into the vertices (normals only)
+ *   scalar   gfx::computeNormals / gfx::computeTangents with the scalar face pass, on one thread
+ *   avx2     the same with 8-wide gathered face passes, on one thread (when the CPU has AVX2)
+ *   pool     the best SIMD level across a gfx::ThreadPool
+ *   shuffled the same as pool on a copy with its vertices renumbered at random, which leaves no index locality
+ *            and, from about 150000 vertices up, takes the counting-sort path instead of the windows
+ *
+ * Normals must match the loop, and every method must match the single-threaded scalar result exactly.
+ * Tangents are checked against the analytic derivative along u away from the texcoord seams, and
+ * their sign against the analytic orientation.
+ *
+ * Options: --vertices N (approximate, default 2000000), --threads N (default: one per core), --iterations N (default 3).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "context.hpp"
+#include "mesh.hpp"
+#include "mesh_processing.hpp"
+#include "simd.hpp"
+#include "test_meshes.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+    constexpr float TWO_PI = 6.2831853F;
+    constexpr float NORMAL_TOLERANCE = 1e-4F;
+    constexpr float TANGENT_TOLERANCE = 2e-3F;
+    constexpr std::uint32_t SHUFFLE_SEED = 42;
+
+    struct BenchOptions {
+        std::size_t vertices;
+        unsigned int threads;
+        unsigned int iterations;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { 2000000, 0, 3 };
+
+        for (int i = 1; i < argc; i++) {
+            if (0 == std::strcmp("--vertices", argv[i])) {
+                options.vertices = gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--vertices");
+            } else if (0 == std::strcmp("--threads", argv[i])) {
+                options.threads = static_cast<unsigned int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--threads"));
+            } else if (0 == std::strcmp("--iterations", argv[i])) {
+                options.iterations = static_cast<unsigned int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--iterations"));
+            }
+        }
+
+        if (options.vertices < 16 || 0 == options.iterations) {
+            throw std::runtime_error("Expected at least 16 vertices and one iteration!");
+        }
+
+        return options;
+    }
+
+    glm::vec3 getTorusNormal(float u, float v) {
+        return glm::vec3(std::cos(TWO_PI * v) * std::cos(TWO_PI * u), std::sin(TWO_PI * v), std::cos(TWO_PI * v) * std::sin(TWO_PI * u));
+    }
+
+    glm::vec3 getTorusDerivativeU(float u) {
+        return glm::vec3(-std::sin(TWO_PI * u), 0.0F, std::cos(TWO_PI * u));
+    }
+
+    glm::vec3 getTorusDerivativeV(float u, float v) {
+        return glm::vec3(-std::sin(TWO_PI * v) * std::cos(TWO_PI * u), std::cos(TWO_PI * v), -std::sin(TWO_PI * v) * std::sin(TWO_PI * u));
+    }
+
+    // The faces keep their order; new vertex remap[i] is old vertex i.
+    gfx::Mesh shuffleVertices(const gfx::Mesh& mesh, std::vector<std::uint32_t>& remap) {
+        auto shuffled = mesh;
+        auto random = std::mt19937(SHUFFLE_SEED);
+
+        remap.resize(mesh.vertices.size());
+        std::iota(remap.begin(), remap.end(), 0U);
+        std::shuffle(remap.begin(), remap.end(), random);
+
+        for (std::size_t i = 0; i < mesh.vertices.size(); i++) {
+            shuffled.vertices[remap[i]] = mesh.vertices[i];
+        }
+
+        for (auto& index : shuffled.indices) {
+            index = remap[index];
+        }
+
+        return shuffled;
+    }
+
+    // What tutorials 18-21 do, with area weighting.
+    void computeNormalsLoop(gfx::Mesh& mesh) {
+        for (auto& p : mesh.vertices) {
+            p.normal = glm::vec3(0.0F);
+        }
+
+        for (std::size_t i = 0; i < mesh.indices.size(); i += 3) {
+            auto& p0 = mesh.vertices[mesh.indices[i]];
+            auto& p1 = mesh.vertices[mesh.indices[i + 1]];
+            auto& p2 = mesh.vertices[mesh.indices[i + 2]];
+            auto normal = glm::cross(p1.position - p0.position, p2.position - p0.position);
+
+            p0.normal += normal;
+            p1.normal += normal;
+            p2.normal += normal;
+        }
+
+        for (auto& p : mesh.vertices) {
+            p.normal = glm::normalize(p.normal);
+        }
+    }
+
+    bool isSame(const std::vector<float>& a, const std::vector<float>& b) {
+        return a.size() == b.size() && 0 == std::memcmp(a.data(), b.data(), a.size() * sizeof(float));
+    }
+
+    bool isSame(const std::vector<float>& a, const std::vector<float>& shuffled, const std::vector<std::uint32_t>& remap) {
+        for (std::size_t i = 0; i < a.size(); i++) {
+            if (0 != std::memcmp(&a[i], &shuffled[remap[i]], sizeof(float))) {
+                return false;
+            }
+        }
+
+        return a.size() == shuffled.size();
+    }
+
+    double getMilliseconds(const std::function<void ()>& run, unsigned int iterations) {
+        auto best = 0.0;
+
+        for (unsigned int i = 0; i < iterations; i++) {
+            auto start = std::chrono::steady_clock::now();
+
+            run();
+
+            auto ms = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+
+            best = 0 == i ? ms : std::min(best, ms);
+        }
+
+        return best;
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+    auto pThreadPool = std::make_unique<gfx::ThreadPool> (options.threads);
+    auto sides = static_cast<std::size_t> (std::sqrt(options.vertices / 4.0));
+    auto mesh = gfx::createTorus(sides * 4, sides, true);
+    auto bestLevel = gfx::getBestSimdLevel();
+
+    std::cout << mesh.vertices.size() << " vertices, " << mesh.indices.size() / 3 << " triangles, " << pThreadPool->getThreadCount() << " threads" << std::endl;
+    std::cout << std::setw(10) << "pass" << std::setw(10) << "method" << std::setw(12) << "ms" << std::setw(10) << "speedup" << std::endl;
+
+    auto loopMs = getMilliseconds([&] { computeNormalsLoop(mesh); }, options.iterations);
+
+    std::cout << std::fixed << std::setprecision(2) << std::setw(10) << "normals" << std::setw(10) << "loop" << std::setw(12) << loopMs << std::setw(10) << 1.0 << std::endl;
+
+    struct Method {
+        const char * name;
+        gfx::SimdLevel level;
+        gfx::ThreadPool * pThreadPool;
+    };
+
+    auto methods = std::vector<Method> ({ { "scalar", gfx::SimdLevel::SCALAR, nullptr } });
+
+    if (gfx::SimdLevel::AVX2 == bestLevel) {
+        methods.push_back({ "avx2", gfx::SimdLevel::AVX2, nullptr });
+    }
+
+    methods.push_back({ "pool", bestLevel, pThreadPool.get() });
+
+    auto streams = gfx::toVertexStreams(mesh);
+    auto reference = gfx::VertexStreams {};
+    auto normalMs = 0.0;
+
+    for (const auto& method : methods) {
+        auto ms = getMilliseconds([&] { gfx::computeNormals(streams, mesh.indices, method.pThreadPool, method.level); }, options.iterations);
+
+        normalMs = 0.0 == normalMs ? ms : normalMs;
+        std::cout << std::setw(10) << "normals" << std::setw(10) << method.name << std::setw(12) << ms << std::setw(10) << loopMs / ms << std::endl;
+
+        if (reference.normalX.empty()) {
+            reference = streams;
+        } else if (!isSame(reference.normalX, streams.normalX) || !isSame(reference.normalY, streams.normalY) || !isSame(reference.normalZ, streams.normalZ)) {
+            std::cerr << "[ERROR]: " << method.name << " normals differ from the single-threaded scalar ones" << std::endl;
+            return 1;
+        }
+    }
+
+    auto remap = std::vector<std::uint32_t> ();
+    auto shuffledMesh = shuffleVertices(mesh, remap);
+    auto shuffled = gfx::toVertexStreams(shuffledMesh);
+    auto shuffledMs = getMilliseconds([&] { gfx::computeNormals(shuffled, shuffledMesh.indices, pThreadPool.get(), bestLevel); }, options.iterations);
+
+    std::cout << std::setw(10) << "normals" << std::setw(10) << "shuffled" << std::setw(12) << shuffledMs << std::setw(10) << loopMs / shuffledMs << std::endl;
+
+    if (!isSame(streams.normalX, shuffled.normalX, remap) || !isSame(streams.normalY, shuffled.normalY, remap) || !isSame(streams.normalZ, shuffled.normalZ, remap)) {
+        std::cerr << "[ERROR]: shuffled normals differ from the single-threaded scalar ones" << std::endl;
+        return 1;
+    }
+
+    auto normalError = 0.0F;
+
+    for (std::size_t i = 0; i < mesh.vertices.size(); i++) {
+        auto difference = glm::abs(glm::vec3(streams.normalX[i], streams.normalY[i], streams.normalZ[i]) - mesh.vertices[i].normal);
+
+        normalError = std::max(normalError, std::max(std::max(difference.x, difference.y), difference.z));
+    }
+
+    auto tangentBaseline = 0.0;
+    reference = gfx::VertexStreams {};
+
+    for (const auto& method : methods) {
+        auto ms = getMilliseconds([&] { gfx::computeTangents(streams, mesh.indices, method.pThreadPool, method.level); }, options.iterations);
+
+        tangentBaseline = 0.0 == tangentBaseline ? ms : tangentBaseline;
+        std::cout << std::setw(10) << "tangents" << std::setw(10) << method.name << std::setw(12) << ms << std::setw(10) << tangentBaseline / ms << std::endl;
+
+        if (reference.tangentX.empty()) {
+            reference = streams;
+        } else if (!isSame(reference.tangentX, streams.tangentX) || !isSame(reference.tangentY, streams.tangentY)
+                || !isSame(reference.tangentZ, streams.tangentZ) || !isSame(reference.tangentW, streams.tangentW)) {
+            std::cerr << "[ERROR]: " << method.name << " tangents differ from the single-threaded scalar ones" << std::endl;
+            return 1;
+        }
+    }
+
+    shuffledMs = getMilliseconds([&] { gfx::computeTangents(shuffled, shuffledMesh.indices, pThreadPool.get(), bestLevel); }, options.iterations);
+
+    std::cout << std::setw(10) << "tangents" << std::setw(10) << "shuffled" << std::setw(12) << shuffledMs << std::setw(10) << tangentBaseline / shuffledMs << std::endl;
+
+    if (!isSame(streams.tangentX, shuffled.tangentX, remap) || !isSame(streams.tangentY, shuffled.tangentY, remap)
+            || !isSame(streams.tangentZ, shuffled.tangentZ, remap) || !isSame(streams.tangentW, shuffled.tangentW, remap)) {
+        std::cerr << "[ERROR]: shuffled tangents differ from the single-threaded scalar ones" << std::endl;
+        return 1;
+    }
+
+    auto rings = sides * 4;
+    auto tangentError = 0.0F;
+    auto wrongSigns = std::size_t(0);
+
+    for (std::size_t j = 1; j < sides; j++) {
+        for (std::size_t i = 1; i < rings; i++) {
+            auto vertex = j * (rings + 1) + i;
+            auto u = static_cast<float> (i) / rings;
+            auto v = static_cast<float> (j) / sides;
+            auto normal = getTorusNormal(u, v);
+            auto expected = getTorusDerivativeU(u);
+            auto tangent = glm::vec3(streams.tangentX[vertex], streams.tangentY[vertex], streams.tangentZ[vertex]);
+            auto sign = glm::dot(glm::cross(normal, expected), getTorusDerivativeV(u, v)) < 0.0F ? -1.0F : 1.0F;
+            auto difference = glm::abs(tangent - expected);
+
+            tangentError = std::max(tangentError, std::max(std::max(difference.x, difference.y), difference.z));
+            wrongSigns += sign != streams.tangentW[vertex] ? 1 : 0;
+        }
+    }
+
+    std::cout << std::scientific << std::setprecision(2) << "max normal error vs loop " << normalError
+        << ", max tangent error vs analytic " << tangentError << ", wrong bitangent signs " << wrongSigns << std::endl;
+
+    if (normalError > NORMAL_TOLERANCE || tangentError > TANGENT_TOLERANCE || 0 != wrongSigns) {
+        std::cerr << "[ERROR]: generated normals or tangents are off" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,277 @@
+/**
+ * benchMeshOptimizer - index buffer optimization benchmark
+ *
+ * Runs the gfx mesh optimizer passes one after another and reports, after each, what the index order
+ * costs the vertex stage (gfx::analyzeVertexCache: ACMR, ATVR and vertex fetch overfetch) and the
+ * overdraw, measured by rasterizing the mesh in index order with depth testing and back-face culling
+ * from the six axis directions and dividing the fragments that pass the depth test by the pixels covered.
+ *
+ *   authored  the input order; the generated torus has its triangles and vertices shuffled
+ *   cache     gfx::optimizeVertexCache (Tipsify)
+ *   overdraw  gfx::optimizeOverdraw on top
+ *   fetch     gfx::optimizeVertexFetch on top
+ *
+ * Every pass is checked to keep the same triangles, and the cache pass not to raise the ACMR.
+ *
+ * Options: --file path (.obj or .glb; default: a torus of about --vertices N, default 1000000),
+ * --cache N (post-transform cache entries, default 16), --threshold F (ACMR the overdraw pass may
+ * give up, default 1.05), --resolution N (overdraw raster size, default 512).
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "context.hpp"
+#include "mesh.hpp"
+#include "mesh_importer.hpp"
+#include "mesh_optimizer.hpp"
+#include "test_meshes.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+    struct BenchOptions {
+        std::string file;
+        std::size_t vertices;
+        unsigned int cacheSize;
+        float threshold;
+        int resolution;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { "", 1000000, 16, 1.05F, 512 };
+
+        for (int i = 1; i < argc; i++) {
+            if (0 == std::strcmp("--file", argv[i])) {
+                options.file = gfx::getOptionValue(argc, argv, i);
+            } else if (0 == std::strcmp("--vertices", argv[i])) {
+                options.vertices = gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--vertices");
+            } else if (0 == std::strcmp("--cache", argv[i])) {
+                options.cacheSize = static_cast<unsigned int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--cache"));
+            } else if (0 == std::strcmp("--threshold", argv[i])) {
+                options.threshold = gfx::parseFloat(gfx::getOptionValue(argc, argv, i), "--threshold");
+            } else if (0 == std::strcmp("--resolution", argv[i])) {
+                options.resolution = static_cast<int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--resolution"));
+            }
+        }
+
+        if (options.vertices < 16 || 0 == options.cacheSize || options.threshold < 1.0F || options.resolution < 16) {
+            throw std::runtime_error("Expected at least 16 vertices, a cache, a threshold of at least 1 and a resolution of at least 16!");
+        }
+
+        return options;
+    }
+
+    // A torus in shuffled order, as an exporter that doesn't care about vertex locality would write it.
+    gfx::Mesh createShuffledTorus(std::size_t rings, std::size_t sides) {
+        auto mesh = gfx::createTorus(rings, sides);
+        auto faces = std::vector<std::array<std::uint32_t, 3>> ();
+
+        for (std::size_t f = 0; f + 2 < mesh.indices.size(); f += 3) {
+            faces.push_back({ { mesh.indices[f], mesh.indices[f + 1], mesh.indices[f + 2] } });
+        }
+
+        auto random = std::mt19937(1);
+        auto remap = std::vector<std::uint32_t> (mesh.vertices.size());
+        auto vertices = mesh.vertices;
+
+        for (std::uint32_t i = 0; i < remap.size(); i++) {
+            remap[i] = i;
+        }
+
+        std::shuffle(remap.begin(), remap.end(), random);
+        std::shuffle(faces.begin(), faces.end(), random);
+
+        for (std::size_t i = 0; i < remap.size(); i++) {
+            mesh.vertices[remap[i]] = vertices[i];
+        }
+
+        mesh.indices.clear();
+
+        for (const auto& face : faces) {
+            mesh.indices.insert(mesh.indices.end(), { remap[face[0]], remap[face[1]], remap[face[2]] });
+        }
+
+        return mesh;
+    }
+
+    float getOverdraw(const gfx::Mesh& mesh, int resolution) {
+        auto boundsMin = glm::vec3(std::numeric_limits<float>::max());
+        auto boundsMax = -boundsMin;
+
+        for (const auto& vertex : mesh.vertices) {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
+
+        auto scale = (resolution - 1) / std::max(std::max(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y), std::max(boundsMax.z - boundsMin.z, 1e-6F));
+        auto depths = std::vector<float> (static_cast<std::size_t> (resolution) * resolution);
+        auto shaded = std::size_t(0);
+        auto covered = std::size_t(0);
+
+        for (int axis = 0; axis < 3; axis++) {
+            for (float direction : { -1.0F, 1.0F }) {
+                // The camera sits on the side of direction and looks back along the axis.
+                auto u = (axis + 1) % 3;
+                auto v = (axis + 2) % 3;
+
+                std::fill(depths.begin(), depths.end(), std::numeric_limits<float>::max());
+
+                for (std::size_t f = 0; f + 2 < mesh.indices.size(); f += 3) {
+                    glm::vec3 p[3];
+
+                    for (int k = 0; k < 3; k++) {
+                        auto position = (mesh.vertices[mesh.indices[f + k]].position - boundsMin) * scale;
+                        p[k] = glm::vec3(position[u], position[v], -direction * position[axis]);
+                    }
+
+                    auto area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+
+                    // (u, v, axis) is right-handed, so looking from +axis front faces have positive area.
+                    if (direction * area <= 0.0F) {
+                        continue;
+                    }
+
+                    auto x0 = std::max(0, static_cast<int> (std::ceil(std::min(std::min(p[0].x, p[1].x), p[2].x) - 0.5F)));
+                    auto x1 = std::min(resolution - 1, static_cast<int> (std::floor(std::max(std::max(p[0].x, p[1].x), p[2].x) - 0.5F)));
+                    auto y0 = std::max(0, static_cast<int> (std::ceil(std::min(std::min(p[0].y, p[1].y), p[2].y) - 0.5F)));
+                    auto y1 = std::min(resolution - 1, static_cast<int> (std::floor(std::max(std::max(p[0].y, p[1].y), p[2].y) - 0.5F)));
+
+                    for (auto y = y0; y <= y1; y++) {
+                        for (auto x = x0; x <= x1; x++) {
+                            auto px = x + 0.5F;
+                            auto py = y + 0.5F;
+                            auto w0 = ((p[2].x - p[1].x) * (py - p[1].y) - (p[2].y - p[1].y) * (px - p[1].x)) / area;
+                            auto w1 = ((p[0].x - p[2].x) * (py - p[2].y) - (p[0].y - p[2].y) * (px - p[2].x)) / area;
+                            auto w2 = 1.0F - w0 - w1;
+
+                            if (w0 < 0.0F || w1 < 0.0F || w2 < 0.0F) {
+                                continue;
+                            }
+
+                            auto depth = w0 * p[0].z + w1 * p[1].z + w2 * p[2].z;
+                            auto& stored = depths[static_cast<std::size_t> (y) * resolution + x];
+
+                            if (depth < stored) {
+                                stored = depth;
+                                shaded++;
+                            }
+                        }
+                    }
+                }
+
+                for (auto depth : depths) {
+                    covered += depth < std::numeric_limits<float>::max() ? 1 : 0;
+                }
+            }
+        }
+
+        return 0 == covered ? 0.0F : static_cast<float> (shaded) / covered;
+    }
+
+    // The faces as sorted vertex triples, each rotated to start at its smallest index.
+    std::vector<std::array<std::uint32_t, 3>> getFaces(const gfx::Mesh& mesh) {
+        auto faces = std::vector<std::array<std::uint32_t, 3>> ();
+
+        for (std::size_t f = 0; f + 2 < mesh.indices.size(); f += 3) {
+            auto face = std::array<std::uint32_t, 3> { { mesh.indices[f], mesh.indices[f + 1], mesh.indices[f + 2] } };
+            std::rotate(face.begin(), std::min_element(face.begin(), face.end()), face.end());
+            faces.push_back(face);
+        }
+
+        std::sort(faces.begin(), faces.end());
+
+        return faces;
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+    auto mesh = gfx::Mesh {};
+
+    if (options.file.empty()) {
+        auto sides = static_cast<std::size_t> (std::sqrt(options.vertices / 4.0));
+        mesh = createShuffledTorus(sides * 4, sides);
+    } else {
+        auto pThreadPool = std::make_unique<gfx::ThreadPool> ();
+        mesh = gfx::importMesh(options.file, pThreadPool.get());
+    }
+
+    auto faces = getFaces(mesh);
+    auto originalVertices = mesh.vertices;
+
+    std::cout << mesh.vertices.size() << " vertices, " << mesh.indices.size() / 3 << " triangles, " << options.cacheSize << " entry cache" << std::endl;
+    std::cout << std::setw(10) << "order" << std::setw(10) << "ms" << std::setw(8) << "ACMR" << std::setw(8) << "ATVR"
+        << std::setw(11) << "overfetch" << std::setw(10) << "overdraw" << std::endl;
+
+    auto report = [&] (const char * name, double ms) {
+        auto stats = gfx::analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), sizeof(gfx::Vertex), options.cacheSize);
+
+        std::cout << std::fixed << std::setw(10) << name << std::setw(10) << std::setprecision(1) << ms << std::setprecision(3)
+            << std::setw(8) << stats.acmr << std::setw(8) << stats.atvr << std::setw(11) << stats.overfetch
+            << std::setw(10) << getOverdraw(mesh, options.resolution) << std::endl;
+
+        return stats;
+    };
+
+    auto time = [] (const std::function<void ()>& run) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+    };
+
+    auto authored = report("authored", 0.0);
+    auto ms = time([&] { gfx::optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), options.cacheSize); });
+    auto cached = report("cache", ms);
+    auto cacheFaces = getFaces(mesh);
+
+    ms = time([&] { gfx::optimizeOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.vertices, options.threshold, options.cacheSize); });
+
+    report("overdraw", ms);
+    auto overdrawFaces = getFaces(mesh);
+    auto remap = std::vector<std::uint32_t> ();
+
+    ms = time([&] { remap = gfx::optimizeVertexFetch(mesh); });
+    report("fetch", ms);
+
+    auto fetchMatches = true;
+
+    for (std::size_t vertex = 0; vertex < originalVertices.size(); vertex++) {
+        fetchMatches = fetchMatches && originalVertices[vertex].position == mesh.vertices[remap[vertex]].position;
+    }
+
+    for (auto& face : faces) {
+        for (auto& vertex : face) {
+            vertex = remap[vertex];
+        }
+
+        std::rotate(face.begin(), std::min_element(face.begin(), face.end()), face.end());
+    }
+
+    std::sort(faces.begin(), faces.end());
+
+    if (cacheFaces != overdrawFaces || faces != getFaces(mesh) || !fetchMatches) {
+        std::cerr << "[ERROR]: an optimizer pass changed the triangles" << std::endl;
+        return 1;
+    }
+
+    if (cached.acmr > authored.acmr) {
+        std::cerr << "[ERROR]: the vertex cache pass raised the ACMR from " << authored.acmr << " to " << cached.acmr << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * benchNormalMatrices - batched normal matrix benchmark
+ *
+ * Fills random affine model matrices (rotation, non-uniform scale, translation) and writes their
+ * normal matrices into per-object records laid out like a std430 Objects buffer
+ * ({ mat4 model; mat3 normal; }) with:
+ *
+ *   glm mat4  glm::transpose(glm::inverse(m)) per object, as the tutorials did
+ *   glm mat3  glm::transpose(glm::inverse(glm::mat3(m))) per object
+ *   gfx::computeNormalMatrices at every SIMD level the CPU supports
+ *
+ * at 1k, 10k, 100k and 1M objects. Prints ns per matrix and the largest relative deviation from
+ * the glm mat4 result, and fails if any method strays past single-precision noise.
+ *
+ * Options: --objects N (a single count instead of the sweep), --iterations N (default 20).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "context.hpp"
+#include "normal_matrix.hpp"
+#include "simd.hpp"
+
+namespace {
+    constexpr float TOLERANCE = 1e-4F;
+
+    struct BenchOptions {
+        std::vector<std::size_t> objects;
+        unsigned int iterations;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { { 1000, 10000, 100000, 1000000 }, 20 };
+
+        for (int i = 1; i < argc; i++) {
+            if (0 == std::strcmp("--objects", argv[i])) {
+                options.objects = { gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--objects") };
+            } else if (0 == std::strcmp("--iterations", argv[i])) {
+                options.iterations = static_cast<unsigned int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--iterations"));
+            }
+        }
+
+        if (0 == options.objects.front() || 0 == options.iterations) {
+            throw std::runtime_error("Expected at least one object and one iteration!");
+        }
+
+        return options;
+    }
+
+    struct alignas(sizeof(glm::vec4)) ObjectT {
+        glm::mat4 model;
+        glm::mat3x4 normal;
+    };
+
+    glm::mat3x4 toStd430(const glm::mat3& normal) {
+        return glm::mat3x4(glm::vec4(normal[0], 0.0F), glm::vec4(normal[1], 0.0F), glm::vec4(normal[2], 0.0F));
+    }
+
+    float getError(const std::vector<ObjectT>& objects, const std::vector<glm::mat3x4>& reference) {
+        auto error = 0.0F;
+
+        for (std::size_t i = 0; i < objects.size(); i++) {
+            for (int c = 0; c < 3; c++) {
+                auto expected = glm::vec3(reference[i][c]);
+                auto difference = glm::abs(glm::vec3(objects[i].normal[c]) - expected);
+
+                error = std::max(error, std::max(std::max(difference.x, difference.y), difference.z) / std::max(1.0F, glm::length(expected)));
+            }
+        }
+
+        return error;
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+
+    std::cout << std::setw(10) << "objects" << std::setw(12) << "method" << std::setw(12) << "ns/matrix"
+        << std::setw(10) << "speedup" << std::setw(12) << "max error" << std::endl;
+
+    for (auto count : options.objects) {
+        auto random = std::mt19937(1234);
+        auto unit = std::uniform_real_distribution<float> (0.0F, 1.0F);
+        auto objects = std::vector<ObjectT> (count);
+        auto reference = std::vector<glm::mat3x4> (count);
+
+        for (auto& object : objects) {
+            auto axis = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + 0.1F);
+            auto scale = glm::vec3(0.2F + unit(random) * 4.0F, 0.2F + unit(random) * 4.0F, 0.2F + unit(random) * 4.0F);
+
+            object.model = glm::translate(glm::mat4(1.0F), (glm::vec3(unit(random), unit(random), unit(random)) - 0.5F) * 100.0F);
+            object.model = glm::scale(glm::rotate(object.model, unit(random) * 6.2831853F, axis), scale);
+        }
+
+        auto models = std::vector<glm::mat4> (count);
+
+        for (std::size_t i = 0; i < count; i++) {
+            models[i] = objects[i].model;
+            reference[i] = toStd430(glm::mat3(glm::transpose(glm::inverse(models[i]))));
+        }
+
+        struct Method {
+            const char * name;
+            std::function<void ()> run;
+        };
+
+        auto methods = std::vector<Method> ({
+            { "glm mat4", [&] {
+                for (std::size_t i = 0; i < count; i++) {
+                    objects[i].normal = toStd430(glm::mat3(glm::transpose(glm::inverse(objects[i].model))));
+                }
+            } },
+            { "glm mat3", [&] {
+                for (std::size_t i = 0; i < count; i++) {
+                    objects[i].normal = toStd430(glm::transpose(glm::inverse(glm::mat3(objects[i].model))));
+                }
+            } }
+        });
+
+        for (auto level : { gfx::SimdLevel::SCALAR, gfx::SimdLevel::SSE, gfx::SimdLevel::AVX2 }) {
+            if (level > gfx::getBestSimdLevel()) {
+                continue;
+            }
+
+            methods.push_back({ gfx::getSimdLevelName(level), [&, level] {
+                gfx::computeNormalMatrices(models.data(), count, &objects[0].normal, sizeof(ObjectT), gfx::NormalMatrixLayout::MAT3, level);
+            } });
+        }
+
+        auto baselineNs = 0.0;
+
+        for (const auto& method : methods) {
+            for (auto& object : objects) {
+                object.normal = glm::mat3x4(0.0F);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+
+            for (unsigned int i = 0; i < options.iterations; i++) {
+                method.run();
+            }
+
+            auto ns = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now() - start).count() / (static_cast<double> (count) * options.iterations);
+            auto error = getError(objects, reference);
+
+            baselineNs = 0.0 == baselineNs ? ns : baselineNs;
+
+            std::cout << std::fixed << std::setprecision(3) << std::setw(10) << count << std::setw(12) << method.name
+                << std::setw(12) << ns << std::setw(10) << baselineNs / ns
+                << std::setw(12) << std::scientific << std::setprecision(2) << error << std::endl;
+
+            if (error > TOLERANCE) {
+                std::cerr << "[ERROR]: " << method.name << " differs from glm" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,490 @@
+/**
+ * benchOcclusion - Software occlusion culling benchmark (OpenGL 4.5)
+ *
+ * Walks a street-level camera through a grid of buildings with props scattered everywhere,
+ * most of them hidden behind or inside the blocks. Buildings are frustum-culled on the CPU and
+ * always drawn. Props are culled by one of three modes:
+ *
+ *   frustum  gfx::FrustumCuller only.
+ *   cpu      gfx::FrustumCuller, then gfx::OcclusionCuller, which rasterizes the buildings into a
+ *            coarse depth buffer on worker threads. Reports the share culled and its CPU cost.
+ *            With --validate, first checks that an occluder crossing the near plane hides nothing
+ *            behind it, as the GPU clips the part in front of the plane away.
+ *   hiz      gfx::HiZCuller tests every prop against a depth pyramid built from the previous
+ *            frame and compacts the survivors into one indirect draw; nothing returns to the CPU.
+ *            With --validate, each frame reads the result back and checks it against a brute-force
+ *            per-pixel test of the same depth, failing if a visible prop was culled.
+ *
+ * Options: --props N (default 50000), --mode frustum|cpu|hiz (default cpu), --validate,
+ * plus the gfx::Context options.
+ */
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "context.hpp"
+#include "debug_logger.hpp"
+#include "frustum_culler.hpp"
+#include "gpu_profiler.hpp"
+#include "hiz_culler.hpp"
+#include "indirect_batch.hpp"
+#include "occlusion_culler.hpp"
+#include "shader_program.hpp"
+#include "storage_buffer.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+    constexpr int BLOCKS = 12;
+    constexpr float BLOCK_SPACING = 24.0F;
+    constexpr float BLOCK_HALF_SIZE = 8.0F;
+    constexpr float EYE_HEIGHT = 1.7F;
+    constexpr float FAR_PLANE = 300.0F;
+
+    // The reference looks a hair inside each box's footprint, so rounding differences from the GPU's
+    // projection can only make it see less, never report a false cull.
+    constexpr float PIXEL_EPSILON = 1e-3F;
+    constexpr float DEPTH_EPSILON = 1e-5F;
+
+    enum class CullMode {
+        FRUSTUM,
+        CPU,
+        HIZ
+    };
+
+    struct alignas(sizeof(glm::vec4)) ObjectT {
+        glm::mat4 model;
+        glm::vec4 color;
+    };
+
+    struct BenchOptions {
+        unsigned int props;
+        CullMode mode;
+        bool validate;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { 50000, CullMode::CPU, false };
+
+        for (int i = 1; i < argc; i++) {
+            if (0 == std::strcmp("--validate", argv[i])) {
+                options.validate = true;
+            } else if (0 == std::strcmp("--props", argv[i]) && i + 1 < argc) {
+                options.props = static_cast<unsigned int> (gfx::parseNumber(argv[++i], "--props"));
+            } else if (0 == std::strcmp("--mode", argv[i]) && i + 1 < argc) {
+                auto mode = std::string(argv[++i]);
+
+                if ("frustum" == mode) {
+                    options.mode = CullMode::FRUSTUM;
+                } else if ("cpu" == mode) {
+                    options.mode = CullMode::CPU;
+                } else if ("hiz" == mode) {
+                    options.mode = CullMode::HIZ;
+                } else {
+                    throw std::runtime_error("Expected --mode frustum, cpu or hiz!");
+                }
+            }
+        }
+
+        if (0 == options.props) {
+            throw std::runtime_error("Expected at least one prop!");
+        }
+
+        return options;
+    }
+
+    glm::mat4 makeBox(const glm::vec3& center, const glm::vec3& halfSize) {
+        return glm::scale(glm::translate(glm::mat4(1.0F), center), halfSize);
+    }
+
+    bool isVisibleReference(const gfx::HiZBox& box, const glm::mat4& viewProj, const std::vector<float>& depth, int width, int height) {
+        auto minX = 1.0F;
+        auto maxX = 0.0F;
+        auto minY = 1.0F;
+        auto maxY = 0.0F;
+        auto nearest = 1.0F;
+
+        for (int corner = 0; corner < 8; corner++) {
+            auto position = glm::vec4(corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y, corner & 4 ? box.max.z : box.min.z, 1.0F);
+            auto clip = viewProj * position;
+
+            if (clip.w < 1e-4F) {
+                return true;
+            }
+
+            minX = std::min(minX, clip.x / clip.w * 0.5F + 0.5F);
+            maxX = std::max(maxX, clip.x / clip.w * 0.5F + 0.5F);
+            minY = std::min(minY, clip.y / clip.w * 0.5F + 0.5F);
+            maxY = std::max(maxY, clip.y / clip.w * 0.5F + 0.5F);
+            nearest = std::min(nearest, clip.z / clip.w * 0.5F + 0.5F);
+        }
+
+        if (minX > 1.0F || minY > 1.0F || maxX < 0.0F || maxY < 0.0F || nearest > 1.0F) {
+            return false;
+        }
+
+        auto x0 = std::max(static_cast<int> (std::floor(minX * width + PIXEL_EPSILON)), 0);
+        auto x1 = std::min(static_cast<int> (std::floor(maxX * width - PIXEL_EPSILON)), width - 1);
+        auto y0 = std::max(static_cast<int> (std::floor(minY * height + PIXEL_EPSILON)), 0);
+        auto y1 = std::min(static_cast<int> (std::floor(maxY * height - PIXEL_EPSILON)), height - 1);
+
+        for (auto y = y0; y <= y1; y++) {
+            for (auto x = x0; x <= x1; x++) {
+                if (depth[y * width + x] >= nearest + DEPTH_EPSILON) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // A triangle from just in front of the near plane to just behind it, covering the middle of the
+    // screen, must not hide a box further down the view direction.
+    bool checkNearPlaneOccluder() {
+        auto pCuller = std::make_unique<gfx::OcclusionCuller> ();
+
+        pCuller->addOccluder({ { -1.0F, -1.0F, -0.05F }, { 1.0F, -1.0F, -0.05F }, { 0.0F, 1.0F, -0.15F } }, { 0, 1, 2 }, glm::mat4(1.0F));
+        pCuller->rasterize(glm::perspective(glm::radians(60.0F), 2.0F, 0.1F, FAR_PLANE));
+
+        return pCuller->isVisible(glm::vec3(-0.5F, -0.5F, -10.5F), glm::vec3(0.5F, 0.5F, -9.5F));
+    }
+
+    const char * getModeName(CullMode mode) {
+        switch (mode) {
+            case CullMode::FRUSTUM:
+                return "frustum";
+
+            case CullMode::HIZ:
+                return "hiz";
+
+            default:
+                return "cpu";
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+
+    if (CullMode::CPU == options.mode && options.validate && !checkNearPlaneOccluder()) {
+        std::cerr << "[ERROR]: an occluder crossing the near plane hid a box behind it" << std::endl;
+        return 1;
+    }
+
+    auto pContext = gfx::Context::create(gfx::parseContextInfo(argc, argv, "benchOcclusion"));
+    auto pDebugLogger = std::make_unique<gfx::DebugLogger> ();
+
+    auto pProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_VERTEX_SHADER, "data/shaders/benchOcclusion/object.vert" },
+            { GL_FRAGMENT_SHADER, "data/shaders/benchOcclusion/object.frag" }
+        }));
+
+    auto pVisibleProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_VERTEX_SHADER, "data/shaders/benchOcclusion/visible_object.vert" },
+            { GL_FRAGMENT_SHADER, "data/shaders/benchOcclusion/object.frag" }
+        }));
+
+    const auto positions = std::vector<glm::vec3> ({
+        { -1.0F, -1.0F, -1.0F }, { 1.0F, -1.0F, -1.0F }, { 1.0F, 1.0F, -1.0F }, { -1.0F, 1.0F, -1.0F },
+        { -1.0F, -1.0F, 1.0F }, { 1.0F, -1.0F, 1.0F }, { 1.0F, 1.0F, 1.0F }, { -1.0F, 1.0F, 1.0F }
+    });
+
+    const auto indices = std::vector<std::uint32_t> ({
+        0, 2, 1, 0, 3, 2,
+        4, 5, 6, 4, 6, 7,
+        0, 1, 5, 0, 5, 4,
+        3, 6, 2, 3, 7, 6,
+        0, 4, 7, 0, 7, 3,
+        1, 2, 6, 1, 6, 5
+    });
+
+    GLuint vbo;
+    glCreateBuffers(1, &vbo);
+    glNamedBufferData(vbo, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+
+    GLuint ibo;
+    glCreateBuffers(1, &ibo);
+    glNamedBufferData(ibo, indices.size() * sizeof(std::uint32_t), indices.data(), GL_STATIC_DRAW);
+
+    GLuint vao;
+    glCreateVertexArrays(1, &vao);
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vao, 0, 0);
+    glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(glm::vec3));
+    glVertexArrayElementBuffer(vao, ibo);
+
+    // Rendered offscreen so the depth buffer can be sampled; the color is blitted to the context afterwards.
+    auto width = pContext->getWidth();
+    auto height = pContext->getHeight();
+
+    GLuint colorbuffer;
+    glCreateRenderbuffers(1, &colorbuffer);
+    glNamedRenderbufferStorage(colorbuffer, GL_RGBA8, width, height);
+
+    GLuint depthTexture;
+    glCreateTextures(GL_TEXTURE_2D, 1, &depthTexture);
+    glTextureStorage2D(depthTexture, 1, GL_DEPTH_COMPONENT32F, width, height);
+
+    GLuint framebuffer;
+    glCreateFramebuffers(1, &framebuffer);
+    glNamedFramebufferRenderbuffer(framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorbuffer);
+    glNamedFramebufferTexture(framebuffer, GL_DEPTH_ATTACHMENT, depthTexture, 0);
+
+    if (GL_FRAMEBUFFER_COMPLETE != glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER)) {
+        throw std::runtime_error("Offscreen framebuffer is incomplete!");
+    }
+
+    // Props first, then buildings: an index below options.props is a prop.
+    auto objectCount = options.props + BLOCKS * BLOCKS;
+    auto pObjects = std::make_unique<gfx::StorageBuffer<ObjectT>> (objectCount);
+    auto pFrustumCuller = std::make_unique<gfx::FrustumCuller> (objectCount);
+    auto pOcclusionCuller = std::make_unique<gfx::OcclusionCuller> ();
+    auto pBounds = std::make_unique<gfx::StorageBuffer<gfx::HiZBox>> (options.props);
+    auto pHiZCuller = std::make_unique<gfx::HiZCuller> (width, height);
+
+    auto random = std::mt19937(1234);
+    auto unit = std::uniform_real_distribution<float> (0.0F, 1.0F);
+    auto extent = BLOCKS * BLOCK_SPACING * 0.5F;
+
+    pOcclusionCuller->resize(options.props);
+
+    for (unsigned int i = 0; i < options.props; i++) {
+        auto halfSize = glm::vec3(0.2F + unit(random) * 0.8F);
+        auto center = glm::vec3((unit(random) * 2.0F - 1.0F) * extent, halfSize.y, (unit(random) * 2.0F - 1.0F) * extent);
+
+        pObjects->write(i, { makeBox(center, halfSize), glm::vec4(unit(random), unit(random), unit(random), 1.0F) });
+        pFrustumCuller->setBox(i, center - halfSize, center + halfSize);
+        pOcclusionCuller->setBox(i, center - halfSize, center + halfSize);
+        pBounds->write(i, { glm::vec4(center - halfSize, 0.0F), glm::vec4(center + halfSize, 0.0F) });
+    }
+
+    for (int i = 0; i < BLOCKS * BLOCKS; i++) {
+        auto height = 5.0F + unit(random) * 20.0F;
+        auto halfSize = glm::vec3(BLOCK_HALF_SIZE, height, BLOCK_HALF_SIZE);
+        auto center = glm::vec3((i % BLOCKS + 0.5F) * BLOCK_SPACING - extent, height, (i / BLOCKS + 0.5F) * BLOCK_SPACING - extent);
+        auto model = makeBox(center, halfSize);
+
+        pObjects->write(options.props + i, { model, glm::vec4(glm::vec3(0.3F + unit(random) * 0.2F), 1.0F) });
+        pFrustumCuller->setBox(options.props + i, center - halfSize, center + halfSize);
+        pOcclusionCuller->addOccluder(positions, indices, model);
+    }
+
+    pObjects->flush();
+    pBounds->flush();
+
+    // Hi-Z survivors: their indices, and the single indirect command that draws them as instances.
+    const auto resetCommand = gfx::DrawElementsIndirectCommand { static_cast<GLuint> (indices.size()), 0, 0, 0, 0 };
+
+    GLuint visibleBuffer;
+    glCreateBuffers(1, &visibleBuffer);
+    glNamedBufferStorage(visibleBuffer, options.props * sizeof(std::uint32_t), nullptr, 0);
+
+    GLuint commandBuffer;
+    glCreateBuffers(1, &commandBuffer);
+    glNamedBufferStorage(commandBuffer, sizeof(resetCommand), &resetCommand, GL_DYNAMIC_STORAGE_BIT);
+
+    auto pGpuProfiler = std::make_unique<gfx::GpuProfiler> ();
+    auto pThreadPool = std::make_unique<gfx::ThreadPool> ();
+    auto inFrustum = std::vector<std::uint32_t> ();
+    auto candidates = std::vector<std::uint32_t> ();
+    auto buildings = std::vector<std::uint32_t> ();
+    auto visible = std::vector<std::uint32_t> ();
+    auto gpuVisible = std::vector<std::uint32_t> ();
+    auto kept = std::vector<bool> ();
+    auto depth = std::vector<float> (width * height);
+
+    glClearColor(0.5F, 0.6F, 0.7F, 0.0F);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    auto trProj = glm::perspective(glm::radians(60.0F), static_cast<float> (pContext->getWidth()) / pContext->getHeight(), 0.1F, FAR_PLANE);
+    auto frames = 0UL;
+    auto candidateSum = 0.0;
+    auto culledSum = 0.0;
+    auto drawSum = 0.0;
+    auto rasterizeMs = 0.0;
+    auto testMs = 0.0;
+    auto referenceSum = 0.0;
+    auto gpuSum = 0.0;
+    auto falseCulls = 0UL;
+    auto t = 0.0F;
+
+    while (!pContext->shouldClose()) {
+        pGpuProfiler->beginFrame();
+
+        // Up and down the street between the first two columns of blocks, glancing left and right.
+        auto eye = glm::vec3(BLOCK_SPACING - extent, EYE_HEIGHT, std::sin(t * 0.1F) * extent * 0.9F);
+        auto direction = glm::vec3(std::sin(t) * 0.6F, 0.0F, -1.0F);
+        auto trViewProj = trProj * glm::lookAt(eye, eye + direction, glm::vec3(0.0F, 1.0F, 0.0F));
+
+        pFrustumCuller->cull(trViewProj, inFrustum, pThreadPool.get());
+
+        candidates.clear();
+        buildings.clear();
+
+        for (auto index : inFrustum) {
+            (index < options.props ? candidates : buildings).push_back(index);
+        }
+
+        if (CullMode::CPU == options.mode) {
+            pOcclusionCuller->rasterize(trViewProj, pThreadPool.get());
+            pOcclusionCuller->cull(candidates, visible, pThreadPool.get());
+
+            const auto& stats = pOcclusionCuller->getStats();
+            culledSum += stats.culled;
+            rasterizeMs += stats.rasterizeMs;
+            testMs += stats.testMs;
+        } else if (CullMode::FRUSTUM == options.mode) {
+            visible = candidates;
+        } else {
+            GFX_GPU_SCOPE(*pGpuProfiler, "hi-z cull");
+
+            if (0 == frames) {
+                pHiZCuller->reset(trViewProj);
+            }
+
+            visible.clear();
+
+            glNamedBufferSubData(commandBuffer, 0, sizeof(resetCommand), &resetCommand);
+            pHiZCuller->cull(pBounds->getHandle(), options.props, visibleBuffer, commandBuffer);
+        }
+
+        if (CullMode::HIZ == options.mode && options.validate) {
+            auto command = gfx::DrawElementsIndirectCommand {};
+            glGetNamedBufferSubData(commandBuffer, 0, sizeof(command), &command);
+
+            gpuVisible.resize(command.instanceCount);
+            glGetNamedBufferSubData(visibleBuffer, 0, gpuVisible.size() * sizeof(std::uint32_t), gpuVisible.data());
+            glGetTextureImage(pHiZCuller->getPyramidHandle(), 0, GL_RED, GL_FLOAT, static_cast<GLsizei> (depth.size() * sizeof(float)), depth.data());
+
+            kept.assign(options.props, false);
+
+            for (auto index : gpuVisible) {
+                kept[index] = true;
+            }
+
+            for (unsigned int i = 0; i < options.props; i++) {
+                if (isVisibleReference((*pBounds)[i], pHiZCuller->getViewProj(), depth, width, height)) {
+                    referenceSum++;
+                    falseCulls += kept[i] ? 0 : 1;
+                }
+            }
+
+            gpuSum += gpuVisible.size();
+        }
+
+        visible.insert(visible.end(), buildings.begin(), buildings.end());
+
+        candidateSum += candidates.size();
+        drawSum += visible.size();
+        frames++;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        {
+            GFX_GPU_SCOPE(*pGpuProfiler, "draw");
+
+            glUseProgram(pProgram->getHandle());
+            glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(trViewProj));
+            pObjects->bind(0);
+            glBindVertexArray(vao);
+
+            for (auto index : visible) {
+                glUniform1ui(1, index);
+                glDrawElements(GL_TRIANGLES, static_cast<GLsizei> (indices.size()), GL_UNSIGNED_INT, 0);
+            }
+
+            if (CullMode::HIZ == options.mode) {
+                glUseProgram(pVisibleProgram->getHandle());
+                glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(trViewProj));
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+                glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+            }
+        }
+
+        if (CullMode::HIZ == options.mode) {
+            GFX_GPU_SCOPE(*pGpuProfiler, "hi-z build");
+
+            pHiZCuller->build(depthTexture, trViewProj);
+        }
+
+        glBlitNamedFramebuffer(framebuffer, pContext->getFramebuffer(), 0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, pContext->getFramebuffer());
+
+        pContext->swapBuffers();
+        pContext->pollEvents();
+        pGpuProfiler->endFrame();
+
+        t += 0.01F;
+    }
+
+    std::cout.precision(3);
+    std::cout << std::fixed << options.props << " props, " << getModeName(options.mode)
+        << ": " << candidateSum / frames << " in frustum, " << drawSum / frames << " direct draws per frame" << std::endl;
+
+    if (CullMode::HIZ == options.mode) {
+        auto command = gfx::DrawElementsIndirectCommand {};
+        glGetNamedBufferSubData(commandBuffer, 0, sizeof(command), &command);
+
+        std::cout << "hi-z kept " << command.instanceCount << " of " << options.props << " props in the last frame" << std::endl;
+    }
+
+    if (CullMode::HIZ == options.mode && options.validate) {
+        std::cout << "validation: " << gpuSum / frames << " kept on the GPU, " << referenceSum / frames
+            << " visible in the brute-force reference per frame, " << falseCulls << " false culls" << std::endl;
+    }
+
+    if (CullMode::CPU == options.mode) {
+        std::cout << "occlusion culled " << 100.0 * culledSum / std::max(candidateSum, 1.0) << "% of in-frustum props, rasterize "
+            << rasterizeMs / frames << " ms, test " << testMs / frames << " ms per frame on "
+            << pThreadPool->getThreadCount() << " threads" << std::endl;
+    }
+
+    pGpuProfiler->report(std::cout);
+
+    pThreadPool = nullptr;
+    pGpuProfiler = nullptr;
+    pHiZCuller = nullptr;
+    pBounds = nullptr;
+    pOcclusionCuller = nullptr;
+    pFrustumCuller = nullptr;
+    pObjects = nullptr;
+
+    glDeleteBuffers(1, &commandBuffer);
+    glDeleteBuffers(1, &visibleBuffer);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &depthTexture);
+    glDeleteRenderbuffers(1, &colorbuffer);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ibo);
+
+    pVisibleProgram = nullptr;
+    pProgram = nullptr;
+    pDebugLogger = nullptr;
+    pContext = nullptr;
+
+    if (0 != falseCulls) {
+        std::cerr << "[ERROR]: hi-z culled props the brute-force reference sees" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
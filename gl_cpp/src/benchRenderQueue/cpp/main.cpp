@@ -0,0 +1,258 @@
+/**
+ * benchRenderQueue - Render queue benchmark (OpenGL 4.5)
+ *
+ * Draws a randomized field of cubes, each picking one of several programs, materials and
+ * textures, either in submission order or sorted by the render queue's 64-bit keys.
+ * All binds go through gfx::StateCache, so the issued/skipped counters show how much state
+ * the sort saves. Reports the CPU cost of sorting and submission per frame.
+ *
+ * Options: --draws N (default 10000), --unsorted, plus the gfx::Context options.
+ */
+
+#include <GL/glew.h>
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "context.hpp"
+#include "debug_logger.hpp"
+#include "render_queue.hpp"
+#include "shader_program.hpp"
+#include "state_cache.hpp"
+#include "util.hpp"
+
+namespace {
+    constexpr unsigned int PROGRAM_COUNT = 8;
+    constexpr unsigned int MATERIAL_COUNT = 64;
+    constexpr unsigned int TEXTURE_COUNT = 16;
+    constexpr GLsizei TEXTURE_SIZE = 4;
+    constexpr float FAR_PLANE = 100.0F;
+
+    struct ObjectT {
+        glm::mat4 mvp;
+    };
+
+    struct MaterialT {
+        glm::vec4 color;
+    };
+
+    struct Object {
+        unsigned int program;
+        unsigned int material;
+        unsigned int texture;
+        float depth;
+    };
+
+    struct BenchOptions {
+        unsigned int draws;
+        bool sorted;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { 10000, true };
+
+        for (int i = 1; i < argc; i++) {
+            if (0 == std::strcmp("--unsorted", argv[i])) {
+                options.sorted = false;
+            } else if (0 == std::strcmp("--draws", argv[i]) && i + 1 < argc) {
+                options.draws = static_cast<unsigned int> (gfx::parseNumber(argv[++i], "--draws"));
+            }
+        }
+
+        if (0 == options.draws) {
+            throw std::runtime_error("Expected at least one draw!");
+        }
+
+        return options;
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+    auto pContext = gfx::Context::create(gfx::parseContextInfo(argc, argv, "benchRenderQueue"));
+    auto pDebugLogger = std::make_unique<gfx::DebugLogger> ();
+
+    // Identical sources, but separate program objects: switching between them costs the same as real variants.
+    auto programs = std::vector<std::unique_ptr<gfx::ShaderProgram>> ();
+
+    for (unsigned int i = 0; i < PROGRAM_COUNT; i++) {
+        programs.push_back(std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+                { GL_VERTEX_SHADER, "data/shaders/benchRenderQueue/object.vert" },
+                { GL_FRAGMENT_SHADER, "data/shaders/benchRenderQueue/object.frag" }
+            })));
+    }
+
+    const auto positions = std::array<glm::vec3, 8> ({{
+        { -1.0F, -1.0F, -1.0F }, { 1.0F, -1.0F, -1.0F }, { 1.0F, 1.0F, -1.0F }, { -1.0F, 1.0F, -1.0F },
+        { -1.0F, -1.0F, 1.0F }, { 1.0F, -1.0F, 1.0F }, { 1.0F, 1.0F, 1.0F }, { -1.0F, 1.0F, 1.0F }
+    }});
+
+    const auto indices = std::array<GLushort, 36> ({{
+        0, 2, 1, 0, 3, 2,
+        4, 5, 6, 4, 6, 7,
+        0, 1, 5, 0, 5, 4,
+        3, 6, 2, 3, 7, 6,
+        0, 4, 7, 0, 7, 3,
+        1, 2, 6, 1, 6, 5
+    }});
+
+    GLuint vbo;
+    glCreateBuffers(1, &vbo);
+    glNamedBufferData(vbo, sizeof(positions), positions.data(), GL_STATIC_DRAW);
+
+    GLuint ibo;
+    glCreateBuffers(1, &ibo);
+    glNamedBufferData(ibo, sizeof(indices), indices.data(), GL_STATIC_DRAW);
+
+    GLuint vao;
+    glCreateVertexArrays(1, &vao);
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vao, 0, 0);
+
+    auto random = std::mt19937(1234);
+    auto unit = std::uniform_real_distribution<float> (0.0F, 1.0F);
+
+    auto textures = std::array<GLuint, TEXTURE_COUNT> ();
+    glCreateTextures(GL_TEXTURE_2D, TEXTURE_COUNT, textures.data());
+
+    for (auto texture : textures) {
+        auto texels = std::vector<GLuint> (TEXTURE_SIZE * TEXTURE_SIZE);
+
+        for (auto& texel : texels) {
+            texel = random() | 0xFF000000;
+        }
+
+        glTextureStorage2D(texture, 1, GL_RGBA8, TEXTURE_SIZE, TEXTURE_SIZE);
+        glTextureSubImage2D(texture, 0, 0, 0, TEXTURE_SIZE, TEXTURE_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    GLint uboAlignment;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uboAlignment);
+
+    auto alignedSizeofMaterialT = gfx::util::alignUp(sizeof(MaterialT), uboAlignment);
+    auto alignedSizeofObjectT = gfx::util::alignUp(sizeof(ObjectT), uboAlignment);
+    auto objectsOffset = alignedSizeofMaterialT * MATERIAL_COUNT;
+    auto uniformData = std::vector<char> (objectsOffset + alignedSizeofObjectT * options.draws);
+
+    for (unsigned int i = 0; i < MATERIAL_COUNT; i++) {
+        auto pMaterial = reinterpret_cast<MaterialT *> (uniformData.data() + i * alignedSizeofMaterialT);
+        pMaterial->color = glm::vec4(unit(random), unit(random), unit(random), 1.0F);
+    }
+
+    auto trProj = glm::perspective(glm::radians(60.0F), static_cast<float> (pContext->getWidth()) / pContext->getHeight(), 0.1F, FAR_PLANE);
+    auto objects = std::vector<Object> (options.draws);
+
+    for (unsigned int i = 0; i < options.draws; i++) {
+        auto position = glm::vec3(unit(random) * 80.0F - 40.0F, unit(random) * 50.0F - 25.0F, -5.0F - unit(random) * 90.0F);
+        auto trModel = glm::translate(glm::mat4(1.0F), position);
+        trModel = glm::rotate(trModel, unit(random) * 6.28F, glm::normalize(glm::vec3(unit(random), unit(random), 0.1F)));
+        trModel = glm::scale(trModel, glm::vec3(0.5F));
+
+        auto pObject = reinterpret_cast<ObjectT *> (uniformData.data() + objectsOffset + i * alignedSizeofObjectT);
+        pObject->mvp = trProj * trModel;
+
+        objects[i] = { static_cast<unsigned int> (random() % PROGRAM_COUNT), static_cast<unsigned int> (random() % MATERIAL_COUNT),
+            static_cast<unsigned int> (random() % TEXTURE_COUNT), -position.z / FAR_PLANE };
+    }
+
+    GLuint ubo;
+    glCreateBuffers(1, &ubo);
+    glNamedBufferStorage(ubo, uniformData.size(), uniformData.data(), 0);
+
+    auto pStateCache = std::make_unique<gfx::StateCache> ();
+    auto pRenderQueue = std::make_unique<gfx::RenderQueue> ();
+
+    glClearColor(0.0F, 0.0F, 0.0F, 0.0F);
+    glEnable(GL_DEPTH_TEST);
+
+    auto frames = 0UL;
+    auto sortMs = 0.0;
+    auto submitMs = 0.0;
+
+    while (!pContext->shouldClose()) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        auto start = std::chrono::steady_clock::now();
+
+        pRenderQueue->clear();
+
+        for (unsigned int i = 0; i < options.draws; i++) {
+            const auto& object = objects[i];
+            auto packet = gfx::DrawPacket {};
+
+            packet.program = programs[object.program]->getHandle();
+            packet.vertexArray = vao;
+            packet.vertexBuffer = vbo;
+            packet.vertexStride = sizeof(glm::vec3);
+            packet.elementBuffer = ibo;
+            packet.indexType = GL_UNSIGNED_SHORT;
+            packet.texture = textures[object.texture];
+            packet.objectBuffer = ubo;
+            packet.objectOffset = objectsOffset + i * alignedSizeofObjectT;
+            packet.objectSize = sizeof(ObjectT);
+            packet.materialBuffer = ubo;
+            packet.materialOffset = object.material * alignedSizeofMaterialT;
+            packet.materialSize = sizeof(MaterialT);
+            packet.count = static_cast<GLsizei> (indices.size());
+            packet.first = 0;
+
+            pRenderQueue->push(gfx::RenderQueue::makeKey(0, object.program, object.material, object.texture, object.depth), packet);
+        }
+
+        if (options.sorted) {
+            pRenderQueue->sort();
+        }
+
+        auto sorted = std::chrono::steady_clock::now();
+
+        pRenderQueue->submit(*pStateCache);
+
+        auto submitted = std::chrono::steady_clock::now();
+
+        sortMs += std::chrono::duration<double, std::milli> (sorted - start).count();
+        submitMs += std::chrono::duration<double, std::milli> (submitted - sorted).count();
+        frames++;
+
+        pContext->swapBuffers();
+        pContext->pollEvents();
+    }
+
+    const auto& stats = pStateCache->getStats();
+
+    std::cout.precision(3);
+    std::cout << std::fixed << options.draws << " draws, " << (options.sorted ? "sorted" : "unsorted") << ": build + sort "
+        << sortMs / frames << " ms, submit " << submitMs / frames << " ms, state changes issued "
+        << static_cast<double> (stats.issued) / frames << ", skipped " << static_cast<double> (stats.skipped) / frames
+        << " per frame" << std::endl;
+
+    pRenderQueue = nullptr;
+    pStateCache = nullptr;
+
+    glDeleteBuffers(1, &ubo);
+    glDeleteTextures(TEXTURE_COUNT, textures.data());
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ibo);
+
+    programs.clear();
+
+    pDebugLogger = nullptr;
+    pContext = nullptr;
+
+    return 0;
+}
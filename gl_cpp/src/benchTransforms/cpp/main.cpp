@@ -0,0 +1,159 @@
+/**
+ * benchTransforms - transform hierarchy update benchmark
+ *
+ * Builds a random forest in gfx::TransformHierarchy (1% roots, every other object parented to a
+ * random earlier one) and animates a share of the local rotations each frame: all of them, a
+ * tenth and a hundredth. Times update() on the calling thread alone and across a gfx::ThreadPool
+ * against the 1 ms budget, then checks every world and normal matrix against a naive recursive
+ * glm::inverse reference.
+ *
+ * Options: --objects N (default 100000), --threads N (default: one per core), --frames N (default 100).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "context.hpp"
+#include "thread_pool.hpp"
+#include "transform_hierarchy.hpp"
+
+namespace {
+    constexpr double BUDGET_MS = 1.0;
+    constexpr float TOLERANCE = 1e-3F;
+
+    struct BenchOptions {
+        std::uint32_t objects;
+        unsigned int threads;
+        unsigned int frames;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { 100000, 0, 100 };
+
+        for (int i = 1; i < argc; i++) {
+            if (0 == std::strcmp("--objects", argv[i])) {
+                options.objects = static_cast<std::uint32_t> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--objects"));
+            } else if (0 == std::strcmp("--threads", argv[i])) {
+                options.threads = static_cast<unsigned int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--threads"));
+            } else if (0 == std::strcmp("--frames", argv[i])) {
+                options.frames = static_cast<unsigned int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--frames"));
+            }
+        }
+
+        if (0 == options.objects || 0 == options.frames) {
+            throw std::runtime_error("Expected at least one object and one frame!");
+        }
+
+        return options;
+    }
+
+    float getError(const glm::vec3& a, const glm::vec3& b) {
+        auto difference = glm::abs(a - b);
+
+        return std::max(std::max(difference.x, difference.y), difference.z) / std::max(1.0F, glm::length(b));
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+    auto pThreadPool = std::make_unique<gfx::ThreadPool> (options.threads);
+    auto pTransforms = std::make_unique<gfx::TransformHierarchy> ();
+    auto random = std::mt19937(1234);
+    auto unit = std::uniform_real_distribution<float> (0.0F, 1.0F);
+    auto axes = std::vector<glm::vec3> (options.objects);
+
+    for (std::uint32_t i = 0; i < options.objects; i++) {
+        auto translation = (glm::vec3(unit(random), unit(random), unit(random)) - 0.5F) * 10.0F;
+        auto scale = glm::vec3(0.5F + unit(random), 0.5F + unit(random), 0.5F + unit(random));
+
+        axes[i] = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + 0.1F);
+
+        if (0 == i || unit(random) < 0.01F) {
+            pTransforms->addRoot(translation, glm::angleAxis(unit(random), axes[i]), scale);
+        } else {
+            auto parent = static_cast<std::uint32_t> (unit(random) * i) % i;
+            pTransforms->add(parent, translation, glm::angleAxis(unit(random), axes[i]), scale);
+        }
+    }
+
+    pTransforms->update();
+
+    std::cout << options.objects << " objects in " << pTransforms->getLevelCount() << " levels" << std::endl;
+    std::cout << std::setw(10) << "dynamic %" << std::setw(9) << "threads" << std::setw(10) << "ms" << std::setw(10) << "budget" << std::setw(10) << "updated" << std::endl;
+
+    auto frame = 0U;
+
+    for (auto stride : { 1U, 10U, 100U }) {
+        for (auto pPool : { static_cast<gfx::ThreadPool *> (nullptr), pThreadPool.get() }) {
+            auto ms = 0.0;
+
+            for (unsigned int i = 0; i < options.frames; i++, frame++) {
+                auto t = frame * 0.01F;
+
+                for (auto object = frame % stride; object < options.objects; object += stride) {
+                    pTransforms->setRotation(object, glm::angleAxis(t + object, axes[object]));
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                pTransforms->update(pPool);
+                ms += std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+            }
+
+            ms /= options.frames;
+
+            // Moving a parent moves its subtree, so more objects are recomputed than were animated.
+            auto updated = 0U;
+
+            for (std::uint32_t object = 0; object < options.objects; object++) {
+                updated += pTransforms->wasUpdated(object) ? 1 : 0;
+            }
+
+            std::cout << std::fixed << std::setprecision(3) << std::setw(10) << 100.0 / stride
+                << std::setw(9) << (nullptr == pPool ? 1 : pPool->getThreadCount())
+                << std::setw(10) << ms << std::setw(10) << (ms < BUDGET_MS ? "ok" : "over") << std::setw(10) << updated << std::endl;
+        }
+    }
+
+    // Parents are always added before their children, so handle order is a valid evaluation order.
+    auto worlds = std::vector<glm::mat4> (options.objects);
+    auto maxError = 0.0F;
+
+    for (std::uint32_t i = 0; i < options.objects; i++) {
+        auto local = glm::translate(glm::mat4(1.0F), pTransforms->getTranslation(i))
+            * glm::mat4_cast(pTransforms->getRotation(i))
+            * glm::scale(glm::mat4(1.0F), pTransforms->getScale(i));
+
+        worlds[i] = pTransforms->isRoot(i) ? local : worlds[pTransforms->getParent(i)] * local;
+
+        auto normal = glm::transpose(glm::inverse(glm::mat3(worlds[i])));
+
+        for (int c = 0; c < 4; c++) {
+            maxError = std::max(maxError, getError(glm::vec3(pTransforms->getWorld(i)[c]), glm::vec3(worlds[i][c])));
+        }
+
+        for (int c = 0; c < 3; c++) {
+            maxError = std::max(maxError, getError(glm::vec3(pTransforms->getNormal(i)[c]), normal[c]));
+        }
+    }
+
+    std::cout << "max relative error against glm: " << std::scientific << maxError << std::endl;
+
+    if (maxError > TOLERANCE) {
+        std::cerr << "[ERROR]: transforms differ from the glm reference" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,271 @@
+/**
+ * benchVertexFormat - float versus quantized vertex format benchmark (OpenGL 4.5)
+ *
+ * Quantizes a mesh with gfx::quantizeVertices and reports the round trip error (position in mesh units,
+ * texcoord, normal angle in degrees), then draws it in both formats, --instances times per frame on a
+ * grid, and prints the vertex buffer size and mean GPU time of each:
+ *
+ *   float   gfx::Vertex, 32 bytes: vec3 position, vec2 texcoord, vec3 normal
+ *   packed  gfx::PackedVertex, 16 bytes: UNORM16 position over the bounds, half texcoord, octahedral SNORM16 normal
+ *
+ * The errors are checked against half a UNORM16 step for positions, half a half-float ulp for texcoords
+ * and 0.02 degrees for normals.
+ *
+ * Options: --file path (.obj or .glb; default: a torus of about --vertices N, default 1000000),
+ * --instances N (default 16), --frames N (measured frames, default 100), plus the gfx::Context options.
+ */
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "context.hpp"
+#include "debug_logger.hpp"
+#include "mesh.hpp"
+#include "mesh_importer.hpp"
+#include "mesh_optimizer.hpp"
+#include "shader_program.hpp"
+#include "test_meshes.hpp"
+#include "thread_pool.hpp"
+#include "vertex_quantizer.hpp"
+
+namespace {
+    constexpr unsigned int WARMUP_FRAMES = 10;
+    constexpr GLsizei GRID_SIDE = 4;
+    constexpr float MAX_NORMAL_ANGLE = 0.02F;
+
+    struct BenchOptions {
+        std::string file;
+        std::size_t vertices;
+        GLsizei instances;
+        unsigned int frames;
+    };
+
+    BenchOptions parseBenchOptions(int argc, char** argv) {
+        auto options = BenchOptions { "", 1000000, 16, 100 };
+
+        for (int i = 1; i < argc; i++) {
+            if (0 == std::strcmp("--file", argv[i])) {
+                options.file = gfx::getOptionValue(argc, argv, i);
+            } else if (0 == std::strcmp("--vertices", argv[i])) {
+                options.vertices = gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--vertices");
+            } else if (0 == std::strcmp("--instances", argv[i])) {
+                options.instances = static_cast<GLsizei> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--instances"));
+            } else if (0 == std::strcmp("--frames", argv[i])) {
+                options.frames = static_cast<unsigned int> (gfx::parseNumber(gfx::getOptionValue(argc, argv, i), "--frames"));
+            }
+        }
+
+        if (options.vertices < 16 || options.instances < 1 || 0 == options.frames) {
+            throw std::runtime_error("Expected at least 16 vertices, one instance and one frame!");
+        }
+
+        return options;
+    }
+
+    // Largest error half floats may give the texcoords: half an ulp of the largest, or of the smallest normal.
+    float getTexcoordTolerance(const std::vector<gfx::Vertex>& vertices) noexcept {
+        auto largest = 6.1035e-5F;
+
+        for (const auto& vertex : vertices) {
+            largest = std::max(largest, std::max(std::fabs(vertex.texcoord.x), std::fabs(vertex.texcoord.y)));
+        }
+
+        return std::ldexp(1.0F, std::ilogb(largest) - 11);
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parseBenchOptions(argc, argv);
+    auto mesh = gfx::Mesh {};
+
+    if (options.file.empty()) {
+        auto sides = static_cast<std::size_t> (std::sqrt(options.vertices / 4.0));
+        mesh = gfx::createTorus(sides * 4, sides);
+    } else {
+        auto pThreadPool = std::make_unique<gfx::ThreadPool> ();
+        mesh = gfx::importMesh(options.file, pThreadPool.get());
+    }
+
+    gfx::optimizeMesh(mesh);
+
+    auto quantized = gfx::quantizeVertices(mesh.vertices);
+    auto error = gfx::getQuantizationError(mesh.vertices, quantized);
+    auto positionTolerance = 0.5F * glm::length(quantized.positionScale) / 65535.0F
+        + glm::length(glm::abs(quantized.positionOffset) + quantized.positionScale) * 1e-6F;
+    auto texcoordTolerance = getTexcoordTolerance(mesh.vertices);
+
+    std::cout << mesh.vertices.size() << " vertices, " << mesh.indices.size() / 3 << " triangles, " << options.instances << " instances" << std::endl;
+    std::cout << std::scientific << std::setprecision(3) << "max error: position " << error.maxPosition << " (tolerance "
+        << positionTolerance << "), texcoord " << error.maxTexcoord << " (tolerance " << texcoordTolerance << "), normal "
+        << std::fixed << std::setprecision(4) << error.maxNormalAngle << " deg (mean " << error.meanNormalAngle << " deg)" << std::endl;
+
+    if (error.maxPosition > positionTolerance || error.maxTexcoord > texcoordTolerance || error.maxNormalAngle > MAX_NORMAL_ANGLE) {
+        std::cerr << "[ERROR]: quantization error beyond tolerance" << std::endl;
+        return 1;
+    }
+
+    auto info = gfx::parseContextInfo(argc, argv, "benchVertexFormat");
+    info.frames = WARMUP_FRAMES + options.frames;
+
+    auto pContext = gfx::Context::create(info);
+    auto pDebugLogger = std::make_unique<gfx::DebugLogger> ();
+
+    auto pFloatProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_VERTEX_SHADER, "data/shaders/benchVertexFormat/float.vert" },
+            { GL_FRAGMENT_SHADER, "data/shaders/benchVertexFormat/shade.frag" }
+        }));
+
+    auto pPackedProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_VERTEX_SHADER, "data/shaders/benchVertexFormat/packed.vert" },
+            { GL_FRAGMENT_SHADER, "data/shaders/benchVertexFormat/shade.frag" }
+        }));
+
+    GLuint floatVbo;
+    glCreateBuffers(1, &floatVbo);
+    glNamedBufferData(floatVbo, mesh.vertices.size() * sizeof(gfx::Vertex), mesh.vertices.data(), GL_STATIC_DRAW);
+
+    GLuint packedVbo;
+    glCreateBuffers(1, &packedVbo);
+    glNamedBufferData(packedVbo, quantized.vertices.size() * sizeof(gfx::PackedVertex), quantized.vertices.data(), GL_STATIC_DRAW);
+
+    GLuint ibo;
+    glCreateBuffers(1, &ibo);
+    glNamedBufferData(ibo, mesh.indices.size() * sizeof(std::uint32_t), mesh.indices.data(), GL_STATIC_DRAW);
+
+    GLuint floatVao;
+    glCreateVertexArrays(1, &floatVao);
+    glEnableVertexArrayAttrib(floatVao, 0);
+    glVertexArrayAttribFormat(floatVao, 0, 3, GL_FLOAT, GL_FALSE, offsetof(gfx::Vertex, position));
+    glVertexArrayAttribBinding(floatVao, 0, 0);
+    glEnableVertexArrayAttrib(floatVao, 1);
+    glVertexArrayAttribFormat(floatVao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(gfx::Vertex, texcoord));
+    glVertexArrayAttribBinding(floatVao, 1, 0);
+    glEnableVertexArrayAttrib(floatVao, 2);
+    glVertexArrayAttribFormat(floatVao, 2, 3, GL_FLOAT, GL_FALSE, offsetof(gfx::Vertex, normal));
+    glVertexArrayAttribBinding(floatVao, 2, 0);
+    glVertexArrayVertexBuffer(floatVao, 0, floatVbo, 0, sizeof(gfx::Vertex));
+    glVertexArrayElementBuffer(floatVao, ibo);
+
+    GLuint packedVao;
+    glCreateVertexArrays(1, &packedVao);
+    gfx::setPackedVertexFormat(packedVao);
+    glVertexArrayVertexBuffer(packedVao, 0, packedVbo, 0, sizeof(gfx::PackedVertex));
+    glVertexArrayElementBuffer(packedVao, ibo);
+
+    // A begin and end timestamp per format and measured frame, the two formats drawn back to back every frame.
+    // Timestamps, as gfx::GpuProfiler uses, rather than GL_TIME_ELAPSED queries, which can't nest.
+    auto floatQueries = std::vector<GLuint> (options.frames * 2);
+    auto packedQueries = std::vector<GLuint> (options.frames * 2);
+    glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei> (floatQueries.size()), floatQueries.data());
+    glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei> (packedQueries.size()), packedQueries.data());
+
+    auto boundsCenter = quantized.positionOffset + quantized.positionScale * 0.5F;
+    auto radius = std::max(glm::length(quantized.positionScale) * 0.5F, 1e-3F);
+    auto rows = (options.instances + GRID_SIDE - 1) / GRID_SIDE;
+    auto gridExtent = glm::vec2(std::min(options.instances, GRID_SIDE), rows) * radius * 2.0F;
+    auto target = glm::vec3(gridExtent.x * 0.5F - radius, 0.0F, gridExtent.y * 0.5F - radius) + boundsCenter;
+    auto distance = std::max(gridExtent.x, gridExtent.y) * 1.2F;
+    auto indexCount = static_cast<GLsizei> (mesh.indices.size());
+    auto frame = 0U;
+
+    glClearColor(0.0F, 0.0F, 0.0F, 0.0F);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    auto draw = [&] (GLuint program, GLuint vao, bool packed, const GLuint * pQueries, bool measured) {
+        auto trView = glm::lookAt(target + glm::vec3(0.0F, distance, distance), target, glm::vec3(0.0F, 1.0F, 0.0F));
+        auto trProj = glm::perspective(glm::radians(60.0F), static_cast<float> (pContext->getWidth()) / pContext->getHeight(), distance * 0.05F, distance * 4.0F);
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        if (measured) {
+            glQueryCounter(pQueries[0], GL_TIMESTAMP);
+        }
+
+        glUseProgram(program);
+        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(trProj * trView));
+        glUniform2f(1, radius * 2.0F, static_cast<float> (GRID_SIDE));
+
+        if (packed) {
+            glUniform3fv(2, 1, glm::value_ptr(quantized.positionOffset));
+            glUniform3fv(3, 1, glm::value_ptr(quantized.positionScale));
+        }
+
+        glBindVertexArray(vao);
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, options.instances);
+
+        if (measured) {
+            glQueryCounter(pQueries[1], GL_TIMESTAMP);
+        }
+    };
+
+    while (!pContext->shouldClose() && frame < WARMUP_FRAMES + options.frames) {
+        auto measured = frame >= WARMUP_FRAMES;
+        auto slot = measured ? frame - WARMUP_FRAMES : 0;
+
+        draw(pFloatProgram->getHandle(), floatVao, false, &floatQueries[slot * 2], measured);
+        draw(pPackedProgram->getHandle(), packedVao, true, &packedQueries[slot * 2], measured);
+
+        pContext->swapBuffers();
+        pContext->pollEvents();
+
+        frame++;
+    }
+
+    if (frame == WARMUP_FRAMES + options.frames) {
+        auto getMeanMs = [] (const std::vector<GLuint>& queries) {
+            auto ms = 0.0;
+
+            for (std::size_t i = 0; i < queries.size(); i += 2) {
+                GLuint64 begin;
+                GLuint64 end;
+                glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(queries[i + 1], GL_QUERY_RESULT, &end);
+
+                ms += static_cast<double> (end - begin) * 1e-6;
+            }
+
+            return ms / (queries.size() / 2);
+        };
+
+        auto floatMs = getMeanMs(floatQueries);
+        auto packedMs = getMeanMs(packedQueries);
+
+        std::cout << std::setw(8) << "format" << std::setw(8) << "bytes" << std::setw(12) << "vertex MB" << std::setw(10) << "gpu ms" << std::endl;
+        std::cout << std::fixed << std::setprecision(3) << std::setw(8) << "float" << std::setw(8) << sizeof(gfx::Vertex)
+            << std::setw(12) << mesh.vertices.size() * sizeof(gfx::Vertex) / 1e6 << std::setw(10) << floatMs << std::endl;
+        std::cout << std::setw(8) << "packed" << std::setw(8) << sizeof(gfx::PackedVertex)
+            << std::setw(12) << quantized.vertices.size() * sizeof(gfx::PackedVertex) / 1e6 << std::setw(10) << packedMs
+            << "  (" << std::setprecision(2) << floatMs / packedMs << "x)" << std::endl;
+    }
+
+    pPackedProgram = nullptr;
+    pFloatProgram = nullptr;
+
+    glDeleteQueries(static_cast<GLsizei> (packedQueries.size()), packedQueries.data());
+    glDeleteQueries(static_cast<GLsizei> (floatQueries.size()), floatQueries.data());
+    glDeleteVertexArrays(1, &packedVao);
+    glDeleteVertexArrays(1, &floatVao);
+    glDeleteBuffers(1, &ibo);
+    glDeleteBuffers(1, &packedVbo);
+    glDeleteBuffers(1, &floatVbo);
+
+    pDebugLogger = nullptr;
+    pContext = nullptr;
+
+    return 0;
+}
@@ -0,0 +1,611 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include "frustum_culler.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+    constexpr unsigned int BIN_COUNT = 16;
+    constexpr std::uint32_t MAX_LEAF_SIZE = 4;
+    constexpr std::uint32_t MIN_PARALLEL_SUBTREE = 4096;
+    // Visiting a node (stack traffic and two child tests) costs about four object box tests.
+    constexpr float TRAVERSAL_COST = 1.0F;
+    constexpr float INTERSECT_COST = 0.25F;
+    constexpr unsigned int ALL_PLANES = 0x3F;
+    constexpr std::uint32_t NO_PARENT = std::numeric_limits<std::uint32_t>::max();
+
+    // Below this depth nodes are halved at the median instead, which keeps every tree under
+    // SAH_DEPTH_LIMIT + 32 levels and lets the queries use fixed stacks.
+    constexpr std::uint32_t SAH_DEPTH_LIMIT = 64;
+    constexpr std::size_t STACK_SIZE = 128;
+
+    struct BuildTask {
+        std::uint32_t node;
+        std::uint32_t begin;
+        std::uint32_t end;
+        std::uint32_t depth;
+    };
+
+    struct BuildInput {
+        const gfx::Aabb * pBounds;
+        const glm::vec3 * pCentroids;
+        std::uint32_t * pObjects;
+    };
+
+    float getHalfArea(const glm::vec3& min, const glm::vec3& max) noexcept {
+        auto size = max - min;
+
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    float getNodeCost(const gfx::BvhNode& node) noexcept {
+        auto area = getHalfArea(node.min, node.max);
+
+        return 0 == node.count ? TRAVERSAL_COST * area : INTERSECT_COST * area * node.count;
+    }
+
+    void grow(glm::vec3& min, glm::vec3& max, const glm::vec3& boundsMin, const glm::vec3& boundsMax) noexcept {
+        min = glm::min(min, boundsMin);
+        max = glm::max(max, boundsMax);
+    }
+
+    unsigned int getBin(float centroid, float origin, float scale, unsigned int binCount) noexcept {
+        return std::min(static_cast<unsigned int> ((centroid - origin) * scale), binCount - 1);
+    }
+
+    // Fills in nodes[task.node]. When it is worth splitting, two children are appended and returned as tasks.
+    bool split(const BuildInput& input, std::vector<gfx::BvhNode>& nodes, const BuildTask& task, BuildTask& left, BuildTask& right) {
+        auto min = glm::vec3(std::numeric_limits<float>::max());
+        auto max = glm::vec3(-std::numeric_limits<float>::max());
+        auto centroidMin = min;
+        auto centroidMax = max;
+
+        for (auto i = task.begin; i < task.end; i++) {
+            auto object = input.pObjects[i];
+
+            grow(min, max, input.pBounds[object].min, input.pBounds[object].max);
+            grow(centroidMin, centroidMax, input.pCentroids[object], input.pCentroids[object]);
+        }
+
+        auto count = task.end - task.begin;
+        nodes[task.node] = { min, task.begin, max, count };
+
+        if (count <= 1) {
+            return false;
+        }
+
+        // Small nodes dominate the node count, so they get no more bins than objects.
+        auto binCount = std::min(BIN_COUNT, count);
+        auto extent = centroidMax - centroidMin;
+        auto bestCost = std::numeric_limits<float>::max();
+        auto bestAxis = -1;
+        auto bestBin = 0U;
+
+        for (int axis = 0; axis < 3 && task.depth < SAH_DEPTH_LIMIT; axis++) {
+            if (extent[axis] <= 0.0F) {
+                continue;
+            }
+
+            std::uint32_t binCounts[BIN_COUNT] = {};
+            glm::vec3 binMin[BIN_COUNT];
+            glm::vec3 binMax[BIN_COUNT];
+
+            for (unsigned int b = 0; b < binCount; b++) {
+                binMin[b] = glm::vec3(std::numeric_limits<float>::max());
+                binMax[b] = glm::vec3(-std::numeric_limits<float>::max());
+            }
+
+            auto scale = binCount / extent[axis];
+
+            for (auto i = task.begin; i < task.end; i++) {
+                auto object = input.pObjects[i];
+                auto b = getBin(input.pCentroids[object][axis], centroidMin[axis], scale, binCount);
+
+                binCounts[b]++;
+                grow(binMin[b], binMax[b], input.pBounds[object].min, input.pBounds[object].max);
+            }
+
+            // Right-hand sums first, then a left-to-right sweep over the binCount - 1 split planes.
+            std::uint32_t rightCounts[BIN_COUNT];
+            float rightAreas[BIN_COUNT];
+            auto sweepMin = glm::vec3(std::numeric_limits<float>::max());
+            auto sweepMax = glm::vec3(-std::numeric_limits<float>::max());
+            auto sweepCount = 0U;
+
+            for (auto b = binCount - 1; b > 0; b--) {
+                sweepCount += binCounts[b];
+                grow(sweepMin, sweepMax, binMin[b], binMax[b]);
+                rightCounts[b] = sweepCount;
+                rightAreas[b] = 0 == sweepCount ? 0.0F : getHalfArea(sweepMin, sweepMax);
+            }
+
+            sweepMin = glm::vec3(std::numeric_limits<float>::max());
+            sweepMax = glm::vec3(-std::numeric_limits<float>::max());
+            sweepCount = 0;
+
+            for (unsigned int b = 1; b < binCount; b++) {
+                sweepCount += binCounts[b - 1];
+                grow(sweepMin, sweepMax, binMin[b - 1], binMax[b - 1]);
+
+                if (0 == sweepCount || 0 == rightCounts[b]) {
+                    continue;
+                }
+
+                auto cost = sweepCount * getHalfArea(sweepMin, sweepMax) + rightCounts[b] * rightAreas[b];
+
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        auto area = getHalfArea(min, max);
+        auto leafCost = count * INTERSECT_COST;
+        auto splitCost = 0 <= bestAxis && area > 0.0F ? TRAVERSAL_COST + INTERSECT_COST * bestCost / area : std::numeric_limits<float>::max();
+
+        if (count <= MAX_LEAF_SIZE && leafCost <= splitCost) {
+            return false;
+        }
+
+        auto pBegin = input.pObjects + task.begin;
+        auto pEnd = input.pObjects + task.end;
+        auto pMiddle = pBegin;
+
+        if (0 <= bestAxis) {
+            auto scale = binCount / extent[bestAxis];
+
+            pMiddle = std::partition(pBegin, pEnd, [&] (std::uint32_t object) {
+                return getBin(input.pCentroids[object][bestAxis], centroidMin[bestAxis], scale, binCount) < bestBin;
+            });
+        } else {
+            // Coincident centroids or the depth limit: halve along the widest centroid axis.
+            auto axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+            pMiddle = pBegin + count / 2;
+
+            std::nth_element(pBegin, pMiddle, pEnd, [&] (std::uint32_t a, std::uint32_t b) {
+                return input.pCentroids[a][axis] < input.pCentroids[b][axis];
+            });
+        }
+
+        auto middle = task.begin + static_cast<std::uint32_t> (pMiddle - pBegin);
+        auto child = static_cast<std::uint32_t> (nodes.size());
+
+        nodes[task.node].first = child;
+        nodes[task.node].count = 0;
+        nodes.push_back(gfx::BvhNode {});
+        nodes.push_back(gfx::BvhNode {});
+
+        left = { child, task.begin, middle, task.depth + 1 };
+        right = { child + 1, middle, task.end, task.depth + 1 };
+
+        return true;
+    }
+
+    // Builds everything below root on the calling thread, except tasks of at most deferSize objects,
+    // which are handed to pDeferred when it is given.
+    void buildSubtree(const BuildInput& input, std::vector<gfx::BvhNode>& nodes, const BuildTask& root, std::uint32_t deferSize, std::vector<BuildTask> * pDeferred) {
+        auto tasks = std::vector<BuildTask> ({ root });
+
+        while (!tasks.empty()) {
+            auto task = tasks.back();
+            tasks.pop_back();
+
+            if (nullptr != pDeferred && task.end - task.begin <= deferSize) {
+                pDeferred->push_back(task);
+                continue;
+            }
+
+            auto left = BuildTask {};
+            auto right = BuildTask {};
+
+            if (split(input, nodes, task, left, right)) {
+                tasks.push_back(right);
+                tasks.push_back(left);
+            }
+        }
+    }
+
+    // Drops the planes the box lies entirely inside of from mask; false once it is outside any of them.
+    bool testPlanes(const std::array<glm::vec4, 6>& planes, const glm::vec3& min, const glm::vec3& max, unsigned int& mask) noexcept {
+        auto center = (min + max) * 0.5F;
+        auto extent = (max - min) * 0.5F;
+
+        for (unsigned int p = 0; p < planes.size(); p++) {
+            if (0 == (mask & (1U << p))) {
+                continue;
+            }
+
+            auto normal = glm::vec3(planes[p]);
+            auto d = glm::dot(normal, center) + planes[p].w;
+            auto e = glm::dot(glm::abs(normal), extent);
+
+            if (d + e <= 0.0F) {
+                return false;
+            }
+
+            if (d - e > 0.0F) {
+                mask &= ~(1U << p);
+            }
+        }
+
+        return true;
+    }
+
+    bool overlapsSphere(const glm::vec3& min, const glm::vec3& max, const glm::vec3& center, float radiusSquared) noexcept {
+        auto offset = center - glm::min(glm::max(center, min), max);
+
+        return glm::dot(offset, offset) <= radiusSquared;
+    }
+
+    bool intersectBox(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance) noexcept {
+        auto tNear = 0.0F;
+        auto tFar = maxDistance;
+
+        for (int axis = 0; axis < 3; axis++) {
+            // A ray parallel to a slab is inside it everywhere or nowhere; the products below would be
+            // 0 * inf = NaN for one lying on a slab plane.
+            if (std::isinf(inverseDirection[axis])) {
+                if (origin[axis] < min[axis] || origin[axis] > max[axis]) {
+                    return false;
+                }
+
+                continue;
+            }
+
+            auto t0 = (min[axis] - origin[axis]) * inverseDirection[axis];
+            auto t1 = (max[axis] - origin[axis]) * inverseDirection[axis];
+
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        }
+
+        distance = tNear;
+
+        return tNear <= tFar;
+    }
+}
+
+namespace gfx {
+    Bvh::Bvh(std::size_t count) {
+        _nodeCost = 0.0;
+        _builtCost = 0.0F;
+
+        resize(count);
+    }
+
+    std::size_t Bvh::size() const noexcept {
+        return _bounds.size();
+    }
+
+    void Bvh::resize(std::size_t count) {
+        _bounds.resize(count, Aabb { glm::vec3(0.0F), glm::vec3(0.0F) });
+        _nodes.clear();
+        _objects.clear();
+        _parents.clear();
+        _leaves.clear();
+        _dirtyObjects.clear();
+        _dirtyNodes.clear();
+        _refitNodes.clear();
+        _nodeCost = 0.0;
+        _builtCost = 0.0F;
+    }
+
+    const Aabb& Bvh::getBounds(std::size_t index) const noexcept {
+        return _bounds[index];
+    }
+
+    void Bvh::setBounds(std::size_t index, const Aabb& bounds) {
+        _bounds[index] = bounds;
+
+        if (!_leaves.empty()) {
+            _dirtyObjects.push_back(static_cast<std::uint32_t> (index));
+        }
+    }
+
+    const std::vector<BvhNode>& Bvh::getNodes() const noexcept {
+        return _nodes;
+    }
+
+    float Bvh::getSahCost() const noexcept {
+        if (_nodes.empty()) {
+            return 0.0F;
+        }
+
+        auto rootArea = getHalfArea(_nodes[0].min, _nodes[0].max);
+
+        return rootArea > 0.0F ? static_cast<float> (_nodeCost / rootArea) : 0.0F;
+    }
+
+    float Bvh::getBuiltSahCost() const noexcept {
+        return _builtCost;
+    }
+
+    void Bvh::build(ThreadPool * pThreadPool) {
+        auto count = static_cast<std::uint32_t> (_bounds.size());
+
+        _centroids.resize(count);
+        _objects.resize(count);
+        _nodes.clear();
+        _dirtyObjects.clear();
+
+        for (std::uint32_t i = 0; i < count; i++) {
+            _centroids[i] = (_bounds[i].min + _bounds[i].max) * 0.5F;
+            _objects[i] = i;
+        }
+
+        if (0 != count) {
+            auto input = BuildInput { _bounds.data(), _centroids.data(), _objects.data() };
+            auto root = BuildTask { 0, 0, count, 0 };
+
+            _nodes.reserve(2 * count);
+            _nodes.push_back(BvhNode {});
+
+            if (nullptr == pThreadPool || 1 == pThreadPool->getThreadCount()) {
+                buildSubtree(input, _nodes, root, 0, nullptr);
+            } else {
+                auto deferSize = std::max(count / (pThreadPool->getThreadCount() * 8), MIN_PARALLEL_SUBTREE);
+                auto deferred = std::vector<BuildTask> ();
+
+                buildSubtree(input, _nodes, root, deferSize, &deferred);
+
+                // Deferred subtrees own disjoint object ranges, so they partition in place without locking.
+                auto subtrees = std::vector<std::vector<BvhNode>> (deferred.size());
+
+                pThreadPool->run(static_cast<unsigned int> (deferred.size()), [&] (unsigned int i) {
+                    auto& nodes = subtrees[i];
+
+                    nodes.reserve(2 * (deferred[i].end - deferred[i].begin));
+                    nodes.push_back(BvhNode {});
+
+                    buildSubtree(input, nodes, { 0, deferred[i].begin, deferred[i].end, deferred[i].depth }, 0, nullptr);
+                });
+
+                // Each subtree's root replaces its placeholder; the rest is appended, so local child index k lands at base + k.
+                for (std::size_t i = 0; i < subtrees.size(); i++) {
+                    auto base = static_cast<std::uint32_t> (_nodes.size()) - 1;
+
+                    for (std::size_t k = 0; k < subtrees[i].size(); k++) {
+                        auto node = subtrees[i][k];
+
+                        if (0 == node.count) {
+                            node.first += base;
+                        }
+
+                        if (0 == k) {
+                            _nodes[deferred[i].node] = node;
+                        } else {
+                            _nodes.push_back(node);
+                        }
+                    }
+                }
+            }
+        }
+
+        linkNodes();
+
+        _nodeCost = 0.0;
+
+        for (const auto& node : _nodes) {
+            _nodeCost += getNodeCost(node);
+        }
+
+        _builtCost = getSahCost();
+    }
+
+    void Bvh::linkNodes() {
+        _parents.assign(_nodes.size(), NO_PARENT);
+        _leaves.assign(_nodes.empty() ? 0 : _bounds.size(), 0);
+        _dirtyNodes.assign(_nodes.size(), 0);
+
+        for (std::uint32_t i = 0; i < _nodes.size(); i++) {
+            const auto& node = _nodes[i];
+
+            if (0 == node.count) {
+                _parents[node.first] = i;
+                _parents[node.first + 1] = i;
+            } else {
+                for (auto k = node.first; k < node.first + node.count; k++) {
+                    _leaves[_objects[k]] = i;
+                }
+            }
+        }
+    }
+
+    void Bvh::refit() {
+        if (_dirtyObjects.empty()) {
+            return;
+        }
+
+        for (auto object : _dirtyObjects) {
+            for (auto node = _leaves[object]; NO_PARENT != node && 0 == _dirtyNodes[node]; node = _parents[node]) {
+                _dirtyNodes[node] = 1;
+                _refitNodes.push_back(node);
+            }
+        }
+
+        _dirtyObjects.clear();
+
+        // Children are always stored after their parent, so visiting the dirty nodes backwards refits them first.
+        std::sort(_refitNodes.begin(), _refitNodes.end(), std::greater<std::uint32_t> ());
+
+        for (auto i : _refitNodes) {
+            auto& node = _nodes[i];
+            _dirtyNodes[i] = 0;
+            _nodeCost -= getNodeCost(node);
+
+            if (0 == node.count) {
+                node.min = glm::min(_nodes[node.first].min, _nodes[node.first + 1].min);
+                node.max = glm::max(_nodes[node.first].max, _nodes[node.first + 1].max);
+            } else {
+                node.min = glm::vec3(std::numeric_limits<float>::max());
+                node.max = glm::vec3(-std::numeric_limits<float>::max());
+
+                for (auto k = node.first; k < node.first + node.count; k++) {
+                    grow(node.min, node.max, _bounds[_objects[k]].min, _bounds[_objects[k]].max);
+                }
+            }
+
+            _nodeCost += getNodeCost(node);
+        }
+
+        _refitNodes.clear();
+    }
+
+    void Bvh::queryFrustum(const glm::mat4& viewProj, std::vector<std::uint32_t>& objects) const {
+        if (_nodes.empty()) {
+            return;
+        }
+
+        auto planes = FrustumCuller::extractPlanes(viewProj);
+        std::uint32_t stack[STACK_SIZE];
+        unsigned int masks[STACK_SIZE];
+        auto depth = std::size_t(0);
+
+        stack[depth] = 0;
+        masks[depth++] = ALL_PLANES;
+
+        // Once a node is inside a plane its whole subtree is, so the mask only shrinks on the way down.
+        while (0 < depth) {
+            depth--;
+
+            const auto& node = _nodes[stack[depth]];
+            auto mask = masks[depth];
+
+            if (!testPlanes(planes, node.min, node.max, mask)) {
+                continue;
+            }
+
+            if (0 == node.count) {
+                stack[depth] = node.first + 1;
+                masks[depth++] = mask;
+                stack[depth] = node.first;
+                masks[depth++] = mask;
+                continue;
+            }
+
+            for (auto k = node.first; k < node.first + node.count; k++) {
+                auto object = _objects[k];
+                auto objectMask = mask;
+
+                if (testPlanes(planes, _bounds[object].min, _bounds[object].max, objectMask)) {
+                    objects.push_back(object);
+                }
+            }
+        }
+    }
+
+    void Bvh::querySphere(const glm::vec3& center, float radius, std::vector<std::uint32_t>& objects) const {
+        if (_nodes.empty()) {
+            return;
+        }
+
+        auto radiusSquared = radius * radius;
+        std::uint32_t stack[STACK_SIZE];
+        auto depth = std::size_t(0);
+
+        stack[depth++] = 0;
+
+        while (0 < depth) {
+            const auto& node = _nodes[stack[--depth]];
+
+            if (!overlapsSphere(node.min, node.max, center, radiusSquared)) {
+                continue;
+            }
+
+            if (0 == node.count) {
+                stack[depth++] = node.first + 1;
+                stack[depth++] = node.first;
+                continue;
+            }
+
+            for (auto k = node.first; k < node.first + node.count; k++) {
+                auto object = _objects[k];
+
+                if (overlapsSphere(_bounds[object].min, _bounds[object].max, center, radiusSquared)) {
+                    objects.push_back(object);
+                }
+            }
+        }
+    }
+
+    bool Bvh::intersectRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const noexcept {
+        auto inverseDirection = glm::vec3(1.0F) / direction;
+        auto distance = 0.0F;
+
+        if (_nodes.empty() || !intersectBox(_nodes[0].min, _nodes[0].max, origin, inverseDirection, maxDistance, distance)) {
+            return false;
+        }
+
+        std::uint32_t stack[STACK_SIZE];
+        float entries[STACK_SIZE];
+        auto depth = std::size_t(0);
+        auto found = false;
+
+        stack[depth] = 0;
+        entries[depth++] = distance;
+        hit.distance = maxDistance;
+
+        // Nearer children are visited first, so most of the far side is rejected by the shrinking hit distance.
+        while (0 < depth) {
+            depth--;
+
+            if (entries[depth] > hit.distance) {
+                continue;
+            }
+
+            const auto& node = _nodes[stack[depth]];
+
+            if (0 == node.count) {
+                auto nearDistance = 0.0F;
+                auto farDistance = 0.0F;
+                auto nearNode = node.first;
+                auto farNode = node.first + 1;
+                auto hitNear = intersectBox(_nodes[nearNode].min, _nodes[nearNode].max, origin, inverseDirection, hit.distance, nearDistance);
+                auto hitFar = intersectBox(_nodes[farNode].min, _nodes[farNode].max, origin, inverseDirection, hit.distance, farDistance);
+
+                if (hitNear && hitFar && farDistance < nearDistance) {
+                    std::swap(nearNode, farNode);
+                    std::swap(nearDistance, farDistance);
+                } else if (!hitNear) {
+                    nearNode = farNode;
+                    nearDistance = farDistance;
+                    hitNear = hitFar;
+                    hitFar = false;
+                }
+
+                if (hitFar) {
+                    stack[depth] = farNode;
+                    entries[depth++] = farDistance;
+                }
+
+                if (hitNear) {
+                    stack[depth] = nearNode;
+                    entries[depth++] = nearDistance;
+                }
+
+                continue;
+            }
+
+            for (auto k = node.first; k < node.first + node.count; k++) {
+                auto object = _objects[k];
+
+                if (intersectBox(_bounds[object].min, _bounds[object].max, origin, inverseDirection, hit.distance, distance)
+                        && (!found || distance < hit.distance)) {
+                    hit.object = object;
+                    hit.distance = distance;
+                    found = true;
+                }
+            }
+        }
+
+        return found;
+    }
+}
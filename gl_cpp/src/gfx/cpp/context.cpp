@@ -0,0 +1,532 @@
+#include "context.hpp"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "cpu_profiler.hpp"
+#include "frame_benchmark.hpp"
+#include "gl_stats.hpp"
+
+namespace {
+    void errorCallback(int error, const char * desc) {
+        std::cerr << "GLFW Error(" << std::dec << error << "): " << desc << std::endl;
+    }
+
+    [[noreturn]] void throwInvalidValue(const char * arg, const char * option) {
+        auto msg = std::stringstream();
+        msg << "Invalid value for " << option << ": \"" << arg << "\"";
+
+        throw std::runtime_error(msg.str());
+    }
+
+    class WindowContext : public gfx::Context {
+        GLFWwindow * _window;
+
+    protected:
+        bool isCloseRequested() const noexcept override;
+
+        void present() noexcept override;
+
+    public:
+        explicit WindowContext(const gfx::ContextInfo& info);
+
+        ~WindowContext() noexcept override;
+
+        GLFWwindow * getWindow() const noexcept override;
+
+        GLuint getFramebuffer() const noexcept override;
+
+        void setTitle(const std::string& title) noexcept override;
+
+        void pollEvents() noexcept override;
+    };
+
+    WindowContext::WindowContext(const gfx::ContextInfo& info) : gfx::Context(info) {
+        glfwSetErrorCallback(errorCallback);
+
+        if (GLFW_TRUE != glfwInit()) {
+            throw std::runtime_error("Failed to init GLFW!");
+        }
+
+        glfwDefaultWindowHints();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, info.versionMajor);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, info.versionMinor);
+
+        _window = glfwCreateWindow(info.width, info.height, info.title.c_str(), nullptr, nullptr);
+
+        if (nullptr == _window) {
+            glfwTerminate();
+
+            throw std::runtime_error("Failed to create GLFW window!");
+        }
+
+        glfwMakeContextCurrent(_window);
+        glfwSwapInterval(info.benchmark.empty() ? 1 : 0);
+
+        GLenum glErr = glewInit();
+        if (glErr) {
+            auto msg = std::stringstream();
+
+            msg << "Failed to init GLEW: " << glewGetErrorString(glErr);
+
+            glfwDestroyWindow(_window);
+            glfwTerminate();
+
+            throw std::runtime_error(msg.str());
+        }
+    }
+
+    WindowContext::~WindowContext() noexcept {
+        releaseBenchmark();
+
+        glfwDestroyWindow(_window);
+
+        glfwTerminate();
+    }
+
+    bool WindowContext::isCloseRequested() const noexcept {
+        return glfwWindowShouldClose(_window);
+    }
+
+    void WindowContext::present() noexcept {
+        glfwSwapBuffers(_window);
+    }
+
+    GLFWwindow * WindowContext::getWindow() const noexcept {
+        return _window;
+    }
+
+    GLuint WindowContext::getFramebuffer() const noexcept {
+        return 0;
+    }
+
+    void WindowContext::setTitle(const std::string& title) noexcept {
+        glfwSetWindowTitle(_window, title.c_str());
+    }
+
+    void WindowContext::pollEvents() noexcept {
+        GFX_CPU_ZONE("poll events");
+
+        glfwPollEvents();
+    }
+
+    // Renders into an offscreen framebuffer on an EGL context with no surface at all, so it runs without an
+    // X server or GPU (e.g. Mesa llvmpipe).
+    class HeadlessContext : public gfx::Context {
+        EGLDisplay _display;
+        EGLContext _context;
+        GLuint _framebuffer;
+        GLuint _colorbuffer;
+        GLuint _depthbuffer;
+
+        void release() noexcept;
+
+    protected:
+        bool isCloseRequested() const noexcept override;
+
+        void present() noexcept override;
+
+    public:
+        explicit HeadlessContext(const gfx::ContextInfo& info);
+
+        ~HeadlessContext() noexcept override;
+
+        GLFWwindow * getWindow() const noexcept override;
+
+        GLuint getFramebuffer() const noexcept override;
+
+        void setTitle(const std::string& title) noexcept override;
+
+        void pollEvents() noexcept override;
+    };
+
+    HeadlessContext::HeadlessContext(const gfx::ContextInfo& info) : gfx::Context(info) {
+        _context = EGL_NO_CONTEXT;
+        _framebuffer = 0;
+        _colorbuffer = 0;
+        _depthbuffer = 0;
+
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC> (eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+        if (nullptr == getPlatformDisplay) {
+            throw std::runtime_error("EGL_EXT_platform_base is not supported!");
+        }
+
+        _display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+        if (EGL_NO_DISPLAY == _display) {
+            throw std::runtime_error("Failed to get surfaceless EGL display!");
+        }
+
+        EGLint major, minor;
+        if (EGL_TRUE != eglInitialize(_display, &major, &minor)) {
+            throw std::runtime_error("Failed to init EGL!");
+        }
+
+        if (EGL_TRUE != eglBindAPI(EGL_OPENGL_API)) {
+            release();
+
+            throw std::runtime_error("Failed to bind the OpenGL API!");
+        }
+
+        const EGLint configAttribs[] = {
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+
+        EGLConfig config;
+        EGLint numConfigs;
+        if (EGL_TRUE != eglChooseConfig(_display, configAttribs, &config, 1, &numConfigs) || 0 == numConfigs) {
+            release();
+
+            throw std::runtime_error("Failed to choose an EGL config!");
+        }
+
+        auto contextAttribs = std::vector<EGLint> ({
+            EGL_CONTEXT_MAJOR_VERSION, info.versionMajor,
+            EGL_CONTEXT_MINOR_VERSION, info.versionMinor
+        });
+
+        if (info.versionMajor > 3 || (3 == info.versionMajor && info.versionMinor >= 2)) {
+            contextAttribs.push_back(EGL_CONTEXT_OPENGL_PROFILE_MASK);
+            contextAttribs.push_back(EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT);
+        }
+
+        contextAttribs.push_back(EGL_NONE);
+
+        _context = eglCreateContext(_display, config, EGL_NO_CONTEXT, contextAttribs.data());
+
+        if (EGL_NO_CONTEXT == _context) {
+            release();
+
+            throw std::runtime_error("Failed to create EGL context!");
+        }
+
+        if (EGL_TRUE != eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, _context)) {
+            release();
+
+            throw std::runtime_error("Failed to make EGL context current!");
+        }
+
+        // glewInit() insists on a GLX display; glewContextInit() only loads the GL entry points.
+        GLenum glErr = glewContextInit();
+        if (glErr) {
+            auto msg = std::stringstream();
+
+            msg << "Failed to init GLEW: " << glewGetErrorString(glErr);
+
+            release();
+
+            throw std::runtime_error(msg.str());
+        }
+
+        glCreateRenderbuffers(1, &_colorbuffer);
+        glNamedRenderbufferStorage(_colorbuffer, GL_RGBA8, info.width, info.height);
+
+        glCreateRenderbuffers(1, &_depthbuffer);
+        glNamedRenderbufferStorage(_depthbuffer, GL_DEPTH24_STENCIL8, info.width, info.height);
+
+        glCreateFramebuffers(1, &_framebuffer);
+        glNamedFramebufferRenderbuffer(_framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colorbuffer);
+        glNamedFramebufferRenderbuffer(_framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthbuffer);
+
+        if (GL_FRAMEBUFFER_COMPLETE != glCheckNamedFramebufferStatus(_framebuffer, GL_FRAMEBUFFER)) {
+            release();
+
+            throw std::runtime_error("Headless framebuffer is incomplete!");
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+        glViewport(0, 0, info.width, info.height);
+    }
+
+    HeadlessContext::~HeadlessContext() noexcept {
+        releaseBenchmark();
+        release();
+    }
+
+    void HeadlessContext::release() noexcept {
+        if (EGL_NO_CONTEXT != _context) {
+            // The names are only created once GLEW has loaded the entry points.
+            if (_framebuffer) {
+                glDeleteFramebuffers(1, &_framebuffer);
+                _framebuffer = 0;
+            }
+
+            if (_colorbuffer) {
+                glDeleteRenderbuffers(1, &_colorbuffer);
+                _colorbuffer = 0;
+            }
+
+            if (_depthbuffer) {
+                glDeleteRenderbuffers(1, &_depthbuffer);
+                _depthbuffer = 0;
+            }
+
+            eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(_display, _context);
+
+            _context = EGL_NO_CONTEXT;
+        }
+
+        eglTerminate(_display);
+    }
+
+    bool HeadlessContext::isCloseRequested() const noexcept {
+        return false;
+    }
+
+    void HeadlessContext::present() noexcept {
+        // Nothing to present; flushing keeps the driver from queueing frames without bound.
+        glFlush();
+    }
+
+    GLFWwindow * HeadlessContext::getWindow() const noexcept {
+        return nullptr;
+    }
+
+    GLuint HeadlessContext::getFramebuffer() const noexcept {
+        return _framebuffer;
+    }
+
+    void HeadlessContext::setTitle(const std::string& title) noexcept {}
+
+    void HeadlessContext::pollEvents() noexcept {}
+}
+
+namespace gfx {
+    unsigned long parseNumber(const char * arg, const char * option) {
+        char * end = nullptr;
+        auto value = 0UL;
+
+        // strtoul would skip leading blanks and wrap a minus sign around, so it only sees digits.
+        if (std::isdigit(static_cast<unsigned char> (*arg))) {
+            errno = 0;
+            value = std::strtoul(arg, &end, 10);
+        }
+
+        if (nullptr == end || '\0' != *end || ERANGE == errno) {
+            throwInvalidValue(arg, option);
+        }
+
+        return value;
+    }
+
+    float parseFloat(const char * arg, const char * option) {
+        char * end = nullptr;
+        auto value = 0.0F;
+
+        // As in parseNumber, no leading blanks; inf and nan are rejected along with anything out of range.
+        if (std::isdigit(static_cast<unsigned char> (*arg)) || '-' == *arg || '+' == *arg || '.' == *arg) {
+            errno = 0;
+            value = std::strtof(arg, &end);
+        }
+
+        if (nullptr == end || arg == end || '\0' != *end || ERANGE == errno || !std::isfinite(value)) {
+            throwInvalidValue(arg, option);
+        }
+
+        return value;
+    }
+
+    const char * getOptionValue(int argc, char** argv, int& i) {
+        if (i + 1 >= argc) {
+            auto msg = std::stringstream();
+            msg << "Missing value for " << argv[i];
+
+            throw std::runtime_error(msg.str());
+        }
+
+        return argv[++i];
+    }
+
+    ContextInfo parseContextInfo(int argc, char** argv, const std::string& title) {
+        auto info = ContextInfo { title, 640, 480, 4, 5, false, 0, std::string(), std::string(), 60, std::string(), false };
+
+        for (int i = 1; i < argc; i++) {
+            if (0 == std::strcmp("--headless", argv[i])) {
+                info.headless = true;
+            } else if (0 == std::strcmp("--frames", argv[i])) {
+                info.frames = static_cast<unsigned int> (parseNumber(getOptionValue(argc, argv, i), "--frames"));
+            } else if (0 == std::strcmp("--size", argv[i])) {
+                auto size = std::string(getOptionValue(argc, argv, i));
+                auto sep = size.find('x');
+
+                if (std::string::npos == sep) {
+                    throw std::runtime_error("Expected --size WIDTHxHEIGHT!");
+                }
+
+                info.width = static_cast<int> (parseNumber(size.substr(0, sep).c_str(), "--size"));
+                info.height = static_cast<int> (parseNumber(size.substr(sep + 1).c_str(), "--size"));
+            } else if (0 == std::strcmp("--screenshot", argv[i])) {
+                info.screenshot = getOptionValue(argc, argv, i);
+            } else if (0 == std::strcmp("--benchmark", argv[i])) {
+                info.benchmark = getOptionValue(argc, argv, i);
+            } else if (0 == std::strcmp("--warmup", argv[i])) {
+                info.warmupFrames = static_cast<unsigned int> (parseNumber(getOptionValue(argc, argv, i), "--warmup"));
+            } else if (0 == std::strcmp("--trace", argv[i])) {
+                info.trace = getOptionValue(argc, argv, i);
+            } else if (0 == std::strcmp("--gl-stats", argv[i])) {
+                info.glStats = true;
+            }
+        }
+
+        if (info.width <= 0 || info.height <= 0) {
+            throw std::runtime_error("Window size must be positive!");
+        }
+
+        if (!info.benchmark.empty() && 0 == info.frames) {
+            info.frames = 500;
+        }
+
+        // Without a display the loop can't be closed by the user, so default to a single frame.
+        if (info.headless && 0 == info.frames) {
+            info.frames = 1;
+        }
+
+        return info;
+    }
+
+    std::unique_ptr<Context> Context::create(const ContextInfo& info) {
+        auto pContext = std::unique_ptr<Context> ();
+
+        if (info.headless) {
+            pContext = std::make_unique<HeadlessContext> (info);
+        } else {
+            pContext = std::make_unique<WindowContext> (info);
+        }
+
+        if (!info.benchmark.empty()) {
+            pContext->_pBenchmark = std::make_unique<FrameBenchmark> (info);
+        }
+
+        if (!info.trace.empty()) {
+            CpuProfiler::setThreadName("main");
+            CpuProfiler::setEnabled(true);
+        }
+
+        if (info.glStats) {
+            GlStats::install();
+        }
+
+        return pContext;
+    }
+
+    Context::Context(const ContextInfo& info) noexcept {
+        _info = info;
+        _frame = 0;
+    }
+
+    Context::~Context() noexcept {
+        if (_info.glStats) {
+            GlStats::uninstall();
+            GlStats::report(std::cout);
+        }
+
+        if (_info.trace.empty()) {
+            return;
+        }
+
+        CpuProfiler::setEnabled(false);
+
+        try {
+            auto events = CpuProfiler::writeChromeTrace(_info.trace);
+
+            std::cout << _info.title << ": wrote " << events << " trace events to " << _info.trace << std::endl;
+        } catch (const std::exception& ex) {
+            std::cerr << "[ERROR]: " << ex.what() << std::endl;
+        }
+    }
+
+    void Context::releaseBenchmark() noexcept {
+        _pBenchmark = nullptr;
+    }
+
+    const ContextInfo& Context::getInfo() const noexcept {
+        return _info;
+    }
+
+    int Context::getWidth() const noexcept {
+        return _info.width;
+    }
+
+    int Context::getHeight() const noexcept {
+        return _info.height;
+    }
+
+    unsigned int Context::getFrame() const noexcept {
+        return _frame;
+    }
+
+    unsigned int Context::getTotalFrames() const noexcept {
+        // Benchmark warm-up frames come on top of the measured ones.
+        return _info.frames + (_pBenchmark ? _info.warmupFrames : 0);
+    }
+
+    bool Context::shouldClose() const noexcept {
+        return (_info.frames && _frame >= getTotalFrames()) || isCloseRequested();
+    }
+
+    void Context::swapBuffers() {
+        if (!_info.screenshot.empty() && _frame + 1 == getTotalFrames()) {
+            writeScreenshot();
+        }
+
+        if (_pBenchmark) {
+            _pBenchmark->beforePresent();
+        }
+
+        {
+            GFX_CPU_ZONE("present");
+            present();
+        }
+
+        if (_info.glStats) {
+            GlStats::endFrame();
+        }
+
+        if (_pBenchmark) {
+            _pBenchmark->afterPresent();
+        }
+
+        _frame++;
+    }
+
+    void Context::writeScreenshot() const {
+        auto rowSize = static_cast<std::size_t> (_info.width) * 3;
+        auto pixels = std::vector<char> (rowSize * _info.height);
+        auto framebuffer = getFramebuffer();
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glReadBuffer(framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, _info.width, _info.height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+        auto file = std::ofstream(_info.screenshot.c_str(), std::ios::binary);
+
+        if (!file) {
+            auto msg = std::stringstream();
+            msg << "Failed to open file: \"" << _info.screenshot << "\"";
+
+            throw std::runtime_error(msg.str());
+        }
+
+        file << "P6\n" << _info.width << " " << _info.height << "\n255\n";
+
+        // GL rows start at the bottom; PPM rows start at the top.
+        for (auto y = _info.height; y > 0; y--) {
+            file.write(pixels.data() + (y - 1) * rowSize, rowSize);
+        }
+    }
+}
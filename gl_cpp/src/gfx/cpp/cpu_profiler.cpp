@@ -0,0 +1,174 @@
+#include "cpu_profiler.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    struct CpuEvent {
+        const char * name;
+        std::uint64_t begin;
+        std::uint64_t end;
+    };
+
+    // Written only by its owning thread; the exporter reads up to the published head. Once full, the
+    // oldest events are overwritten so a long session keeps its most recent frames.
+    struct ThreadBuffer {
+        static constexpr std::size_t CAPACITY = 1 << 16;
+
+        std::vector<CpuEvent> events;
+        std::atomic<std::uint64_t> head;
+        unsigned int threadId;
+        std::string threadName;
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        bool calibrated;
+        std::uint64_t startTicks;
+        std::chrono::steady_clock::time_point startTime;
+    };
+
+    Registry& getRegistry() {
+        static Registry registry {};
+
+        return registry;
+    }
+
+    thread_local ThreadBuffer * tlsBuffer = nullptr;
+
+    ThreadBuffer * getThreadBuffer() {
+        if (nullptr == tlsBuffer) {
+            auto& registry = getRegistry();
+            auto pBuffer = std::make_shared<ThreadBuffer> ();
+
+            pBuffer->events.resize(ThreadBuffer::CAPACITY);
+            pBuffer->head = 0;
+
+            // Buffers stay registered after their thread exits so its events still make it into the trace.
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            pBuffer->threadId = static_cast<unsigned int> (registry.buffers.size()) + 1;
+            pBuffer->threadName = "thread " + std::to_string(pBuffer->threadId);
+            registry.buffers.push_back(pBuffer);
+
+            tlsBuffer = pBuffer.get();
+        }
+
+        return tlsBuffer;
+    }
+
+    void writeEscaped(std::ostream& out, const std::string& str) {
+        for (auto c : str) {
+            if ('"' == c || '\\' == c) {
+                out << '\\' << c;
+            } else if (static_cast<unsigned char> (c) >= 0x20) {
+                out << c;
+            }
+        }
+    }
+}
+
+namespace gfx {
+    std::atomic<bool> CpuProfiler::_enabled(false);
+
+    void CpuProfiler::setEnabled(bool enabled) noexcept {
+        if (enabled) {
+            auto& registry = getRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+
+            if (!registry.calibrated) {
+                registry.calibrated = true;
+                registry.startTicks = now();
+                registry.startTime = std::chrono::steady_clock::now();
+            }
+        }
+
+        _enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void CpuProfiler::setThreadName(const std::string& name) {
+        auto pBuffer = getThreadBuffer();
+        std::lock_guard<std::mutex> lock(getRegistry().mutex);
+
+        pBuffer->threadName = name;
+    }
+
+    void CpuProfiler::record(const char * name, std::uint64_t begin, std::uint64_t end) noexcept {
+        auto pBuffer = tlsBuffer;
+
+        if (nullptr == pBuffer) {
+            try {
+                pBuffer = getThreadBuffer();
+            } catch (...) {
+                return;
+            }
+        }
+
+        auto head = pBuffer->head.load(std::memory_order_relaxed);
+
+        pBuffer->events[head & (ThreadBuffer::CAPACITY - 1)] = { name, begin, end };
+        pBuffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    std::size_t CpuProfiler::writeChromeTrace(const std::string& path) {
+        auto& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        if (!registry.calibrated) {
+            throw std::runtime_error("CPU profiler was never enabled!");
+        }
+
+        auto file = std::ofstream(path.c_str());
+
+        if (!file) {
+            auto msg = std::stringstream();
+            msg << "Failed to open file: \"" << path << "\"";
+
+            throw std::runtime_error(msg.str());
+        }
+
+        // Calibrate ticks against the steady clock over the whole session.
+        auto elapsedTicks = now() - registry.startTicks;
+        auto elapsedNs = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now() - registry.startTime).count();
+        auto usPerTick = elapsedTicks ? elapsedNs / elapsedTicks * 1e-3 : 1e-3;
+        auto count = std::size_t(0);
+
+        file.precision(3);
+        file << std::fixed << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+        for (const auto& pBuffer : registry.buffers) {
+            file << (count ? ",\n" : "") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << pBuffer->threadId
+                << ", \"args\": {\"name\": \"";
+            writeEscaped(file, pBuffer->threadName);
+            file << "\"}}";
+            count++;
+
+            auto head = pBuffer->head.load(std::memory_order_acquire);
+            auto first = head > ThreadBuffer::CAPACITY ? head - ThreadBuffer::CAPACITY : 0;
+
+            for (auto i = first; i < head; i++) {
+                const auto& event = pBuffer->events[i & (ThreadBuffer::CAPACITY - 1)];
+
+                if (event.begin < registry.startTicks) {
+                    continue;
+                }
+
+                file << ",\n{\"name\": \"";
+                writeEscaped(file, event.name);
+                file << "\", \"cat\": \"cpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << pBuffer->threadId
+                    << ", \"ts\": " << (event.begin - registry.startTicks) * usPerTick
+                    << ", \"dur\": " << (event.end - event.begin) * usPerTick << "}";
+                count++;
+            }
+        }
+
+        file << "\n]}\n";
+
+        return count;
+    }
+}
@@ -0,0 +1,229 @@
+#include "debug_logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    constexpr std::size_t RING_SIZE = 256;
+    constexpr std::size_t COUNTER_BITS = 10;
+    constexpr std::size_t COUNTER_SIZE = 1 << COUNTER_BITS;
+    constexpr std::size_t MAX_MESSAGE_LENGTH = 512;
+
+    constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(10);
+    constexpr auto REPEAT_INTERVAL = std::chrono::seconds(1);
+
+    std::uint64_t makeKey(GLenum source, GLenum type, GLuint id) noexcept {
+        return (static_cast<std::uint64_t> (source & 0xFFFF) << 48) | (static_cast<std::uint64_t> (type & 0xFFFF) << 32) | id;
+    }
+}
+
+namespace gfx {
+    struct DebugLogger::Message {
+        std::atomic<std::size_t> sequence;
+        std::uint64_t key;
+        GLenum type;
+        char text[MAX_MESSAGE_LENGTH];
+    };
+
+    struct DebugLogger::Counter {
+        std::atomic<std::uint64_t> key;
+        std::atomic<unsigned long> count;
+    };
+
+    DebugLogger::DebugLogger(std::ostream& out) : _out(out) {
+        _ring.reset(new Message[RING_SIZE]);
+        _counters.reset(new Counter[COUNTER_SIZE]);
+
+        for (std::size_t i = 0; i < RING_SIZE; i++) {
+            _ring[i].sequence = i;
+        }
+
+        for (std::size_t i = 0; i < COUNTER_SIZE; i++) {
+            _counters[i].key = 0;
+            _counters[i].count = 0;
+        }
+
+        _enqueuePos = 0;
+        _dequeuePos = 0;
+        _dropped = 0;
+        _stop = false;
+
+        _thread = std::thread(&DebugLogger::run, this);
+
+        glEnable(GL_DEBUG_OUTPUT);
+        glDebugMessageCallback(callback, this);
+
+        // Notifications are informational chatter (buffer placement hints and the like) on most drivers.
+        setFilter(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, false);
+    }
+
+    DebugLogger::~DebugLogger() noexcept {
+        glDebugMessageCallback(nullptr, nullptr);
+        glDisable(GL_DEBUG_OUTPUT);
+
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _stop = true;
+        }
+
+        _wake.notify_one();
+        _thread.join();
+    }
+
+    void DebugLogger::setFilter(GLenum source, GLenum type, GLenum severity, bool enabled) noexcept {
+        glDebugMessageControl(source, type, severity, 0, nullptr, enabled ? GL_TRUE : GL_FALSE);
+    }
+
+    unsigned long DebugLogger::getDropped() const noexcept {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    void GLAPIENTRY DebugLogger::callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar * message, const void * userParam) {
+        auto pLogger = const_cast<DebugLogger *> (static_cast<const DebugLogger *> (userParam));
+
+        pLogger->push(source, type, id, severity, length, message);
+    }
+
+    void DebugLogger::push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar * message) noexcept {
+        auto key = makeKey(source, type, id);
+        auto slot = static_cast<std::size_t> ((key * 0x9E3779B97F4A7C15ULL) >> (64 - COUNTER_BITS));
+
+        Counter * pCounter = nullptr;
+
+        // Repeats only bump a counter; the text is copied once, for the first occurrence.
+        for (std::size_t probe = 0; probe < COUNTER_SIZE; probe++) {
+            auto& counter = _counters[(slot + probe) & (COUNTER_SIZE - 1)];
+            auto current = counter.key.load(std::memory_order_acquire);
+
+            if (0 == current && counter.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                current = key;
+            }
+
+            if (key == current) {
+                if (counter.count.fetch_add(1, std::memory_order_relaxed)) {
+                    return;
+                }
+
+                pCounter = &counter;
+                break;
+            }
+
+            if (COUNTER_SIZE == probe + 1) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        // Bounded MPMC queue (Vyukov); the driver may call back from several threads.
+        auto pos = _enqueuePos.load(std::memory_order_relaxed);
+        Message * pMessage;
+
+        while (true) {
+            pMessage = &_ring[pos & (RING_SIZE - 1)];
+
+            auto sequence = pMessage->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t> (sequence) - static_cast<std::intptr_t> (pos);
+
+            if (0 == diff) {
+                if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // Ring full: reset the counter so the next occurrence is treated as the first again,
+                // and count whatever piled up meanwhile as dropped.
+                _dropped.fetch_add(pCounter->count.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+                return;
+            } else {
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        auto size = length < 0 ? std::strlen(message) : static_cast<std::size_t> (length);
+        size = std::min(size, MAX_MESSAGE_LENGTH - 1);
+
+        pMessage->key = key;
+        pMessage->type = type;
+        std::memcpy(pMessage->text, message, size);
+        pMessage->text[size] = '\0';
+
+        pMessage->sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    bool DebugLogger::drain() {
+        auto written = false;
+
+        while (true) {
+            auto& message = _ring[_dequeuePos & (RING_SIZE - 1)];
+
+            if (message.sequence.load(std::memory_order_acquire) != _dequeuePos + 1) {
+                return written;
+            }
+
+            auto error = GL_DEBUG_TYPE_ERROR == message.type;
+
+            _out << (error ? "[ERROR]: " : "[DEBUG]: ") << message.text << '\n';
+            _reported[message.key] = { message.text, error, 1 };
+            written = true;
+
+            message.sequence.store(_dequeuePos + RING_SIZE, std::memory_order_release);
+            _dequeuePos++;
+        }
+    }
+
+    bool DebugLogger::reportRepeats() {
+        auto written = false;
+
+        for (std::size_t i = 0; i < COUNTER_SIZE; i++) {
+            auto key = _counters[i].key.load(std::memory_order_acquire);
+            auto entry = _reported.find(key);
+
+            if (0 == key || _reported.end() == entry) {
+                continue;
+            }
+
+            auto& reported = entry->second;
+            auto count = _counters[i].count.load(std::memory_order_relaxed);
+
+            if (count > reported.printed) {
+                _out << (reported.error ? "[ERROR]: " : "[DEBUG]: ") << "repeated " << count - reported.printed << " times: " << reported.text << '\n';
+                reported.printed = count;
+                written = true;
+            }
+        }
+
+        return written;
+    }
+
+    void DebugLogger::run() noexcept {
+        auto lastRepeats = std::chrono::steady_clock::now();
+        auto stop = false;
+
+        while (!stop) {
+            {
+                std::unique_lock<std::mutex> guard(_lock);
+                stop = _wake.wait_for(guard, DRAIN_INTERVAL, [this] { return _stop; });
+            }
+
+            auto written = drain();
+            auto now = std::chrono::steady_clock::now();
+
+            if (stop || now - lastRepeats >= REPEAT_INTERVAL) {
+                written = reportRepeats() || written;
+                lastRepeats = now;
+            }
+
+            auto dropped = _dropped.load(std::memory_order_relaxed);
+
+            if (stop && dropped) {
+                _out << "[DEBUG]: dropped " << dropped << " debug messages" << '\n';
+                written = true;
+            }
+
+            // One flush per batch instead of one per message.
+            if (written) {
+                _out.flush();
+            }
+        }
+    }
+}
@@ -0,0 +1,182 @@
+#include "frame_benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+#include "context.hpp"
+
+namespace {
+    struct Summary {
+        double mean;
+        double min;
+        double p50;
+        double p95;
+        double p99;
+        double max;
+    };
+
+    double percentile(const std::vector<double>& sorted, double p) {
+        auto rank = static_cast<std::size_t> (std::ceil(p / 100.0 * sorted.size()));
+
+        return sorted[std::max<std::size_t> (rank, 1) - 1];
+    }
+
+    Summary summarize(std::vector<double> samples) {
+        std::sort(samples.begin(), samples.end());
+
+        auto sum = std::accumulate(samples.begin(), samples.end(), 0.0);
+
+        return {
+            sum / samples.size(),
+            samples.front(),
+            percentile(samples, 50.0),
+            percentile(samples, 95.0),
+            percentile(samples, 99.0),
+            samples.back()
+        };
+    }
+
+    void writeSummary(std::ostream& out, const char * name, const Summary& summary) {
+        out << "  \"" << name << "\": {"
+            << "\"mean\": " << summary.mean << ", "
+            << "\"min\": " << summary.min << ", "
+            << "\"p50\": " << summary.p50 << ", "
+            << "\"p95\": " << summary.p95 << ", "
+            << "\"p99\": " << summary.p99 << ", "
+            << "\"max\": " << summary.max << "},\n";
+    }
+
+    void writeSamples(std::ostream& out, const char * name, const std::vector<double>& samples) {
+        out << "  \"" << name << "\": [";
+
+        for (std::size_t i = 0; i < samples.size(); i++) {
+            out << (i ? ", " : "") << samples[i];
+        }
+
+        out << "]";
+    }
+}
+
+namespace gfx {
+    FrameBenchmark::FrameBenchmark(const ContextInfo& info) {
+        _name = info.title;
+        _path = info.benchmark;
+        _width = info.width;
+        _height = info.height;
+        _warmupFrames = info.warmupFrames;
+        _frames = info.frames;
+        _frame = 0;
+        _finished = false;
+
+        if (0 == _frames) {
+            throw std::runtime_error("Benchmark needs at least one measured frame!");
+        }
+
+        // A pair of timestamps per measured frame: nothing is read back until the run is over, so the
+        // measurement itself never waits on the GPU. Unlike GL_TIME_ELAPSED queries they don't nest, so
+        // programs can keep timing their own passes with GL_TIME_ELAPSED.
+        _queries.resize(_frames * 2);
+        glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei> (_queries.size()), _queries.data());
+
+        _cpuTimes.reserve(_frames);
+        _lastPresent = std::chrono::steady_clock::now();
+
+        if (0 == _warmupFrames) {
+            glQueryCounter(_queries[0], GL_TIMESTAMP);
+        }
+    }
+
+    FrameBenchmark::~FrameBenchmark() noexcept {
+        release();
+    }
+
+    void FrameBenchmark::release() noexcept {
+        if (!_queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei> (_queries.size()), _queries.data());
+            _queries.clear();
+        }
+    }
+
+    void FrameBenchmark::beforePresent() noexcept {
+        if (!_finished && _frame >= _warmupFrames) {
+            glQueryCounter(_queries[(_frame - _warmupFrames) * 2 + 1], GL_TIMESTAMP);
+        }
+    }
+
+    void FrameBenchmark::afterPresent() {
+        if (_finished) {
+            return;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+
+        if (_frame >= _warmupFrames) {
+            _cpuTimes.push_back(std::chrono::duration<double, std::milli> (now - _lastPresent).count());
+        }
+
+        _lastPresent = now;
+        _frame++;
+
+        if (_frame == _warmupFrames + _frames) {
+            finish();
+        } else if (_frame >= _warmupFrames) {
+            glQueryCounter(_queries[(_frame - _warmupFrames) * 2], GL_TIMESTAMP);
+        }
+    }
+
+    void FrameBenchmark::finish() {
+        _finished = true;
+
+        glFinish();
+
+        auto gpuTimes = std::vector<double> ();
+        gpuTimes.reserve(_frames);
+
+        for (std::size_t i = 0; i < _queries.size(); i += 2) {
+            GLuint64 begin, end;
+            glGetQueryObjectui64v(_queries[i], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(_queries[i + 1], GL_QUERY_RESULT, &end);
+
+            gpuTimes.push_back(static_cast<double> (end - begin) * 1e-6);
+        }
+
+        release();
+
+        auto cpu = summarize(_cpuTimes);
+        auto gpu = summarize(gpuTimes);
+
+        auto file = std::ofstream(_path.c_str());
+
+        if (!file) {
+            auto msg = std::stringstream();
+            msg << "Failed to open file: \"" << _path << "\"";
+
+            throw std::runtime_error(msg.str());
+        }
+
+        file.precision(4);
+        file << std::fixed;
+        file << "{\n"
+             << "  \"name\": \"" << _name << "\",\n"
+             << "  \"width\": " << _width << ",\n"
+             << "  \"height\": " << _height << ",\n"
+             << "  \"warmupFrames\": " << _warmupFrames << ",\n"
+             << "  \"frames\": " << _frames << ",\n";
+
+        writeSummary(file, "cpuMs", cpu);
+        writeSummary(file, "gpuMs", gpu);
+        writeSamples(file, "cpuSamplesMs", _cpuTimes);
+        file << ",\n";
+        writeSamples(file, "gpuSamplesMs", gpuTimes);
+        file << "\n}\n";
+
+        std::cout.precision(3);
+        std::cout << std::fixed << _name << ": cpu p50 " << cpu.p50 << " ms, p95 " << cpu.p95 << " ms, p99 " << cpu.p99
+            << " ms | gpu p50 " << gpu.p50 << " ms, p95 " << gpu.p95 << " ms, p99 " << gpu.p99 << " ms" << std::endl;
+    }
+}
@@ -0,0 +1,305 @@
+#include "frustum_culler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "thread_pool.hpp"
+
+namespace {
+    constexpr std::size_t LANES = 8;
+    constexpr std::size_t PARTITION_SIZE = 16384;
+    constexpr unsigned int PLANE_COUNT = 6;
+
+    // Padding objects can never pass a plane test, so the kernels need no tail loop.
+    constexpr float PADDING_RADIUS = -std::numeric_limits<float>::max();
+
+    struct Planes {
+        float nx[PLANE_COUNT];
+        float ny[PLANE_COUNT];
+        float nz[PLANE_COUNT];
+        float w[PLANE_COUNT];
+        float ax[PLANE_COUNT];
+        float ay[PLANE_COUNT];
+        float az[PLANE_COUNT];
+    };
+
+    struct Bounds {
+        const float * centerX;
+        const float * centerY;
+        const float * centerZ;
+        const float * extentX;
+        const float * extentY;
+        const float * extentZ;
+        const float * radius;
+    };
+
+    // All kernels evaluate d + min(radius, |n| . extent) > 0 in the same order, so they agree bit for bit.
+    // The output needs LANES slots of slack: indices are written unconditionally and only the count advances.
+    std::size_t cullScalar(const Planes& planes, const Bounds& bounds, std::size_t begin, std::size_t end, std::uint32_t * pOut) noexcept {
+        auto n = std::size_t(0);
+
+        for (auto i = begin; i < end; i++) {
+            auto visible = true;
+
+            for (unsigned int p = 0; p < PLANE_COUNT; p++) {
+                auto d = (planes.nx[p] * bounds.centerX[i] + planes.ny[p] * bounds.centerY[i]) + (planes.nz[p] * bounds.centerZ[i] + planes.w[p]);
+                auto e = (planes.ax[p] * bounds.extentX[i] + planes.ay[p] * bounds.extentY[i]) + planes.az[p] * bounds.extentZ[i];
+
+                visible = visible && d + std::min(bounds.radius[i], e) > 0.0F;
+            }
+
+            pOut[n] = static_cast<std::uint32_t> (i);
+            n += visible ? 1 : 0;
+        }
+
+        return n;
+    }
+
+#if defined(__x86_64__)
+    std::size_t cullSse(const Planes& planes, const Bounds& bounds, std::size_t begin, std::size_t end, std::uint32_t * pOut) noexcept {
+        __m128 nx[PLANE_COUNT], ny[PLANE_COUNT], nz[PLANE_COUNT], w[PLANE_COUNT], ax[PLANE_COUNT], ay[PLANE_COUNT], az[PLANE_COUNT];
+
+        for (unsigned int p = 0; p < PLANE_COUNT; p++) {
+            nx[p] = _mm_set1_ps(planes.nx[p]);
+            ny[p] = _mm_set1_ps(planes.ny[p]);
+            nz[p] = _mm_set1_ps(planes.nz[p]);
+            w[p] = _mm_set1_ps(planes.w[p]);
+            ax[p] = _mm_set1_ps(planes.ax[p]);
+            ay[p] = _mm_set1_ps(planes.ay[p]);
+            az[p] = _mm_set1_ps(planes.az[p]);
+        }
+
+        auto zero = _mm_setzero_ps();
+        auto n = std::size_t(0);
+
+        for (auto i = begin; i < end; i += 4) {
+            auto cx = _mm_loadu_ps(bounds.centerX + i);
+            auto cy = _mm_loadu_ps(bounds.centerY + i);
+            auto cz = _mm_loadu_ps(bounds.centerZ + i);
+            auto ex = _mm_loadu_ps(bounds.extentX + i);
+            auto ey = _mm_loadu_ps(bounds.extentY + i);
+            auto ez = _mm_loadu_ps(bounds.extentZ + i);
+            auto r = _mm_loadu_ps(bounds.radius + i);
+            auto visible = _mm_cmpeq_ps(zero, zero);
+
+            for (unsigned int p = 0; p < PLANE_COUNT; p++) {
+                auto d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)), _mm_add_ps(_mm_mul_ps(nz[p], cz), w[p]));
+                auto e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez));
+
+                visible = _mm_and_ps(visible, _mm_cmpgt_ps(_mm_add_ps(d, _mm_min_ps(r, e)), zero));
+            }
+
+            auto mask = static_cast<unsigned int> (_mm_movemask_ps(visible));
+
+            // Skipping fully culled groups is the common case once most of the scene is off screen.
+            if (0 == mask) {
+                continue;
+            }
+
+            for (unsigned int k = 0; k < 4; k++) {
+                pOut[n] = static_cast<std::uint32_t> (i + k);
+                n += (mask >> k) & 1;
+            }
+        }
+
+        return n;
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t cullAvx2(const Planes& planes, const Bounds& bounds, std::size_t begin, std::size_t end, std::uint32_t * pOut) noexcept {
+        __m256 nx[PLANE_COUNT], ny[PLANE_COUNT], nz[PLANE_COUNT], w[PLANE_COUNT], ax[PLANE_COUNT], ay[PLANE_COUNT], az[PLANE_COUNT];
+
+        for (unsigned int p = 0; p < PLANE_COUNT; p++) {
+            nx[p] = _mm256_set1_ps(planes.nx[p]);
+            ny[p] = _mm256_set1_ps(planes.ny[p]);
+            nz[p] = _mm256_set1_ps(planes.nz[p]);
+            w[p] = _mm256_set1_ps(planes.w[p]);
+            ax[p] = _mm256_set1_ps(planes.ax[p]);
+            ay[p] = _mm256_set1_ps(planes.ay[p]);
+            az[p] = _mm256_set1_ps(planes.az[p]);
+        }
+
+        auto zero = _mm256_setzero_ps();
+        auto n = std::size_t(0);
+
+        for (auto i = begin; i < end; i += LANES) {
+            auto cx = _mm256_loadu_ps(bounds.centerX + i);
+            auto cy = _mm256_loadu_ps(bounds.centerY + i);
+            auto cz = _mm256_loadu_ps(bounds.centerZ + i);
+            auto ex = _mm256_loadu_ps(bounds.extentX + i);
+            auto ey = _mm256_loadu_ps(bounds.extentY + i);
+            auto ez = _mm256_loadu_ps(bounds.extentZ + i);
+            auto r = _mm256_loadu_ps(bounds.radius + i);
+            auto visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            for (unsigned int p = 0; p < PLANE_COUNT; p++) {
+                auto d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], cx), _mm256_mul_ps(ny[p], cy)), _mm256_add_ps(_mm256_mul_ps(nz[p], cz), w[p]));
+                auto e = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)), _mm256_mul_ps(az[p], ez));
+
+                visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(d, _mm256_min_ps(r, e)), zero, _CMP_GT_OQ));
+            }
+
+            auto mask = static_cast<unsigned int> (_mm256_movemask_ps(visible));
+
+            if (0 == mask) {
+                continue;
+            }
+
+            for (unsigned int k = 0; k < LANES; k++) {
+                pOut[n] = static_cast<std::uint32_t> (i + k);
+                n += (mask >> k) & 1;
+            }
+        }
+
+        return n;
+    }
+#endif
+}
+
+namespace gfx {
+    std::array<glm::vec4, 6> FrustumCuller::extractPlanes(const glm::mat4& viewProj) noexcept {
+        auto row = [&viewProj] (int i) {
+            return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+        };
+
+        auto planes = std::array<glm::vec4, 6> ({{
+            row(3) + row(0), row(3) - row(0),
+            row(3) + row(1), row(3) - row(1),
+            row(3) + row(2), row(3) - row(2)
+        }});
+
+        for (auto& plane : planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        return planes;
+    }
+
+    FrustumCuller::FrustumCuller(std::size_t count) {
+        _count = 0;
+        _simdLevel = getBestSimdLevel();
+
+        resize(count);
+    }
+
+    std::size_t FrustumCuller::size() const noexcept {
+        return _count;
+    }
+
+    void FrustumCuller::resize(std::size_t count) {
+        auto padded = (count + LANES - 1) / LANES * LANES;
+
+        for (auto pArray : { &_centerX, &_centerY, &_centerZ, &_extentX, &_extentY, &_extentZ }) {
+            pArray->resize(padded, 0.0F);
+        }
+
+        // Objects past the new end become padding again, whether they were just added or cut off.
+        _radius.resize(padded, PADDING_RADIUS);
+        std::fill(_radius.begin() + count, _radius.end(), PADDING_RADIUS);
+
+        _count = count;
+    }
+
+    SimdLevel FrustumCuller::getSimdLevel() const noexcept {
+        return _simdLevel;
+    }
+
+    void FrustumCuller::setSimdLevel(SimdLevel level) noexcept {
+        _simdLevel = std::min(level, getBestSimdLevel());
+    }
+
+    void FrustumCuller::setSphere(std::size_t index, const glm::vec3& center, float radius) noexcept {
+        _centerX[index] = center.x;
+        _centerY[index] = center.y;
+        _centerZ[index] = center.z;
+        _extentX[index] = radius;
+        _extentY[index] = radius;
+        _extentZ[index] = radius;
+        _radius[index] = radius;
+    }
+
+    void FrustumCuller::setBox(std::size_t index, const glm::vec3& min, const glm::vec3& max) noexcept {
+        auto center = (min + max) * 0.5F;
+        auto extent = (max - min) * 0.5F;
+
+        _centerX[index] = center.x;
+        _centerY[index] = center.y;
+        _centerZ[index] = center.z;
+        _extentX[index] = extent.x;
+        _extentY[index] = extent.y;
+        _extentZ[index] = extent.z;
+        _radius[index] = glm::length(extent);
+    }
+
+    void FrustumCuller::cull(const glm::mat4& viewProj, std::vector<std::uint32_t>& visible, ThreadPool * pThreadPool) {
+        auto planes = Planes {};
+        auto extracted = extractPlanes(viewProj);
+
+        for (unsigned int p = 0; p < PLANE_COUNT; p++) {
+            planes.nx[p] = extracted[p].x;
+            planes.ny[p] = extracted[p].y;
+            planes.nz[p] = extracted[p].z;
+            planes.w[p] = extracted[p].w;
+            planes.ax[p] = std::abs(extracted[p].x);
+            planes.ay[p] = std::abs(extracted[p].y);
+            planes.az[p] = std::abs(extracted[p].z);
+        }
+
+        auto bounds = Bounds { _centerX.data(), _centerY.data(), _centerZ.data(), _extentX.data(), _extentY.data(), _extentZ.data(), _radius.data() };
+        auto padded = _radius.size();
+        auto partitionCount = static_cast<unsigned int> ((padded + PARTITION_SIZE - 1) / PARTITION_SIZE);
+
+        _partitions.resize(std::max<std::size_t> (_partitions.size(), partitionCount));
+        _partitionSizes.resize(partitionCount);
+
+        for (unsigned int i = 0; i < partitionCount; i++) {
+            _partitions[i].resize(PARTITION_SIZE + LANES);
+        }
+
+        auto kernel = cullScalar;
+
+#if defined(__x86_64__)
+        if (SimdLevel::AVX2 == _simdLevel) {
+            kernel = cullAvx2;
+        } else if (SimdLevel::SSE == _simdLevel) {
+            kernel = cullSse;
+        }
+#endif
+
+        auto task = [&] (unsigned int partition) {
+            auto begin = partition * PARTITION_SIZE;
+            auto end = std::min(begin + PARTITION_SIZE, padded);
+
+            _partitionSizes[partition] = kernel(planes, bounds, begin, end, _partitions[partition].data());
+        };
+
+        if (nullptr != pThreadPool) {
+            pThreadPool->run(partitionCount, task);
+        } else {
+            for (unsigned int i = 0; i < partitionCount; i++) {
+                task(i);
+            }
+        }
+
+        auto total = std::size_t(0);
+
+        for (auto size : _partitionSizes) {
+            total += size;
+        }
+
+        visible.resize(total);
+
+        auto offset = std::size_t(0);
+
+        for (unsigned int i = 0; i < partitionCount; i++) {
+            std::memcpy(visible.data() + offset, _partitions[i].data(), _partitionSizes[i] * sizeof(std::uint32_t));
+            offset += _partitionSizes[i];
+        }
+    }
+}
@@ -0,0 +1,1157 @@
+#include "gl_stats.hpp"
+
+#include <GL/glew.h>
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Calls with their own hooks below, which also track bindings to spot the redundant ones.
+#define GFX_GL_TRACKED_CALLS(X) \
+    X(UseProgram) \
+    X(BindBuffer) \
+    X(BindBufferBase) \
+    X(BindBufferRange) \
+    X(BindVertexArray) \
+    X(BindVertexBuffer) \
+    X(ActiveTexture) \
+    X(BindTextureUnit) \
+    X(BindSampler) \
+    X(BindFramebuffer) \
+    X(Uniform1i) \
+    X(Uniform1f) \
+    X(Uniform4fv) \
+    X(UniformMatrix4fv) \
+    X(ProgramUniform1i) \
+    X(ProgramUniform1f) \
+    X(ProgramUniformMatrix4fv) \
+    X(LinkProgram) \
+    X(DeleteProgram) \
+    X(DeleteBuffers) \
+    X(DeleteVertexArrays) \
+    X(DeleteFramebuffers)
+
+// Every other entry point GLEW loads for core GL 1.2 to 4.6 (as listed by glcorearb.h), plus the
+// extensions used here.
+#define GFX_GL_COUNTED_CALLS(X) \
+    X(DrawRangeElements) \
+    X(TexImage3D) \
+    X(TexSubImage3D) \
+    X(CopyTexSubImage3D) \
+    X(SampleCoverage) \
+    X(CompressedTexImage3D) \
+    X(CompressedTexImage2D) \
+    X(CompressedTexImage1D) \
+    X(CompressedTexSubImage3D) \
+    X(CompressedTexSubImage2D) \
+    X(CompressedTexSubImage1D) \
+    X(GetCompressedTexImage) \
+    X(BlendFuncSeparate) \
+    X(MultiDrawArrays) \
+    X(MultiDrawElements) \
+    X(PointParameterf) \
+    X(PointParameterfv) \
+    X(PointParameteri) \
+    X(PointParameteriv) \
+    X(BlendColor) \
+    X(BlendEquation) \
+    X(GenQueries) \
+    X(DeleteQueries) \
+    X(IsQuery) \
+    X(BeginQuery) \
+    X(EndQuery) \
+    X(GetQueryiv) \
+    X(GetQueryObjectiv) \
+    X(GetQueryObjectuiv) \
+    X(GenBuffers) \
+    X(IsBuffer) \
+    X(BufferData) \
+    X(BufferSubData) \
+    X(GetBufferSubData) \
+    X(MapBuffer) \
+    X(UnmapBuffer) \
+    X(GetBufferParameteriv) \
+    X(GetBufferPointerv) \
+    X(BlendEquationSeparate) \
+    X(DrawBuffers) \
+    X(StencilOpSeparate) \
+    X(StencilFuncSeparate) \
+    X(StencilMaskSeparate) \
+    X(AttachShader) \
+    X(BindAttribLocation) \
+    X(CompileShader) \
+    X(CreateProgram) \
+    X(CreateShader) \
+    X(DeleteShader) \
+    X(DetachShader) \
+    X(DisableVertexAttribArray) \
+    X(EnableVertexAttribArray) \
+    X(GetActiveAttrib) \
+    X(GetActiveUniform) \
+    X(GetAttachedShaders) \
+    X(GetAttribLocation) \
+    X(GetProgramiv) \
+    X(GetProgramInfoLog) \
+    X(GetShaderiv) \
+    X(GetShaderInfoLog) \
+    X(GetShaderSource) \
+    X(GetUniformLocation) \
+    X(GetUniformfv) \
+    X(GetUniformiv) \
+    X(GetVertexAttribdv) \
+    X(GetVertexAttribfv) \
+    X(GetVertexAttribiv) \
+    X(GetVertexAttribPointerv) \
+    X(IsProgram) \
+    X(IsShader) \
+    X(ShaderSource) \
+    X(Uniform2f) \
+    X(Uniform3f) \
+    X(Uniform4f) \
+    X(Uniform2i) \
+    X(Uniform3i) \
+    X(Uniform4i) \
+    X(Uniform1fv) \
+    X(Uniform2fv) \
+    X(Uniform3fv) \
+    X(Uniform1iv) \
+    X(Uniform2iv) \
+    X(Uniform3iv) \
+    X(Uniform4iv) \
+    X(UniformMatrix2fv) \
+    X(UniformMatrix3fv) \
+    X(ValidateProgram) \
+    X(VertexAttrib1d) \
+    X(VertexAttrib1dv) \
+    X(VertexAttrib1f) \
+    X(VertexAttrib1fv) \
+    X(VertexAttrib1s) \
+    X(VertexAttrib1sv) \
+    X(VertexAttrib2d) \
+    X(VertexAttrib2dv) \
+    X(VertexAttrib2f) \
+    X(VertexAttrib2fv) \
+    X(VertexAttrib2s) \
+    X(VertexAttrib2sv) \
+    X(VertexAttrib3d) \
+    X(VertexAttrib3dv) \
+    X(VertexAttrib3f) \
+    X(VertexAttrib3fv) \
+    X(VertexAttrib3s) \
+    X(VertexAttrib3sv) \
+    X(VertexAttrib4Nbv) \
+    X(VertexAttrib4Niv) \
+    X(VertexAttrib4Nsv) \
+    X(VertexAttrib4Nub) \
+    X(VertexAttrib4Nubv) \
+    X(VertexAttrib4Nuiv) \
+    X(VertexAttrib4Nusv) \
+    X(VertexAttrib4bv) \
+    X(VertexAttrib4d) \
+    X(VertexAttrib4dv) \
+    X(VertexAttrib4f) \
+    X(VertexAttrib4fv) \
+    X(VertexAttrib4iv) \
+    X(VertexAttrib4s) \
+    X(VertexAttrib4sv) \
+    X(VertexAttrib4ubv) \
+    X(VertexAttrib4uiv) \
+    X(VertexAttrib4usv) \
+    X(VertexAttribPointer) \
+    X(UniformMatrix2x3fv) \
+    X(UniformMatrix3x2fv) \
+    X(UniformMatrix2x4fv) \
+    X(UniformMatrix4x2fv) \
+    X(UniformMatrix3x4fv) \
+    X(UniformMatrix4x3fv) \
+    X(ColorMaski) \
+    X(GetBooleani_v) \
+    X(GetIntegeri_v) \
+    X(Enablei) \
+    X(Disablei) \
+    X(IsEnabledi) \
+    X(BeginTransformFeedback) \
+    X(EndTransformFeedback) \
+    X(TransformFeedbackVaryings) \
+    X(GetTransformFeedbackVarying) \
+    X(ClampColor) \
+    X(BeginConditionalRender) \
+    X(EndConditionalRender) \
+    X(VertexAttribIPointer) \
+    X(GetVertexAttribIiv) \
+    X(GetVertexAttribIuiv) \
+    X(VertexAttribI1i) \
+    X(VertexAttribI2i) \
+    X(VertexAttribI3i) \
+    X(VertexAttribI4i) \
+    X(VertexAttribI1ui) \
+    X(VertexAttribI2ui) \
+    X(VertexAttribI3ui) \
+    X(VertexAttribI4ui) \
+    X(VertexAttribI1iv) \
+    X(VertexAttribI2iv) \
+    X(VertexAttribI3iv) \
+    X(VertexAttribI4iv) \
+    X(VertexAttribI1uiv) \
+    X(VertexAttribI2uiv) \
+    X(VertexAttribI3uiv) \
+    X(VertexAttribI4uiv) \
+    X(VertexAttribI4bv) \
+    X(VertexAttribI4sv) \
+    X(VertexAttribI4ubv) \
+    X(VertexAttribI4usv) \
+    X(GetUniformuiv) \
+    X(BindFragDataLocation) \
+    X(GetFragDataLocation) \
+    X(Uniform1ui) \
+    X(Uniform2ui) \
+    X(Uniform3ui) \
+    X(Uniform4ui) \
+    X(Uniform1uiv) \
+    X(Uniform2uiv) \
+    X(Uniform3uiv) \
+    X(Uniform4uiv) \
+    X(TexParameterIiv) \
+    X(TexParameterIuiv) \
+    X(GetTexParameterIiv) \
+    X(GetTexParameterIuiv) \
+    X(ClearBufferiv) \
+    X(ClearBufferuiv) \
+    X(ClearBufferfv) \
+    X(ClearBufferfi) \
+    X(GetStringi) \
+    X(IsRenderbuffer) \
+    X(BindRenderbuffer) \
+    X(DeleteRenderbuffers) \
+    X(GenRenderbuffers) \
+    X(RenderbufferStorage) \
+    X(GetRenderbufferParameteriv) \
+    X(IsFramebuffer) \
+    X(GenFramebuffers) \
+    X(CheckFramebufferStatus) \
+    X(FramebufferTexture1D) \
+    X(FramebufferTexture2D) \
+    X(FramebufferTexture3D) \
+    X(FramebufferRenderbuffer) \
+    X(GetFramebufferAttachmentParameteriv) \
+    X(GenerateMipmap) \
+    X(BlitFramebuffer) \
+    X(RenderbufferStorageMultisample) \
+    X(FramebufferTextureLayer) \
+    X(MapBufferRange) \
+    X(FlushMappedBufferRange) \
+    X(GenVertexArrays) \
+    X(IsVertexArray) \
+    X(DrawArraysInstanced) \
+    X(DrawElementsInstanced) \
+    X(TexBuffer) \
+    X(PrimitiveRestartIndex) \
+    X(CopyBufferSubData) \
+    X(GetUniformIndices) \
+    X(GetActiveUniformsiv) \
+    X(GetActiveUniformName) \
+    X(GetUniformBlockIndex) \
+    X(GetActiveUniformBlockiv) \
+    X(GetActiveUniformBlockName) \
+    X(UniformBlockBinding) \
+    X(DrawElementsBaseVertex) \
+    X(DrawRangeElementsBaseVertex) \
+    X(DrawElementsInstancedBaseVertex) \
+    X(MultiDrawElementsBaseVertex) \
+    X(ProvokingVertex) \
+    X(FenceSync) \
+    X(IsSync) \
+    X(DeleteSync) \
+    X(ClientWaitSync) \
+    X(WaitSync) \
+    X(GetInteger64v) \
+    X(GetSynciv) \
+    X(GetInteger64i_v) \
+    X(GetBufferParameteri64v) \
+    X(FramebufferTexture) \
+    X(TexImage2DMultisample) \
+    X(TexImage3DMultisample) \
+    X(GetMultisamplefv) \
+    X(SampleMaski) \
+    X(BindFragDataLocationIndexed) \
+    X(GetFragDataIndex) \
+    X(GenSamplers) \
+    X(DeleteSamplers) \
+    X(IsSampler) \
+    X(SamplerParameteri) \
+    X(SamplerParameteriv) \
+    X(SamplerParameterf) \
+    X(SamplerParameterfv) \
+    X(SamplerParameterIiv) \
+    X(SamplerParameterIuiv) \
+    X(GetSamplerParameteriv) \
+    X(GetSamplerParameterIiv) \
+    X(GetSamplerParameterfv) \
+    X(GetSamplerParameterIuiv) \
+    X(QueryCounter) \
+    X(GetQueryObjecti64v) \
+    X(GetQueryObjectui64v) \
+    X(VertexAttribDivisor) \
+    X(VertexAttribP1ui) \
+    X(VertexAttribP1uiv) \
+    X(VertexAttribP2ui) \
+    X(VertexAttribP2uiv) \
+    X(VertexAttribP3ui) \
+    X(VertexAttribP3uiv) \
+    X(VertexAttribP4ui) \
+    X(VertexAttribP4uiv) \
+    X(MinSampleShading) \
+    X(BlendEquationi) \
+    X(BlendEquationSeparatei) \
+    X(BlendFunci) \
+    X(BlendFuncSeparatei) \
+    X(DrawArraysIndirect) \
+    X(DrawElementsIndirect) \
+    X(Uniform1d) \
+    X(Uniform2d) \
+    X(Uniform3d) \
+    X(Uniform4d) \
+    X(Uniform1dv) \
+    X(Uniform2dv) \
+    X(Uniform3dv) \
+    X(Uniform4dv) \
+    X(UniformMatrix2dv) \
+    X(UniformMatrix3dv) \
+    X(UniformMatrix4dv) \
+    X(UniformMatrix2x3dv) \
+    X(UniformMatrix2x4dv) \
+    X(UniformMatrix3x2dv) \
+    X(UniformMatrix3x4dv) \
+    X(UniformMatrix4x2dv) \
+    X(UniformMatrix4x3dv) \
+    X(GetUniformdv) \
+    X(GetSubroutineUniformLocation) \
+    X(GetSubroutineIndex) \
+    X(GetActiveSubroutineUniformiv) \
+    X(GetActiveSubroutineUniformName) \
+    X(GetActiveSubroutineName) \
+    X(UniformSubroutinesuiv) \
+    X(GetUniformSubroutineuiv) \
+    X(GetProgramStageiv) \
+    X(PatchParameteri) \
+    X(PatchParameterfv) \
+    X(BindTransformFeedback) \
+    X(DeleteTransformFeedbacks) \
+    X(GenTransformFeedbacks) \
+    X(IsTransformFeedback) \
+    X(PauseTransformFeedback) \
+    X(ResumeTransformFeedback) \
+    X(DrawTransformFeedback) \
+    X(DrawTransformFeedbackStream) \
+    X(BeginQueryIndexed) \
+    X(EndQueryIndexed) \
+    X(GetQueryIndexediv) \
+    X(ReleaseShaderCompiler) \
+    X(ShaderBinary) \
+    X(GetShaderPrecisionFormat) \
+    X(DepthRangef) \
+    X(ClearDepthf) \
+    X(GetProgramBinary) \
+    X(ProgramBinary) \
+    X(ProgramParameteri) \
+    X(UseProgramStages) \
+    X(ActiveShaderProgram) \
+    X(CreateShaderProgramv) \
+    X(BindProgramPipeline) \
+    X(DeleteProgramPipelines) \
+    X(GenProgramPipelines) \
+    X(IsProgramPipeline) \
+    X(GetProgramPipelineiv) \
+    X(ProgramUniform1iv) \
+    X(ProgramUniform1fv) \
+    X(ProgramUniform1d) \
+    X(ProgramUniform1dv) \
+    X(ProgramUniform1ui) \
+    X(ProgramUniform1uiv) \
+    X(ProgramUniform2i) \
+    X(ProgramUniform2iv) \
+    X(ProgramUniform2f) \
+    X(ProgramUniform2fv) \
+    X(ProgramUniform2d) \
+    X(ProgramUniform2dv) \
+    X(ProgramUniform2ui) \
+    X(ProgramUniform2uiv) \
+    X(ProgramUniform3i) \
+    X(ProgramUniform3iv) \
+    X(ProgramUniform3f) \
+    X(ProgramUniform3fv) \
+    X(ProgramUniform3d) \
+    X(ProgramUniform3dv) \
+    X(ProgramUniform3ui) \
+    X(ProgramUniform3uiv) \
+    X(ProgramUniform4i) \
+    X(ProgramUniform4iv) \
+    X(ProgramUniform4f) \
+    X(ProgramUniform4fv) \
+    X(ProgramUniform4d) \
+    X(ProgramUniform4dv) \
+    X(ProgramUniform4ui) \
+    X(ProgramUniform4uiv) \
+    X(ProgramUniformMatrix2fv) \
+    X(ProgramUniformMatrix3fv) \
+    X(ProgramUniformMatrix2dv) \
+    X(ProgramUniformMatrix3dv) \
+    X(ProgramUniformMatrix4dv) \
+    X(ProgramUniformMatrix2x3fv) \
+    X(ProgramUniformMatrix3x2fv) \
+    X(ProgramUniformMatrix2x4fv) \
+    X(ProgramUniformMatrix4x2fv) \
+    X(ProgramUniformMatrix3x4fv) \
+    X(ProgramUniformMatrix4x3fv) \
+    X(ProgramUniformMatrix2x3dv) \
+    X(ProgramUniformMatrix3x2dv) \
+    X(ProgramUniformMatrix2x4dv) \
+    X(ProgramUniformMatrix4x2dv) \
+    X(ProgramUniformMatrix3x4dv) \
+    X(ProgramUniformMatrix4x3dv) \
+    X(ValidateProgramPipeline) \
+    X(GetProgramPipelineInfoLog) \
+    X(VertexAttribL1d) \
+    X(VertexAttribL2d) \
+    X(VertexAttribL3d) \
+    X(VertexAttribL4d) \
+    X(VertexAttribL1dv) \
+    X(VertexAttribL2dv) \
+    X(VertexAttribL3dv) \
+    X(VertexAttribL4dv) \
+    X(VertexAttribLPointer) \
+    X(GetVertexAttribLdv) \
+    X(ViewportArrayv) \
+    X(ViewportIndexedf) \
+    X(ViewportIndexedfv) \
+    X(ScissorArrayv) \
+    X(ScissorIndexed) \
+    X(ScissorIndexedv) \
+    X(DepthRangeArrayv) \
+    X(DepthRangeIndexed) \
+    X(GetFloati_v) \
+    X(GetDoublei_v) \
+    X(DrawArraysInstancedBaseInstance) \
+    X(DrawElementsInstancedBaseInstance) \
+    X(DrawElementsInstancedBaseVertexBaseInstance) \
+    X(GetInternalformativ) \
+    X(GetActiveAtomicCounterBufferiv) \
+    X(BindImageTexture) \
+    X(MemoryBarrier) \
+    X(TexStorage1D) \
+    X(TexStorage2D) \
+    X(TexStorage3D) \
+    X(DrawTransformFeedbackInstanced) \
+    X(DrawTransformFeedbackStreamInstanced) \
+    X(ClearBufferData) \
+    X(ClearBufferSubData) \
+    X(DispatchCompute) \
+    X(DispatchComputeIndirect) \
+    X(CopyImageSubData) \
+    X(FramebufferParameteri) \
+    X(GetFramebufferParameteriv) \
+    X(GetInternalformati64v) \
+    X(InvalidateTexSubImage) \
+    X(InvalidateTexImage) \
+    X(InvalidateBufferSubData) \
+    X(InvalidateBufferData) \
+    X(InvalidateFramebuffer) \
+    X(InvalidateSubFramebuffer) \
+    X(MultiDrawArraysIndirect) \
+    X(MultiDrawElementsIndirect) \
+    X(GetProgramInterfaceiv) \
+    X(GetProgramResourceIndex) \
+    X(GetProgramResourceName) \
+    X(GetProgramResourceiv) \
+    X(GetProgramResourceLocation) \
+    X(GetProgramResourceLocationIndex) \
+    X(ShaderStorageBlockBinding) \
+    X(TexBufferRange) \
+    X(TexStorage2DMultisample) \
+    X(TexStorage3DMultisample) \
+    X(TextureView) \
+    X(VertexAttribFormat) \
+    X(VertexAttribIFormat) \
+    X(VertexAttribLFormat) \
+    X(VertexAttribBinding) \
+    X(VertexBindingDivisor) \
+    X(DebugMessageControl) \
+    X(DebugMessageInsert) \
+    X(DebugMessageCallback) \
+    X(GetDebugMessageLog) \
+    X(PushDebugGroup) \
+    X(PopDebugGroup) \
+    X(ObjectLabel) \
+    X(GetObjectLabel) \
+    X(ObjectPtrLabel) \
+    X(GetObjectPtrLabel) \
+    X(BufferStorage) \
+    X(ClearTexImage) \
+    X(ClearTexSubImage) \
+    X(BindBuffersBase) \
+    X(BindBuffersRange) \
+    X(BindTextures) \
+    X(BindSamplers) \
+    X(BindImageTextures) \
+    X(BindVertexBuffers) \
+    X(ClipControl) \
+    X(CreateTransformFeedbacks) \
+    X(TransformFeedbackBufferBase) \
+    X(TransformFeedbackBufferRange) \
+    X(GetTransformFeedbackiv) \
+    X(GetTransformFeedbacki_v) \
+    X(GetTransformFeedbacki64_v) \
+    X(CreateBuffers) \
+    X(NamedBufferStorage) \
+    X(NamedBufferData) \
+    X(NamedBufferSubData) \
+    X(CopyNamedBufferSubData) \
+    X(ClearNamedBufferData) \
+    X(ClearNamedBufferSubData) \
+    X(MapNamedBuffer) \
+    X(MapNamedBufferRange) \
+    X(UnmapNamedBuffer) \
+    X(FlushMappedNamedBufferRange) \
+    X(GetNamedBufferParameteriv) \
+    X(GetNamedBufferParameteri64v) \
+    X(GetNamedBufferPointerv) \
+    X(GetNamedBufferSubData) \
+    X(CreateFramebuffers) \
+    X(NamedFramebufferRenderbuffer) \
+    X(NamedFramebufferParameteri) \
+    X(NamedFramebufferTexture) \
+    X(NamedFramebufferTextureLayer) \
+    X(NamedFramebufferDrawBuffer) \
+    X(NamedFramebufferDrawBuffers) \
+    X(NamedFramebufferReadBuffer) \
+    X(InvalidateNamedFramebufferData) \
+    X(InvalidateNamedFramebufferSubData) \
+    X(ClearNamedFramebufferiv) \
+    X(ClearNamedFramebufferuiv) \
+    X(ClearNamedFramebufferfv) \
+    X(ClearNamedFramebufferfi) \
+    X(BlitNamedFramebuffer) \
+    X(CheckNamedFramebufferStatus) \
+    X(GetNamedFramebufferParameteriv) \
+    X(GetNamedFramebufferAttachmentParameteriv) \
+    X(CreateRenderbuffers) \
+    X(NamedRenderbufferStorage) \
+    X(NamedRenderbufferStorageMultisample) \
+    X(GetNamedRenderbufferParameteriv) \
+    X(CreateTextures) \
+    X(TextureBuffer) \
+    X(TextureBufferRange) \
+    X(TextureStorage1D) \
+    X(TextureStorage2D) \
+    X(TextureStorage3D) \
+    X(TextureStorage2DMultisample) \
+    X(TextureStorage3DMultisample) \
+    X(TextureSubImage1D) \
+    X(TextureSubImage2D) \
+    X(TextureSubImage3D) \
+    X(CompressedTextureSubImage1D) \
+    X(CompressedTextureSubImage2D) \
+    X(CompressedTextureSubImage3D) \
+    X(CopyTextureSubImage1D) \
+    X(CopyTextureSubImage2D) \
+    X(CopyTextureSubImage3D) \
+    X(TextureParameterf) \
+    X(TextureParameterfv) \
+    X(TextureParameteri) \
+    X(TextureParameterIiv) \
+    X(TextureParameterIuiv) \
+    X(TextureParameteriv) \
+    X(GenerateTextureMipmap) \
+    X(GetTextureImage) \
+    X(GetCompressedTextureImage) \
+    X(GetTextureLevelParameterfv) \
+    X(GetTextureLevelParameteriv) \
+    X(GetTextureParameterfv) \
+    X(GetTextureParameterIiv) \
+    X(GetTextureParameterIuiv) \
+    X(GetTextureParameteriv) \
+    X(CreateVertexArrays) \
+    X(DisableVertexArrayAttrib) \
+    X(EnableVertexArrayAttrib) \
+    X(VertexArrayElementBuffer) \
+    X(VertexArrayVertexBuffer) \
+    X(VertexArrayVertexBuffers) \
+    X(VertexArrayAttribBinding) \
+    X(VertexArrayAttribFormat) \
+    X(VertexArrayAttribIFormat) \
+    X(VertexArrayAttribLFormat) \
+    X(VertexArrayBindingDivisor) \
+    X(GetVertexArrayiv) \
+    X(GetVertexArrayIndexediv) \
+    X(GetVertexArrayIndexed64iv) \
+    X(CreateSamplers) \
+    X(CreateProgramPipelines) \
+    X(CreateQueries) \
+    X(GetQueryBufferObjecti64v) \
+    X(GetQueryBufferObjectiv) \
+    X(GetQueryBufferObjectui64v) \
+    X(GetQueryBufferObjectuiv) \
+    X(MemoryBarrierByRegion) \
+    X(GetTextureSubImage) \
+    X(GetCompressedTextureSubImage) \
+    X(GetGraphicsResetStatus) \
+    X(GetnCompressedTexImage) \
+    X(GetnTexImage) \
+    X(GetnUniformdv) \
+    X(GetnUniformfv) \
+    X(GetnUniformiv) \
+    X(GetnUniformuiv) \
+    X(ReadnPixels) \
+    X(TextureBarrier) \
+    X(SpecializeShader) \
+    X(MultiDrawArraysIndirectCount) \
+    X(MultiDrawElementsIndirectCount) \
+    X(PolygonOffsetClamp) \
+    X(MaxShaderCompilerThreadsARB)
+
+#define GFX_GL_CALLS(X) \
+    GFX_GL_TRACKED_CALLS(X) \
+    GFX_GL_COUNTED_CALLS(X)
+
+// libGL exports GL 1.0 and 1.1 directly instead of through GLEW pointers, so these are interposed by name
+// below and forward to the next definition, the driver's. Each is (return type, name, parameters, arguments).
+#define GFX_GL_LEGACY_TRACKED_CALLS(X) \
+    X(void, Enable, (GLenum cap), (cap)) \
+    X(void, Disable, (GLenum cap), (cap)) \
+    X(void, BindTexture, (GLenum target, GLuint texture), (target, texture)) \
+    X(void, DeleteTextures, (GLsizei n, const GLuint *textures), (n, textures))
+
+// GL 1.0 and 1.1 setters, redundant when called again with the same arguments.
+#define GFX_GL_LEGACY_STATE_CALLS(X) \
+    X(void, CullFace, (GLenum mode), (mode)) \
+    X(void, FrontFace, (GLenum mode), (mode)) \
+    X(void, LineWidth, (GLfloat width), (width)) \
+    X(void, PointSize, (GLfloat size), (size)) \
+    X(void, PolygonMode, (GLenum face, GLenum mode), (face, mode)) \
+    X(void, Scissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height)) \
+    X(void, ClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha)) \
+    X(void, ClearStencil, (GLint s), (s)) \
+    X(void, ClearDepth, (GLdouble depth), (depth)) \
+    X(void, ColorMask, (GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha), (red, green, blue, alpha)) \
+    X(void, DepthMask, (GLboolean flag), (flag)) \
+    X(void, BlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor)) \
+    X(void, LogicOp, (GLenum opcode), (opcode)) \
+    X(void, DepthFunc, (GLenum func), (func)) \
+    X(void, DepthRange, (GLdouble n, GLdouble f), (n, f)) \
+    X(void, Viewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height)) \
+    X(void, PolygonOffset, (GLfloat factor, GLfloat units), (factor, units))
+
+// The rest of core GL 1.0 and 1.1 (as listed by glcorearb.h), counted only.
+#define GFX_GL_LEGACY_COUNTED_CALLS(X) \
+    X(void, Hint, (GLenum target, GLenum mode), (target, mode)) \
+    X(void, TexParameterf, (GLenum target, GLenum pname, GLfloat param), (target, pname, param)) \
+    X(void, TexParameterfv, (GLenum target, GLenum pname, const GLfloat *params), (target, pname, params)) \
+    X(void, TexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param)) \
+    X(void, TexParameteriv, (GLenum target, GLenum pname, const GLint *params), (target, pname, params)) \
+    X(void, TexImage1D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLint border, GLenum format, GLenum type, const void *pixels), (target, level, internalformat, width, border, format, type, pixels)) \
+    X(void, TexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels), (target, level, internalformat, width, height, border, format, type, pixels)) \
+    X(void, DrawBuffer, (GLenum buf), (buf)) \
+    X(void, Clear, (GLbitfield mask), (mask)) \
+    X(void, StencilMask, (GLuint mask), (mask)) \
+    X(void, Finish, (), ()) \
+    X(void, Flush, (), ()) \
+    X(void, StencilFunc, (GLenum func, GLint ref, GLuint mask), (func, ref, mask)) \
+    X(void, StencilOp, (GLenum fail, GLenum zfail, GLenum zpass), (fail, zfail, zpass)) \
+    X(void, PixelStoref, (GLenum pname, GLfloat param), (pname, param)) \
+    X(void, PixelStorei, (GLenum pname, GLint param), (pname, param)) \
+    X(void, ReadBuffer, (GLenum src), (src)) \
+    X(void, ReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels), (x, y, width, height, format, type, pixels)) \
+    X(void, GetBooleanv, (GLenum pname, GLboolean *data), (pname, data)) \
+    X(void, GetDoublev, (GLenum pname, GLdouble *data), (pname, data)) \
+    X(GLenum, GetError, (), ()) \
+    X(void, GetFloatv, (GLenum pname, GLfloat *data), (pname, data)) \
+    X(void, GetIntegerv, (GLenum pname, GLint *data), (pname, data)) \
+    X(const GLubyte *, GetString, (GLenum name), (name)) \
+    X(void, GetTexImage, (GLenum target, GLint level, GLenum format, GLenum type, void *pixels), (target, level, format, type, pixels)) \
+    X(void, GetTexParameterfv, (GLenum target, GLenum pname, GLfloat *params), (target, pname, params)) \
+    X(void, GetTexParameteriv, (GLenum target, GLenum pname, GLint *params), (target, pname, params)) \
+    X(void, GetTexLevelParameterfv, (GLenum target, GLint level, GLenum pname, GLfloat *params), (target, level, pname, params)) \
+    X(void, GetTexLevelParameteriv, (GLenum target, GLint level, GLenum pname, GLint *params), (target, level, pname, params)) \
+    X(GLboolean, IsEnabled, (GLenum cap), (cap)) \
+    X(void, DrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count)) \
+    X(void, DrawElements, (GLenum mode, GLsizei count, GLenum type, const void *indices), (mode, count, type, indices)) \
+    X(void, GetPointerv, (GLenum pname, void **params), (pname, params)) \
+    X(void, CopyTexImage1D, (GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLint border), (target, level, internalformat, x, y, width, border)) \
+    X(void, CopyTexImage2D, (GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border), (target, level, internalformat, x, y, width, height, border)) \
+    X(void, CopyTexSubImage1D, (GLenum target, GLint level, GLint xoffset, GLint x, GLint y, GLsizei width), (target, level, xoffset, x, y, width)) \
+    X(void, CopyTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height), (target, level, xoffset, yoffset, x, y, width, height)) \
+    X(void, TexSubImage1D, (GLenum target, GLint level, GLint xoffset, GLsizei width, GLenum format, GLenum type, const void *pixels), (target, level, xoffset, width, format, type, pixels)) \
+    X(void, TexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels)) \
+    X(void, GenTextures, (GLsizei n, GLuint *textures), (n, textures)) \
+    X(GLboolean, IsTexture, (GLuint texture), (texture))
+
+#define GFX_GL_LEGACY_CALLS(X) \
+    GFX_GL_LEGACY_TRACKED_CALLS(X) \
+    GFX_GL_LEGACY_STATE_CALLS(X) \
+    GFX_GL_LEGACY_COUNTED_CALLS(X)
+
+namespace {
+    enum Call : std::size_t {
+#define GFX_GL_CALL_ENUM(name) CALL_##name,
+        GFX_GL_CALLS(GFX_GL_CALL_ENUM)
+#undef GFX_GL_CALL_ENUM
+#define GFX_GL_LEGACY_CALL_ENUM(R, name, params, args) CALL_##name,
+        GFX_GL_LEGACY_CALLS(GFX_GL_LEGACY_CALL_ENUM)
+#undef GFX_GL_LEGACY_CALL_ENUM
+        CALL_COUNT
+    };
+
+    const char * const CALL_NAMES[] = {
+#define GFX_GL_CALL_NAME(name) "gl" #name,
+        GFX_GL_CALLS(GFX_GL_CALL_NAME)
+#undef GFX_GL_CALL_NAME
+#define GFX_GL_LEGACY_CALL_NAME(R, name, params, args) "gl" #name,
+        GFX_GL_LEGACY_CALLS(GFX_GL_LEGACY_CALL_NAME)
+#undef GFX_GL_LEGACY_CALL_NAME
+    };
+
+#define GFX_GL_CALL_REAL(name) decltype(__glew##name) real##name = nullptr;
+    GFX_GL_CALLS(GFX_GL_CALL_REAL)
+#undef GFX_GL_CALL_REAL
+
+    // Resolved up front since the interposed functions run whether or not the layer is installed.
+#define GFX_GL_LEGACY_CALL_REAL(R, name, params, args) \
+    const auto real##name = reinterpret_cast<R (APIENTRY *) params> (dlsym(RTLD_NEXT, "gl" #name));
+    GFX_GL_LEGACY_CALLS(GFX_GL_LEGACY_CALL_REAL)
+#undef GFX_GL_LEGACY_CALL_REAL
+
+    enum Slot : std::uint64_t {
+        SLOT_PROGRAM,
+        SLOT_BUFFER,
+        SLOT_INDEXED_BUFFER,
+        SLOT_VERTEX_ARRAY,
+        SLOT_VERTEX_BUFFER,
+        SLOT_ACTIVE_TEXTURE,
+        SLOT_TEXTURE_UNIT,
+        SLOT_SAMPLER,
+        SLOT_FRAMEBUFFER,
+        SLOT_UNIFORM,
+        SLOT_CAPABILITY,
+        SLOT_TEXTURE,
+        SLOT_STATE
+    };
+
+    struct Counter {
+        unsigned long calls;
+        unsigned long redundant;
+    };
+
+    struct Stats {
+        bool installed;
+        std::array<Counter, CALL_COUNT> counters;
+        std::unordered_map<std::uint64_t, std::uint64_t> bindings;
+        GLuint program;
+        GLuint vertexArray;
+        GLuint activeTexture;
+        unsigned long frames;
+        unsigned long frameCalls;
+        unsigned long maxFrameCalls;
+    };
+
+    Stats stats {};
+
+    class Hasher {
+        std::uint64_t _hash;
+
+    public:
+        Hasher() noexcept : _hash(14695981039346656037ULL) {}
+
+        Hasher& add(const void * data, std::size_t size) noexcept {
+            auto bytes = static_cast<const unsigned char *> (data);
+
+            for (std::size_t i = 0; i < size; i++) {
+                _hash = (_hash ^ bytes[i]) * 1099511628211ULL;
+            }
+
+            return *this;
+        }
+
+        template<class T>
+        Hasher& add(const T& value) noexcept {
+            return add(&value, sizeof(T));
+        }
+
+        Hasher& addAll() noexcept {
+            return *this;
+        }
+
+        template<class T, class... Rest>
+        Hasher& addAll(const T& value, const Rest&... rest) noexcept {
+            return add(value).addAll(rest...);
+        }
+
+        std::uint64_t get() const noexcept {
+            return _hash;
+        }
+    };
+
+    std::uint64_t makeSlot(Slot slot, std::uint64_t a, std::uint64_t b = 0) noexcept {
+        return (static_cast<std::uint64_t> (slot) << 56) | ((a & 0xFFFFFFF) << 28) | (b & 0xFFFFFFF);
+    }
+
+    // Returns true when the binding already holds the value, i.e. the call changes nothing.
+    bool setBinding(std::uint64_t slot, std::uint64_t value) {
+        auto it = stats.bindings.find(slot);
+
+        if (stats.bindings.end() != it && value == it->second) {
+            return true;
+        }
+
+        stats.bindings[slot] = value;
+
+        return false;
+    }
+
+    void count(Call call, bool redundant = false) noexcept {
+        auto& counter = stats.counters[call];
+
+        counter.calls++;
+        counter.redundant += redundant ? 1 : 0;
+        stats.frameCalls++;
+    }
+
+    // For the interposed GL 1.x functions, which also run while the layer isn't installed, e.g. from glewInit.
+    // Named apart from count() since glDrawArrays and glDrawElements have a count parameter.
+    void countInstalled(Call call) noexcept {
+        if (stats.installed) {
+            count(call);
+        }
+    }
+
+    // Deleting objects implicitly unbinds them; forget everything rather than track which names were bound.
+    void invalidate() noexcept {
+        stats.bindings.clear();
+        stats.program = 0;
+        stats.vertexArray = 0;
+    }
+
+    template<class Proc, Proc * REAL, Call CALL>
+    struct Counted;
+
+    template<class R, class... Args, R (APIENTRY ** REAL) (Args...), Call CALL>
+    struct Counted<R (APIENTRY *) (Args...), REAL, CALL> {
+        static R APIENTRY hook(Args... args) {
+            count(CALL);
+
+            return (*REAL)(args...);
+        }
+    };
+
+    void APIENTRY hookUseProgram(GLuint program) {
+        count(CALL_UseProgram, setBinding(makeSlot(SLOT_PROGRAM, 0), program));
+        stats.program = program;
+
+        realUseProgram(program);
+    }
+
+    void APIENTRY hookBindBuffer(GLenum target, GLuint buffer) {
+        // The element array binding is vertex array state.
+        auto owner = GL_ELEMENT_ARRAY_BUFFER == target ? stats.vertexArray : 0;
+
+        count(CALL_BindBuffer, setBinding(makeSlot(SLOT_BUFFER, target, owner), buffer));
+
+        realBindBuffer(target, buffer);
+    }
+
+    void APIENTRY hookBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+        // glBindBufferBase also sets the generic binding point, so that is hashed alongside the range.
+        auto value = Hasher().add(buffer).add(GLintptr(0)).add(GLsizeiptr(-1)).get();
+
+        count(CALL_BindBufferBase, setBinding(makeSlot(SLOT_INDEXED_BUFFER, target, index), value));
+        setBinding(makeSlot(SLOT_BUFFER, target), buffer);
+
+        realBindBufferBase(target, index, buffer);
+    }
+
+    void APIENTRY hookBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+        auto value = Hasher().add(buffer).add(offset).add(size).get();
+
+        count(CALL_BindBufferRange, setBinding(makeSlot(SLOT_INDEXED_BUFFER, target, index), value));
+        setBinding(makeSlot(SLOT_BUFFER, target), buffer);
+
+        realBindBufferRange(target, index, buffer, offset, size);
+    }
+
+    void APIENTRY hookBindVertexArray(GLuint array) {
+        count(CALL_BindVertexArray, setBinding(makeSlot(SLOT_VERTEX_ARRAY, 0), array));
+        stats.vertexArray = array;
+
+        realBindVertexArray(array);
+    }
+
+    void APIENTRY hookBindVertexBuffer(GLuint bindingIndex, GLuint buffer, GLintptr offset, GLsizei stride) {
+        auto value = Hasher().add(buffer).add(offset).add(stride).get();
+
+        count(CALL_BindVertexBuffer, setBinding(makeSlot(SLOT_VERTEX_BUFFER, stats.vertexArray, bindingIndex), value));
+
+        realBindVertexBuffer(bindingIndex, buffer, offset, stride);
+    }
+
+    void APIENTRY hookActiveTexture(GLenum texture) {
+        count(CALL_ActiveTexture, setBinding(makeSlot(SLOT_ACTIVE_TEXTURE, 0), texture));
+        stats.activeTexture = texture - GL_TEXTURE0;
+
+        realActiveTexture(texture);
+    }
+
+    void APIENTRY hookBindTextureUnit(GLuint unit, GLuint texture) {
+        count(CALL_BindTextureUnit, setBinding(makeSlot(SLOT_TEXTURE_UNIT, unit), texture));
+
+        realBindTextureUnit(unit, texture);
+    }
+
+    void APIENTRY hookBindSampler(GLuint unit, GLuint sampler) {
+        count(CALL_BindSampler, setBinding(makeSlot(SLOT_SAMPLER, unit), sampler));
+
+        realBindSampler(unit, sampler);
+    }
+
+    void APIENTRY hookBindFramebuffer(GLenum target, GLuint framebuffer) {
+        auto redundant = false;
+
+        if (GL_FRAMEBUFFER == target) {
+            auto draw = setBinding(makeSlot(SLOT_FRAMEBUFFER, GL_DRAW_FRAMEBUFFER), framebuffer);
+            auto read = setBinding(makeSlot(SLOT_FRAMEBUFFER, GL_READ_FRAMEBUFFER), framebuffer);
+
+            redundant = draw && read;
+        } else {
+            redundant = setBinding(makeSlot(SLOT_FRAMEBUFFER, target), framebuffer);
+        }
+
+        count(CALL_BindFramebuffer, redundant);
+
+        realBindFramebuffer(target, framebuffer);
+    }
+
+    bool setUniform(GLuint program, GLint location, std::uint64_t value) {
+        return location >= 0 && setBinding(makeSlot(SLOT_UNIFORM, program, static_cast<std::uint64_t> (location)), value);
+    }
+
+    void APIENTRY hookUniform1i(GLint location, GLint v0) {
+        count(CALL_Uniform1i, setUniform(stats.program, location, Hasher().add(v0).get()));
+
+        realUniform1i(location, v0);
+    }
+
+    void APIENTRY hookUniform1f(GLint location, GLfloat v0) {
+        count(CALL_Uniform1f, setUniform(stats.program, location, Hasher().add(v0).get()));
+
+        realUniform1f(location, v0);
+    }
+
+    void APIENTRY hookUniform4fv(GLint location, GLsizei n, const GLfloat * value) {
+        count(CALL_Uniform4fv, setUniform(stats.program, location, Hasher().add(value, n * 4 * sizeof(GLfloat)).get()));
+
+        realUniform4fv(location, n, value);
+    }
+
+    void APIENTRY hookUniformMatrix4fv(GLint location, GLsizei n, GLboolean transpose, const GLfloat * value) {
+        auto hash = Hasher().add(transpose).add(value, n * 16 * sizeof(GLfloat)).get();
+
+        count(CALL_UniformMatrix4fv, setUniform(stats.program, location, hash));
+
+        realUniformMatrix4fv(location, n, transpose, value);
+    }
+
+    void APIENTRY hookProgramUniform1i(GLuint program, GLint location, GLint v0) {
+        count(CALL_ProgramUniform1i, setUniform(program, location, Hasher().add(v0).get()));
+
+        realProgramUniform1i(program, location, v0);
+    }
+
+    void APIENTRY hookProgramUniform1f(GLuint program, GLint location, GLfloat v0) {
+        count(CALL_ProgramUniform1f, setUniform(program, location, Hasher().add(v0).get()));
+
+        realProgramUniform1f(program, location, v0);
+    }
+
+    void APIENTRY hookProgramUniformMatrix4fv(GLuint program, GLint location, GLsizei n, GLboolean transpose, const GLfloat * value) {
+        auto hash = Hasher().add(transpose).add(value, n * 16 * sizeof(GLfloat)).get();
+
+        count(CALL_ProgramUniformMatrix4fv, setUniform(program, location, hash));
+
+        realProgramUniformMatrix4fv(program, location, n, transpose, value);
+    }
+
+    // Relinking resets every uniform of the program to its default.
+    void APIENTRY hookLinkProgram(GLuint program) {
+        count(CALL_LinkProgram);
+        invalidate();
+
+        realLinkProgram(program);
+    }
+
+    void APIENTRY hookDeleteProgram(GLuint program) {
+        count(CALL_DeleteProgram);
+        invalidate();
+
+        realDeleteProgram(program);
+    }
+
+    void APIENTRY hookDeleteBuffers(GLsizei n, const GLuint * buffers) {
+        count(CALL_DeleteBuffers);
+        invalidate();
+
+        realDeleteBuffers(n, buffers);
+    }
+
+    void APIENTRY hookDeleteVertexArrays(GLsizei n, const GLuint * arrays) {
+        count(CALL_DeleteVertexArrays);
+        invalidate();
+
+        realDeleteVertexArrays(n, arrays);
+    }
+
+    void APIENTRY hookDeleteFramebuffers(GLsizei n, const GLuint * framebuffers) {
+        count(CALL_DeleteFramebuffers);
+        invalidate();
+
+        realDeleteFramebuffers(n, framebuffers);
+    }
+
+#define GFX_GL_COUNTED(name) \
+    auto hook##name = &Counted<decltype(real##name), &real##name, CALL_##name>::hook;
+    GFX_GL_COUNTED_CALLS(GFX_GL_COUNTED)
+#undef GFX_GL_COUNTED
+}
+
+extern "C" {
+    void APIENTRY glEnable(GLenum cap) {
+        if (stats.installed) {
+            count(CALL_Enable, setBinding(makeSlot(SLOT_CAPABILITY, cap), 1));
+        }
+
+        realEnable(cap);
+    }
+
+    void APIENTRY glDisable(GLenum cap) {
+        if (stats.installed) {
+            count(CALL_Disable, setBinding(makeSlot(SLOT_CAPABILITY, cap), 0));
+        }
+
+        realDisable(cap);
+    }
+
+    // Shares the unit's slot with glBindTextureUnit; mixing the two is never reported redundant, only missed.
+    void APIENTRY glBindTexture(GLenum target, GLuint texture) {
+        if (stats.installed) {
+            count(CALL_BindTexture, setBinding(makeSlot(SLOT_TEXTURE_UNIT, stats.activeTexture), Hasher().addAll(target, texture).get()));
+        }
+
+        realBindTexture(target, texture);
+    }
+
+    void APIENTRY glDeleteTextures(GLsizei n, const GLuint * textures) {
+        if (stats.installed) {
+            count(CALL_DeleteTextures);
+            invalidate();
+        }
+
+        realDeleteTextures(n, textures);
+    }
+
+#define GFX_GL_LEGACY_STATE(R, name, params, args) \
+    R APIENTRY gl##name params { \
+        if (stats.installed) { \
+            count(CALL_##name, setBinding(makeSlot(SLOT_STATE, CALL_##name), Hasher().addAll args .get())); \
+        } \
+        return real##name args; \
+    }
+    GFX_GL_LEGACY_STATE_CALLS(GFX_GL_LEGACY_STATE)
+#undef GFX_GL_LEGACY_STATE
+
+#define GFX_GL_LEGACY_COUNTED(R, name, params, args) \
+    R APIENTRY gl##name params { \
+        countInstalled(CALL_##name); \
+        return real##name args; \
+    }
+    GFX_GL_LEGACY_COUNTED_CALLS(GFX_GL_LEGACY_COUNTED)
+#undef GFX_GL_LEGACY_COUNTED
+}
+
+namespace gfx {
+    bool GlStats::isInstalled() noexcept {
+        return stats.installed;
+    }
+
+    void GlStats::install() noexcept {
+        if (stats.installed) {
+            return;
+        }
+
+        // Entry points the driver doesn't expose stay null and are left alone.
+#define GFX_GL_CALL_INSTALL(name) \
+        real##name = __glew##name; \
+        if (nullptr != real##name) { \
+            __glew##name = hook##name; \
+        }
+        GFX_GL_CALLS(GFX_GL_CALL_INSTALL)
+#undef GFX_GL_CALL_INSTALL
+
+        stats.installed = true;
+    }
+
+    void GlStats::uninstall() noexcept {
+        if (!stats.installed) {
+            return;
+        }
+
+#define GFX_GL_CALL_UNINSTALL(name) \
+        if (nullptr != real##name) { \
+            __glew##name = real##name; \
+        }
+        GFX_GL_CALLS(GFX_GL_CALL_UNINSTALL)
+#undef GFX_GL_CALL_UNINSTALL
+
+        stats.installed = false;
+    }
+
+    void GlStats::endFrame() noexcept {
+        stats.frames++;
+        stats.maxFrameCalls = std::max(stats.maxFrameCalls, stats.frameCalls);
+        stats.frameCalls = 0;
+    }
+
+    void GlStats::report(std::ostream& out, std::size_t top) {
+        auto frames = static_cast<double> (std::max(stats.frames, 1UL));
+        auto calls = 0UL;
+        auto redundant = 0UL;
+        auto order = std::vector<std::size_t> ();
+
+        for (std::size_t i = 0; i < CALL_COUNT; i++) {
+            calls += stats.counters[i].calls;
+            redundant += stats.counters[i].redundant;
+
+            if (stats.counters[i].calls) {
+                order.push_back(i);
+            }
+        }
+
+        std::sort(order.begin(), order.end(), [] (std::size_t a, std::size_t b) {
+            const auto& lhs = stats.counters[a];
+            const auto& rhs = stats.counters[b];
+
+            return lhs.redundant != rhs.redundant ? lhs.redundant > rhs.redundant : lhs.calls > rhs.calls;
+        });
+
+        out.precision(2);
+        out << std::fixed << "GL calls over " << stats.frames << " frames: " << calls / frames << " per frame (max "
+            << stats.maxFrameCalls << "), " << redundant / frames << " redundant per frame" << std::endl;
+
+        for (std::size_t i = 0; i < std::min(top, order.size()); i++) {
+            const auto& counter = stats.counters[order[i]];
+
+            out << "  " << CALL_NAMES[order[i]] << ": " << counter.calls / frames << " calls, "
+                << counter.redundant / frames << " redundant per frame" << std::endl;
+        }
+    }
+}
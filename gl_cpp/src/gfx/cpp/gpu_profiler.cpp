@@ -0,0 +1,172 @@
+#include "gpu_profiler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+namespace {
+    constexpr double AVERAGE_WEIGHT = 0.05;
+
+    constexpr const char * FRAME_SCOPE = "frame";
+}
+
+namespace gfx {
+    GpuProfiler::GpuProfiler(std::size_t latency) {
+        if (latency < 2) {
+            throw std::runtime_error("GpuProfiler needs a latency of at least two frames!");
+        }
+
+        _frames.resize(latency);
+
+        for (auto& frame : _frames) {
+            frame.usedQueries = 0;
+            frame.pending = false;
+        }
+
+        _current = 0;
+        _droppedFrames = 0;
+        _collectedFrames = 0;
+    }
+
+    GpuProfiler::~GpuProfiler() noexcept {
+        for (auto& frame : _frames) {
+            if (!frame.queries.empty()) {
+                glDeleteQueries(static_cast<GLsizei> (frame.queries.size()), frame.queries.data());
+            }
+        }
+    }
+
+    std::size_t GpuProfiler::timestamp() {
+        auto& frame = _frames[_current];
+
+        if (frame.usedQueries == frame.queries.size()) {
+            GLuint query;
+            glCreateQueries(GL_TIMESTAMP, 1, &query);
+
+            frame.queries.push_back(query);
+        }
+
+        glQueryCounter(frame.queries[frame.usedQueries], GL_TIMESTAMP);
+
+        return frame.usedQueries++;
+    }
+
+    bool GpuProfiler::isAvailable(const Frame& frame) const noexcept {
+        // Timestamps complete in submission order, so the frame's last query stands in for all of them.
+        GLint available;
+        glGetQueryObjectiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        return GL_FALSE != available;
+    }
+
+    void GpuProfiler::collect(Frame& frame) {
+        _collectedFrames++;
+
+        for (const auto& marker : frame.markers) {
+            GLuint64 begin, end;
+            glGetQueryObjectui64v(frame.queries[marker.beginQuery], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(frame.queries[marker.endQuery], GL_QUERY_RESULT, &end);
+
+            auto ms = static_cast<double> (end - begin) * 1e-6;
+            auto it = _stats.find(marker.name);
+
+            if (_stats.end() == it) {
+                auto order = _stats.size();
+
+                _stats[marker.name] = { order, marker.depth, ms, ms, 1, _collectedFrames };
+            } else {
+                auto& stats = it->second;
+
+                stats.averageMs += (ms - stats.averageMs) * AVERAGE_WEIGHT;
+                stats.lastMs = ms;
+                stats.samples++;
+                stats.lastCollected = _collectedFrames;
+            }
+        }
+
+        frame.pending = false;
+    }
+
+    void GpuProfiler::beginFrame() {
+        for (auto& frame : _frames) {
+            if (frame.pending && isAvailable(frame)) {
+                collect(frame);
+            }
+        }
+
+        _current = (_current + 1) % _frames.size();
+
+        auto& frame = _frames[_current];
+
+        // Still in flight after a full trip around the ring: give up on it instead of waiting.
+        if (frame.pending) {
+            frame.pending = false;
+            _droppedFrames++;
+        }
+
+        frame.usedQueries = 0;
+        frame.markers.clear();
+
+        beginScope(FRAME_SCOPE);
+    }
+
+    void GpuProfiler::endFrame() {
+        while (!_stack.empty()) {
+            endScope();
+        }
+
+        _frames[_current].pending = true;
+    }
+
+    void GpuProfiler::beginScope(const char * name) {
+        auto& frame = _frames[_current];
+
+        _stack.push_back(frame.markers.size());
+        frame.markers.push_back({ name, static_cast<unsigned int> (_stack.size() - 1), timestamp(), 0 });
+    }
+
+    void GpuProfiler::endScope() {
+        if (_stack.empty()) {
+            throw std::runtime_error("GpuProfiler::endScope() without a matching beginScope()!");
+        }
+
+        auto& frame = _frames[_current];
+
+        frame.markers[_stack.back()].endQuery = timestamp();
+        _stack.pop_back();
+    }
+
+    std::vector<GpuScopeStats> GpuProfiler::getStats() const {
+        auto out = std::vector<GpuScopeStats> (_stats.size());
+
+        for (const auto& entry : _stats) {
+            const auto& stats = entry.second;
+
+            out[stats.order] = { entry.first, stats.depth, stats.averageMs, stats.lastMs, stats.samples, stats.lastCollected == _collectedFrames };
+        }
+
+        return out;
+    }
+
+    unsigned long GpuProfiler::getDroppedFrames() const noexcept {
+        return _droppedFrames;
+    }
+
+    void GpuProfiler::report(std::ostream& out) const {
+        auto flags = out.flags();
+
+        out << "GPU scope averages (ms):" << std::endl;
+
+        for (const auto& stats : getStats()) {
+            out << "  " << std::string(stats.depth * 2, ' ') << std::left << std::setw(24) << stats.name
+                << std::right << std::fixed << std::setprecision(3) << std::setw(9) << stats.averageMs
+                << "  (" << stats.samples << " samples)" << std::endl;
+        }
+
+        if (_droppedFrames) {
+            out << "  " << _droppedFrames << " frames dropped waiting on query results" << std::endl;
+        }
+
+        out.flags(flags);
+    }
+}
@@ -0,0 +1,75 @@
+#include "gpu_query.hpp"
+
+namespace {
+    constexpr double AVERAGE_WEIGHT = 0.05;
+}
+
+namespace gfx {
+    GpuQuery::GpuQuery(GLenum target) noexcept {
+        _target = target;
+
+        glCreateQueries(_target, static_cast<GLsizei> (LATENCY), _queries.data());
+
+        _pending.fill(false);
+        _next = 0;
+        _active = false;
+        _average = 0.0;
+        _hasAverage = false;
+    }
+
+    GpuQuery::~GpuQuery() noexcept {
+        glDeleteQueries(static_cast<GLsizei> (LATENCY), _queries.data());
+    }
+
+    void GpuQuery::collect() noexcept {
+        for (std::size_t i = 0; i < LATENCY; i++) {
+            if (!_pending[i]) {
+                continue;
+            }
+
+            GLint available;
+            glGetQueryObjectiv(_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+
+            if (!available) {
+                continue;
+            }
+
+            GLuint64 result;
+            glGetQueryObjectui64v(_queries[i], GL_QUERY_RESULT, &result);
+
+            auto value = static_cast<double> (result);
+
+            _average = _hasAverage ? _average + (value - _average) * AVERAGE_WEIGHT : value;
+            _hasAverage = true;
+            _pending[i] = false;
+        }
+    }
+
+    void GpuQuery::begin() noexcept {
+        collect();
+
+        // If the GPU is more than LATENCY frames behind, drop this sample rather than wait on it.
+        if (_pending[_next]) {
+            return;
+        }
+
+        glBeginQuery(_target, _queries[_next]);
+        _active = true;
+    }
+
+    void GpuQuery::end() noexcept {
+        if (!_active) {
+            return;
+        }
+
+        glEndQuery(_target);
+
+        _pending[_next] = true;
+        _next = (_next + 1) % LATENCY;
+        _active = false;
+    }
+
+    double GpuQuery::getAverage() const noexcept {
+        return _average;
+    }
+}
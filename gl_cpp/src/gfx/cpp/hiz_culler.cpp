@@ -0,0 +1,100 @@
+#include "hiz_culler.hpp"
+
+#include <algorithm>
+
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+    constexpr GLuint REDUCE_GROUP_SIZE = 8;
+    constexpr GLuint CULL_GROUP_SIZE = 64;
+}
+
+namespace gfx {
+    HiZCuller::HiZCuller(int width, int height) {
+        _width = std::max(width, 1);
+        _height = std::max(height, 1);
+        _levels = 1;
+        _viewProj = glm::mat4(1.0F);
+
+        while ((std::max(_width, _height) >> _levels) > 0) {
+            _levels++;
+        }
+
+        _pReduceProgram = std::make_unique<ShaderProgram> (std::vector<ShaderStage> ({
+                { GL_COMPUTE_SHADER, "data/shaders/gfx/depth_pyramid.comp" }
+            }));
+
+        _pCullProgram = std::make_unique<ShaderProgram> (std::vector<ShaderStage> ({
+                { GL_COMPUTE_SHADER, "data/shaders/gfx/hiz_cull.comp" }
+            }));
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &_pyramid);
+        glTextureStorage2D(_pyramid, _levels, GL_R32F, _width, _height);
+        glTextureParameteri(_pyramid, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTextureParameteri(_pyramid, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        reset(_viewProj);
+    }
+
+    HiZCuller::~HiZCuller() noexcept {
+        glDeleteTextures(1, &_pyramid);
+    }
+
+    GLuint HiZCuller::getPyramidHandle() const noexcept {
+        return _pyramid;
+    }
+
+    int HiZCuller::getLevelCount() const noexcept {
+        return _levels;
+    }
+
+    const glm::mat4& HiZCuller::getViewProj() const noexcept {
+        return _viewProj;
+    }
+
+    void HiZCuller::reset(const glm::mat4& viewProj) {
+        const auto far = 1.0F;
+
+        _viewProj = viewProj;
+
+        for (int level = 0; level < _levels; level++) {
+            glClearTexImage(_pyramid, level, GL_RED, GL_FLOAT, &far);
+        }
+    }
+
+    void HiZCuller::build(GLuint depthTexture, const glm::mat4& viewProj) {
+        _viewProj = viewProj;
+
+        glUseProgram(_pReduceProgram->getHandle());
+        glBindTextureUnit(0, depthTexture);
+
+        for (int level = 0; level < _levels; level++) {
+            auto width = std::max(_width >> level, 1);
+            auto height = std::max(_height >> level, 1);
+            auto source = std::max(level - 1, 0);
+
+            glUniform1i(0, level);
+            glUniform2i(1, std::max(_width >> source, 1), std::max(_height >> source, 1));
+            glBindImageTexture(0, _pyramid, source, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+            glBindImageTexture(1, _pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+            glDispatchCompute((width + REDUCE_GROUP_SIZE - 1) / REDUCE_GROUP_SIZE, (height + REDUCE_GROUP_SIZE - 1) / REDUCE_GROUP_SIZE, 1);
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        }
+
+        // Texture update covers reading the pyramid back with glGetTextureImage.
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    }
+
+    void HiZCuller::cull(GLuint boundsBuffer, GLuint count, GLuint visibleBuffer, GLuint commandBuffer) {
+        glUseProgram(_pCullProgram->getHandle());
+        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(_viewProj));
+        glUniform1ui(1, count);
+        glBindTextureUnit(0, _pyramid);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, boundsBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+        glDispatchCompute((count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+        // Buffer update covers reading the results back and resetting the command before the next cull.
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    }
+}
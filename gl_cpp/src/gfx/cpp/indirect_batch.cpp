@@ -0,0 +1,104 @@
+#include "indirect_batch.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace gfx {
+    IndirectBatch::IndirectBatch(GLsizei capacity) {
+        _capacity = std::max(capacity, 1);
+        _dirty = false;
+
+        _commands.reserve(_capacity);
+
+        // Fixed capacity: vertex arrays keep referencing the draw id buffer, so it must never be reallocated.
+        glCreateBuffers(1, &_commandBuffer);
+        glNamedBufferStorage(_commandBuffer, _capacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+        glCreateBuffers(1, &_culledBuffer);
+        glNamedBufferStorage(_culledBuffer, _capacity * sizeof(DrawElementsIndirectCommand), nullptr, 0);
+
+        auto drawIds = std::vector<GLuint> (_capacity);
+        std::iota(drawIds.begin(), drawIds.end(), 0);
+
+        glCreateBuffers(1, &_drawIdBuffer);
+        glNamedBufferStorage(_drawIdBuffer, _capacity * sizeof(GLuint), drawIds.data(), 0);
+    }
+
+    IndirectBatch::~IndirectBatch() noexcept {
+        glDeleteBuffers(1, &_drawIdBuffer);
+        glDeleteBuffers(1, &_culledBuffer);
+        glDeleteBuffers(1, &_commandBuffer);
+    }
+
+    GLsizei IndirectBatch::size() const noexcept {
+        return static_cast<GLsizei> (_commands.size());
+    }
+
+    const std::vector<DrawElementsIndirectCommand>& IndirectBatch::getCommands() const noexcept {
+        return _commands;
+    }
+
+    GLuint IndirectBatch::getCommandHandle() const noexcept {
+        return _commandBuffer;
+    }
+
+    GLuint IndirectBatch::getCulledHandle() const noexcept {
+        return _culledBuffer;
+    }
+
+    void IndirectBatch::clear() noexcept {
+        _commands.clear();
+        _dirty = false;
+    }
+
+    GLuint IndirectBatch::add(GLuint count, GLuint firstIndex, GLint baseVertex) {
+        if (size() == _capacity) {
+            auto msg = std::stringstream();
+            msg << "Indirect batch is full: " << _capacity << " draws";
+
+            throw std::runtime_error(msg.str());
+        }
+
+        auto drawId = static_cast<GLuint> (_commands.size());
+
+        _commands.push_back({ count, 1, firstIndex, baseVertex, drawId });
+        _dirty = true;
+
+        return drawId;
+    }
+
+    void IndirectBatch::flush() {
+        if (!_dirty) {
+            return;
+        }
+
+        glNamedBufferSubData(_commandBuffer, 0, _commands.size() * sizeof(DrawElementsIndirectCommand), _commands.data());
+
+        _dirty = false;
+    }
+
+    void IndirectBatch::attachDrawIds(GLuint vertexArray, GLuint attribIndex, GLuint bindingIndex) const noexcept {
+        glEnableVertexArrayAttrib(vertexArray, attribIndex);
+        glVertexArrayAttribIFormat(vertexArray, attribIndex, 1, GL_UNSIGNED_INT, 0);
+        glVertexArrayAttribBinding(vertexArray, attribIndex, bindingIndex);
+        glVertexArrayVertexBuffer(vertexArray, bindingIndex, _drawIdBuffer, 0, sizeof(GLuint));
+        glVertexArrayBindingDivisor(vertexArray, bindingIndex, 1);
+    }
+
+    void IndirectBatch::bindForCulling(GLuint sourceIndex, GLuint culledIndex) const noexcept {
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, sourceIndex, _commandBuffer, 0, _capacity * sizeof(DrawElementsIndirectCommand));
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, culledIndex, _culledBuffer, 0, _capacity * sizeof(DrawElementsIndirectCommand));
+    }
+
+    void IndirectBatch::draw(GLenum indexType) const noexcept {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _commandBuffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, nullptr, size(), 0);
+    }
+
+    void IndirectBatch::drawCulled(GLenum indexType) const noexcept {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _culledBuffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, nullptr, size(), 0);
+    }
+}
@@ -0,0 +1,31 @@
+#include "mesh.hpp"
+
+#include <cstring>
+#include <limits>
+
+namespace gfx {
+    GLenum Mesh::getIndexType() const noexcept {
+        return vertices.size() <= std::numeric_limits<std::uint16_t>::max() + std::size_t(1) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+
+    std::size_t Mesh::getIndexSize() const noexcept {
+        return GL_UNSIGNED_SHORT == getIndexType() ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+    }
+
+    std::vector<std::uint8_t> Mesh::packIndices() const {
+        auto packed = std::vector<std::uint8_t> (indices.size() * getIndexSize());
+
+        if (GL_UNSIGNED_INT == getIndexType()) {
+            std::memcpy(packed.data(), indices.data(), packed.size());
+            return packed;
+        }
+
+        auto pOut = reinterpret_cast<std::uint16_t *> (packed.data());
+
+        for (std::size_t i = 0; i < indices.size(); i++) {
+            pOut[i] = static_cast<std::uint16_t> (indices[i]);
+        }
+
+        return packed;
+    }
+}
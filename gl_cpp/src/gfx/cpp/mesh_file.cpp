@@ -0,0 +1,376 @@
+#include "mesh_file.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    constexpr std::uint64_t BLOCK_ALIGNMENT = 64;
+    constexpr std::uint32_t POSITION_STREAM = 0;
+    constexpr std::uint32_t SURFACE_STREAM = 1;
+
+    struct SurfaceT {
+        glm::vec2 texcoord;
+        glm::vec3 normal;
+    };
+
+    static_assert(104 == sizeof(gfx::MeshFileHeader), "MeshFileHeader must match the file layout");
+    static_assert(24 == sizeof(gfx::MeshFileStream), "MeshFileStream must match the file layout");
+    static_assert(24 == sizeof(gfx::MeshFileAttribute), "MeshFileAttribute must match the file layout");
+    static_assert(16 == sizeof(gfx::MeshFileLod), "MeshFileLod must match the file layout");
+    static_assert(20 == sizeof(SurfaceT), "SurfaceT must be tightly packed");
+
+    std::uint64_t align(std::uint64_t offset) noexcept {
+        return (offset + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+    }
+
+    [[noreturn]] void throwInvalid(const std::string& path, const char * pReason) {
+        auto msg = std::stringstream();
+        msg << "Invalid mesh file \"" << path << "\": " << pReason;
+
+        throw std::runtime_error(msg.str());
+    }
+
+    bool isInside(std::uint64_t offset, std::uint64_t size, std::uint64_t fileSize) noexcept {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+
+    // Bytes one attribute reads from each vertex, or 0 for a type glVertexArrayAttribFormat doesn't take.
+    std::uint64_t getAttributeSize(const gfx::MeshFileAttribute& attribute) noexcept {
+        switch (attribute.type) {
+            case GL_BYTE:
+            case GL_UNSIGNED_BYTE:
+                return attribute.components;
+
+            case GL_SHORT:
+            case GL_UNSIGNED_SHORT:
+            case GL_HALF_FLOAT:
+                return 2 * attribute.components;
+
+            case GL_INT:
+            case GL_UNSIGNED_INT:
+            case GL_FIXED:
+            case GL_FLOAT:
+                return 4 * attribute.components;
+
+            case GL_DOUBLE:
+                return 8 * attribute.components;
+
+            case GL_INT_2_10_10_10_REV:
+            case GL_UNSIGNED_INT_2_10_10_10_REV:
+            case GL_UNSIGNED_INT_10F_11F_11F_REV:
+                return 4;
+
+            default:
+                return 0;
+        }
+    }
+}
+
+namespace gfx {
+    void writeMeshFile(const std::string& path, const Mesh& mesh, const std::vector<MeshFileLod>& lods) {
+        if (mesh.vertices.empty() || mesh.indices.empty()) {
+            auto msg = std::stringstream();
+            msg << "Cannot write an empty mesh to \"" << path << "\"";
+
+            throw std::runtime_error(msg.str());
+        }
+
+        auto vertexCount = static_cast<std::uint32_t> (mesh.vertices.size());
+        auto indices = mesh.packIndices();
+        auto fileLods = lods.empty() ? std::vector<MeshFileLod> ({ { 0, static_cast<std::uint32_t> (mesh.indices.size()), 0.0F, 0 } }) : lods;
+
+        auto positions = std::vector<glm::vec3> (vertexCount);
+        auto surfaces = std::vector<SurfaceT> (vertexCount);
+        auto header = MeshFileHeader {};
+
+        header.boundsMin = glm::vec3(0.0F);
+        header.boundsMax = glm::vec3(0.0F);
+
+        for (std::uint32_t i = 0; i < vertexCount; i++) {
+            const auto& vertex = mesh.vertices[i];
+
+            positions[i] = vertex.position;
+            surfaces[i] = { vertex.texcoord, vertex.normal };
+            header.boundsMin = 0 == i ? vertex.position : glm::min(header.boundsMin, vertex.position);
+            header.boundsMax = 0 == i ? vertex.position : glm::max(header.boundsMax, vertex.position);
+        }
+
+        auto center = (header.boundsMin + header.boundsMax) * 0.5F;
+        auto radius = 0.0F;
+
+        for (const auto& position : positions) {
+            radius = std::max(radius, glm::length(position - center));
+        }
+
+        auto streams = std::vector<MeshFileStream> ({
+            { 0, positions.size() * sizeof(glm::vec3), sizeof(glm::vec3), 0 },
+            { 0, surfaces.size() * sizeof(SurfaceT), sizeof(SurfaceT), 0 }
+        });
+
+        // Locations 0, 1 and 2 are position, texcoord and normal, as in every shader here.
+        auto attributes = std::vector<MeshFileAttribute> ({
+            { 0, POSITION_STREAM, 3, GL_FLOAT, GL_FALSE, 0 },
+            { 1, SURFACE_STREAM, 2, GL_FLOAT, GL_FALSE, offsetof(SurfaceT, texcoord) },
+            { 2, SURFACE_STREAM, 3, GL_FLOAT, GL_FALSE, offsetof(SurfaceT, normal) }
+        });
+
+        auto offset = align(sizeof(MeshFileHeader) + streams.size() * sizeof(MeshFileStream)
+            + attributes.size() * sizeof(MeshFileAttribute) + fileLods.size() * sizeof(MeshFileLod));
+
+        for (auto& stream : streams) {
+            stream.offset = offset;
+            offset = align(offset + stream.size);
+        }
+
+        header.magic = MESH_FILE_MAGIC;
+        header.version = MESH_FILE_VERSION;
+        header.flags = (mesh.hasTexcoords ? MESH_FILE_TEXCOORDS : 0) | (mesh.hasNormals ? MESH_FILE_NORMALS : 0);
+        header.streamCount = static_cast<std::uint32_t> (streams.size());
+        header.attributeCount = static_cast<std::uint32_t> (attributes.size());
+        header.lodCount = static_cast<std::uint32_t> (fileLods.size());
+        header.vertexCount = vertexCount;
+        header.indexCount = static_cast<std::uint32_t> (mesh.indices.size());
+        header.indexType = mesh.getIndexType();
+        header.indexOffset = offset;
+        header.indexSize = indices.size();
+        header.fileSize = offset + indices.size();
+        header.boundingSphere = glm::vec4(center, radius);
+
+        auto file = std::ofstream(path.c_str(), std::ios::binary | std::ios::trunc);
+
+        if (!file) {
+            auto msg = std::stringstream();
+            msg << "Failed to create file: \"" << path << "\"";
+
+            throw std::runtime_error(msg.str());
+        }
+
+        auto padding = std::vector<char> (BLOCK_ALIGNMENT, 0);
+        auto written = std::uint64_t(0);
+        auto writeBlock = [&] (std::uint64_t blockOffset, const void * pData, std::size_t size) {
+            file.write(padding.data(), blockOffset - written);
+            file.write(static_cast<const char *> (pData), size);
+            written = blockOffset + size;
+        };
+
+        writeBlock(0, &header, sizeof(header));
+        writeBlock(written, streams.data(), streams.size() * sizeof(MeshFileStream));
+        writeBlock(written, attributes.data(), attributes.size() * sizeof(MeshFileAttribute));
+        writeBlock(written, fileLods.data(), fileLods.size() * sizeof(MeshFileLod));
+        writeBlock(streams[POSITION_STREAM].offset, positions.data(), streams[POSITION_STREAM].size);
+        writeBlock(streams[SURFACE_STREAM].offset, surfaces.data(), streams[SURFACE_STREAM].size);
+        writeBlock(header.indexOffset, indices.data(), indices.size());
+
+        if (!file.flush()) {
+            auto msg = std::stringstream();
+            msg << "Failed to write file: \"" << path << "\"";
+
+            throw std::runtime_error(msg.str());
+        }
+    }
+
+    MeshFile::MeshFile(const std::string& path) {
+        auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd < 0) {
+            auto msg = std::stringstream();
+            msg << "Failed to open file \"" << path << "\": " << std::strerror(errno);
+
+            throw std::runtime_error(msg.str());
+        }
+
+        struct stat info;
+        auto pMapping = MAP_FAILED;
+
+        if (0 == fstat(fd, &info) && static_cast<std::size_t> (info.st_size) >= sizeof(MeshFileHeader)) {
+            pMapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+
+        // The mapping keeps its own reference to the file.
+        close(fd);
+
+        if (MAP_FAILED == pMapping) {
+            throwInvalid(path, "too small, or could not be mapped");
+        }
+
+        _pData = static_cast<const std::uint8_t *> (pMapping);
+        _size = info.st_size;
+
+        // Everything is read once by the GL upload, so start reading ahead right away.
+        madvise(pMapping, _size, MADV_WILLNEED);
+
+        try {
+            const auto& header = getHeader();
+
+            if (MESH_FILE_MAGIC != header.magic || MESH_FILE_VERSION != header.version) {
+                throwInvalid(path, "not a mesh file, or an unsupported version");
+            }
+
+            auto tablesSize = sizeof(MeshFileHeader) + static_cast<std::uint64_t> (header.streamCount) * sizeof(MeshFileStream)
+                + static_cast<std::uint64_t> (header.attributeCount) * sizeof(MeshFileAttribute)
+                + static_cast<std::uint64_t> (header.lodCount) * sizeof(MeshFileLod);
+            auto indexSize = static_cast<std::uint64_t> (header.indexCount) * (GL_UNSIGNED_SHORT == header.indexType ? 2 : 4);
+
+            if (header.fileSize != _size || tablesSize > _size) {
+                throwInvalid(path, "truncated");
+            }
+
+            if ((GL_UNSIGNED_SHORT != header.indexType && GL_UNSIGNED_INT != header.indexType) || indexSize != header.indexSize
+                    || !isInside(header.indexOffset, header.indexSize, _size) || 0 == header.indexCount || 0 == header.lodCount) {
+                throwInvalid(path, "bad index data");
+            }
+
+            // Every buffer must have data: glNamedBufferStorage rejects an empty one.
+            if (0 == header.vertexCount || 0 == header.streamCount) {
+                throwInvalid(path, "no vertex data");
+            }
+
+            for (std::uint32_t i = 0; i < header.streamCount; i++) {
+                const auto& stream = getStream(i);
+
+                if (!isInside(stream.offset, stream.size, _size) || 0 == stream.stride
+                        || static_cast<std::uint64_t> (header.vertexCount) * stream.stride != stream.size) {
+                    throwInvalid(path, "bad vertex stream");
+                }
+            }
+
+            for (std::uint32_t i = 0; i < header.attributeCount; i++) {
+                const auto& attribute = getAttribute(i);
+                auto attributeSize = getAttributeSize(attribute);
+
+                if (attribute.stream >= header.streamCount || 0 == attribute.components || 4 < attribute.components || 0 == attributeSize
+                        || attribute.offset + attributeSize > getStream(attribute.stream).stride) {
+                    throwInvalid(path, "bad vertex attribute");
+                }
+            }
+
+            for (std::uint32_t i = 0; i < header.lodCount; i++) {
+                const auto& lod = getLod(i);
+
+                if (!isInside(lod.firstIndex, lod.indexCount, header.indexCount)) {
+                    throwInvalid(path, "LOD outside the index data");
+                }
+            }
+        } catch (...) {
+            munmap(pMapping, _size);
+            throw;
+        }
+    }
+
+    MeshFile::~MeshFile() noexcept {
+        munmap(const_cast<std::uint8_t *> (_pData), _size);
+    }
+
+    const MeshFileHeader& MeshFile::getHeader() const noexcept {
+        return *reinterpret_cast<const MeshFileHeader *> (_pData);
+    }
+
+    const MeshFileStream& MeshFile::getStream(std::uint32_t index) const noexcept {
+        auto pStreams = reinterpret_cast<const MeshFileStream *> (_pData + sizeof(MeshFileHeader));
+
+        return pStreams[index];
+    }
+
+    const MeshFileAttribute& MeshFile::getAttribute(std::uint32_t index) const noexcept {
+        auto pAttributes = reinterpret_cast<const MeshFileAttribute *> (&getStream(getHeader().streamCount));
+
+        return pAttributes[index];
+    }
+
+    const MeshFileLod& MeshFile::getLod(std::uint32_t index) const noexcept {
+        auto pLods = reinterpret_cast<const MeshFileLod *> (&getAttribute(getHeader().attributeCount));
+
+        return pLods[index];
+    }
+
+    const void * MeshFile::getStreamData(std::uint32_t index) const noexcept {
+        return _pData + getStream(index).offset;
+    }
+
+    const void * MeshFile::getIndexData() const noexcept {
+        return _pData + getHeader().indexOffset;
+    }
+
+    MeshBuffers::MeshBuffers(const MeshFile& file) {
+        const auto& header = file.getHeader();
+
+        _indexType = header.indexType;
+        _vertexBuffers.resize(header.streamCount);
+
+        for (std::uint32_t i = 0; i < header.lodCount; i++) {
+            _lods.push_back(file.getLod(i));
+        }
+
+        glCreateBuffers(header.streamCount, _vertexBuffers.data());
+
+        for (std::uint32_t i = 0; i < header.streamCount; i++) {
+            glNamedBufferStorage(_vertexBuffers[i], file.getStream(i).size, file.getStreamData(i), 0);
+        }
+
+        glCreateBuffers(1, &_indexBuffer);
+        glNamedBufferStorage(_indexBuffer, header.indexSize, file.getIndexData(), 0);
+
+        glCreateVertexArrays(1, &_vertexArray);
+
+        for (std::uint32_t i = 0; i < header.attributeCount; i++) {
+            const auto& attribute = file.getAttribute(i);
+
+            glEnableVertexArrayAttrib(_vertexArray, attribute.location);
+            glVertexArrayAttribFormat(_vertexArray, attribute.location, attribute.components, attribute.type, attribute.normalized, attribute.offset);
+            glVertexArrayAttribBinding(_vertexArray, attribute.location, attribute.stream);
+        }
+
+        for (std::uint32_t i = 0; i < header.streamCount; i++) {
+            glVertexArrayVertexBuffer(_vertexArray, i, _vertexBuffers[i], 0, file.getStream(i).stride);
+        }
+
+        glVertexArrayElementBuffer(_vertexArray, _indexBuffer);
+    }
+
+    MeshBuffers::~MeshBuffers() noexcept {
+        glDeleteVertexArrays(1, &_vertexArray);
+        glDeleteBuffers(1, &_indexBuffer);
+        glDeleteBuffers(static_cast<GLsizei> (_vertexBuffers.size()), _vertexBuffers.data());
+    }
+
+    GLuint MeshBuffers::getVertexArray() const noexcept {
+        return _vertexArray;
+    }
+
+    GLuint MeshBuffers::getVertexBuffer(std::uint32_t stream) const noexcept {
+        return _vertexBuffers[stream];
+    }
+
+    GLuint MeshBuffers::getIndexBuffer() const noexcept {
+        return _indexBuffer;
+    }
+
+    GLenum MeshBuffers::getIndexType() const noexcept {
+        return _indexType;
+    }
+
+    std::uint32_t MeshBuffers::getLodCount() const noexcept {
+        return static_cast<std::uint32_t> (_lods.size());
+    }
+
+    const MeshFileLod& MeshBuffers::getLod(std::uint32_t lod) const noexcept {
+        return _lods[lod];
+    }
+
+    void MeshBuffers::draw(std::uint32_t lod, GLsizei instanceCount) const noexcept {
+        const auto& range = _lods[lod];
+        auto indexSize = GL_UNSIGNED_SHORT == _indexType ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+
+        glDrawElementsInstanced(GL_TRIANGLES, range.indexCount, _indexType, reinterpret_cast<const void *> (range.firstIndex * indexSize), instanceCount);
+    }
+}
@@ -0,0 +1,1022 @@
+#include "mesh_importer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+namespace {
+    constexpr std::size_t MIN_CHUNK_SIZE = 256 * 1024;
+    constexpr std::size_t CORNERS_PER_TASK = 64 * 1024;
+    constexpr unsigned int BUCKET_BITS = 8;
+    constexpr unsigned int BUCKET_COUNT = 1U << BUCKET_BITS;
+    constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+    constexpr std::uint64_t MANTISSA_LIMIT = 100000000000000000ULL;
+    constexpr int MAX_JSON_DEPTH = 64;
+
+    constexpr std::uint32_t GLB_MAGIC = 0x46546C67;
+    constexpr std::uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+    constexpr std::uint32_t GLB_CHUNK_BIN = 0x004E4942;
+    constexpr int GLTF_UNSIGNED_BYTE = 5121;
+    constexpr int GLTF_UNSIGNED_SHORT = 5123;
+    constexpr int GLTF_UNSIGNED_INT = 5125;
+    constexpr int GLTF_FLOAT = 5126;
+    constexpr int GLTF_TRIANGLES = 4;
+
+    constexpr double POWERS_OF_TEN[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    constexpr const char JSON_TRUE[] = "true";
+    constexpr const char JSON_FALSE[] = "false";
+    constexpr const char JSON_NULL[] = "null";
+    constexpr const char * JSON_LITERALS[] = { JSON_TRUE, JSON_FALSE, JSON_NULL };
+
+    std::vector<char> readFile(const std::string& path) {
+        auto file = std::ifstream(path.c_str(), std::ios::binary | std::ios::ate);
+
+        if (!file) {
+            auto msg = std::stringstream();
+            msg << "Failed to load file: \"" << path << "\"";
+
+            throw std::runtime_error(msg.str());
+        }
+
+        auto data = std::vector<char> (static_cast<std::size_t> (file.tellg()));
+
+        file.seekg(0);
+        file.read(data.data(), data.size());
+
+        return data;
+    }
+
+    void parallelFor(gfx::ThreadPool * pThreadPool, std::size_t count, const std::function<void (unsigned int)>& task) {
+        if (nullptr != pThreadPool) {
+            pThreadPool->run(static_cast<unsigned int> (count), task);
+            return;
+        }
+
+        for (std::size_t i = 0; i < count; i++) {
+            task(static_cast<unsigned int> (i));
+        }
+    }
+
+    // ThreadPool tasks must not throw, so each one keeps its first error here for the caller to rethrow.
+    void rethrow(const std::vector<std::string>& errors) {
+        for (const auto& error : errors) {
+            if (!error.empty()) {
+                throw std::runtime_error(error);
+            }
+        }
+    }
+
+    // --- Wavefront OBJ -------------------------------------------------------------------------------
+
+    // Resolved, 0-based attribute indices; NONE when the face omits the attribute.
+    struct Corner {
+        std::uint32_t position;
+        std::uint32_t texcoord;
+        std::uint32_t normal;
+    };
+
+    struct ObjChunk {
+        const char * pBegin;
+        const char * pEnd;
+        std::uint32_t positionCount;
+        std::uint32_t texcoordCount;
+        std::uint32_t normalCount;
+        std::uint32_t positionBase;
+        std::uint32_t texcoordBase;
+        std::uint32_t normalBase;
+        std::vector<Corner> corners;
+    };
+
+    enum class ObjRecord {
+        OTHER,
+        POSITION,
+        TEXCOORD,
+        NORMAL,
+        FACE
+    };
+
+    bool isBlank(char c) noexcept {
+        return ' ' == c || '\t' == c || '\r' == c;
+    }
+
+    bool isDigit(char c) noexcept {
+        return '0' <= c && c <= '9';
+    }
+
+    const char * skipBlanks(const char * p, const char * pEnd) noexcept {
+        while (p < pEnd && isBlank(*p)) {
+            p++;
+        }
+
+        return p;
+    }
+
+    const char * findLineEnd(const char * p, const char * pEnd) noexcept {
+        auto pNewline = static_cast<const char *> (std::memchr(p, '\n', pEnd - p));
+
+        return nullptr == pNewline ? pEnd : pNewline;
+    }
+
+    // Classifies the line and moves p past its keyword.
+    ObjRecord getRecord(const char *& p, const char * pLineEnd) noexcept {
+        p = skipBlanks(p, pLineEnd);
+
+        if (pLineEnd - p >= 2 && isBlank(p[1])) {
+            if ('v' == p[0]) {
+                p += 2;
+                return ObjRecord::POSITION;
+            }
+
+            if ('f' == p[0]) {
+                p += 2;
+                return ObjRecord::FACE;
+            }
+        }
+
+        if (pLineEnd - p >= 3 && 'v' == p[0] && isBlank(p[2])) {
+            if ('t' == p[1]) {
+                p += 3;
+                return ObjRecord::TEXCOORD;
+            }
+
+            if ('n' == p[1]) {
+                p += 3;
+                return ObjRecord::NORMAL;
+            }
+        }
+
+        return ObjRecord::OTHER;
+    }
+
+    [[noreturn]] void throwObjError(const char * pMessage, const char * pLine, const char * pLineEnd) {
+        auto msg = std::stringstream();
+        msg << pMessage << ": \"" << std::string(pLine, std::min(pLineEnd, pLine + 80)) << "\"";
+
+        throw std::runtime_error(msg.str());
+    }
+
+    // Decimal with optional sign, fraction and exponent. Not correctly rounded: the result can be an ulp or two
+    // off the nearest double, which is far below what a float attribute keeps.
+    // Bounded by pEnd and independent of the C locale, unlike strtod.
+    bool parseDouble(const char *& p, const char * pEnd, double& value) noexcept {
+        p = skipBlanks(p, pEnd);
+
+        auto negative = p < pEnd && '-' == *p;
+
+        if (p < pEnd && ('-' == *p || '+' == *p)) {
+            p++;
+        }
+
+        auto mantissa = std::uint64_t(0);
+        auto exponent = 0;
+        auto digits = 0;
+
+        for (; p < pEnd && isDigit(*p); p++, digits++) {
+            if (mantissa < MANTISSA_LIMIT) {
+                mantissa = mantissa * 10 + (*p - '0');
+            } else {
+                exponent++;
+            }
+        }
+
+        if (p < pEnd && '.' == *p) {
+            for (p++; p < pEnd && isDigit(*p); p++, digits++) {
+                if (mantissa < MANTISSA_LIMIT) {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    exponent--;
+                }
+            }
+        }
+
+        if (0 == digits) {
+            return false;
+        }
+
+        if (p < pEnd && ('e' == *p || 'E' == *p)) {
+            p++;
+
+            auto negativeExponent = p < pEnd && '-' == *p;
+
+            if (p < pEnd && ('-' == *p || '+' == *p)) {
+                p++;
+            }
+
+            if (p >= pEnd || !isDigit(*p)) {
+                return false;
+            }
+
+            auto e = 0;
+
+            for (; p < pEnd && isDigit(*p); p++) {
+                e = std::min(e * 10 + (*p - '0'), 1000);
+            }
+
+            exponent += negativeExponent ? -e : e;
+        }
+
+        auto scale = std::abs(exponent) <= 22 ? POWERS_OF_TEN[std::abs(exponent)] : std::pow(10.0, std::abs(exponent));
+        auto result = exponent < 0 ? mantissa / scale : mantissa * scale;
+
+        value = negative ? -result : result;
+
+        return true;
+    }
+
+    bool parseFloat(const char *& p, const char * pEnd, float& value) noexcept {
+        auto result = 0.0;
+
+        if (!parseDouble(p, pEnd, result)) {
+            return false;
+        }
+
+        value = static_cast<float> (result);
+
+        return true;
+    }
+
+    // 1-based, or negative relative to the count defined so far; the result is 0-based.
+    bool parseIndex(const char *& p, const char * pEnd, std::uint32_t count, std::uint32_t& index) noexcept {
+        auto negative = p < pEnd && '-' == *p;
+
+        if (negative) {
+            p++;
+        }
+
+        if (p >= pEnd || !isDigit(*p)) {
+            return false;
+        }
+
+        auto value = std::int64_t(0);
+
+        for (; p < pEnd && isDigit(*p); p++) {
+            value = std::min<std::int64_t> (value * 10 + (*p - '0'), NONE);
+        }
+
+        auto resolved = negative ? static_cast<std::int64_t> (count) - value : value - 1;
+
+        if (resolved < 0 || resolved >= NONE) {
+            return false;
+        }
+
+        index = static_cast<std::uint32_t> (resolved);
+
+        return true;
+    }
+
+    void countObjChunk(ObjChunk& chunk) noexcept {
+        for (auto p = chunk.pBegin; p < chunk.pEnd;) {
+            auto pLineEnd = findLineEnd(p, chunk.pEnd);
+
+            switch (getRecord(p, pLineEnd)) {
+                case ObjRecord::POSITION:
+                    chunk.positionCount++;
+                    break;
+
+                case ObjRecord::TEXCOORD:
+                    chunk.texcoordCount++;
+                    break;
+
+                case ObjRecord::NORMAL:
+                    chunk.normalCount++;
+                    break;
+
+                default:
+                    break;
+            }
+
+            p = pLineEnd + 1;
+        }
+    }
+
+    void parseObjChunk(ObjChunk& chunk, std::vector<glm::vec3>& positions, std::vector<glm::vec2>& texcoords, std::vector<glm::vec3>& normals) {
+        auto position = chunk.positionBase;
+        auto texcoord = chunk.texcoordBase;
+        auto normal = chunk.normalBase;
+        auto polygon = std::vector<Corner> ();
+
+        for (auto pLine = chunk.pBegin; pLine < chunk.pEnd;) {
+            auto pLineEnd = findLineEnd(pLine, chunk.pEnd);
+            auto p = pLine;
+            auto record = getRecord(p, pLineEnd);
+
+            if (ObjRecord::POSITION == record) {
+                auto& v = positions[position++];
+
+                if (!parseFloat(p, pLineEnd, v.x) || !parseFloat(p, pLineEnd, v.y) || !parseFloat(p, pLineEnd, v.z)) {
+                    throwObjError("Malformed OBJ position", pLine, pLineEnd);
+                }
+            } else if (ObjRecord::TEXCOORD == record) {
+                auto& v = texcoords[texcoord++];
+
+                if (!parseFloat(p, pLineEnd, v.x)) {
+                    throwObjError("Malformed OBJ texcoord", pLine, pLineEnd);
+                }
+
+                // The v coordinate is optional.
+                v.y = 0.0F;
+                parseFloat(p, pLineEnd, v.y);
+            } else if (ObjRecord::NORMAL == record) {
+                auto& v = normals[normal++];
+
+                if (!parseFloat(p, pLineEnd, v.x) || !parseFloat(p, pLineEnd, v.y) || !parseFloat(p, pLineEnd, v.z)) {
+                    throwObjError("Malformed OBJ normal", pLine, pLineEnd);
+                }
+            } else if (ObjRecord::FACE == record) {
+                polygon.clear();
+
+                for (p = skipBlanks(p, pLineEnd); p < pLineEnd; p = skipBlanks(p, pLineEnd)) {
+                    auto corner = Corner { NONE, NONE, NONE };
+                    auto valid = parseIndex(p, pLineEnd, position, corner.position);
+
+                    if (valid && p < pLineEnd && '/' == *p) {
+                        p++;
+
+                        if (p < pLineEnd && '/' != *p) {
+                            valid = parseIndex(p, pLineEnd, texcoord, corner.texcoord);
+                        }
+
+                        if (valid && p < pLineEnd && '/' == *p) {
+                            p++;
+                            valid = parseIndex(p, pLineEnd, normal, corner.normal);
+                        }
+                    }
+
+                    if (!valid || (p < pLineEnd && !isBlank(*p))) {
+                        throwObjError("Malformed OBJ face", pLine, pLineEnd);
+                    }
+
+                    polygon.push_back(corner);
+                }
+
+                if (polygon.size() < 3) {
+                    throwObjError("OBJ face with fewer than three corners", pLine, pLineEnd);
+                }
+
+                for (std::size_t k = 2; k < polygon.size(); k++) {
+                    chunk.corners.push_back(polygon[0]);
+                    chunk.corners.push_back(polygon[k - 1]);
+                    chunk.corners.push_back(polygon[k]);
+                }
+            }
+
+            pLine = pLineEnd + 1;
+        }
+    }
+
+    std::uint32_t hashCorner(const Corner& corner) noexcept {
+        auto h = corner.position * 0x9E3779B1U;
+
+        h ^= corner.texcoord * 0x85EBCA77U + (h << 6) + (h >> 2);
+        h ^= corner.normal * 0xC2B2AE3DU + (h << 6) + (h >> 2);
+        h ^= h >> 16;
+        h *= 0x7FEB352DU;
+        h ^= h >> 15;
+
+        return h;
+    }
+
+    // Buckets carry a copy of the corner so merging them reads sequentially instead of gathering from the corner list.
+    struct BucketEntry {
+        Corner corner;
+        std::uint32_t index;
+    };
+
+    bool operator== (const Corner& a, const Corner& b) noexcept {
+        return a.position == b.position && a.texcoord == b.texcoord && a.normal == b.normal;
+    }
+
+    // Corners are spread over BUCKET_COUNT buckets by hash, so each bucket can be merged by one thread with
+    // its own open-addressing table. Visiting corners in ascending order makes the first use the representative,
+    // and numbering representatives in corner order keeps the vertices in first-use order.
+    gfx::Mesh mergeCorners(const std::vector<Corner>& corners, const std::vector<glm::vec3>& positions,
+            const std::vector<glm::vec2>& texcoords, const std::vector<glm::vec3>& normals, gfx::ThreadPool * pThreadPool) {
+        auto taskCount = (corners.size() + CORNERS_PER_TASK - 1) / CORNERS_PER_TASK;
+        auto buckets = std::vector<std::vector<BucketEntry>> (taskCount * BUCKET_COUNT);
+        auto errors = std::vector<std::string> (taskCount);
+        auto hasTexcoords = std::vector<std::uint8_t> (taskCount, 0);
+        auto hasNormals = std::vector<std::uint8_t> (taskCount, 1);
+
+        parallelFor(pThreadPool, taskCount, [&] (unsigned int task) {
+            auto begin = task * CORNERS_PER_TASK;
+            auto end = std::min(begin + CORNERS_PER_TASK, corners.size());
+
+            try {
+                for (auto c = begin; c < end; c++) {
+                    const auto& corner = corners[c];
+
+                    if (corner.position >= positions.size() || (NONE != corner.texcoord && corner.texcoord >= texcoords.size())
+                            || (NONE != corner.normal && corner.normal >= normals.size())) {
+                        errors[task] = "OBJ face refers to an undefined vertex attribute";
+                        return;
+                    }
+
+                    hasTexcoords[task] |= NONE != corner.texcoord ? 1 : 0;
+                    hasNormals[task] &= NONE != corner.normal ? 1 : 0;
+                    buckets[task * BUCKET_COUNT + (hashCorner(corner) >> (32 - BUCKET_BITS))].push_back({ corner, static_cast<std::uint32_t> (c) });
+                }
+            } catch (const std::exception& e) {
+                errors[task] = e.what();
+            }
+        });
+
+        rethrow(errors);
+
+        struct Slot {
+            Corner key;
+            std::uint32_t first;
+        };
+
+        auto firstUses = std::vector<std::uint32_t> (corners.size());
+
+        parallelFor(pThreadPool, BUCKET_COUNT, [&] (unsigned int bucket) {
+            auto size = std::size_t(0);
+
+            for (std::size_t task = 0; task < taskCount; task++) {
+                size += buckets[task * BUCKET_COUNT + bucket].size();
+            }
+
+            auto capacity = std::size_t(16);
+
+            while (capacity < size * 2) {
+                capacity *= 2;
+            }
+
+            auto slots = std::vector<Slot> (capacity, Slot { Corner { NONE, NONE, NONE }, NONE });
+            auto mask = capacity - 1;
+
+            for (std::size_t task = 0; task < taskCount; task++) {
+                for (const auto& entry : buckets[task * BUCKET_COUNT + bucket]) {
+                    const auto& corner = entry.corner;
+                    auto c = entry.index;
+
+                    for (auto s = hashCorner(corner) & mask;; s = (s + 1) & mask) {
+                        if (NONE == slots[s].first) {
+                            slots[s] = { corner, c };
+                            firstUses[c] = c;
+                            break;
+                        }
+
+                        if (slots[s].key == corner) {
+                            firstUses[c] = slots[s].first;
+                            break;
+                        }
+                    }
+                }
+            }
+        });
+
+        auto vertexIds = std::vector<std::uint32_t> (corners.size());
+        auto vertexCount = std::uint32_t(0);
+
+        for (std::uint32_t c = 0; c < corners.size(); c++) {
+            vertexIds[c] = firstUses[c] == c ? vertexCount++ : NONE;
+        }
+
+        auto mesh = gfx::Mesh {};
+        mesh.vertices.resize(vertexCount);
+        mesh.indices.resize(corners.size());
+        mesh.hasTexcoords = std::any_of(hasTexcoords.begin(), hasTexcoords.end(), [] (std::uint8_t value) { return 0 != value; });
+        mesh.hasNormals = !corners.empty() && std::all_of(hasNormals.begin(), hasNormals.end(), [] (std::uint8_t value) { return 0 != value; });
+
+        parallelFor(pThreadPool, taskCount, [&] (unsigned int task) {
+            auto begin = task * CORNERS_PER_TASK;
+            auto end = std::min(begin + CORNERS_PER_TASK, corners.size());
+
+            for (auto c = begin; c < end; c++) {
+                const auto& corner = corners[c];
+                auto vertex = vertexIds[firstUses[c]];
+
+                mesh.indices[c] = vertex;
+
+                if (firstUses[c] == c) {
+                    mesh.vertices[vertex] = {
+                        positions[corner.position],
+                        NONE == corner.texcoord ? glm::vec2(0.0F) : texcoords[corner.texcoord],
+                        NONE == corner.normal ? glm::vec3(0.0F) : normals[corner.normal]
+                    };
+                }
+            }
+        });
+
+        return mesh;
+    }
+
+    // --- glTF 2.0 binary ------------------------------------------------------------------------------
+
+    // Just enough JSON for the glTF document: no validation beyond what reading it needs.
+    struct Json {
+        enum class Type {
+            NONE,
+            BOOLEAN,
+            NUMBER,
+            STRING,
+            ARRAY,
+            OBJECT
+        };
+
+        Type type = Type::NONE;
+        double number = 0.0;
+        std::string string;
+        std::vector<Json> elements;
+        std::vector<std::pair<std::string, Json>> members;
+
+        const Json * find(const char * pKey) const noexcept {
+            for (const auto& member : members) {
+                if (member.first == pKey) {
+                    return &member.second;
+                }
+            }
+
+            return nullptr;
+        }
+
+        int getInt(const char * pKey, int fallback) const {
+            auto pValue = find(pKey);
+
+            if (nullptr == pValue || Type::NUMBER != pValue->type) {
+                return fallback;
+            }
+
+            if (!(pValue->number >= std::numeric_limits<int>::min() && pValue->number <= std::numeric_limits<int>::max())
+                    || std::floor(pValue->number) != pValue->number) {
+                throw std::runtime_error(std::string("glTF ") + pKey + " is not an integer in range");
+            }
+
+            return static_cast<int> (pValue->number);
+        }
+    };
+
+    class JsonParser {
+        const char * _p;
+        const char * _pEnd;
+
+        [[noreturn]] void fail(const char * pMessage) const {
+            throw std::runtime_error(std::string("Malformed glTF JSON: ") + pMessage);
+        }
+
+        void skipSpace() noexcept {
+            while (_p < _pEnd && (' ' == *_p || '\t' == *_p || '\n' == *_p || '\r' == *_p)) {
+                _p++;
+            }
+        }
+
+        void expect(char c) {
+            skipSpace();
+
+            if (_p >= _pEnd || c != *_p) {
+                fail("unexpected character");
+            }
+
+            _p++;
+        }
+
+        bool consume(const char * pLiteral) noexcept {
+            auto length = std::strlen(pLiteral);
+
+            if (static_cast<std::size_t> (_pEnd - _p) < length || 0 != std::strncmp(_p, pLiteral, length)) {
+                return false;
+            }
+
+            _p += length;
+
+            return true;
+        }
+
+        // The literal consumed at the cursor, or nullptr when there is none.
+        const char * parseLiteral() noexcept {
+            for (auto pLiteral : JSON_LITERALS) {
+                if (consume(pLiteral)) {
+                    return pLiteral;
+                }
+            }
+
+            return nullptr;
+        }
+
+        std::string parseString() {
+            expect('"');
+
+            auto value = std::string();
+
+            while (_p < _pEnd && '"' != *_p) {
+                if ('\\' != *_p) {
+                    value += *_p++;
+                    continue;
+                }
+
+                if (++_p >= _pEnd) {
+                    break;
+                }
+
+                switch (*_p++) {
+                    case 'n': value += '\n'; break;
+                    case 't': value += '\t'; break;
+                    case 'r': value += '\r'; break;
+                    case 'b': value += '\b'; break;
+                    case 'f': value += '\f'; break;
+
+                    // Only names and URIs are strings in glTF; non-ASCII code points are not needed to read geometry.
+                    case 'u':
+                        _p = std::min(_p + 4, _pEnd);
+                        value += '?';
+                        break;
+
+                    default: value += _p[-1]; break;
+                }
+            }
+
+            expect('"');
+
+            return value;
+        }
+
+    public:
+        JsonParser(const char * pBegin, const char * pEnd) : _p(pBegin), _pEnd(pEnd) {
+        }
+
+        Json parse(int depth = 0) {
+            auto value = Json {};
+
+            skipSpace();
+
+            if (_p >= _pEnd) {
+                fail("unexpected end");
+            }
+
+            if (MAX_JSON_DEPTH < depth) {
+                fail("nested too deeply");
+            }
+
+            if ('{' == *_p) {
+                value.type = Json::Type::OBJECT;
+                _p++;
+                skipSpace();
+
+                if (_p < _pEnd && '}' == *_p) {
+                    _p++;
+                    return value;
+                }
+
+                do {
+                    auto key = parseString();
+                    expect(':');
+                    value.members.emplace_back(std::move(key), parse(depth + 1));
+                    skipSpace();
+                } while (_p < _pEnd && ',' == *_p && ++_p);
+
+                expect('}');
+            } else if ('[' == *_p) {
+                value.type = Json::Type::ARRAY;
+                _p++;
+                skipSpace();
+
+                if (_p < _pEnd && ']' == *_p) {
+                    _p++;
+                    return value;
+                }
+
+                do {
+                    value.elements.push_back(parse(depth + 1));
+                    skipSpace();
+                } while (_p < _pEnd && ',' == *_p && ++_p);
+
+                expect(']');
+            } else if ('"' == *_p) {
+                value.type = Json::Type::STRING;
+                value.string = parseString();
+            } else {
+                auto pLiteral = parseLiteral();
+
+                if (JSON_TRUE == pLiteral || JSON_FALSE == pLiteral) {
+                    value.type = Json::Type::BOOLEAN;
+                    value.number = JSON_TRUE == pLiteral ? 1.0 : 0.0;
+                } else if (JSON_NULL == pLiteral) {
+                    value.type = Json::Type::NONE;
+                } else {
+                    value.type = Json::Type::NUMBER;
+
+                    if (!parseDouble(_p, _pEnd, value.number)) {
+                        fail("unexpected token");
+                    }
+                }
+            }
+
+            return value;
+        }
+    };
+
+    const Json& getElement(const Json& document, const char * pArray, int index) {
+        auto pElements = document.find(pArray);
+
+        if (nullptr == pElements || index < 0 || static_cast<std::size_t> (index) >= pElements->elements.size()) {
+            auto msg = std::stringstream();
+            msg << "glTF refers to missing " << pArray << " " << index;
+
+            throw std::runtime_error(msg.str());
+        }
+
+        return pElements->elements[index];
+    }
+
+    int getComponentCount(const std::string& type) noexcept {
+        return "SCALAR" == type ? 1 : ("VEC2" == type ? 2 : ("VEC3" == type ? 3 : ("VEC4" == type ? 4 : 0)));
+    }
+
+    int getComponentSize(int componentType) noexcept {
+        return GLTF_UNSIGNED_BYTE == componentType ? 1 : (GLTF_UNSIGNED_SHORT == componentType ? 2 : 4);
+    }
+
+    struct AccessorView {
+        const std::uint8_t * pData;
+        std::size_t count;
+        std::size_t stride;
+        int componentType;
+    };
+
+    AccessorView getAccessor(const Json& document, int index, int components, const std::uint8_t * pBin, std::size_t binSize) {
+        const auto& accessor = getElement(document, "accessors", index);
+        auto pType = accessor.find("type");
+        auto componentType = accessor.getInt("componentType", 0);
+        auto count = accessor.getInt("count", 0);
+
+        if (nullptr != accessor.find("sparse") || nullptr == pType || components != getComponentCount(pType->string)) {
+            throw std::runtime_error("Unsupported glTF accessor: sparse, or of an unexpected type");
+        }
+
+        if (1 != components && GLTF_FLOAT != componentType) {
+            throw std::runtime_error("Unsupported glTF accessor: vertex attributes must be float");
+        }
+
+        const auto& view = getElement(document, "bufferViews", accessor.getInt("bufferView", -1));
+        auto viewOffset = view.getInt("byteOffset", 0);
+        auto accessorOffset = accessor.getInt("byteOffset", 0);
+        auto byteStride = view.getInt("byteStride", 0);
+
+        if (0 > count || 0 > viewOffset || 0 > accessorOffset || 0 > byteStride) {
+            throw std::runtime_error("glTF accessor has a negative count, offset or stride");
+        }
+
+        auto elementSize = static_cast<std::size_t> (components * getComponentSize(componentType));
+        auto offset = static_cast<std::size_t> (viewOffset) + static_cast<std::size_t> (accessorOffset);
+        auto stride = 0 == byteStride ? elementSize : static_cast<std::size_t> (byteStride);
+        auto last = static_cast<std::size_t> (count) - 1;
+
+        // Compared by division so stride * (count - 1) can't wrap around.
+        if (0 != view.getInt("buffer", 0) || (0 < count && (offset > binSize || elementSize > binSize - offset
+                || (0 < last && stride > (binSize - offset - elementSize) / last)))) {
+            throw std::runtime_error("glTF accessor reads outside the binary chunk");
+        }
+
+        return { pBin + offset, static_cast<std::size_t> (count), stride, componentType };
+    }
+
+    std::uint32_t readIndex(const AccessorView& view, std::size_t i) noexcept {
+        auto pElement = view.pData + i * view.stride;
+
+        if (GLTF_UNSIGNED_BYTE == view.componentType) {
+            return *pElement;
+        }
+
+        if (GLTF_UNSIGNED_SHORT == view.componentType) {
+            std::uint16_t value;
+            std::memcpy(&value, pElement, sizeof(value));
+            return value;
+        }
+
+        std::uint32_t value;
+        std::memcpy(&value, pElement, sizeof(value));
+        return value;
+    }
+
+    void appendPrimitive(gfx::Mesh& mesh, const Json& document, const Json& primitive, const std::uint8_t * pBin, std::size_t binSize) {
+        auto pAttributes = primitive.find("attributes");
+
+        if (GLTF_TRIANGLES != primitive.getInt("mode", GLTF_TRIANGLES) || nullptr == pAttributes || nullptr == pAttributes->find("POSITION")) {
+            throw std::runtime_error("Unsupported glTF primitive: not a triangle list with positions");
+        }
+
+        auto positions = getAccessor(document, pAttributes->getInt("POSITION", -1), 3, pBin, binSize);
+        auto base = mesh.vertices.size();
+        auto hasNormals = nullptr != pAttributes->find("NORMAL");
+        auto hasTexcoords = nullptr != pAttributes->find("TEXCOORD_0");
+
+        mesh.vertices.resize(base + positions.count, gfx::Vertex { glm::vec3(0.0F), glm::vec2(0.0F), glm::vec3(0.0F) });
+
+        for (std::size_t i = 0; i < positions.count; i++) {
+            std::memcpy(&mesh.vertices[base + i].position, positions.pData + i * positions.stride, sizeof(glm::vec3));
+        }
+
+        if (hasNormals) {
+            auto normals = getAccessor(document, pAttributes->getInt("NORMAL", -1), 3, pBin, binSize);
+
+            for (std::size_t i = 0; i < std::min(normals.count, positions.count); i++) {
+                std::memcpy(&mesh.vertices[base + i].normal, normals.pData + i * normals.stride, sizeof(glm::vec3));
+            }
+        }
+
+        if (hasTexcoords) {
+            auto texcoords = getAccessor(document, pAttributes->getInt("TEXCOORD_0", -1), 2, pBin, binSize);
+
+            for (std::size_t i = 0; i < std::min(texcoords.count, positions.count); i++) {
+                std::memcpy(&mesh.vertices[base + i].texcoord, texcoords.pData + i * texcoords.stride, sizeof(glm::vec2));
+            }
+        }
+
+        mesh.hasNormals = (0 == base || mesh.hasNormals) && hasNormals;
+        mesh.hasTexcoords = mesh.hasTexcoords || hasTexcoords;
+
+        if (nullptr == primitive.find("indices")) {
+            for (std::size_t i = 0; i < positions.count; i++) {
+                mesh.indices.push_back(static_cast<std::uint32_t> (base + i));
+            }
+
+            return;
+        }
+
+        auto indices = getAccessor(document, primitive.getInt("indices", -1), 1, pBin, binSize);
+
+        for (std::size_t i = 0; i < indices.count; i++) {
+            auto index = readIndex(indices, i);
+
+            if (index >= positions.count) {
+                throw std::runtime_error("glTF index refers to a missing vertex");
+            }
+
+            mesh.indices.push_back(static_cast<std::uint32_t> (base + index));
+        }
+    }
+
+    std::uint32_t readWord(const std::uint8_t * pData) noexcept {
+        std::uint32_t value;
+        std::memcpy(&value, pData, sizeof(value));
+
+        return value;
+    }
+
+    bool hasExtension(const std::string& path, const char * pExtension) {
+        auto length = std::strlen(pExtension);
+
+        if (path.size() < length) {
+            return false;
+        }
+
+        return std::equal(path.end() - length, path.end(), pExtension, [] (char a, char b) {
+            return std::tolower(static_cast<unsigned char> (a)) == b;
+        });
+    }
+}
+
+namespace gfx {
+    Mesh parseObj(const char * pText, std::size_t size, ThreadPool * pThreadPool) {
+        auto threadCount = nullptr == pThreadPool ? 1 : pThreadPool->getThreadCount();
+        auto chunkCount = std::max<std::size_t> (1, std::min<std::size_t> (size / MIN_CHUNK_SIZE, threadCount * 4));
+        auto chunks = std::vector<ObjChunk> (chunkCount);
+        auto pEnd = pText + size;
+
+        // Chunks start just after a newline, so no line is split between two of them.
+        for (std::size_t i = 0; i < chunkCount; i++) {
+            auto pBegin = pText + size * i / chunkCount;
+
+            if (0 < i) {
+                pBegin = std::min(findLineEnd(std::max(pBegin, chunks[i - 1].pBegin), pEnd) + 1, pEnd);
+                chunks[i - 1].pEnd = pBegin;
+            }
+
+            chunks[i] = { pBegin, pEnd, 0, 0, 0, 0, 0, 0, {} };
+        }
+
+        // Counting first gives every chunk its attribute offsets, so negative indices resolve while parsing.
+        parallelFor(pThreadPool, chunkCount, [&] (unsigned int i) {
+            countObjChunk(chunks[i]);
+        });
+
+        auto positionCount = std::uint32_t(0);
+        auto texcoordCount = std::uint32_t(0);
+        auto normalCount = std::uint32_t(0);
+
+        for (auto& chunk : chunks) {
+            chunk.positionBase = positionCount;
+            chunk.texcoordBase = texcoordCount;
+            chunk.normalBase = normalCount;
+            positionCount += chunk.positionCount;
+            texcoordCount += chunk.texcoordCount;
+            normalCount += chunk.normalCount;
+        }
+
+        auto positions = std::vector<glm::vec3> (positionCount);
+        auto texcoords = std::vector<glm::vec2> (texcoordCount);
+        auto normals = std::vector<glm::vec3> (normalCount);
+        auto errors = std::vector<std::string> (chunkCount);
+
+        parallelFor(pThreadPool, chunkCount, [&] (unsigned int i) {
+            try {
+                parseObjChunk(chunks[i], positions, texcoords, normals);
+            } catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+        });
+
+        rethrow(errors);
+
+        auto cornerBases = std::vector<std::size_t> (chunkCount + 1, 0);
+
+        for (std::size_t i = 0; i < chunkCount; i++) {
+            cornerBases[i + 1] = cornerBases[i] + chunks[i].corners.size();
+        }
+
+        if (cornerBases.back() >= NONE) {
+            throw std::runtime_error("OBJ has too many face corners for 32-bit indices");
+        }
+
+        auto corners = std::vector<Corner> (cornerBases.back());
+
+        parallelFor(pThreadPool, chunkCount, [&] (unsigned int i) {
+            std::copy(chunks[i].corners.begin(), chunks[i].corners.end(), corners.begin() + cornerBases[i]);
+            chunks[i].corners = std::vector<Corner> ();
+        });
+
+        return mergeCorners(corners, positions, texcoords, normals, pThreadPool);
+    }
+
+    Mesh importObj(const std::string& path, ThreadPool * pThreadPool) {
+        auto text = readFile(path);
+
+        return parseObj(text.data(), text.size(), pThreadPool);
+    }
+
+    Mesh parseGlb(const std::uint8_t * pData, std::size_t size) {
+        if (size < 20 || GLB_MAGIC != readWord(pData) || 2 != readWord(pData + 4)) {
+            throw std::runtime_error("Not a glTF 2.0 binary file");
+        }
+
+        auto jsonSize = static_cast<std::size_t> (readWord(pData + 12));
+
+        if (GLB_CHUNK_JSON != readWord(pData + 16) || 20 + jsonSize > size) {
+            throw std::runtime_error("glTF binary file does not start with a JSON chunk");
+        }
+
+        auto pJson = reinterpret_cast<const char *> (pData + 20);
+        auto document = JsonParser(pJson, pJson + jsonSize).parse();
+        auto pBin = static_cast<const std::uint8_t *> (nullptr);
+        auto binSize = std::size_t(0);
+        auto binOffset = 20 + jsonSize;
+
+        if (binOffset + 8 <= size && GLB_CHUNK_BIN == readWord(pData + binOffset + 4)) {
+            binSize = std::min<std::size_t> (readWord(pData + binOffset), size - binOffset - 8);
+            pBin = pData + binOffset + 8;
+        }
+
+        auto mesh = Mesh {};
+        auto pMeshes = document.find("meshes");
+
+        if (nullptr == pMeshes) {
+            return mesh;
+        }
+
+        for (const auto& gltfMesh : pMeshes->elements) {
+            auto pPrimitives = gltfMesh.find("primitives");
+
+            for (std::size_t i = 0; nullptr != pPrimitives && i < pPrimitives->elements.size(); i++) {
+                appendPrimitive(mesh, document, pPrimitives->elements[i], pBin, binSize);
+            }
+        }
+
+        return mesh;
+    }
+
+    Mesh importGlb(const std::string& path) {
+        auto data = readFile(path);
+
+        return parseGlb(reinterpret_cast<const std::uint8_t *> (data.data()), data.size());
+    }
+
+    Mesh importMesh(const std::string& path, ThreadPool * pThreadPool) {
+        if (hasExtension(path, ".obj")) {
+            return importObj(path, pThreadPool);
+        }
+
+        if (hasExtension(path, ".glb")) {
+            return importGlb(path);
+        }
+
+        auto msg = std::stringstream();
+        msg << "Unsupported mesh format: \"" << path << "\"";
+
+        throw std::runtime_error(msg.str());
+    }
+}
@@ -0,0 +1,347 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr std::size_t CACHE_LINE_SIZE = 64;
+    constexpr unsigned int FETCH_CACHE_LINES = 64;
+    constexpr std::uint32_t INVALID_VERTEX = std::numeric_limits<std::uint32_t>::max();
+
+    // A FIFO cache over ids: an id is cached if it went in within the last size misses. reset() ages out
+    // every entry without touching the array.
+    class FifoCache {
+        std::vector<std::size_t> _entered;
+        std::size_t _misses;
+        unsigned int _size;
+
+    public:
+        FifoCache(std::size_t idCount, unsigned int size) :
+            _entered(idCount, 0),
+            _misses(size),
+            _size(size) {}
+
+        bool miss(std::size_t id) noexcept {
+            if (_misses - _entered[id] < _size) {
+                return false;
+            }
+
+            _entered[id] = ++_misses;
+
+            return true;
+        }
+
+        void reset() noexcept {
+            _misses += _size;
+        }
+    };
+
+    unsigned int getFaceMisses(FifoCache& cache, const std::uint32_t * pFace) noexcept {
+        return (cache.miss(pFace[0]) ? 1 : 0) + (cache.miss(pFace[1]) ? 1 : 0) + (cache.miss(pFace[2]) ? 1 : 0);
+    }
+
+    // Face starts of the clusters optimizeOverdraw may move independently.
+    std::vector<std::size_t> getClusters(const std::uint32_t * pIndices, std::size_t faceCount, std::size_t vertexCount, float threshold, unsigned int cacheSize) {
+        auto cache = FifoCache(vertexCount, cacheSize);
+        auto hardClusters = std::vector<std::size_t> ({ 0 });
+
+        for (std::size_t f = 0; f < faceCount; f++) {
+            if (3 == getFaceMisses(cache, pIndices + f * 3) && 0 < f) {
+                hardClusters.push_back(f);
+            }
+        }
+
+        hardClusters.push_back(faceCount);
+
+        auto clusters = std::vector<std::size_t> ();
+
+        for (std::size_t cluster = 0; cluster + 1 < hardClusters.size(); cluster++) {
+            auto begin = hardClusters[cluster];
+            auto end = hardClusters[cluster + 1];
+            auto misses = std::size_t(0);
+
+            cache.reset();
+
+            for (auto f = begin; f < end; f++) {
+                misses += getFaceMisses(cache, pIndices + f * 3);
+            }
+
+            auto target = threshold * misses / (end - begin);
+            auto runningMisses = std::size_t(0);
+            auto runningFaces = std::size_t(0);
+
+            cache.reset();
+            clusters.push_back(begin);
+
+            for (auto f = begin; f + 1 < end; f++) {
+                runningMisses += getFaceMisses(cache, pIndices + f * 3);
+                runningFaces++;
+
+                if (runningMisses <= target * runningFaces) {
+                    cache.reset();
+                    clusters.push_back(f + 1);
+                    runningMisses = 0;
+                    runningFaces = 0;
+                }
+            }
+        }
+
+        clusters.push_back(faceCount);
+
+        return clusters;
+    }
+}
+
+namespace gfx {
+    VertexCacheStats analyzeVertexCache(const std::uint32_t * pIndices, std::size_t indexCount, std::size_t vertexCount, std::size_t vertexSize, unsigned int cacheSize) {
+        auto stats = VertexCacheStats { 0.0F, 0.0F, 0.0F };
+        auto faceCount = indexCount / 3;
+
+        if (0 == faceCount) {
+            return stats;
+        }
+
+        auto vertexCache = FifoCache(vertexCount, cacheSize);
+        auto lineCache = FifoCache((vertexCount * vertexSize + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE, FETCH_CACHE_LINES);
+        auto referenced = std::vector<bool> (vertexCount, false);
+        auto referencedCount = std::size_t(0);
+        auto misses = std::size_t(0);
+        auto fetchedBytes = std::size_t(0);
+
+        for (std::size_t i = 0; i < faceCount * 3; i++) {
+            auto vertex = pIndices[i];
+
+            if (!referenced[vertex]) {
+                referenced[vertex] = true;
+                referencedCount++;
+            }
+
+            if (!vertexCache.miss(vertex)) {
+                continue;
+            }
+
+            misses++;
+
+            for (auto line = vertex * vertexSize / CACHE_LINE_SIZE; line <= (vertex * vertexSize + vertexSize - 1) / CACHE_LINE_SIZE; line++) {
+                fetchedBytes += lineCache.miss(line) ? CACHE_LINE_SIZE : 0;
+            }
+        }
+
+        stats.acmr = static_cast<float> (misses) / faceCount;
+        stats.atvr = static_cast<float> (misses) / referencedCount;
+        stats.overfetch = static_cast<float> (fetchedBytes) / (referencedCount * vertexSize);
+
+        return stats;
+    }
+
+    void optimizeVertexCache(std::uint32_t * pIndices, std::size_t indexCount, std::size_t vertexCount, unsigned int cacheSize) {
+        auto faceCount = indexCount / 3;
+        auto live = std::vector<std::uint32_t> (vertexCount, 0);
+
+        for (std::size_t i = 0; i < faceCount * 3; i++) {
+            live[pIndices[i]]++;
+        }
+
+        // Faces around each vertex, ascending.
+        auto offsets = std::vector<std::size_t> (vertexCount + 1, 0);
+
+        for (std::size_t vertex = 0; vertex < vertexCount; vertex++) {
+            offsets[vertex + 1] = offsets[vertex] + live[vertex];
+        }
+
+        auto adjacency = std::vector<std::uint32_t> (faceCount * 3);
+        auto next = std::vector<std::size_t> (offsets.begin(), offsets.end() - 1);
+
+        for (std::size_t i = 0; i < faceCount * 3; i++) {
+            adjacency[next[pIndices[i]]++] = static_cast<std::uint32_t> (i / 3);
+        }
+
+        // A vertex is cached while time - cacheTime < cacheSize; time only advances on misses.
+        auto cacheTime = std::vector<std::size_t> (vertexCount, 0);
+        auto time = std::size_t(cacheSize) + 1;
+        auto emitted = std::vector<bool> (faceCount, false);
+        auto deadEnds = std::vector<std::uint32_t> ();
+        auto candidates = std::vector<std::uint32_t> ();
+        auto output = std::vector<std::uint32_t> ();
+        auto cursor = std::size_t(0);
+        auto fanning = INVALID_VERTEX;
+
+        output.reserve(faceCount * 3);
+
+        while (cursor < vertexCount && 0 == live[cursor]) {
+            cursor++;
+        }
+
+        fanning = cursor < vertexCount ? static_cast<std::uint32_t> (cursor) : INVALID_VERTEX;
+
+        while (INVALID_VERTEX != fanning) {
+            candidates.clear();
+
+            for (auto i = offsets[fanning]; i < offsets[fanning + 1]; i++) {
+                auto face = adjacency[i];
+
+                if (emitted[face]) {
+                    continue;
+                }
+
+                for (int k = 0; k < 3; k++) {
+                    auto vertex = pIndices[face * 3 + k];
+
+                    output.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    live[vertex]--;
+
+                    if (time - cacheTime[vertex] > cacheSize) {
+                        cacheTime[vertex] = time++;
+                    }
+                }
+
+                emitted[face] = true;
+            }
+
+            // The oldest candidate that will still be cached once its remaining faces are fanned.
+            auto best = INVALID_VERTEX;
+            auto bestPriority = -1L;
+
+            for (auto vertex : candidates) {
+                if (0 == live[vertex]) {
+                    continue;
+                }
+
+                auto age = static_cast<long> (time - cacheTime[vertex]);
+                auto priority = age + 2 * static_cast<long> (live[vertex]) <= static_cast<long> (cacheSize) ? age : 0L;
+
+                if (priority > bestPriority) {
+                    best = vertex;
+                    bestPriority = priority;
+                }
+            }
+
+            while (INVALID_VERTEX == best && !deadEnds.empty()) {
+                auto vertex = deadEnds.back();
+                deadEnds.pop_back();
+
+                if (0 < live[vertex]) {
+                    best = vertex;
+                }
+            }
+
+            while (INVALID_VERTEX == best && cursor < vertexCount) {
+                if (0 < live[cursor]) {
+                    best = static_cast<std::uint32_t> (cursor);
+                } else {
+                    cursor++;
+                }
+            }
+
+            fanning = best;
+        }
+
+        std::copy(output.begin(), output.end(), pIndices);
+    }
+
+    void optimizeOverdraw(std::uint32_t * pIndices, std::size_t indexCount, const std::vector<Vertex>& vertices, float threshold, unsigned int cacheSize) {
+        auto faceCount = indexCount / 3;
+
+        if (faceCount < 2) {
+            return;
+        }
+
+        auto clusters = getClusters(pIndices, faceCount, vertices.size(), threshold, cacheSize);
+        auto clusterCount = clusters.size() - 1;
+        auto normals = std::vector<glm::vec3> (clusterCount, glm::vec3(0.0F));
+        auto centroids = std::vector<glm::vec3> (clusterCount, glm::vec3(0.0F));
+        auto areas = std::vector<float> (clusterCount, 0.0F);
+        auto meshCentroid = glm::vec3(0.0F);
+        auto meshArea = 0.0F;
+
+        // Area-weighted, so the centroids don't depend on how finely a region is tessellated.
+        for (std::size_t cluster = 0; cluster < clusterCount; cluster++) {
+            for (auto f = clusters[cluster]; f < clusters[cluster + 1]; f++) {
+                const auto& p0 = vertices[pIndices[f * 3]].position;
+                const auto& p1 = vertices[pIndices[f * 3 + 1]].position;
+                const auto& p2 = vertices[pIndices[f * 3 + 2]].position;
+                auto normal = glm::cross(p1 - p0, p2 - p0);
+                auto area = glm::length(normal);
+
+                normals[cluster] += normal;
+                centroids[cluster] += (p0 + p1 + p2) * (area / 3.0F);
+                areas[cluster] += area;
+            }
+
+            meshCentroid += centroids[cluster];
+            meshArea += areas[cluster];
+        }
+
+        meshCentroid = 0.0F < meshArea ? meshCentroid / meshArea : meshCentroid;
+
+        // Clusters facing away from the middle of the mesh are the likeliest occluders.
+        auto keys = std::vector<float> (clusterCount, 0.0F);
+
+        for (std::size_t cluster = 0; cluster < clusterCount; cluster++) {
+            auto length = glm::length(normals[cluster]);
+
+            if (0.0F < areas[cluster] && 0.0F < length) {
+                keys[cluster] = glm::dot(centroids[cluster] / areas[cluster] - meshCentroid, normals[cluster] / length);
+            }
+        }
+
+        auto order = std::vector<std::size_t> (clusterCount);
+
+        for (std::size_t cluster = 0; cluster < clusterCount; cluster++) {
+            order[cluster] = cluster;
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&] (std::size_t a, std::size_t b) {
+            return keys[a] > keys[b];
+        });
+
+        auto output = std::vector<std::uint32_t> ();
+        output.reserve(faceCount * 3);
+
+        for (auto cluster : order) {
+            output.insert(output.end(), pIndices + clusters[cluster] * 3, pIndices + clusters[cluster + 1] * 3);
+        }
+
+        std::copy(output.begin(), output.end(), pIndices);
+    }
+
+    std::vector<std::uint32_t> optimizeVertexFetch(Mesh& mesh) {
+        auto remap = std::vector<std::uint32_t> (mesh.vertices.size(), INVALID_VERTEX);
+        auto next = std::uint32_t(0);
+
+        for (auto vertex : mesh.indices) {
+            if (INVALID_VERTEX == remap[vertex]) {
+                remap[vertex] = next++;
+            }
+        }
+
+        for (auto& target : remap) {
+            if (INVALID_VERTEX == target) {
+                target = next++;
+            }
+        }
+
+        auto vertices = std::vector<Vertex> (mesh.vertices.size());
+
+        for (std::size_t vertex = 0; vertex < mesh.vertices.size(); vertex++) {
+            vertices[remap[vertex]] = mesh.vertices[vertex];
+        }
+
+        for (auto& vertex : mesh.indices) {
+            vertex = remap[vertex];
+        }
+
+        mesh.vertices.swap(vertices);
+
+        return remap;
+    }
+
+    void optimizeMesh(Mesh& mesh, float threshold, unsigned int cacheSize) {
+        optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), cacheSize);
+        optimizeOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.vertices, threshold, cacheSize);
+        optimizeVertexFetch(mesh);
+    }
+}
@@ -0,0 +1,699 @@
+#include "mesh_processing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "thread_pool.hpp"
+
+namespace {
+    constexpr unsigned int BLOCK_BITS = 12;
+    constexpr std::uint32_t BLOCK_SIZE = 1U << BLOCK_BITS;
+    constexpr std::size_t CORNERS_PER_TASK = 256 * 1024;
+    constexpr std::size_t FACES_PER_TASK = 64 * 1024;
+    constexpr std::size_t FACE_BATCH = 256;
+    constexpr std::size_t WINDOW_BUDGET = 4;
+    constexpr float PI = 3.14159265F;
+
+    void parallelFor(gfx::ThreadPool * pThreadPool, std::size_t count, const std::function<void (unsigned int)>& task) {
+        if (nullptr != pThreadPool && 1 < count) {
+            pThreadPool->run(static_cast<unsigned int> (count), task);
+            return;
+        }
+
+        for (std::size_t i = 0; i < count; i++) {
+            task(static_cast<unsigned int> (i));
+        }
+    }
+
+    // Corner ids (3 * face + k) grouped by the block of BLOCK_SIZE vertices they refer to, ascending within
+    // each block. Built with a counting sort whose task split doesn't depend on the thread count.
+    struct CornerBuckets {
+        std::vector<std::uint32_t> corners;
+        std::vector<std::size_t> offsets;
+    };
+
+    CornerBuckets bucketCorners(const std::vector<std::uint32_t>& indices, std::size_t cornerCount, std::size_t vertexCount, gfx::ThreadPool * pThreadPool) {
+        auto blockCount = (vertexCount + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        auto taskCount = (cornerCount + CORNERS_PER_TASK - 1) / CORNERS_PER_TASK;
+        auto counts = std::vector<std::size_t> (taskCount * blockCount, 0);
+
+        parallelFor(pThreadPool, taskCount, [&] (unsigned int task) {
+            auto pCounts = &counts[task * blockCount];
+            auto end = std::min((task + 1) * CORNERS_PER_TASK, cornerCount);
+
+            for (auto c = task * CORNERS_PER_TASK; c < end; c++) {
+                pCounts[indices[c] >> BLOCK_BITS]++;
+            }
+        });
+
+        auto buckets = CornerBuckets {};
+        auto offset = std::size_t(0);
+
+        buckets.offsets.resize(blockCount + 1);
+
+        // Block-major, so each block's corners end up contiguous and in task order.
+        for (std::size_t block = 0; block < blockCount; block++) {
+            buckets.offsets[block] = offset;
+
+            for (std::size_t task = 0; task < taskCount; task++) {
+                auto count = counts[task * blockCount + block];
+
+                counts[task * blockCount + block] = offset;
+                offset += count;
+            }
+        }
+
+        buckets.offsets[blockCount] = offset;
+        buckets.corners.resize(offset);
+
+        parallelFor(pThreadPool, taskCount, [&] (unsigned int task) {
+            auto pNext = &counts[task * blockCount];
+            auto end = std::min((task + 1) * CORNERS_PER_TASK, cornerCount);
+
+            for (auto c = task * CORNERS_PER_TASK; c < end; c++) {
+                buckets.corners[pNext[indices[c] >> BLOCK_BITS]++] = static_cast<std::uint32_t> (c);
+            }
+        });
+
+        return buckets;
+    }
+
+    // The vertex range each FACES_PER_TASK range of faces touches, and where its window starts in the
+    // shared window array. Narrow for any mesh whose indices have some locality.
+    struct TaskWindows {
+        std::vector<std::uint32_t> first;
+        std::vector<std::uint32_t> size;
+        std::vector<std::size_t> offsets;
+    };
+
+    TaskWindows getTaskWindows(const std::vector<std::uint32_t>& indices, std::size_t faceCount, gfx::ThreadPool * pThreadPool) {
+        auto taskCount = (faceCount + FACES_PER_TASK - 1) / FACES_PER_TASK;
+        auto windows = TaskWindows { std::vector<std::uint32_t> (taskCount), std::vector<std::uint32_t> (taskCount), std::vector<std::size_t> (taskCount + 1, 0) };
+
+        parallelFor(pThreadPool, taskCount, [&] (unsigned int task) {
+            auto end = std::min((task + 1) * FACES_PER_TASK, faceCount) * 3;
+            auto first = indices[task * FACES_PER_TASK * 3];
+            auto last = first;
+
+            for (auto i = task * FACES_PER_TASK * 3; i < end; i++) {
+                first = std::min(first, indices[i]);
+                last = std::max(last, indices[i]);
+            }
+
+            windows.first[task] = first;
+            windows.size[task] = last - first + 1;
+        });
+
+        for (std::size_t task = 0; task < taskCount; task++) {
+            windows.offsets[task + 1] = windows.offsets[task] + windows.size[task];
+        }
+
+        return windows;
+    }
+
+    // Abramowitz and Stegun 4.4.45, within 7e-5 radians; only used for weights.
+    float approxAcos(float x) noexcept {
+        auto a = std::min(std::fabs(x), 1.0F);
+        auto r = std::sqrt(1.0F - a) * (1.5707288F + a * (-0.2121144F + a * (0.0742610F + a * -0.0187293F)));
+
+        return x < 0.0F ? PI - r : r;
+    }
+
+    float getCornerAngle(float ax, float ay, float az, float bx, float by, float bz) noexcept {
+        auto lengths = (ax * ax + ay * ay + az * az) * (bx * bx + by * by + bz * bz);
+
+        return 0.0F < lengths ? approxAcos((ax * bx + ay * by + az * bz) / std::sqrt(lengths)) : 0.0F;
+    }
+
+    // Per-face data lives in float arrays; these views point COMPONENTS arrays of stride floats into them.
+    struct FaceNormals {
+        static constexpr unsigned int COMPONENTS = 3;
+        static constexpr unsigned int SUMS = 3;
+
+        float * x;
+        float * y;
+        float * z;
+
+        static FaceNormals at(float * p, std::size_t stride) noexcept {
+            return { p, p + stride, p + 2 * stride };
+        }
+    };
+
+    void computeFaceNormalsScalar(const gfx::VertexStreams& streams, const std::uint32_t * pIndices, std::size_t begin, std::size_t end, const FaceNormals& faces) noexcept {
+        const auto * px = streams.positionX.data();
+        const auto * py = streams.positionY.data();
+        const auto * pz = streams.positionZ.data();
+
+        for (auto f = begin; f < end; f++) {
+            auto i0 = pIndices[f * 3];
+            auto i1 = pIndices[f * 3 + 1];
+            auto i2 = pIndices[f * 3 + 2];
+            auto d1x = px[i1] - px[i0];
+            auto d1y = py[i1] - py[i0];
+            auto d1z = pz[i1] - pz[i0];
+            auto d2x = px[i2] - px[i0];
+            auto d2y = py[i2] - py[i0];
+            auto d2z = pz[i2] - pz[i0];
+
+            faces.x[f] = d1y * d2z - d1z * d2y;
+            faces.y[f] = d1z * d2x - d1x * d2z;
+            faces.z[f] = d1x * d2y - d1y * d2x;
+        }
+    }
+
+    // Per face: unit dP/du and dP/dv (zero for degenerate texcoords), and the angle at each corner.
+    struct FaceTangents {
+        static constexpr unsigned int COMPONENTS = 9;
+        static constexpr unsigned int SUMS = 6;
+
+        float * tangentX;
+        float * tangentY;
+        float * tangentZ;
+        float * bitangentX;
+        float * bitangentY;
+        float * bitangentZ;
+        float * angles[3];
+
+        static FaceTangents at(float * p, std::size_t stride) noexcept {
+            return { p, p + stride, p + 2 * stride, p + 3 * stride, p + 4 * stride, p + 5 * stride,
+                { p + 6 * stride, p + 7 * stride, p + 8 * stride } };
+        }
+    };
+
+    void computeFaceTangentsScalar(const gfx::VertexStreams& streams, const std::uint32_t * pIndices, std::size_t begin, std::size_t end, const FaceTangents& faces) noexcept {
+        for (auto f = begin; f < end; f++) {
+            float x[3], y[3], z[3], u[3], v[3];
+
+            for (int k = 0; k < 3; k++) {
+                auto i = pIndices[f * 3 + k];
+
+                x[k] = streams.positionX[i];
+                y[k] = streams.positionY[i];
+                z[k] = streams.positionZ[i];
+                u[k] = streams.texcoordX[i];
+                v[k] = streams.texcoordY[i];
+            }
+
+            auto d1x = x[1] - x[0];
+            auto d1y = y[1] - y[0];
+            auto d1z = z[1] - z[0];
+            auto d2x = x[2] - x[0];
+            auto d2y = y[2] - y[0];
+            auto d2z = z[2] - z[0];
+            auto t21x = u[1] - u[0];
+            auto t21y = v[1] - v[0];
+            auto t31x = u[2] - u[0];
+            auto t31y = v[2] - v[0];
+            auto signedArea = t21x * t31y - t21y * t31x;
+            auto sign = 0.0F == signedArea ? 0.0F : (signedArea < 0.0F ? -1.0F : 1.0F);
+
+            auto sx = t31y * d1x - t21y * d2x;
+            auto sy = t31y * d1y - t21y * d2y;
+            auto sz = t31y * d1z - t21y * d2z;
+            auto tx = t21x * d2x - t31x * d1x;
+            auto ty = t21x * d2y - t31x * d1y;
+            auto tz = t21x * d2z - t31x * d1z;
+            auto sLength = std::sqrt(sx * sx + sy * sy + sz * sz);
+            auto tLength = std::sqrt(tx * tx + ty * ty + tz * tz);
+            auto sScale = 0.0F < sLength ? sign / sLength : 0.0F;
+            auto tScale = 0.0F < tLength ? sign / tLength : 0.0F;
+
+            faces.tangentX[f] = sx * sScale;
+            faces.tangentY[f] = sy * sScale;
+            faces.tangentZ[f] = sz * sScale;
+            faces.bitangentX[f] = tx * tScale;
+            faces.bitangentY[f] = ty * tScale;
+            faces.bitangentZ[f] = tz * tScale;
+
+            for (int k = 0; k < 3; k++) {
+                auto next = (k + 1) % 3;
+                auto prev = (k + 2) % 3;
+
+                faces.angles[k][f] = getCornerAngle(x[next] - x[k], y[next] - y[k], z[next] - z[k], x[prev] - x[k], y[prev] - y[k], z[prev] - z[k]);
+            }
+        }
+    }
+
+#if defined(__x86_64__)
+    struct GatheredFaces {
+        __m256 x[3];
+        __m256 y[3];
+        __m256 z[3];
+        __m256 u[3];
+        __m256 v[3];
+    };
+
+    // Gathers the corners of faces f ... f + 7; vertex indices must fit in 31 bits.
+    __attribute__((target("avx2")))
+    inline void gatherFaces(const gfx::VertexStreams& streams, const std::uint32_t * pIndices, std::size_t f, bool texcoords, GatheredFaces& out) noexcept {
+        auto stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+        auto pFace = reinterpret_cast<const int *> (pIndices + f * 3);
+
+        for (int k = 0; k < 3; k++) {
+            auto vertices = _mm256_i32gather_epi32(pFace + k, stride, 4);
+
+            out.x[k] = _mm256_i32gather_ps(streams.positionX.data(), vertices, 4);
+            out.y[k] = _mm256_i32gather_ps(streams.positionY.data(), vertices, 4);
+            out.z[k] = _mm256_i32gather_ps(streams.positionZ.data(), vertices, 4);
+
+            if (texcoords) {
+                out.u[k] = _mm256_i32gather_ps(streams.texcoordX.data(), vertices, 4);
+                out.v[k] = _mm256_i32gather_ps(streams.texcoordY.data(), vertices, 4);
+            }
+        }
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t computeFaceNormalsAvx2(const gfx::VertexStreams& streams, const std::uint32_t * pIndices, std::size_t begin, std::size_t end, const FaceNormals& faces) noexcept {
+        auto f = begin;
+
+        for (; f + 8 <= end; f += 8) {
+            auto g = GatheredFaces {};
+            gatherFaces(streams, pIndices, f, false, g);
+
+            auto d1x = _mm256_sub_ps(g.x[1], g.x[0]);
+            auto d1y = _mm256_sub_ps(g.y[1], g.y[0]);
+            auto d1z = _mm256_sub_ps(g.z[1], g.z[0]);
+            auto d2x = _mm256_sub_ps(g.x[2], g.x[0]);
+            auto d2y = _mm256_sub_ps(g.y[2], g.y[0]);
+            auto d2z = _mm256_sub_ps(g.z[2], g.z[0]);
+
+            _mm256_storeu_ps(&faces.x[f], _mm256_sub_ps(_mm256_mul_ps(d1y, d2z), _mm256_mul_ps(d1z, d2y)));
+            _mm256_storeu_ps(&faces.y[f], _mm256_sub_ps(_mm256_mul_ps(d1z, d2x), _mm256_mul_ps(d1x, d2z)));
+            _mm256_storeu_ps(&faces.z[f], _mm256_sub_ps(_mm256_mul_ps(d1x, d2y), _mm256_mul_ps(d1y, d2x)));
+        }
+
+        return f;
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256 approxAcosAvx2(__m256 x) noexcept {
+        auto signMask = _mm256_set1_ps(-0.0F);
+        auto one = _mm256_set1_ps(1.0F);
+        auto a = _mm256_min_ps(_mm256_andnot_ps(signMask, x), one);
+        auto p = _mm256_add_ps(_mm256_set1_ps(0.0742610F), _mm256_mul_ps(a, _mm256_set1_ps(-0.0187293F)));
+
+        p = _mm256_add_ps(_mm256_set1_ps(-0.2121144F), _mm256_mul_ps(a, p));
+        p = _mm256_add_ps(_mm256_set1_ps(1.5707288F), _mm256_mul_ps(a, p));
+
+        auto r = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_sub_ps(one, a)), p);
+        auto negative = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ);
+
+        return _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(PI), r), negative);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256 getCornerAngleAvx2(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz) noexcept {
+        auto zero = _mm256_setzero_ps();
+        auto aa = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, ax), _mm256_mul_ps(ay, ay)), _mm256_mul_ps(az, az));
+        auto bb = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(bx, bx), _mm256_mul_ps(by, by)), _mm256_mul_ps(bz, bz));
+        auto ab = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+        auto lengths = _mm256_mul_ps(aa, bb);
+        auto valid = _mm256_cmp_ps(zero, lengths, _CMP_LT_OQ);
+        auto angle = approxAcosAvx2(_mm256_div_ps(ab, _mm256_sqrt_ps(lengths)));
+
+        return _mm256_and_ps(valid, angle);
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t computeFaceTangentsAvx2(const gfx::VertexStreams& streams, const std::uint32_t * pIndices, std::size_t begin, std::size_t end, const FaceTangents& faces) noexcept {
+        auto zero = _mm256_setzero_ps();
+        auto one = _mm256_set1_ps(1.0F);
+        auto signMask = _mm256_set1_ps(-0.0F);
+        auto f = begin;
+
+        for (; f + 8 <= end; f += 8) {
+            auto g = GatheredFaces {};
+            gatherFaces(streams, pIndices, f, true, g);
+
+            auto d1x = _mm256_sub_ps(g.x[1], g.x[0]);
+            auto d1y = _mm256_sub_ps(g.y[1], g.y[0]);
+            auto d1z = _mm256_sub_ps(g.z[1], g.z[0]);
+            auto d2x = _mm256_sub_ps(g.x[2], g.x[0]);
+            auto d2y = _mm256_sub_ps(g.y[2], g.y[0]);
+            auto d2z = _mm256_sub_ps(g.z[2], g.z[0]);
+            auto t21x = _mm256_sub_ps(g.u[1], g.u[0]);
+            auto t21y = _mm256_sub_ps(g.v[1], g.v[0]);
+            auto t31x = _mm256_sub_ps(g.u[2], g.u[0]);
+            auto t31y = _mm256_sub_ps(g.v[2], g.v[0]);
+            auto signedArea = _mm256_sub_ps(_mm256_mul_ps(t21x, t31y), _mm256_mul_ps(t21y, t31x));
+
+            // sign(signedArea), or 0 for degenerate texcoords.
+            auto sign = _mm256_and_ps(_mm256_cmp_ps(signedArea, zero, _CMP_NEQ_OQ), _mm256_or_ps(one, _mm256_and_ps(signMask, signedArea)));
+
+            auto sx = _mm256_sub_ps(_mm256_mul_ps(t31y, d1x), _mm256_mul_ps(t21y, d2x));
+            auto sy = _mm256_sub_ps(_mm256_mul_ps(t31y, d1y), _mm256_mul_ps(t21y, d2y));
+            auto sz = _mm256_sub_ps(_mm256_mul_ps(t31y, d1z), _mm256_mul_ps(t21y, d2z));
+            auto tx = _mm256_sub_ps(_mm256_mul_ps(t21x, d2x), _mm256_mul_ps(t31x, d1x));
+            auto ty = _mm256_sub_ps(_mm256_mul_ps(t21x, d2y), _mm256_mul_ps(t31x, d1y));
+            auto tz = _mm256_sub_ps(_mm256_mul_ps(t21x, d2z), _mm256_mul_ps(t31x, d1z));
+            auto sLength = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, sx), _mm256_mul_ps(sy, sy)), _mm256_mul_ps(sz, sz)));
+            auto tLength = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tx, tx), _mm256_mul_ps(ty, ty)), _mm256_mul_ps(tz, tz)));
+            auto sScale = _mm256_and_ps(_mm256_cmp_ps(zero, sLength, _CMP_LT_OQ), _mm256_div_ps(sign, sLength));
+            auto tScale = _mm256_and_ps(_mm256_cmp_ps(zero, tLength, _CMP_LT_OQ), _mm256_div_ps(sign, tLength));
+
+            _mm256_storeu_ps(&faces.tangentX[f], _mm256_mul_ps(sx, sScale));
+            _mm256_storeu_ps(&faces.tangentY[f], _mm256_mul_ps(sy, sScale));
+            _mm256_storeu_ps(&faces.tangentZ[f], _mm256_mul_ps(sz, sScale));
+            _mm256_storeu_ps(&faces.bitangentX[f], _mm256_mul_ps(tx, tScale));
+            _mm256_storeu_ps(&faces.bitangentY[f], _mm256_mul_ps(ty, tScale));
+            _mm256_storeu_ps(&faces.bitangentZ[f], _mm256_mul_ps(tz, tScale));
+
+            for (int k = 0; k < 3; k++) {
+                auto next = (k + 1) % 3;
+                auto prev = (k + 2) % 3;
+                auto angle = getCornerAngleAvx2(
+                    _mm256_sub_ps(g.x[next], g.x[k]), _mm256_sub_ps(g.y[next], g.y[k]), _mm256_sub_ps(g.z[next], g.z[k]),
+                    _mm256_sub_ps(g.x[prev], g.x[k]), _mm256_sub_ps(g.y[prev], g.y[k]), _mm256_sub_ps(g.z[prev], g.z[k]));
+
+                _mm256_storeu_ps(&faces.angles[k][f], angle);
+            }
+        }
+
+        return f;
+    }
+
+    __attribute__((target("avx2")))
+    std::uint32_t normalizeAvx2(const float * pX, const float * pY, const float * pZ, std::uint32_t count, float * pOutX, float * pOutY, float * pOutZ) noexcept {
+        auto zero = _mm256_setzero_ps();
+        auto fallbackY = _mm256_set1_ps(1.0F);
+        auto i = std::uint32_t(0);
+
+        for (; i + 8 <= count; i += 8) {
+            auto x = _mm256_loadu_ps(pX + i);
+            auto y = _mm256_loadu_ps(pY + i);
+            auto z = _mm256_loadu_ps(pZ + i);
+            auto lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+            auto valid = _mm256_cmp_ps(zero, lengthSquared, _CMP_LT_OQ);
+            auto scale = _mm256_div_ps(_mm256_set1_ps(1.0F), _mm256_sqrt_ps(lengthSquared));
+
+            _mm256_storeu_ps(pOutX + i, _mm256_and_ps(valid, _mm256_mul_ps(x, scale)));
+            _mm256_storeu_ps(pOutY + i, _mm256_blendv_ps(fallbackY, _mm256_mul_ps(y, scale), valid));
+            _mm256_storeu_ps(pOutZ + i, _mm256_and_ps(valid, _mm256_mul_ps(z, scale)));
+        }
+
+        return i;
+    }
+#endif
+
+    void normalizeScalar(const float * pX, const float * pY, const float * pZ, std::uint32_t begin, std::uint32_t end, float * pOutX, float * pOutY, float * pOutZ) noexcept {
+        for (auto i = begin; i < end; i++) {
+            auto lengthSquared = pX[i] * pX[i] + pY[i] * pY[i] + pZ[i] * pZ[i];
+            auto valid = 0.0F < lengthSquared;
+            auto scale = 1.0F / std::sqrt(lengthSquared);
+
+            pOutX[i] = valid ? pX[i] * scale : 0.0F;
+            pOutY[i] = valid ? pY[i] * scale : 1.0F;
+            pOutZ[i] = valid ? pZ[i] * scale : 0.0F;
+        }
+    }
+
+    // Sums per-corner contributions into Faces::SUMS arrays per vertex without two threads ever writing the
+    // same vertex, and hands each block of vertices to blockKernel as BLOCK_SIZE-strided sums.
+    //
+    // faceKernel(pIndices, count, faces) fills a view for count faces; cornerKernel(faces, face, k, vertex,
+    // pSums, stride, slot) adds corner k of a face to pSums[component * stride + slot].
+    //
+    // Usually each FACES_PER_TASK range of faces sums into a private window over the vertices it touches,
+    // batch by batch while its face data is in cache, and every block then adds up the windows overlapping it
+    // in task order. When the windows would take more than WINDOW_BUDGET times the vertex count, face data
+    // is stored for the whole mesh instead and each block sums its corners after a counting sort. The task
+    // split is fixed in both cases, so results don't depend on the thread count, and both paths add in the
+    // same order, so they don't depend on which one ran either.
+    template <typename Faces, typename FaceKernel, typename CornerKernel, typename BlockKernel>
+    void accumulateCorners(std::size_t vertexCount, const std::vector<std::uint32_t>& indices, gfx::ThreadPool * pThreadPool,
+            FaceKernel faceKernel, CornerKernel cornerKernel, BlockKernel blockKernel) {
+
+        auto faceCount = indices.size() / 3;
+        auto taskCount = (faceCount + FACES_PER_TASK - 1) / FACES_PER_TASK;
+        auto blockCount = (vertexCount + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        auto windows = getTaskWindows(indices, faceCount, pThreadPool);
+
+        if (windows.offsets.back() <= WINDOW_BUDGET * vertexCount) {
+            auto sums = std::unique_ptr<float[]> (new float[Faces::SUMS * windows.offsets.back()]);
+
+            parallelFor(pThreadPool, taskCount, [&] (unsigned int task) {
+                auto first = windows.first[task];
+                auto stride = windows.size[task];
+                auto pWindow = &sums[Faces::SUMS * windows.offsets[task]];
+                auto storage = std::vector<float> (Faces::COMPONENTS * FACE_BATCH);
+                auto faces = Faces::at(storage.data(), FACE_BATCH);
+                auto end = std::min((task + 1) * FACES_PER_TASK, faceCount);
+
+                std::fill(pWindow, pWindow + Faces::SUMS * stride, 0.0F);
+
+                for (auto f = task * FACES_PER_TASK; f < end; f += FACE_BATCH) {
+                    auto count = std::min(FACE_BATCH, end - f);
+                    const auto * pFaces = &indices[f * 3];
+
+                    faceKernel(pFaces, count, faces);
+
+                    for (std::size_t i = 0; i < count; i++) {
+                        for (unsigned int k = 0; k < 3; k++) {
+                            auto vertex = pFaces[i * 3 + k];
+
+                            cornerKernel(faces, i, k, vertex, pWindow, stride, vertex - first);
+                        }
+                    }
+                }
+            });
+
+            parallelFor(pThreadPool, blockCount, [&] (unsigned int block) {
+                auto base = block * BLOCK_SIZE;
+                auto end = static_cast<std::uint32_t> (std::min<std::size_t> (base + BLOCK_SIZE, vertexCount));
+                auto blockSums = std::vector<float> (Faces::SUMS * BLOCK_SIZE, 0.0F);
+
+                for (std::size_t task = 0; task < taskCount; task++) {
+                    auto first = windows.first[task];
+                    auto stride = windows.size[task];
+                    auto begin = std::max(base, first);
+                    auto last = std::min(end, first + stride);
+
+                    for (unsigned int component = 0; component < Faces::SUMS && begin < last; component++) {
+                        const auto * pSource = &sums[Faces::SUMS * windows.offsets[task] + component * stride + begin - first];
+                        auto pTarget = &blockSums[component * BLOCK_SIZE + begin - base];
+
+                        for (std::uint32_t i = 0; i < last - begin; i++) {
+                            pTarget[i] += pSource[i];
+                        }
+                    }
+                }
+
+                blockKernel(base, end - base, blockSums.data());
+            });
+
+            return;
+        }
+
+        auto storage = std::vector<float> (Faces::COMPONENTS * faceCount);
+
+        parallelFor(pThreadPool, taskCount, [&] (unsigned int task) {
+            auto begin = task * FACES_PER_TASK;
+            auto end = std::min(begin + FACES_PER_TASK, faceCount);
+
+            faceKernel(&indices[begin * 3], end - begin, Faces::at(&storage[begin], faceCount));
+        });
+
+        auto faces = Faces::at(storage.data(), faceCount);
+        auto buckets = bucketCorners(indices, faceCount * 3, vertexCount, pThreadPool);
+
+        // Corners come in ascending order, so summing each task's share on its own and adding the shares in
+        // task order rounds exactly as the windows do.
+        parallelFor(pThreadPool, blockCount, [&] (unsigned int block) {
+            auto base = block * BLOCK_SIZE;
+            auto count = static_cast<std::uint32_t> (std::min<std::size_t> (BLOCK_SIZE, vertexCount - base));
+            auto blockSums = std::vector<float> (Faces::SUMS * BLOCK_SIZE, 0.0F);
+            auto taskSums = std::vector<float> (Faces::SUMS * BLOCK_SIZE, 0.0F);
+            auto owners = std::vector<std::size_t> (BLOCK_SIZE, taskCount);
+            auto touched = std::vector<std::uint32_t> ();
+            auto currentTask = taskCount;
+
+            auto addTaskSums = [&] {
+                for (auto slot : touched) {
+                    for (unsigned int component = 0; component < Faces::SUMS; component++) {
+                        blockSums[component * BLOCK_SIZE + slot] += taskSums[component * BLOCK_SIZE + slot];
+                        taskSums[component * BLOCK_SIZE + slot] = 0.0F;
+                    }
+                }
+
+                touched.clear();
+            };
+
+            for (auto i = buckets.offsets[block]; i < buckets.offsets[block + 1]; i++) {
+                auto corner = buckets.corners[i];
+                auto vertex = indices[corner];
+                auto slot = vertex - base;
+                auto task = corner / (3 * FACES_PER_TASK);
+
+                if (task != currentTask) {
+                    addTaskSums();
+                    currentTask = task;
+                }
+
+                if (task != owners[slot]) {
+                    owners[slot] = task;
+                    touched.push_back(slot);
+                }
+
+                cornerKernel(faces, corner / 3, corner % 3, vertex, taskSums.data(), BLOCK_SIZE, slot);
+            }
+
+            addTaskSums();
+            blockKernel(base, count, blockSums.data());
+        });
+    }
+}
+
+namespace gfx {
+    std::size_t VertexStreams::size() const noexcept {
+        return positionX.size();
+    }
+
+    void VertexStreams::resize(std::size_t count) {
+        for (auto pArray : { &positionX, &positionY, &positionZ, &texcoordX, &texcoordY, &normalX, &normalY, &normalZ,
+                &tangentX, &tangentY, &tangentZ, &tangentW }) {
+            pArray->resize(count, 0.0F);
+        }
+    }
+
+    VertexStreams toVertexStreams(const Mesh& mesh) {
+        auto streams = VertexStreams {};
+        streams.resize(mesh.vertices.size());
+
+        for (std::size_t i = 0; i < mesh.vertices.size(); i++) {
+            const auto& vertex = mesh.vertices[i];
+
+            streams.positionX[i] = vertex.position.x;
+            streams.positionY[i] = vertex.position.y;
+            streams.positionZ[i] = vertex.position.z;
+            streams.texcoordX[i] = vertex.texcoord.x;
+            streams.texcoordY[i] = vertex.texcoord.y;
+            streams.normalX[i] = vertex.normal.x;
+            streams.normalY[i] = vertex.normal.y;
+            streams.normalZ[i] = vertex.normal.z;
+        }
+
+        return streams;
+    }
+
+    void storeVertexStreams(const VertexStreams& streams, Mesh& mesh) noexcept {
+        for (std::size_t i = 0; i < mesh.vertices.size(); i++) {
+            auto& vertex = mesh.vertices[i];
+
+            vertex.position = glm::vec3(streams.positionX[i], streams.positionY[i], streams.positionZ[i]);
+            vertex.texcoord = glm::vec2(streams.texcoordX[i], streams.texcoordY[i]);
+            vertex.normal = glm::vec3(streams.normalX[i], streams.normalY[i], streams.normalZ[i]);
+        }
+    }
+
+    void computeNormals(VertexStreams& streams, const std::vector<std::uint32_t>& indices, ThreadPool * pThreadPool, SimdLevel level) {
+        auto useAvx2 = SimdLevel::AVX2 == std::min(level, getBestSimdLevel());
+
+        accumulateCorners<FaceNormals> (streams.size(), indices, pThreadPool,
+            [&] (const std::uint32_t * pIndices, std::size_t count, const FaceNormals& faces) {
+                auto done = std::size_t(0);
+
+#if defined(__x86_64__)
+                if (useAvx2) {
+                    done = computeFaceNormalsAvx2(streams, pIndices, 0, count, faces);
+                }
+#endif
+
+                computeFaceNormalsScalar(streams, pIndices, done, count, faces);
+            },
+            [] (const FaceNormals& faces, std::size_t face, unsigned int, std::uint32_t, float * pSums, std::size_t stride, std::size_t slot) {
+                pSums[slot] += faces.x[face];
+                pSums[stride + slot] += faces.y[face];
+                pSums[2 * stride + slot] += faces.z[face];
+            },
+            [&] (std::uint32_t base, std::uint32_t count, const float * pSums) {
+                auto done = std::uint32_t(0);
+                auto pOutX = &streams.normalX[base];
+                auto pOutY = &streams.normalY[base];
+                auto pOutZ = &streams.normalZ[base];
+
+#if defined(__x86_64__)
+                if (useAvx2) {
+                    done = normalizeAvx2(pSums, pSums + BLOCK_SIZE, pSums + 2 * BLOCK_SIZE, count, pOutX, pOutY, pOutZ);
+                }
+#endif
+
+                normalizeScalar(pSums, pSums + BLOCK_SIZE, pSums + 2 * BLOCK_SIZE, done, count, pOutX, pOutY, pOutZ);
+            });
+    }
+
+    void computeTangents(VertexStreams& streams, const std::vector<std::uint32_t>& indices, ThreadPool * pThreadPool, SimdLevel level) {
+        auto useAvx2 = SimdLevel::AVX2 == std::min(level, getBestSimdLevel());
+
+        accumulateCorners<FaceTangents> (streams.size(), indices, pThreadPool,
+            [&] (const std::uint32_t * pIndices, std::size_t count, const FaceTangents& faces) {
+                auto done = std::size_t(0);
+
+#if defined(__x86_64__)
+                if (useAvx2) {
+                    done = computeFaceTangentsAvx2(streams, pIndices, 0, count, faces);
+                }
+#endif
+
+                computeFaceTangentsScalar(streams, pIndices, done, count, faces);
+            },
+            [&] (const FaceTangents& faces, std::size_t face, unsigned int k, std::uint32_t vertex, float * pSums, std::size_t stride, std::size_t slot) {
+                auto normal = glm::vec3(streams.normalX[vertex], streams.normalY[vertex], streams.normalZ[vertex]);
+                auto tangent = glm::vec3(faces.tangentX[face], faces.tangentY[face], faces.tangentZ[face]);
+                auto bitangent = glm::vec3(faces.bitangentX[face], faces.bitangentY[face], faces.bitangentZ[face]);
+                auto angle = faces.angles[k][face];
+
+                // Project into the vertex's normal plane before weighting, as MikkTSpace does.
+                tangent -= normal * glm::dot(normal, tangent);
+                bitangent -= normal * glm::dot(normal, bitangent);
+
+                auto tangentLength = glm::dot(tangent, tangent);
+                auto bitangentLength = glm::dot(bitangent, bitangent);
+
+                if (0.0F < tangentLength) {
+                    tangent *= angle / std::sqrt(tangentLength);
+                    pSums[slot] += tangent.x;
+                    pSums[stride + slot] += tangent.y;
+                    pSums[2 * stride + slot] += tangent.z;
+                }
+
+                if (0.0F < bitangentLength) {
+                    bitangent *= angle / std::sqrt(bitangentLength);
+                    pSums[3 * stride + slot] += bitangent.x;
+                    pSums[4 * stride + slot] += bitangent.y;
+                    pSums[5 * stride + slot] += bitangent.z;
+                }
+            },
+            [&] (std::uint32_t base, std::uint32_t count, const float * pSums) {
+                for (std::uint32_t i = 0; i < count; i++) {
+                    auto vertex = base + i;
+                    auto normal = glm::vec3(streams.normalX[vertex], streams.normalY[vertex], streams.normalZ[vertex]);
+                    auto tangent = glm::vec3(pSums[i], pSums[BLOCK_SIZE + i], pSums[2 * BLOCK_SIZE + i]);
+                    auto bitangent = glm::vec3(pSums[3 * BLOCK_SIZE + i], pSums[4 * BLOCK_SIZE + i], pSums[5 * BLOCK_SIZE + i]);
+
+                    tangent -= normal * glm::dot(normal, tangent);
+
+                    auto lengthSquared = glm::dot(tangent, tangent);
+
+                    if (0.0F < lengthSquared) {
+                        tangent = tangent / std::sqrt(lengthSquared);
+                    } else {
+                        // No usable texcoords around this vertex: any unit vector in the normal plane.
+                        auto axis = std::fabs(normal.x) < 0.9F ? glm::vec3(1.0F, 0.0F, 0.0F) : glm::vec3(0.0F, 1.0F, 0.0F);
+                        tangent = glm::normalize(axis - normal * glm::dot(normal, axis));
+                    }
+
+                    streams.tangentX[vertex] = tangent.x;
+                    streams.tangentY[vertex] = tangent.y;
+                    streams.tangentZ[vertex] = tangent.z;
+                    streams.tangentW[vertex] = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0F ? -1.0F : 1.0F;
+                }
+            });
+    }
+}
@@ -0,0 +1,194 @@
+#include "normal_matrix.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace {
+    void storeColumns(std::uint8_t * pOut, gfx::NormalMatrixLayout layout, const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2) noexcept {
+        if (gfx::NormalMatrixLayout::MAT4 == layout) {
+            *reinterpret_cast<glm::mat4 *> (pOut) = glm::mat4(c0, c1, c2, glm::vec4(0.0F, 0.0F, 0.0F, 1.0F));
+        } else {
+            *reinterpret_cast<glm::mat3x4 *> (pOut) = glm::mat3x4(c0, c1, c2);
+        }
+    }
+
+    void computeScalar(const glm::mat4 * pMatrices, std::size_t begin, std::size_t end, std::uint8_t * pOut, std::size_t outStride, gfx::NormalMatrixLayout layout) noexcept {
+        for (auto i = begin; i < end; i++) {
+            auto c0 = glm::vec3(pMatrices[i][0]);
+            auto c1 = glm::vec3(pMatrices[i][1]);
+            auto c2 = glm::vec3(pMatrices[i][2]);
+            auto r0 = glm::cross(c1, c2);
+            auto r1 = glm::cross(c2, c0);
+            auto r2 = glm::cross(c0, c1);
+            auto det = glm::dot(c0, r0);
+            auto scale = 0.0F == det ? 1.0F : 1.0F / det;
+
+            storeColumns(pOut + i * outStride, layout, glm::vec4(r0 * scale, 0.0F), glm::vec4(r1 * scale, 0.0F), glm::vec4(r2 * scale, 0.0F));
+        }
+    }
+
+#if defined(__x86_64__)
+    // Four matrices per step: each column is transposed into x/y/z registers holding one lane per matrix,
+    // the cofactors are computed lane-wise, and the result columns are transposed back for the stores.
+    std::size_t computeSse(const glm::mat4 * pMatrices, std::size_t count, std::uint8_t * pOut, std::size_t outStride, gfx::NormalMatrixLayout layout) noexcept {
+        auto zero = _mm_setzero_ps();
+        auto one = _mm_set1_ps(1.0F);
+        auto lastColumn = _mm_set_ps(1.0F, 0.0F, 0.0F, 0.0F);
+        auto pInput = reinterpret_cast<const float *> (pMatrices);
+        auto i = std::size_t(0);
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 x[3], y[3], z[3];
+
+            for (int c = 0; c < 3; c++) {
+                auto a = _mm_loadu_ps(pInput + (i + 0) * 16 + c * 4);
+                auto b = _mm_loadu_ps(pInput + (i + 1) * 16 + c * 4);
+                auto d = _mm_loadu_ps(pInput + (i + 2) * 16 + c * 4);
+                auto e = _mm_loadu_ps(pInput + (i + 3) * 16 + c * 4);
+
+                _MM_TRANSPOSE4_PS(a, b, d, e);
+                x[c] = a;
+                y[c] = b;
+                z[c] = d;
+            }
+
+            // r0 = c1 x c2, r1 = c2 x c0, r2 = c0 x c1
+            __m128 rx[3], ry[3], rz[3];
+
+            for (int r = 0; r < 3; r++) {
+                auto p = (r + 1) % 3;
+                auto q = (r + 2) % 3;
+
+                rx[r] = _mm_sub_ps(_mm_mul_ps(y[p], z[q]), _mm_mul_ps(z[p], y[q]));
+                ry[r] = _mm_sub_ps(_mm_mul_ps(z[p], x[q]), _mm_mul_ps(x[p], z[q]));
+                rz[r] = _mm_sub_ps(_mm_mul_ps(x[p], y[q]), _mm_mul_ps(y[p], x[q]));
+            }
+
+            auto det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x[0], rx[0]), _mm_mul_ps(y[0], ry[0])), _mm_mul_ps(z[0], rz[0]));
+            auto singular = _mm_cmpeq_ps(det, zero);
+            auto scale = _mm_or_ps(_mm_and_ps(singular, one), _mm_andnot_ps(singular, _mm_div_ps(one, det)));
+
+            for (int r = 0; r < 3; r++) {
+                auto a = _mm_mul_ps(rx[r], scale);
+                auto b = _mm_mul_ps(ry[r], scale);
+                auto d = _mm_mul_ps(rz[r], scale);
+                auto e = zero;
+
+                _MM_TRANSPOSE4_PS(a, b, d, e);
+                _mm_storeu_ps(reinterpret_cast<float *> (pOut + (i + 0) * outStride) + r * 4, a);
+                _mm_storeu_ps(reinterpret_cast<float *> (pOut + (i + 1) * outStride) + r * 4, b);
+                _mm_storeu_ps(reinterpret_cast<float *> (pOut + (i + 2) * outStride) + r * 4, d);
+                _mm_storeu_ps(reinterpret_cast<float *> (pOut + (i + 3) * outStride) + r * 4, e);
+            }
+
+            if (gfx::NormalMatrixLayout::MAT4 == layout) {
+                for (int k = 0; k < 4; k++) {
+                    _mm_storeu_ps(reinterpret_cast<float *> (pOut + (i + k) * outStride) + 12, lastColumn);
+                }
+            }
+        }
+
+        return i;
+    }
+
+    // _MM_TRANSPOSE4_PS within each 128-bit lane: the low lane holds matrices 0-3, the high lane 4-7.
+    __attribute__((target("avx2")))
+    inline void transposeLanes(__m256& a, __m256& b, __m256& c, __m256& d) noexcept {
+        auto t0 = _mm256_shuffle_ps(a, b, 0x44);
+        auto t2 = _mm256_shuffle_ps(a, b, 0xEE);
+        auto t1 = _mm256_shuffle_ps(c, d, 0x44);
+        auto t3 = _mm256_shuffle_ps(c, d, 0xEE);
+
+        a = _mm256_shuffle_ps(t0, t1, 0x88);
+        b = _mm256_shuffle_ps(t0, t1, 0xDD);
+        c = _mm256_shuffle_ps(t2, t3, 0x88);
+        d = _mm256_shuffle_ps(t2, t3, 0xDD);
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t computeAvx2(const glm::mat4 * pMatrices, std::size_t count, std::uint8_t * pOut, std::size_t outStride, gfx::NormalMatrixLayout layout) noexcept {
+        auto zero = _mm256_setzero_ps();
+        auto one = _mm256_set1_ps(1.0F);
+        auto lastColumn = _mm_set_ps(1.0F, 0.0F, 0.0F, 0.0F);
+        auto pInput = reinterpret_cast<const float *> (pMatrices);
+        auto i = std::size_t(0);
+
+        for (; i + 8 <= count; i += 8) {
+            __m256 x[3], y[3], z[3];
+
+            for (int c = 0; c < 3; c++) {
+                __m256 m[4];
+
+                for (int k = 0; k < 4; k++) {
+                    auto low = _mm_loadu_ps(pInput + (i + k) * 16 + c * 4);
+                    auto high = _mm_loadu_ps(pInput + (i + k + 4) * 16 + c * 4);
+
+                    m[k] = _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+                }
+
+                transposeLanes(m[0], m[1], m[2], m[3]);
+                x[c] = m[0];
+                y[c] = m[1];
+                z[c] = m[2];
+            }
+
+            __m256 rx[3], ry[3], rz[3];
+
+            for (int r = 0; r < 3; r++) {
+                auto p = (r + 1) % 3;
+                auto q = (r + 2) % 3;
+
+                rx[r] = _mm256_sub_ps(_mm256_mul_ps(y[p], z[q]), _mm256_mul_ps(z[p], y[q]));
+                ry[r] = _mm256_sub_ps(_mm256_mul_ps(z[p], x[q]), _mm256_mul_ps(x[p], z[q]));
+                rz[r] = _mm256_sub_ps(_mm256_mul_ps(x[p], y[q]), _mm256_mul_ps(y[p], x[q]));
+            }
+
+            auto det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x[0], rx[0]), _mm256_mul_ps(y[0], ry[0])), _mm256_mul_ps(z[0], rz[0]));
+            auto singular = _mm256_cmp_ps(det, zero, _CMP_EQ_OQ);
+            auto scale = _mm256_blendv_ps(_mm256_div_ps(one, det), one, singular);
+
+            for (int r = 0; r < 3; r++) {
+                __m256 m[4] = { _mm256_mul_ps(rx[r], scale), _mm256_mul_ps(ry[r], scale), _mm256_mul_ps(rz[r], scale), zero };
+
+                transposeLanes(m[0], m[1], m[2], m[3]);
+
+                for (int k = 0; k < 4; k++) {
+                    _mm_storeu_ps(reinterpret_cast<float *> (pOut + (i + k) * outStride) + r * 4, _mm256_castps256_ps128(m[k]));
+                    _mm_storeu_ps(reinterpret_cast<float *> (pOut + (i + k + 4) * outStride) + r * 4, _mm256_extractf128_ps(m[k], 1));
+                }
+            }
+
+            if (gfx::NormalMatrixLayout::MAT4 == layout) {
+                for (int k = 0; k < 8; k++) {
+                    _mm_storeu_ps(reinterpret_cast<float *> (pOut + (i + k) * outStride) + 12, lastColumn);
+                }
+            }
+        }
+
+        return i;
+    }
+#endif
+}
+
+namespace gfx {
+    void computeNormalMatrices(const glm::mat4 * pMatrices, std::size_t count, void * pOut, std::size_t outStride, NormalMatrixLayout layout, SimdLevel level) noexcept {
+        auto pBytes = static_cast<std::uint8_t *> (pOut);
+        auto done = std::size_t(0);
+
+        level = std::min(level, getBestSimdLevel());
+
+#if defined(__x86_64__)
+        if (SimdLevel::AVX2 == level) {
+            done = computeAvx2(pMatrices, count, pBytes, outStride, layout);
+        } else if (SimdLevel::SSE == level) {
+            done = computeSse(pMatrices, count, pBytes, outStride, layout);
+        }
+#endif
+
+        computeScalar(pMatrices, done, count, pBytes, outStride, layout);
+    }
+}
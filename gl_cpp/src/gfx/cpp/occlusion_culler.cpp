@@ -0,0 +1,357 @@
+#include "occlusion_culler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "thread_pool.hpp"
+
+namespace {
+    constexpr int TILE_SIZE = 8;
+    constexpr std::size_t PARTITION_SIZE = 4096;
+
+    // Points this close to (or behind) the eye can't be projected; occluder triangles touching them are
+    // dropped and boxes touching them are kept.
+    constexpr float MIN_W = 1e-4F;
+
+    double elapsedMs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+namespace gfx {
+    OcclusionCuller::OcclusionCuller(int width, int height) {
+        _tilesX = std::max((width + TILE_SIZE - 1) / TILE_SIZE, 1);
+        _tilesY = std::max((height + TILE_SIZE - 1) / TILE_SIZE, 1);
+        _width = _tilesX * TILE_SIZE;
+        _height = _tilesY * TILE_SIZE;
+        _viewProj = glm::mat4(1.0F);
+        _depth.assign(_width * _height, 1.0F);
+        _tileMax.assign(_tilesX * _tilesY, 1.0F);
+        _stats = { 0, 0, 0, 0.0, 0.0 };
+    }
+
+    int OcclusionCuller::getWidth() const noexcept {
+        return _width;
+    }
+
+    int OcclusionCuller::getHeight() const noexcept {
+        return _height;
+    }
+
+    const std::vector<float>& OcclusionCuller::getDepth() const noexcept {
+        return _depth;
+    }
+
+    const OcclusionStats& OcclusionCuller::getStats() const noexcept {
+        return _stats;
+    }
+
+    std::size_t OcclusionCuller::addOccluder(const std::vector<glm::vec3>& positions, const std::vector<std::uint32_t>& indices, const glm::mat4& model) {
+        _occluders.push_back({ positions, indices, model });
+
+        return _occluders.size() - 1;
+    }
+
+    void OcclusionCuller::setOccluderTransform(std::size_t occluder, const glm::mat4& model) noexcept {
+        _occluders[occluder].model = model;
+    }
+
+    void OcclusionCuller::clearOccluders() noexcept {
+        _occluders.clear();
+    }
+
+    std::size_t OcclusionCuller::size() const noexcept {
+        return _boundsMin.size();
+    }
+
+    void OcclusionCuller::resize(std::size_t count) {
+        _boundsMin.resize(count);
+        _boundsMax.resize(count);
+    }
+
+    void OcclusionCuller::setBox(std::size_t index, const glm::vec3& min, const glm::vec3& max) noexcept {
+        _boundsMin[index] = min;
+        _boundsMax[index] = max;
+    }
+
+    void OcclusionCuller::setupTriangles() {
+        auto clip = std::vector<glm::vec4> ();
+
+        _triangles.clear();
+
+        for (const auto& occluder : _occluders) {
+            auto trModelViewProj = _viewProj * occluder.model;
+
+            clip.resize(occluder.positions.size());
+
+            for (std::size_t i = 0; i < clip.size(); i++) {
+                clip[i] = trModelViewProj * glm::vec4(occluder.positions[i], 1.0F);
+            }
+
+            for (std::size_t i = 0; i + 2 < occluder.indices.size(); i += 3) {
+                const auto& c0 = clip[occluder.indices[i]];
+                const auto& c1 = clip[occluder.indices[i + 1]];
+                const auto& c2 = clip[occluder.indices[i + 2]];
+
+                // Triangles crossing the near plane are dropped rather than clipped: the part in front of it would
+                // land at depth < 0 and hide everything, though the GPU clips it away. Losing occluder area only
+                // makes the culler more conservative.
+                if (c0.w < MIN_W || c1.w < MIN_W || c2.w < MIN_W || c0.z < -c0.w || c1.z < -c1.w || c2.z < -c2.w) {
+                    continue;
+                }
+
+                // Pixel space with y up, depth mapped to [0, 1]; z / w is affine in screen space, so a plane fits it exactly.
+                float x[3], y[3], z[3];
+
+                for (int v = 0; v < 3; v++) {
+                    const auto& c = 0 == v ? c0 : (1 == v ? c1 : c2);
+
+                    x[v] = (c.x / c.w * 0.5F + 0.5F) * _width;
+                    y[v] = (c.y / c.w * 0.5F + 0.5F) * _height;
+                    z[v] = c.z / c.w * 0.5F + 0.5F;
+                }
+
+                auto area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+
+                if (area <= 0.0F) {
+                    continue;
+                }
+
+                auto triangle = Triangle {};
+
+                triangle.minX = std::max(static_cast<int> (std::floor(std::min({ x[0], x[1], x[2] }))), 0);
+                triangle.maxX = std::min(static_cast<int> (std::ceil(std::max({ x[0], x[1], x[2] }))), _width - 1);
+                triangle.minY = std::max(static_cast<int> (std::floor(std::min({ y[0], y[1], y[2] }))), 0);
+                triangle.maxY = std::min(static_cast<int> (std::ceil(std::max({ y[0], y[1], y[2] }))), _height - 1);
+
+                if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) {
+                    continue;
+                }
+
+                // Edge e runs from vertex e to vertex e + 1 and is positive on the inside.
+                for (int e = 0; e < 3; e++) {
+                    auto a = e;
+                    auto b = (e + 1) % 3;
+
+                    triangle.edgeA[e] = y[a] - y[b];
+                    triangle.edgeB[e] = x[b] - x[a];
+                    triangle.edgeC[e] = x[a] * y[b] - x[b] * y[a];
+                }
+
+                // Edge e is opposite vertex e + 2, so it weighs that vertex in the barycentric blend.
+                triangle.depthA = (triangle.edgeA[1] * z[0] + triangle.edgeA[2] * z[1] + triangle.edgeA[0] * z[2]) / area;
+                triangle.depthB = (triangle.edgeB[1] * z[0] + triangle.edgeB[2] * z[1] + triangle.edgeB[0] * z[2]) / area;
+                triangle.depthC = (triangle.edgeC[1] * z[0] + triangle.edgeC[2] * z[1] + triangle.edgeC[0] * z[2]) / area;
+
+                _triangles.push_back(triangle);
+            }
+        }
+    }
+
+    void OcclusionCuller::rasterizeBand(int tileRow) noexcept {
+        auto bandMinY = tileRow * TILE_SIZE;
+        auto bandMaxY = bandMinY + TILE_SIZE - 1;
+
+        std::fill(_depth.begin() + bandMinY * _width, _depth.begin() + (bandMaxY + 1) * _width, 1.0F);
+
+        for (const auto& triangle : _triangles) {
+            auto minY = std::max(triangle.minY, bandMinY);
+            auto maxY = std::min(triangle.maxY, bandMaxY);
+
+            if (minY > maxY) {
+                continue;
+            }
+
+            // Rows are processed four pixels at a time, so start on a multiple of four; the width always is one.
+            auto minX = triangle.minX & ~3;
+
+            for (auto py = minY; py <= maxY; py++) {
+                auto pRow = _depth.data() + py * _width;
+                auto fy = py + 0.5F;
+
+#if defined(__x86_64__)
+                auto offsets = _mm_setr_ps(0.5F, 1.5F, 2.5F, 3.5F);
+                auto zero = _mm_setzero_ps();
+                __m128 rowEdge[3];
+                __m128 stepEdge[3];
+
+                for (int e = 0; e < 3; e++) {
+                    rowEdge[e] = _mm_set1_ps(triangle.edgeB[e] * fy + triangle.edgeC[e]);
+                    stepEdge[e] = _mm_set1_ps(triangle.edgeA[e]);
+                }
+
+                auto rowDepth = _mm_set1_ps(triangle.depthB * fy + triangle.depthC);
+                auto stepDepth = _mm_set1_ps(triangle.depthA);
+
+                for (auto px = minX; px <= triangle.maxX; px += 4) {
+                    auto fx = _mm_add_ps(_mm_set1_ps(static_cast<float> (px)), offsets);
+                    auto e0 = _mm_add_ps(_mm_mul_ps(stepEdge[0], fx), rowEdge[0]);
+                    auto e1 = _mm_add_ps(_mm_mul_ps(stepEdge[1], fx), rowEdge[1]);
+                    auto e2 = _mm_add_ps(_mm_mul_ps(stepEdge[2], fx), rowEdge[2]);
+                    auto inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+
+                    if (0 == _mm_movemask_ps(inside)) {
+                        continue;
+                    }
+
+                    auto depth = _mm_add_ps(_mm_mul_ps(stepDepth, fx), rowDepth);
+                    auto old = _mm_loadu_ps(pRow + px);
+                    auto nearest = _mm_min_ps(old, depth);
+
+                    _mm_storeu_ps(pRow + px, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+                }
+#else
+                for (auto px = minX; px <= triangle.maxX; px++) {
+                    auto fx = px + 0.5F;
+                    auto inside = true;
+
+                    for (int e = 0; e < 3; e++) {
+                        inside = inside && triangle.edgeA[e] * fx + triangle.edgeB[e] * fy + triangle.edgeC[e] >= 0.0F;
+                    }
+
+                    if (inside) {
+                        pRow[px] = std::min(pRow[px], triangle.depthA * fx + triangle.depthB * fy + triangle.depthC);
+                    }
+                }
+#endif
+            }
+        }
+
+        for (auto tx = 0; tx < _tilesX; tx++) {
+            auto farthest = 0.0F;
+
+            for (auto py = bandMinY; py <= bandMaxY; py++) {
+                auto pTile = _depth.data() + py * _width + tx * TILE_SIZE;
+
+                farthest = std::max(farthest, *std::max_element(pTile, pTile + TILE_SIZE));
+            }
+
+            _tileMax[tileRow * _tilesX + tx] = farthest;
+        }
+    }
+
+    void OcclusionCuller::rasterize(const glm::mat4& viewProj, ThreadPool * pThreadPool) {
+        auto start = std::chrono::steady_clock::now();
+
+        _viewProj = viewProj;
+
+        setupTriangles();
+
+        // Each band owns its rows of the depth buffer and its row of tiles, so bands need no synchronization.
+        auto task = [this] (unsigned int tileRow) {
+            rasterizeBand(static_cast<int> (tileRow));
+        };
+
+        if (nullptr != pThreadPool) {
+            pThreadPool->run(_tilesY, task);
+        } else {
+            for (auto tileRow = 0; tileRow < _tilesY; tileRow++) {
+                task(tileRow);
+            }
+        }
+
+        _stats.occluderTriangles = _triangles.size();
+        _stats.rasterizeMs = elapsedMs(start);
+    }
+
+    bool OcclusionCuller::isVisible(const glm::vec3& min, const glm::vec3& max) const noexcept {
+        auto minX = static_cast<float> (_width);
+        auto maxX = 0.0F;
+        auto minY = static_cast<float> (_height);
+        auto maxY = 0.0F;
+        auto nearest = 1.0F;
+
+        for (int corner = 0; corner < 8; corner++) {
+            auto position = glm::vec4(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z, 1.0F);
+            auto clip = _viewProj * position;
+
+            // Boxes reaching the eye would need clipping; they are close enough to draw anyway.
+            if (clip.w < MIN_W) {
+                return true;
+            }
+
+            auto x = (clip.x / clip.w * 0.5F + 0.5F) * _width;
+            auto y = (clip.y / clip.w * 0.5F + 0.5F) * _height;
+
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+            nearest = std::min(nearest, clip.z / clip.w * 0.5F + 0.5F);
+        }
+
+        auto x0 = std::max(static_cast<int> (std::floor(minX)), 0);
+        auto x1 = std::min(static_cast<int> (std::floor(maxX)), _width - 1);
+        auto y0 = std::max(static_cast<int> (std::floor(minY)), 0);
+        auto y1 = std::min(static_cast<int> (std::floor(maxY)), _height - 1);
+
+        // Tiles whose farthest occluder is nearer than the box hide it outright; only the others are checked per pixel.
+        for (auto ty = y0 / TILE_SIZE; ty <= y1 / TILE_SIZE && y0 <= y1; ty++) {
+            for (auto tx = x0 / TILE_SIZE; tx <= x1 / TILE_SIZE && x0 <= x1; tx++) {
+                if (_tileMax[ty * _tilesX + tx] < nearest) {
+                    continue;
+                }
+
+                auto pxEnd = std::min(x1, tx * TILE_SIZE + TILE_SIZE - 1);
+                auto pyEnd = std::min(y1, ty * TILE_SIZE + TILE_SIZE - 1);
+
+                for (auto py = std::max(y0, ty * TILE_SIZE); py <= pyEnd; py++) {
+                    for (auto px = std::max(x0, tx * TILE_SIZE); px <= pxEnd; px++) {
+                        if (_depth[py * _width + px] >= nearest) {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    void OcclusionCuller::cull(const std::vector<std::uint32_t>& candidates, std::vector<std::uint32_t>& visible, ThreadPool * pThreadPool) {
+        auto start = std::chrono::steady_clock::now();
+        auto partitionCount = static_cast<unsigned int> ((candidates.size() + PARTITION_SIZE - 1) / PARTITION_SIZE);
+
+        _partitions.resize(std::max<std::size_t> (_partitions.size(), partitionCount));
+
+        auto task = [&] (unsigned int partition) {
+            auto begin = partition * PARTITION_SIZE;
+            auto end = std::min(begin + PARTITION_SIZE, candidates.size());
+            auto& out = _partitions[partition];
+
+            out.clear();
+
+            for (auto i = begin; i < end; i++) {
+                auto index = candidates[i];
+
+                if (isVisible(_boundsMin[index], _boundsMax[index])) {
+                    out.push_back(index);
+                }
+            }
+        };
+
+        if (nullptr != pThreadPool) {
+            pThreadPool->run(partitionCount, task);
+        } else {
+            for (unsigned int i = 0; i < partitionCount; i++) {
+                task(i);
+            }
+        }
+
+        visible.clear();
+
+        for (unsigned int i = 0; i < partitionCount; i++) {
+            visible.insert(visible.end(), _partitions[i].begin(), _partitions[i].end());
+        }
+
+        _stats.tested = candidates.size();
+        _stats.culled = candidates.size() - visible.size();
+        _stats.testMs = elapsedMs(start);
+    }
+}
@@ -0,0 +1,103 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include "state_cache.hpp"
+
+namespace {
+    constexpr unsigned int RADIX_BITS = 8;
+    constexpr std::size_t RADIX_SIZE = 1 << RADIX_BITS;
+    constexpr unsigned int RADIX_PASSES = 64 / RADIX_BITS;
+
+    constexpr std::uint64_t DEPTH_MAX = (1 << 24) - 1;
+}
+
+namespace gfx {
+    std::uint64_t RenderQueue::makeKey(unsigned int layer, GLuint program, GLuint material, GLuint texture, float depth) noexcept {
+        auto quantized = static_cast<std::uint64_t> (std::min(std::max(depth, 0.0F), 1.0F) * DEPTH_MAX);
+
+        return (static_cast<std::uint64_t> (layer & 0xF) << 60)
+            | (static_cast<std::uint64_t> (program & 0xFFF) << 48)
+            | (static_cast<std::uint64_t> (material & 0xFFF) << 36)
+            | (static_cast<std::uint64_t> (texture & 0xFFF) << 24)
+            | quantized;
+    }
+
+    RenderQueue::RenderQueue(GLuint objectBinding, GLuint materialBinding, GLuint textureUnit) {
+        _objectBinding = objectBinding;
+        _materialBinding = materialBinding;
+        _textureUnit = textureUnit;
+    }
+
+    std::size_t RenderQueue::size() const noexcept {
+        return _packets.size();
+    }
+
+    void RenderQueue::clear() noexcept {
+        _packets.clear();
+        _entries.clear();
+    }
+
+    void RenderQueue::push(std::uint64_t key, const DrawPacket& packet) {
+        _entries.push_back({ key, static_cast<std::uint32_t> (_packets.size()) });
+        _packets.push_back(packet);
+    }
+
+    void RenderQueue::sort() {
+        // LSD radix sort; all histograms are built in one sweep over the keys.
+        auto histograms = std::array<std::array<std::uint32_t, RADIX_SIZE>, RADIX_PASSES> {};
+
+        for (const auto& entry : _entries) {
+            for (unsigned int pass = 0; pass < RADIX_PASSES; pass++) {
+                histograms[pass][(entry.key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+            }
+        }
+
+        _scratch.resize(_entries.size());
+
+        for (unsigned int pass = 0; pass < RADIX_PASSES; pass++) {
+            auto& histogram = histograms[pass];
+            auto shift = pass * RADIX_BITS;
+
+            // Every key has the same digit here, so the pass wouldn't move anything.
+            if (_entries.empty() || histogram[(_entries.front().key >> shift) & (RADIX_SIZE - 1)] == _entries.size()) {
+                continue;
+            }
+
+            auto offset = std::uint32_t(0);
+
+            for (auto& bucket : histogram) {
+                auto count = bucket;
+                bucket = offset;
+                offset += count;
+            }
+
+            for (const auto& entry : _entries) {
+                _scratch[histogram[(entry.key >> shift) & (RADIX_SIZE - 1)]++] = entry;
+            }
+
+            _entries.swap(_scratch);
+        }
+    }
+
+    void RenderQueue::submit(StateCache& cache) const {
+        for (const auto& entry : _entries) {
+            const auto& packet = _packets[entry.index];
+
+            cache.useProgram(packet.program);
+            cache.bindBufferRange(GL_UNIFORM_BUFFER, _objectBinding, packet.objectBuffer, packet.objectOffset, packet.objectSize);
+            cache.bindBufferRange(GL_UNIFORM_BUFFER, _materialBinding, packet.materialBuffer, packet.materialOffset, packet.materialSize);
+            cache.bindTextureUnit(_textureUnit, packet.texture);
+            cache.bindVertexArray(packet.vertexArray);
+            cache.bindVertexBuffer(0, packet.vertexBuffer, 0, packet.vertexStride);
+
+            if (packet.elementBuffer) {
+                cache.bindElementBuffer(packet.elementBuffer);
+                glDrawElements(GL_TRIANGLES, packet.count, packet.indexType, reinterpret_cast<const void *> (packet.first));
+            } else {
+                glDrawArrays(GL_TRIANGLES, static_cast<GLint> (packet.first), packet.count);
+            }
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#include "scene.hpp"
+
+namespace {
+    // Arvo: the world extent along each axis is the local extent projected onto the absolute basis vectors.
+    gfx::Aabb transformBounds(const gfx::Aabb& bounds, const glm::mat4& transform) noexcept {
+        auto center = glm::vec3(transform * glm::vec4((bounds.min + bounds.max) * 0.5F, 1.0F));
+        auto extent = (bounds.max - bounds.min) * 0.5F;
+        auto worldExtent = glm::abs(glm::vec3(transform[0])) * extent.x
+            + glm::abs(glm::vec3(transform[1])) * extent.y
+            + glm::abs(glm::vec3(transform[2])) * extent.z;
+
+        return { center - worldExtent, center + worldExtent };
+    }
+}
+
+namespace gfx {
+    Scene::Scene(float rebuildRatio) {
+        _rebuildRatio = rebuildRatio;
+        _needsBuild = false;
+    }
+
+    std::size_t Scene::size() const noexcept {
+        return _transforms.size();
+    }
+
+    std::uint32_t Scene::add(const Aabb& localBounds, const glm::mat4& transform) {
+        auto object = static_cast<std::uint32_t> (_transforms.size());
+
+        _localBounds.push_back(localBounds);
+        _transforms.push_back(transform);
+        _bvh.resize(_transforms.size());
+        _bvh.setBounds(object, transformBounds(localBounds, transform));
+        _needsBuild = true;
+
+        return object;
+    }
+
+    const glm::mat4& Scene::getTransform(std::uint32_t object) const noexcept {
+        return _transforms[object];
+    }
+
+    void Scene::setTransform(std::uint32_t object, const glm::mat4& transform) {
+        _transforms[object] = transform;
+        _bvh.setBounds(object, transformBounds(_localBounds[object], transform));
+    }
+
+    const Aabb& Scene::getBounds(std::uint32_t object) const noexcept {
+        return _bvh.getBounds(object);
+    }
+
+    const Bvh& Scene::getBvh() const noexcept {
+        return _bvh;
+    }
+
+    bool Scene::update(ThreadPool * pThreadPool) {
+        if (!_needsBuild) {
+            _bvh.refit();
+            _needsBuild = _bvh.getSahCost() > _rebuildRatio * _bvh.getBuiltSahCost();
+        }
+
+        if (!_needsBuild) {
+            return false;
+        }
+
+        rebuild(pThreadPool);
+
+        return true;
+    }
+
+    void Scene::rebuild(ThreadPool * pThreadPool) {
+        _bvh.build(pThreadPool);
+        _needsBuild = false;
+    }
+}
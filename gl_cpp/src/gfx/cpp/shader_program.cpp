@@ -0,0 +1,313 @@
+#include "shader_program.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+    constexpr GLsizei MAX_INFO_LOG_LENGTH = 1024;
+
+    std::string readSource(const std::string& path) {
+        auto file = std::ifstream(path.c_str(), std::ios::binary);
+
+        if (!file) {
+            auto msg = std::stringstream();
+            msg << "Failed to load file: \"" << path << "\"";
+
+            throw std::runtime_error(msg.str());
+        }
+
+        auto buffer = std::stringstream();
+        buffer << file.rdbuf();
+
+        return buffer.str();
+    }
+
+    GLuint beginCompile(GLenum type, const std::string& src) {
+        auto pSrc = src.c_str();
+        auto len = static_cast<GLint> (src.length());
+        auto shader = glCreateShader(type);
+
+        glShaderSource(shader, 1, &pSrc, &len);
+        glCompileShader(shader);
+
+        return shader;
+    }
+
+    // With ARB_parallel_shader_compile the driver compiles and links on its own threads;
+    // polling GL_COMPLETION_STATUS lets the frame loop carry on with the old program meanwhile.
+    bool isShaderReady(GLuint shader) {
+        if (!GLEW_ARB_parallel_shader_compile) {
+            return true;
+        }
+
+        GLint done;
+        glGetShaderiv(shader, GL_COMPLETION_STATUS_ARB, &done);
+
+        return GL_FALSE != done;
+    }
+
+    bool isProgramReady(GLuint program) {
+        if (!GLEW_ARB_parallel_shader_compile) {
+            return true;
+        }
+
+        GLint done;
+        glGetProgramiv(program, GL_COMPLETION_STATUS_ARB, &done);
+
+        return GL_FALSE != done;
+    }
+
+    std::string getCompileError(GLuint shader, const std::string& path) {
+        GLint success;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+        if (success) {
+            return std::string();
+        }
+
+        auto infoLog = std::make_unique<GLchar[]> (MAX_INFO_LOG_LENGTH);
+
+        glGetShaderInfoLog(shader, MAX_INFO_LOG_LENGTH, nullptr, infoLog.get());
+
+        auto msg = std::stringstream();
+        msg << "Error compiling shader \"" << path << "\": " << infoLog.get();
+
+        return msg.str();
+    }
+
+    std::string getLinkError(GLuint program) {
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+        if (success) {
+            return std::string();
+        }
+
+        auto infoLog = std::make_unique<GLchar[]> (MAX_INFO_LOG_LENGTH);
+
+        glGetProgramInfoLog(program, MAX_INFO_LOG_LENGTH, nullptr, infoLog.get());
+
+        auto msg = std::stringstream();
+        msg << "Error linking program: " << infoLog.get();
+
+        return msg.str();
+    }
+}
+
+namespace gfx {
+    ShaderProgram::Shader::Shader(GLuint handle) noexcept :
+        _handle(handle) {}
+
+    ShaderProgram::Shader::Shader(Shader&& other) noexcept :
+        _handle(other._handle) {
+
+        other._handle = 0;
+    }
+
+    ShaderProgram::Shader& ShaderProgram::Shader::operator= (Shader&& other) noexcept {
+        if (this != &other) {
+            glDeleteShader(_handle);
+            _handle = other._handle;
+            other._handle = 0;
+        }
+
+        return *this;
+    }
+
+    ShaderProgram::Shader::~Shader() noexcept {
+        glDeleteShader(_handle);
+    }
+
+    GLuint ShaderProgram::Shader::get() const noexcept {
+        return _handle;
+    }
+
+    ShaderProgram::ShaderProgram(const std::vector<ShaderStage>& stages) {
+        _pendingHandle = 0;
+        _dirty = false;
+
+        if (GLEW_ARB_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        }
+
+        // The stages own their shaders, so a throw anywhere below deletes the ones already compiled.
+        for (const auto& stage : stages) {
+            auto source = readSource(stage.path);
+
+            _stages.push_back({ stage.type, stage.path, Shader(beginCompile(stage.type, source)), Shader(), std::string(), false });
+        }
+
+        for (const auto& stage : _stages) {
+            auto err = getCompileError(stage.shader.get(), stage.path);
+
+            if (!err.empty()) {
+                throw std::runtime_error(err);
+            }
+        }
+
+        _handle = glCreateProgram();
+
+        for (const auto& stage : _stages) {
+            glAttachShader(_handle, stage.shader.get());
+        }
+
+        glLinkProgram(_handle);
+
+        for (const auto& stage : _stages) {
+            glDetachShader(_handle, stage.shader.get());
+        }
+
+        auto err = getLinkError(_handle);
+
+        if (!err.empty()) {
+            glDeleteProgram(_handle);
+
+            throw std::runtime_error(err);
+        }
+    }
+
+    ShaderProgram::~ShaderProgram() noexcept {
+        discardPending();
+
+        glDeleteProgram(_handle);
+    }
+
+    GLuint ShaderProgram::getHandle() const noexcept {
+        return _handle;
+    }
+
+    void ShaderProgram::watch(ShaderWatcher& watcher) const {
+        for (const auto& stage : _stages) {
+            watcher.watch(stage.path);
+        }
+    }
+
+    bool ShaderProgram::reload(const FileChange& change) {
+        auto affected = false;
+
+        for (auto& stage : _stages) {
+            if (stage.path != change.path) {
+                continue;
+            }
+
+            // A newer edit supersedes whatever is still compiling for this stage.
+            if (_pendingHandle) {
+                glDeleteProgram(_pendingHandle);
+                _pendingHandle = 0;
+            }
+
+            if (GLEW_ARB_parallel_shader_compile) {
+                stage.pendingShader = Shader(beginCompile(stage.type, change.source));
+            } else {
+                stage.pendingShader = Shader();
+                stage.pendingSource = change.source;
+                stage.compilePending = true;
+            }
+
+            affected = true;
+        }
+
+        _dirty = _dirty || affected;
+
+        return affected;
+    }
+
+    bool ShaderProgram::update() {
+        if (_dirty) {
+            // Without parallel compilation, spread the synchronous compiles over frames.
+            for (auto& stage : _stages) {
+                if (stage.compilePending) {
+                    stage.pendingShader = Shader(beginCompile(stage.type, stage.pendingSource));
+                    stage.pendingSource.clear();
+                    stage.compilePending = false;
+
+                    return false;
+                }
+            }
+
+            for (const auto& stage : _stages) {
+                if (stage.pendingShader.get() && !isShaderReady(stage.pendingShader.get())) {
+                    return false;
+                }
+            }
+
+            for (const auto& stage : _stages) {
+                if (!stage.pendingShader.get()) {
+                    continue;
+                }
+
+                auto err = getCompileError(stage.pendingShader.get(), stage.path);
+
+                if (!err.empty()) {
+                    std::cerr << "[ERROR]: " << err << std::endl;
+
+                    // Keep the live program and drop every pending stage; each is retried on its next save.
+                    discardPending();
+
+                    return false;
+                }
+            }
+
+            _pendingHandle = glCreateProgram();
+
+            for (const auto& stage : _stages) {
+                glAttachShader(_pendingHandle, getLinkedShader(stage));
+            }
+
+            glLinkProgram(_pendingHandle);
+            _dirty = false;
+        }
+
+        if (!_pendingHandle || !isProgramReady(_pendingHandle)) {
+            return false;
+        }
+
+        for (const auto& stage : _stages) {
+            glDetachShader(_pendingHandle, getLinkedShader(stage));
+        }
+
+        auto err = getLinkError(_pendingHandle);
+
+        if (!err.empty()) {
+            std::cerr << "[ERROR]: " << err << std::endl;
+
+            discardPending();
+            return false;
+        }
+
+        glDeleteProgram(_handle);
+        _handle = _pendingHandle;
+        _pendingHandle = 0;
+
+        for (auto& stage : _stages) {
+            if (stage.pendingShader.get()) {
+                stage.shader = std::move(stage.pendingShader);
+            }
+        }
+
+        return true;
+    }
+
+    GLuint ShaderProgram::getLinkedShader(const Stage& stage) noexcept {
+        return stage.pendingShader.get() ? stage.pendingShader.get() : stage.shader.get();
+    }
+
+    void ShaderProgram::discardPending() noexcept {
+        if (_pendingHandle) {
+            glDeleteProgram(_pendingHandle);
+            _pendingHandle = 0;
+        }
+
+        for (auto& stage : _stages) {
+            stage.pendingShader = Shader();
+            stage.pendingSource.clear();
+            stage.compilePending = false;
+        }
+
+        _dirty = false;
+    }
+}
@@ -0,0 +1,190 @@
+#include "shader_watcher.hpp"
+
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <set>
+#include <stdexcept>
+
+namespace {
+    constexpr std::uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO;
+
+    void splitPath(const std::string& path, std::string& dir, std::string& name) {
+        auto sep = path.find_last_of('/');
+
+        if (std::string::npos == sep) {
+            dir = ".";
+            name = path;
+        } else {
+            dir = path.substr(0, sep);
+            name = path.substr(sep + 1);
+        }
+    }
+
+    bool readFile(const std::string& path, std::string& out) {
+        auto file = std::ifstream(path.c_str(), std::ios::binary);
+
+        if (!file) {
+            return false;
+        }
+
+        auto buffer = std::stringstream();
+        buffer << file.rdbuf();
+        out = buffer.str();
+
+        return true;
+    }
+}
+
+namespace gfx {
+    ShaderWatcher::ShaderWatcher() {
+        _inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        if (_inotifyFd < 0) {
+            auto msg = std::stringstream();
+            msg << "Failed to init inotify: " << std::strerror(errno);
+
+            throw std::runtime_error(msg.str());
+        }
+
+        _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (_wakeFd < 0) {
+            close(_inotifyFd);
+
+            throw std::runtime_error("Failed to create eventfd!");
+        }
+
+        _thread = std::thread(&ShaderWatcher::run, this);
+    }
+
+    ShaderWatcher::~ShaderWatcher() noexcept {
+        std::uint64_t one = 1;
+
+        if (write(_wakeFd, &one, sizeof(one)) < 0) {
+            std::cerr << "[ERROR]: Failed to wake shader watcher thread" << std::endl;
+        }
+
+        _thread.join();
+
+        close(_wakeFd);
+        close(_inotifyFd);
+    }
+
+    void ShaderWatcher::watch(const std::string& path) {
+        std::string dir, name;
+        splitPath(path, dir, name);
+
+        // Watch the parent directory rather than the file itself; editors that save by
+        // renaming a temporary over the original would otherwise drop the watch.
+        auto wd = inotify_add_watch(_inotifyFd, dir.c_str(), WATCH_MASK);
+
+        if (wd < 0) {
+            auto msg = std::stringstream();
+            msg << "Failed to watch directory: \"" << dir << "\": " << std::strerror(errno);
+
+            throw std::runtime_error(msg.str());
+        }
+
+        std::lock_guard<std::mutex> guard(_lock);
+
+        _directories[wd] = dir;
+        _files[dir + "/" + name] = path;
+    }
+
+    std::vector<FileChange> ShaderWatcher::poll() {
+        std::lock_guard<std::mutex> guard(_lock);
+
+        auto out = std::vector<FileChange> ();
+        out.swap(_changes);
+
+        return out;
+    }
+
+    void ShaderWatcher::run() noexcept {
+        alignas(struct inotify_event) char buffer[4096];
+
+        while (true) {
+            pollfd fds[2];
+            fds[0] = { _inotifyFd, POLLIN, 0 };
+            fds[1] = { _wakeFd, POLLIN, 0 };
+
+            if (::poll(fds, 2, -1) < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+
+                std::cerr << "[ERROR]: Shader watcher poll failed: " << std::strerror(errno) << std::endl;
+                return;
+            }
+
+            if (fds[1].revents & POLLIN) {
+                return;
+            }
+
+            auto changed = std::set<std::string> ();
+
+            while (true) {
+                auto len = read(_inotifyFd, buffer, sizeof(buffer));
+
+                if (len <= 0) {
+                    break;
+                }
+
+                std::lock_guard<std::mutex> guard(_lock);
+
+                for (auto ptr = buffer; ptr < buffer + len; ) {
+                    auto event = reinterpret_cast<const struct inotify_event *> (ptr);
+
+                    ptr += sizeof(struct inotify_event) + event->len;
+
+                    if (0 == event->len) {
+                        continue;
+                    }
+
+                    auto dir = _directories.find(event->wd);
+
+                    if (_directories.end() == dir) {
+                        continue;
+                    }
+
+                    auto file = _files.find(dir->second + "/" + event->name);
+
+                    if (_files.end() != file) {
+                        changed.insert(file->second);
+                    }
+                }
+            }
+
+            // Read the new sources here so the render thread only ever has to compile.
+            for (const auto& path : changed) {
+                auto change = FileChange { path, std::string() };
+
+                if (!readFile(path, change.source)) {
+                    continue;
+                }
+
+                std::lock_guard<std::mutex> guard(_lock);
+
+                auto it = std::find_if(_changes.begin(), _changes.end(), [&path](const FileChange& c) {
+                    return c.path == path;
+                });
+
+                if (_changes.end() == it) {
+                    _changes.push_back(std::move(change));
+                } else {
+                    *it = std::move(change);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#include "simd.hpp"
+
+namespace gfx {
+    SimdLevel getBestSimdLevel() noexcept {
+#if defined(__x86_64__)
+        return __builtin_cpu_supports("avx2") ? SimdLevel::AVX2 : SimdLevel::SSE;
+#else
+        return SimdLevel::SCALAR;
+#endif
+    }
+
+    const char * getSimdLevelName(SimdLevel level) noexcept {
+        switch (level) {
+            case SimdLevel::SSE:
+                return "sse";
+
+            case SimdLevel::AVX2:
+                return "avx2";
+
+            default:
+                return "scalar";
+        }
+    }
+}
@@ -0,0 +1,202 @@
+#include "state_cache.hpp"
+
+#include <cstring>
+
+namespace gfx {
+    constexpr GLuint StateCache::UNKNOWN;
+
+    StateCache::StateCache() noexcept {
+        invalidate();
+        resetStats();
+    }
+
+    void StateCache::invalidate() noexcept {
+        _program = UNKNOWN;
+        _drawFramebuffer = UNKNOWN;
+        _readFramebuffer = UNKNOWN;
+        _vertexArray = UNKNOWN;
+        _pVertexArray = nullptr;
+        _uniformBuffers.fill({ UNKNOWN, 0, 0 });
+        _storageBuffers.fill({ UNKNOWN, 0, 0 });
+        _textures.fill(UNKNOWN);
+        _vertexArrays.clear();
+        _uniforms.clear();
+    }
+
+    const StateCacheStats& StateCache::getStats() const noexcept {
+        return _stats;
+    }
+
+    void StateCache::resetStats() noexcept {
+        _stats = { 0, 0 };
+    }
+
+    bool StateCache::issue(bool changed) noexcept {
+        if (changed) {
+            _stats.issued++;
+        } else {
+            _stats.skipped++;
+        }
+
+        return changed;
+    }
+
+    StateCache::BufferRange * StateCache::getBufferRange(GLenum target, GLuint index) noexcept {
+        if (index >= MAX_BUFFER_BINDINGS) {
+            return nullptr;
+        }
+
+        switch (target) {
+            case GL_UNIFORM_BUFFER:
+                return &_uniformBuffers[index];
+
+            case GL_SHADER_STORAGE_BUFFER:
+                return &_storageBuffers[index];
+
+            default:
+                return nullptr;
+        }
+    }
+
+    void StateCache::useProgram(GLuint program) noexcept {
+        if (issue(program != _program)) {
+            _program = program;
+            glUseProgram(program);
+        }
+    }
+
+    void StateCache::bindFramebuffer(GLenum target, GLuint framebuffer) noexcept {
+        auto draw = GL_FRAMEBUFFER == target || GL_DRAW_FRAMEBUFFER == target;
+        auto read = GL_FRAMEBUFFER == target || GL_READ_FRAMEBUFFER == target;
+        auto changed = (draw && framebuffer != _drawFramebuffer) || (read && framebuffer != _readFramebuffer);
+
+        if (issue(changed)) {
+            _drawFramebuffer = draw ? framebuffer : _drawFramebuffer;
+            _readFramebuffer = read ? framebuffer : _readFramebuffer;
+            glBindFramebuffer(target, framebuffer);
+        }
+    }
+
+    void StateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) noexcept {
+        auto pRange = getBufferRange(target, index);
+
+        if (nullptr == pRange) {
+            issue(true);
+            glBindBufferRange(target, index, buffer, offset, size);
+            return;
+        }
+
+        if (issue(buffer != pRange->buffer || offset != pRange->offset || size != pRange->size)) {
+            *pRange = { buffer, offset, size };
+            glBindBufferRange(target, index, buffer, offset, size);
+        }
+    }
+
+    void StateCache::bindTextureUnit(GLuint unit, GLuint texture) noexcept {
+        if (unit >= MAX_TEXTURE_UNITS) {
+            issue(true);
+            glBindTextureUnit(unit, texture);
+            return;
+        }
+
+        if (issue(texture != _textures[unit])) {
+            _textures[unit] = texture;
+            glBindTextureUnit(unit, texture);
+        }
+    }
+
+    void StateCache::bindVertexArray(GLuint vertexArray) {
+        if (!issue(vertexArray != _vertexArray)) {
+            return;
+        }
+
+        _vertexArray = vertexArray;
+        glBindVertexArray(vertexArray);
+
+        // Element and vertex buffer bindings are vertex array state, so they are tracked per array.
+        auto it = _vertexArrays.find(vertexArray);
+
+        if (_vertexArrays.end() == it) {
+            auto state = VertexArray {};
+            state.elementBuffer = UNKNOWN;
+            state.bindings.fill({ UNKNOWN, 0, 0 });
+
+            it = _vertexArrays.emplace(vertexArray, state).first;
+        }
+
+        _pVertexArray = &it->second;
+    }
+
+    void StateCache::bindVertexBuffer(GLuint bindingIndex, GLuint buffer, GLintptr offset, GLsizei stride) noexcept {
+        if (nullptr == _pVertexArray || bindingIndex >= MAX_VERTEX_BINDINGS) {
+            issue(true);
+            glBindVertexBuffer(bindingIndex, buffer, offset, stride);
+            return;
+        }
+
+        auto& binding = _pVertexArray->bindings[bindingIndex];
+
+        if (issue(buffer != binding.buffer || offset != binding.offset || stride != binding.stride)) {
+            binding = { buffer, offset, stride };
+            glBindVertexBuffer(bindingIndex, buffer, offset, stride);
+        }
+    }
+
+    void StateCache::bindElementBuffer(GLuint buffer) noexcept {
+        if (nullptr == _pVertexArray) {
+            issue(true);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+            return;
+        }
+
+        if (issue(buffer != _pVertexArray->elementBuffer)) {
+            _pVertexArray->elementBuffer = buffer;
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+        }
+    }
+
+    bool StateCache::setUniform(GLint location, const UniformValue& value) {
+        if (UNKNOWN == _program || location < 0) {
+            return issue(true);
+        }
+
+        // Uniform values are program state; key them by program and location.
+        auto key = (static_cast<std::uint64_t> (_program) << 32) | static_cast<std::uint32_t> (location);
+        auto it = _uniforms.find(key);
+
+        if (_uniforms.end() != it && value == it->second) {
+            return issue(false);
+        }
+
+        _uniforms[key] = value;
+
+        return issue(true);
+    }
+
+    void StateCache::uniform1i(GLint location, GLint value) {
+        auto bits = UniformValue {};
+        std::memcpy(bits.data(), &value, sizeof(value));
+
+        if (setUniform(location, bits)) {
+            glUniform1i(location, value);
+        }
+    }
+
+    void StateCache::uniform1f(GLint location, GLfloat value) {
+        auto bits = UniformValue {};
+        std::memcpy(bits.data(), &value, sizeof(value));
+
+        if (setUniform(location, bits)) {
+            glUniform1f(location, value);
+        }
+    }
+
+    void StateCache::uniform3fv(GLint location, const GLfloat * pValue) {
+        auto bits = UniformValue {};
+        std::memcpy(bits.data(), pValue, 3 * sizeof(GLfloat));
+
+        if (setUniform(location, bits)) {
+            glUniform3fv(location, 1, pValue);
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#include "test_meshes.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+    constexpr float TWO_PI = 6.2831853F;
+    constexpr float MAJOR_RADIUS = 1.0F;
+    constexpr float MINOR_RADIUS = 0.4F;
+}
+
+namespace gfx {
+    glm::vec3 getGridPosition(std::size_t x, std::size_t y, std::size_t width) noexcept {
+        return glm::vec3(static_cast<float> (x) / width, std::sin(0.1F * x) * std::cos(0.1F * y), static_cast<float> (y) / width);
+    }
+
+    glm::vec2 getGridTexcoord(std::size_t x, std::size_t y, std::size_t width) noexcept {
+        return glm::vec2(static_cast<float> (x) / width, 1.0F - static_cast<float> (y) / width);
+    }
+
+    std::string writeGridObj(std::size_t width) {
+        auto text = std::string();
+        char line[128];
+
+        text.reserve((width + 1) * (width + 1) * 80 + width * width * 64);
+        text += "# gfx grid\no grid\n";
+
+        for (std::size_t y = 0; y <= width; y++) {
+            for (std::size_t x = 0; x <= width; x++) {
+                auto position = getGridPosition(x, y, width);
+                auto texcoord = getGridTexcoord(x, y, width);
+                auto length = std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0.000000 1.000000 0.000000\n",
+                    position.x, position.y, position.z, texcoord.x, texcoord.y);
+
+                text.append(line, length);
+            }
+        }
+
+        for (std::size_t y = 0; y < width; y++) {
+            for (std::size_t x = 0; x < width; x++) {
+                auto a = y * (width + 1) + x + 1;
+                auto b = a + 1;
+                auto c = b + width + 1;
+                auto d = a + width + 1;
+                auto length = std::snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n",
+                    a, a, a, b, b, b, c, c, c, d, d, d);
+
+                text.append(line, length);
+            }
+        }
+
+        return text;
+    }
+    Mesh createTorus(std::size_t rings, std::size_t sides, bool seams) {
+        auto columns = seams ? rings + 1 : rings;
+        auto rows = seams ? sides + 1 : sides;
+        auto mesh = Mesh {};
+
+        for (std::size_t j = 0; j < rows; j++) {
+            for (std::size_t i = 0; i < columns; i++) {
+                auto u = static_cast<float> (i) / rings;
+                auto v = static_cast<float> (j) / sides;
+                auto ring = MAJOR_RADIUS + MINOR_RADIUS * std::cos(TWO_PI * v);
+                auto position = glm::vec3(ring * std::cos(TWO_PI * u), MINOR_RADIUS * std::sin(TWO_PI * v), ring * std::sin(TWO_PI * u));
+                auto normal = glm::vec3(std::cos(TWO_PI * v) * std::cos(TWO_PI * u), std::sin(TWO_PI * v), std::cos(TWO_PI * v) * std::sin(TWO_PI * u));
+
+                mesh.vertices.push_back({ position, glm::vec2(u, v), normal });
+            }
+        }
+
+        for (std::size_t j = 0; j < sides; j++) {
+            for (std::size_t i = 0; i < rings; i++) {
+                auto a = static_cast<std::uint32_t> (j * columns + i);
+                auto b = static_cast<std::uint32_t> (j * columns + (i + 1) % columns);
+                auto c = static_cast<std::uint32_t> ((j + 1) % rows * columns + (i + 1) % columns);
+                auto d = static_cast<std::uint32_t> ((j + 1) % rows * columns + i);
+
+                mesh.indices.insert(mesh.indices.end(), { a, c, b, a, d, c });
+            }
+        }
+
+        mesh.hasTexcoords = true;
+        mesh.hasNormals = true;
+
+        return mesh;
+    }
+}
@@ -0,0 +1,107 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace gfx {
+    ThreadPool::ThreadPool(unsigned int threadCount) {
+        _pTask = nullptr;
+        _taskCount = 0;
+        _nextTask = 0;
+        _busyWorkers = 0;
+        _generation = 0;
+        _stop = false;
+
+        if (0 == threadCount) {
+            threadCount = std::max(std::thread::hardware_concurrency(), 1U);
+        }
+
+        for (unsigned int i = 1; i < threadCount; i++) {
+            _threads.push_back(std::thread(&ThreadPool::work, this));
+        }
+    }
+
+    ThreadPool::~ThreadPool() noexcept {
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _stop = true;
+        }
+
+        _wake.notify_all();
+
+        for (auto& thread : _threads) {
+            thread.join();
+        }
+    }
+
+    unsigned int ThreadPool::getThreadCount() const noexcept {
+        return static_cast<unsigned int> (_threads.size()) + 1;
+    }
+
+    void ThreadPool::drain(const std::function<void (unsigned int)>& task, unsigned int taskCount) noexcept {
+        for (auto i = _nextTask.fetch_add(1); i < taskCount; i = _nextTask.fetch_add(1)) {
+            task(i);
+        }
+    }
+
+    void ThreadPool::work() noexcept {
+        auto generation = 0UL;
+
+        while (true) {
+            auto lock = std::unique_lock<std::mutex> (_lock);
+
+            _wake.wait(lock, [&] {
+                return _stop || generation != _generation;
+            });
+
+            if (_stop) {
+                return;
+            }
+
+            generation = _generation;
+
+            auto pTask = _pTask;
+            auto taskCount = _taskCount;
+
+            lock.unlock();
+
+            drain(*pTask, taskCount);
+
+            lock.lock();
+
+            if (0 == --_busyWorkers) {
+                _done.notify_one();
+            }
+        }
+    }
+
+    void ThreadPool::run(unsigned int taskCount, const std::function<void (unsigned int)>& task) {
+        if (_threads.empty() || taskCount <= 1) {
+            for (unsigned int i = 0; i < taskCount; i++) {
+                task(i);
+            }
+
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+
+            _pTask = &task;
+            _taskCount = taskCount;
+            _nextTask = 0;
+            _busyWorkers = static_cast<unsigned int> (_threads.size());
+            _generation++;
+        }
+
+        _wake.notify_all();
+
+        drain(task, taskCount);
+
+        // Every worker has to check in, even one that woke too late to find work, before the task goes out of scope.
+        auto lock = std::unique_lock<std::mutex> (_lock);
+
+        _done.wait(lock, [this] {
+            return 0 == _busyWorkers;
+        });
+    }
+}
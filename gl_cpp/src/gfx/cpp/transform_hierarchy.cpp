@@ -0,0 +1,290 @@
+#include "transform_hierarchy.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "normal_matrix.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+    constexpr std::uint32_t NO_PARENT = std::numeric_limits<std::uint32_t>::max();
+    constexpr std::uint32_t CHUNK_SIZE = 4096;
+
+    template <typename T>
+    void permute(std::vector<T>& values, const std::vector<std::uint32_t>& order) {
+        auto permuted = std::vector<T> (values.size());
+
+        for (std::size_t i = 0; i < order.size(); i++) {
+            permuted[i] = values[order[i]];
+        }
+
+        values.swap(permuted);
+    }
+
+    // T * R * S with the quaternion expanded in place; the rotation is assumed to be normalized.
+    glm::mat4 composeLocal(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) noexcept {
+        auto x = rotation.x;
+        auto y = rotation.y;
+        auto z = rotation.z;
+        auto w = rotation.w;
+        auto xx = x * x;
+        auto yy = y * y;
+        auto zz = z * z;
+        auto xy = x * y;
+        auto xz = x * z;
+        auto yz = y * z;
+        auto wx = w * x;
+        auto wy = w * y;
+        auto wz = w * z;
+
+        return glm::mat4(
+            glm::vec4(1.0F - 2.0F * (yy + zz), 2.0F * (xy + wz), 2.0F * (xz - wy), 0.0F) * scale.x,
+            glm::vec4(2.0F * (xy - wz), 1.0F - 2.0F * (xx + zz), 2.0F * (yz + wx), 0.0F) * scale.y,
+            glm::vec4(2.0F * (xz + wy), 2.0F * (yz - wx), 1.0F - 2.0F * (xx + yy), 0.0F) * scale.z,
+            glm::vec4(translation, 1.0F));
+    }
+
+    // Both matrices are affine, so the bottom row is skipped: 36 multiplies instead of 64.
+    glm::mat4 composeAffine(const glm::mat4& parent, const glm::mat4& local) noexcept {
+        return glm::mat4(
+            parent[0] * local[0].x + parent[1] * local[0].y + parent[2] * local[0].z,
+            parent[0] * local[1].x + parent[1] * local[1].y + parent[2] * local[1].z,
+            parent[0] * local[2].x + parent[1] * local[2].y + parent[2] * local[2].z,
+            parent[0] * local[3].x + parent[1] * local[3].y + parent[2] * local[3].z + parent[3]);
+    }
+}
+
+namespace gfx {
+    TransformHierarchy::TransformHierarchy() {
+        _needsSort = false;
+    }
+
+    std::size_t TransformHierarchy::size() const noexcept {
+        return _handles.size();
+    }
+
+    std::size_t TransformHierarchy::getLevelCount() const noexcept {
+        return _levelOffsets.empty() ? 0 : _levelOffsets.size() - 1;
+    }
+
+    std::uint32_t TransformHierarchy::append(std::uint32_t parentIndex, std::uint32_t depth, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+        auto handle = static_cast<std::uint32_t> (_indices.size());
+        auto index = static_cast<std::uint32_t> (_handles.size());
+
+        _parents.push_back(parentIndex);
+        _depths.push_back(depth);
+        _translations.push_back(translation);
+        _rotations.push_back(rotation);
+        _scales.push_back(scale);
+        _worlds.push_back(glm::mat4(1.0F));
+        _normals.push_back(glm::mat3x4(1.0F));
+        _dirty.push_back(1);
+        _changed.push_back(0);
+        _handles.push_back(handle);
+        _indices.push_back(index);
+
+        // Level offsets are rebuilt on the next update, even when the new object kept the order.
+        _needsSort = true;
+
+        return handle;
+    }
+
+    std::uint32_t TransformHierarchy::addRoot(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+        return append(NO_PARENT, 0, translation, rotation, scale);
+    }
+
+    std::uint32_t TransformHierarchy::add(std::uint32_t parent, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+        auto parentIndex = _indices[parent];
+
+        return append(parentIndex, _depths[parentIndex] + 1, translation, rotation, scale);
+    }
+
+    void TransformHierarchy::sortByDepth() {
+        auto levelCount = _depths.empty() ? 0 : *std::max_element(_depths.begin(), _depths.end()) + 1;
+
+        _levelOffsets.assign(levelCount + 1, 0);
+
+        for (auto depth : _depths) {
+            _levelOffsets[depth + 1]++;
+        }
+
+        for (std::size_t level = 0; level < levelCount; level++) {
+            _levelOffsets[level + 1] += _levelOffsets[level];
+        }
+
+        // Counting sort by depth, then each level by its parents' new positions, so that a level reads its
+        // parents' world matrices front to back instead of at random. order[new index] is the old index.
+        auto order = std::vector<std::uint32_t> (_depths.size());
+        auto newIndices = std::vector<std::uint32_t> (_depths.size());
+        auto next = _levelOffsets;
+
+        for (std::uint32_t i = 0; i < _depths.size(); i++) {
+            order[next[_depths[i]]++] = i;
+        }
+
+        for (std::size_t level = 0; level < levelCount; level++) {
+            auto begin = order.begin() + _levelOffsets[level];
+            auto end = order.begin() + _levelOffsets[level + 1];
+
+            if (0 < level) {
+                std::stable_sort(begin, end, [&] (std::uint32_t a, std::uint32_t b) {
+                    return newIndices[_parents[a]] < newIndices[_parents[b]];
+                });
+            }
+
+            for (auto i = _levelOffsets[level]; i < _levelOffsets[level + 1]; i++) {
+                newIndices[order[i]] = i;
+            }
+        }
+
+        _needsSort = false;
+
+        auto sorted = true;
+
+        for (std::uint32_t i = 0; i < order.size() && sorted; i++) {
+            sorted = order[i] == i;
+        }
+
+        if (sorted) {
+            return;
+        }
+
+        permute(_parents, order);
+        permute(_depths, order);
+        permute(_translations, order);
+        permute(_rotations, order);
+        permute(_scales, order);
+        permute(_worlds, order);
+        permute(_normals, order);
+        permute(_dirty, order);
+        permute(_changed, order);
+        permute(_handles, order);
+
+        for (auto& parent : _parents) {
+            parent = NO_PARENT == parent ? NO_PARENT : newIndices[parent];
+        }
+
+        for (std::uint32_t i = 0; i < _handles.size(); i++) {
+            _indices[_handles[i]] = i;
+        }
+    }
+
+    std::uint32_t TransformHierarchy::getParent(std::uint32_t handle) const noexcept {
+        auto parent = _parents[_indices[handle]];
+
+        return NO_PARENT == parent ? handle : _handles[parent];
+    }
+
+    bool TransformHierarchy::isRoot(std::uint32_t handle) const noexcept {
+        return NO_PARENT == _parents[_indices[handle]];
+    }
+
+    void TransformHierarchy::setTranslation(std::uint32_t handle, const glm::vec3& translation) noexcept {
+        auto index = _indices[handle];
+
+        _translations[index] = translation;
+        _dirty[index] = 1;
+    }
+
+    void TransformHierarchy::setRotation(std::uint32_t handle, const glm::quat& rotation) noexcept {
+        auto index = _indices[handle];
+
+        _rotations[index] = rotation;
+        _dirty[index] = 1;
+    }
+
+    void TransformHierarchy::setScale(std::uint32_t handle, const glm::vec3& scale) noexcept {
+        auto index = _indices[handle];
+
+        _scales[index] = scale;
+        _dirty[index] = 1;
+    }
+
+    void TransformHierarchy::setLocal(std::uint32_t handle, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) noexcept {
+        auto index = _indices[handle];
+
+        _translations[index] = translation;
+        _rotations[index] = rotation;
+        _scales[index] = scale;
+        _dirty[index] = 1;
+    }
+
+    const glm::vec3& TransformHierarchy::getTranslation(std::uint32_t handle) const noexcept {
+        return _translations[_indices[handle]];
+    }
+
+    const glm::quat& TransformHierarchy::getRotation(std::uint32_t handle) const noexcept {
+        return _rotations[_indices[handle]];
+    }
+
+    const glm::vec3& TransformHierarchy::getScale(std::uint32_t handle) const noexcept {
+        return _scales[_indices[handle]];
+    }
+
+    const glm::mat4& TransformHierarchy::getWorld(std::uint32_t handle) const noexcept {
+        return _worlds[_indices[handle]];
+    }
+
+    const glm::mat3x4& TransformHierarchy::getNormal(std::uint32_t handle) const noexcept {
+        return _normals[_indices[handle]];
+    }
+
+    bool TransformHierarchy::wasUpdated(std::uint32_t handle) const noexcept {
+        return 0 != _changed[_indices[handle]];
+    }
+
+    // Parents live in an earlier level, so their _changed flags and world matrices are already final.
+    void TransformHierarchy::updateRange(std::uint32_t begin, std::uint32_t end) noexcept {
+        auto runBegin = end;
+
+        for (auto i = begin; i < end; i++) {
+            auto parent = _parents[i];
+            auto changed = 0 != _dirty[i] || (NO_PARENT != parent && 0 != _changed[parent]);
+
+            _changed[i] = changed ? 1 : 0;
+            _dirty[i] = 0;
+
+            // Normal matrices are computed in batches, one per run of consecutive changed objects.
+            if (!changed) {
+                if (runBegin < i) {
+                    computeNormalMatrices(&_worlds[runBegin], i - runBegin, &_normals[runBegin], sizeof(glm::mat3x4));
+                }
+
+                runBegin = end;
+                continue;
+            }
+
+            auto local = composeLocal(_translations[i], _rotations[i], _scales[i]);
+
+            _worlds[i] = NO_PARENT == parent ? local : composeAffine(_worlds[parent], local);
+            runBegin = std::min(runBegin, i);
+        }
+
+        if (runBegin < end) {
+            computeNormalMatrices(&_worlds[runBegin], end - runBegin, &_normals[runBegin], sizeof(glm::mat3x4));
+        }
+    }
+
+    void TransformHierarchy::update(ThreadPool * pThreadPool) {
+        if (_needsSort) {
+            sortByDepth();
+        }
+
+        for (std::size_t level = 0; level < getLevelCount(); level++) {
+            auto begin = _levelOffsets[level];
+            auto end = _levelOffsets[level + 1];
+            auto chunks = (end - begin + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+            if (nullptr == pThreadPool || chunks < 2) {
+                updateRange(begin, end);
+                continue;
+            }
+
+            pThreadPool->run(chunks, [&] (unsigned int chunk) {
+                auto chunkBegin = begin + chunk * CHUNK_SIZE;
+
+                updateRange(chunkBegin, std::min(chunkBegin + CHUNK_SIZE, end));
+            });
+        }
+    }
+}
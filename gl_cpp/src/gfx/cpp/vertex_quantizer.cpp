@@ -0,0 +1,158 @@
+#include "vertex_quantizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include <glm/gtc/packing.hpp>
+
+namespace {
+    constexpr float SNORM16_MAX = 32767.0F;
+    constexpr float DEGREES_PER_RADIAN = 57.2957795F;
+
+    // Octahedral mapping of a unit vector onto [-1, 1]^2, the lower hemisphere folded over the diagonals.
+    glm::vec2 encodeOctahedral(const glm::vec3& n) noexcept {
+        auto sum = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+
+        if (0.0F == sum) {
+            return glm::vec2(0.0F);
+        }
+
+        auto x = n.x / sum;
+        auto y = n.y / sum;
+
+        if (n.z < 0.0F) {
+            auto foldedX = (1.0F - std::fabs(y)) * (x >= 0.0F ? 1.0F : -1.0F);
+            auto foldedY = (1.0F - std::fabs(x)) * (y >= 0.0F ? 1.0F : -1.0F);
+
+            x = foldedX;
+            y = foldedY;
+        }
+
+        return glm::vec2(x, y);
+    }
+
+    // The same decode as lighting.vert.
+    glm::vec3 decodeOctahedral(const glm::vec2& e) noexcept {
+        auto n = glm::vec3(e.x, e.y, 1.0F - std::fabs(e.x) - std::fabs(e.y));
+        auto t = std::min(std::max(-n.z, 0.0F), 1.0F);
+
+        n.x += n.x >= 0.0F ? -t : t;
+        n.y += n.y >= 0.0F ? -t : t;
+
+        return glm::normalize(n);
+    }
+
+    float unpackSnorm16(std::int16_t value) noexcept {
+        return std::max(value / SNORM16_MAX, -1.0F);
+    }
+
+    float unpackUnorm16(std::uint16_t value) noexcept {
+        return glm::unpackUnorm1x16(value);
+    }
+
+    // acos loses everything below a few hundredths of a degree in float.
+    float getAngle(const glm::vec3& a, const glm::vec3& b) noexcept {
+        return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)) * DEGREES_PER_RADIAN;
+    }
+}
+
+namespace gfx {
+    QuantizedVertices quantizeVertices(const std::vector<Vertex>& vertices) {
+        auto quantized = QuantizedVertices { std::vector<PackedVertex> (vertices.size()), glm::vec3(0.0F), glm::vec3(0.0F) };
+
+        if (vertices.empty()) {
+            return quantized;
+        }
+
+        auto boundsMin = vertices[0].position;
+        auto boundsMax = boundsMin;
+
+        for (const auto& vertex : vertices) {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
+
+        quantized.positionOffset = boundsMin;
+        quantized.positionScale = boundsMax - boundsMin;
+
+        for (std::size_t i = 0; i < vertices.size(); i++) {
+            const auto& vertex = vertices[i];
+            auto& packed = quantized.vertices[i];
+
+            for (int axis = 0; axis < 3; axis++) {
+                auto extent = quantized.positionScale[axis];
+                auto position = 0.0F < extent ? (vertex.position[axis] - boundsMin[axis]) / extent : 0.0F;
+
+                packed.position[axis] = glm::packUnorm1x16(position);
+            }
+
+            packed.reserved = 0;
+            packed.texcoord[0] = glm::packHalf1x16(vertex.texcoord.x);
+            packed.texcoord[1] = glm::packHalf1x16(vertex.texcoord.y);
+
+            // Rounding each coordinate to nearest isn't always the closest code; try all four neighbours.
+            auto normal = glm::length(vertex.normal) > 0.0F ? glm::normalize(vertex.normal) : glm::vec3(0.0F, 0.0F, 1.0F);
+            auto encoded = encodeOctahedral(normal) * SNORM16_MAX;
+            auto bestDot = -2.0F;
+
+            for (int corner = 0; corner < 4; corner++) {
+                auto x = static_cast<std::int16_t> (0 == (corner & 1) ? std::floor(encoded.x) : std::ceil(encoded.x));
+                auto y = static_cast<std::int16_t> (0 == (corner & 2) ? std::floor(encoded.y) : std::ceil(encoded.y));
+                auto dot = glm::dot(normal, decodeOctahedral(glm::vec2(unpackSnorm16(x), unpackSnorm16(y))));
+
+                if (dot > bestDot) {
+                    bestDot = dot;
+                    packed.normal[0] = x;
+                    packed.normal[1] = y;
+                }
+            }
+        }
+
+        return quantized;
+    }
+
+    Vertex dequantizeVertex(const PackedVertex& vertex, const glm::vec3& positionOffset, const glm::vec3& positionScale) noexcept {
+        auto position = glm::vec3(unpackUnorm16(vertex.position[0]), unpackUnorm16(vertex.position[1]), unpackUnorm16(vertex.position[2]));
+
+        return {
+            positionOffset + position * positionScale,
+            glm::vec2(glm::unpackHalf1x16(vertex.texcoord[0]), glm::unpackHalf1x16(vertex.texcoord[1])),
+            decodeOctahedral(glm::vec2(unpackSnorm16(vertex.normal[0]), unpackSnorm16(vertex.normal[1])))
+        };
+    }
+
+    QuantizationError getQuantizationError(const std::vector<Vertex>& vertices, const QuantizedVertices& quantized) noexcept {
+        auto error = QuantizationError { 0.0F, 0.0F, 0.0F, 0.0F };
+        auto angleSum = 0.0;
+
+        for (std::size_t i = 0; i < vertices.size(); i++) {
+            const auto& vertex = vertices[i];
+            auto decoded = dequantizeVertex(quantized.vertices[i], quantized.positionOffset, quantized.positionScale);
+            auto texcoordError = glm::abs(decoded.texcoord - vertex.texcoord);
+            auto normal = glm::length(vertex.normal) > 0.0F ? glm::normalize(vertex.normal) : glm::vec3(0.0F, 0.0F, 1.0F);
+            auto angle = getAngle(decoded.normal, normal);
+
+            error.maxPosition = std::max(error.maxPosition, glm::length(decoded.position - vertex.position));
+            error.maxTexcoord = std::max(error.maxTexcoord, std::max(texcoordError.x, texcoordError.y));
+            error.maxNormalAngle = std::max(error.maxNormalAngle, angle);
+            angleSum += angle;
+        }
+
+        error.meanNormalAngle = vertices.empty() ? 0.0F : static_cast<float> (angleSum / vertices.size());
+
+        return error;
+    }
+
+    void setPackedVertexFormat(GLuint vertexArray, GLuint bindingIndex) noexcept {
+        glEnableVertexArrayAttrib(vertexArray, 0);
+        glVertexArrayAttribFormat(vertexArray, 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(PackedVertex, position));
+        glVertexArrayAttribBinding(vertexArray, 0, bindingIndex);
+        glEnableVertexArrayAttrib(vertexArray, 1);
+        glVertexArrayAttribFormat(vertexArray, 1, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedVertex, texcoord));
+        glVertexArrayAttribBinding(vertexArray, 1, bindingIndex);
+        glEnableVertexArrayAttrib(vertexArray, 2);
+        glVertexArrayAttribFormat(vertexArray, 2, 2, GL_SHORT, GL_TRUE, offsetof(PackedVertex, normal));
+        glVertexArrayAttribBinding(vertexArray, 2, bindingIndex);
+    }
+}
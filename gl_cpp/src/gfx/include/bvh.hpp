@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace gfx {
+    class ThreadPool;
+
+    struct Aabb {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    struct RayHit {
+        std::uint32_t object;
+        float distance;
+    };
+
+    // Interior nodes have count 0 and their children at first and first + 1; leaves own objects [first, first + count).
+    struct BvhNode {
+        glm::vec3 min;
+        std::uint32_t first;
+        glm::vec3 max;
+        std::uint32_t count;
+    };
+
+    class Bvh {
+        std::vector<Aabb> _bounds;
+        std::vector<glm::vec3> _centroids;
+        std::vector<BvhNode> _nodes;
+        std::vector<std::uint32_t> _objects;
+        std::vector<std::uint32_t> _parents;
+        std::vector<std::uint32_t> _leaves;
+        std::vector<std::uint32_t> _dirtyObjects;
+        std::vector<std::uint8_t> _dirtyNodes;
+        std::vector<std::uint32_t> _refitNodes;
+        double _nodeCost;
+        float _builtCost;
+
+        Bvh(const Bvh&) = delete;
+
+        Bvh& operator= (const Bvh&) = delete;
+
+        void linkNodes();
+
+    public:
+        explicit Bvh(std::size_t count = 0);
+
+        std::size_t size() const noexcept;
+
+        // Drops the tree; call build() before querying again.
+        void resize(std::size_t count);
+
+        const Aabb& getBounds(std::size_t index) const noexcept;
+
+        // Takes effect on the next refit() or build().
+        void setBounds(std::size_t index, const Aabb& bounds);
+
+        const std::vector<BvhNode>& getNodes() const noexcept;
+
+        // Expected traversal cost relative to the root: sum of node areas weighted by their work, over the root area.
+        // The sum is kept up to date by build() and refit(), so this is constant time.
+        float getSahCost() const noexcept;
+
+        // The cost right after the last build; a refit tree drifts above it as objects move.
+        float getBuiltSahCost() const noexcept;
+
+        // Binned SAH, top-down. With a pool the upper levels are split on the calling thread and the
+        // subtrees below them are built in parallel.
+        void build(ThreadPool * pThreadPool = nullptr);
+
+        // Recomputes only the nodes above objects whose bounds changed, keeping the topology.
+        void refit();
+
+        // Appends the objects whose bounds intersect the frustum of trProj * trView.
+        void queryFrustum(const glm::mat4& viewProj, std::vector<std::uint32_t>& objects) const;
+
+        // Appends the objects whose bounds intersect the sphere, e.g. a point light's range.
+        void querySphere(const glm::vec3& center, float radius, std::vector<std::uint32_t>& objects) const;
+
+        // Nearest object whose bounds the ray enters within maxDistance; distance is 0 when it starts inside.
+        bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const noexcept;
+    };
+}
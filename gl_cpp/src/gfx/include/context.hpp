@@ -0,0 +1,85 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <memory>
+#include <string>
+
+namespace gfx {
+    struct ContextInfo {
+        std::string title;
+        int width;
+        int height;
+        int versionMajor;
+        int versionMinor;
+        bool headless;
+        unsigned int frames;
+        std::string screenshot;
+        std::string benchmark;
+        unsigned int warmupFrames;
+        std::string trace;
+        bool glStats;
+    };
+
+    class FrameBenchmark;
+
+    // Parses a whole decimal command line value, throwing std::runtime_error naming option otherwise.
+    unsigned long parseNumber(const char * arg, const char * option);
+
+    // Parses a whole finite decimal command line value, throwing std::runtime_error naming option otherwise.
+    float parseFloat(const char * arg, const char * option);
+
+    // The value after the option at argv[i], advancing i to it; throws std::runtime_error when it is missing.
+    const char * getOptionValue(int argc, char** argv, int& i);
+
+    ContextInfo parseContextInfo(int argc, char** argv, const std::string& title);
+
+    class Context {
+        ContextInfo _info;
+        unsigned int _frame;
+        std::unique_ptr<FrameBenchmark> _pBenchmark;
+
+        Context(const Context&) = delete;
+
+        Context& operator= (const Context&) = delete;
+
+        void writeScreenshot() const;
+
+        unsigned int getTotalFrames() const noexcept;
+
+    protected:
+        explicit Context(const ContextInfo& info) noexcept;
+
+        void releaseBenchmark() noexcept;
+
+        virtual bool isCloseRequested() const noexcept = 0;
+
+        virtual void present() noexcept = 0;
+
+    public:
+        static std::unique_ptr<Context> create(const ContextInfo& info);
+
+        virtual ~Context() noexcept;
+
+        virtual GLFWwindow * getWindow() const noexcept = 0;
+
+        virtual GLuint getFramebuffer() const noexcept = 0;
+
+        virtual void setTitle(const std::string& title) noexcept = 0;
+
+        virtual void pollEvents() noexcept = 0;
+
+        const ContextInfo& getInfo() const noexcept;
+
+        int getWidth() const noexcept;
+
+        int getHeight() const noexcept;
+
+        unsigned int getFrame() const noexcept;
+
+        bool shouldClose() const noexcept;
+
+        void swapBuffers();
+    };
+}
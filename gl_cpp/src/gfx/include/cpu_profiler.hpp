@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+#define GFX_CPU_ZONE_CONCAT_IMPL(a, b) a##b
+#define GFX_CPU_ZONE_CONCAT(a, b) GFX_CPU_ZONE_CONCAT_IMPL(a, b)
+#define GFX_CPU_ZONE(name) gfx::CpuZone GFX_CPU_ZONE_CONCAT(cpuZone, __LINE__) (name)
+
+namespace gfx {
+    class CpuProfiler {
+        static std::atomic<bool> _enabled;
+
+        CpuProfiler() = delete;
+
+    public:
+        static bool isEnabled() noexcept;
+
+        static void setEnabled(bool enabled) noexcept;
+
+        static void setThreadName(const std::string& name);
+
+        static std::uint64_t now() noexcept;
+
+        // Zone names must outlive the profiler; string literals are expected.
+        static void record(const char * name, std::uint64_t begin, std::uint64_t end) noexcept;
+
+        static std::size_t writeChromeTrace(const std::string& path);
+    };
+
+    class CpuZone {
+        const char * _name;
+        std::uint64_t _begin;
+
+        CpuZone(const CpuZone&) = delete;
+
+        CpuZone& operator= (const CpuZone&) = delete;
+
+    public:
+        explicit CpuZone(const char * name) noexcept;
+
+        ~CpuZone() noexcept;
+    };
+
+    inline bool CpuProfiler::isEnabled() noexcept {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    inline std::uint64_t CpuProfiler::now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        // Ticks are converted to time only when exporting, keeping the per-zone cost to two TSC reads.
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    inline CpuZone::CpuZone(const char * name) noexcept {
+        _name = name;
+        _begin = CpuProfiler::isEnabled() ? CpuProfiler::now() : 0;
+    }
+
+    inline CpuZone::~CpuZone() noexcept {
+        if (_begin) {
+            CpuProfiler::record(_name, _begin, CpuProfiler::now());
+        }
+    }
+}
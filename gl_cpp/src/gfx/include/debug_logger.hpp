@@ -0,0 +1,62 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace gfx {
+    class DebugLogger {
+        struct Message;
+        struct Counter;
+
+        struct Reported {
+            std::string text;
+            bool error;
+            unsigned long printed;
+        };
+
+        std::ostream& _out;
+        std::unique_ptr<Message[]> _ring;
+        std::unique_ptr<Counter[]> _counters;
+        std::atomic<std::size_t> _enqueuePos;
+        std::size_t _dequeuePos;
+        std::atomic<unsigned long> _dropped;
+        std::map<std::uint64_t, Reported> _reported;
+        std::mutex _lock;
+        std::condition_variable _wake;
+        bool _stop;
+        std::thread _thread;
+
+        DebugLogger(const DebugLogger&) = delete;
+
+        DebugLogger& operator= (const DebugLogger&) = delete;
+
+        static void GLAPIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar * message, const void * userParam);
+
+        void push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar * message) noexcept;
+
+        bool drain();
+
+        bool reportRepeats();
+
+        void run() noexcept;
+
+    public:
+        explicit DebugLogger(std::ostream& out = std::cerr);
+
+        ~DebugLogger() noexcept;
+
+        void setFilter(GLenum source, GLenum type, GLenum severity, bool enabled) noexcept;
+
+        unsigned long getDropped() const noexcept;
+    };
+}
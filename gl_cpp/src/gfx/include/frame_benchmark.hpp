@@ -0,0 +1,42 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace gfx {
+    struct ContextInfo;
+
+    class FrameBenchmark {
+        std::string _name;
+        std::string _path;
+        int _width;
+        int _height;
+        unsigned int _warmupFrames;
+        unsigned int _frames;
+        unsigned int _frame;
+        std::vector<GLuint> _queries;
+        std::vector<double> _cpuTimes;
+        std::chrono::steady_clock::time_point _lastPresent;
+        bool _finished;
+
+        FrameBenchmark(const FrameBenchmark&) = delete;
+
+        FrameBenchmark& operator= (const FrameBenchmark&) = delete;
+
+        void finish();
+
+    public:
+        explicit FrameBenchmark(const ContextInfo& info);
+
+        ~FrameBenchmark() noexcept;
+
+        void beforePresent() noexcept;
+
+        void afterPresent();
+
+        void release() noexcept;
+    };
+}
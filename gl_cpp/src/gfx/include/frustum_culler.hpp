@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "simd.hpp"
+
+namespace gfx {
+    class ThreadPool;
+
+    class FrustumCuller {
+        std::size_t _count;
+        std::vector<float> _centerX;
+        std::vector<float> _centerY;
+        std::vector<float> _centerZ;
+        std::vector<float> _extentX;
+        std::vector<float> _extentY;
+        std::vector<float> _extentZ;
+        std::vector<float> _radius;
+        std::vector<std::vector<std::uint32_t>> _partitions;
+        std::vector<std::size_t> _partitionSizes;
+        SimdLevel _simdLevel;
+
+        FrustumCuller(const FrustumCuller&) = delete;
+
+        FrustumCuller& operator= (const FrustumCuller&) = delete;
+
+    public:
+        // Gribb/Hartmann extraction from trProj * trView; normals point inwards and are normalized.
+        static std::array<glm::vec4, 6> extractPlanes(const glm::mat4& viewProj) noexcept;
+
+        explicit FrustumCuller(std::size_t count = 0);
+
+        std::size_t size() const noexcept;
+
+        void resize(std::size_t count);
+
+        SimdLevel getSimdLevel() const noexcept;
+
+        // Levels the CPU doesn't support fall back to the best one it does.
+        void setSimdLevel(SimdLevel level) noexcept;
+
+        // Every object keeps a box and a bounding sphere; it is culled when either lies outside a plane.
+        void setSphere(std::size_t index, const glm::vec3& center, float radius) noexcept;
+
+        void setBox(std::size_t index, const glm::vec3& min, const glm::vec3& max) noexcept;
+
+        // Replaces visible with the ascending indices of the objects that intersect the frustum.
+        void cull(const glm::mat4& viewProj, std::vector<std::uint32_t>& visible, ThreadPool * pThreadPool = nullptr);
+    };
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+namespace gfx {
+    // Counts GL calls by swapping GLEW's function pointers for counting wrappers: every core entry point
+    // from GL 1.2 to 4.6 and the extensions the repo uses, with binding and uniform calls also checked for
+    // redundancy. GL 1.0 and 1.1 functions such as glClear, glEnable or glDrawElements don't go through
+    // GLEW, so gfx defines them itself, forwarding to libGL and counting while installed; glEnable,
+    // glDisable, glBindTexture and the fixed-function setters like glDepthFunc are checked for redundancy.
+    // Only the 1.x functions in the core profile are covered.
+    class GlStats {
+        GlStats() = delete;
+
+    public:
+        static bool isInstalled() noexcept;
+
+        static void install() noexcept;
+
+        static void uninstall() noexcept;
+
+        static void endFrame() noexcept;
+
+        static void report(std::ostream& out, std::size_t top = 10);
+    };
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#define GFX_GPU_SCOPE_CONCAT_IMPL(a, b) a##b
+#define GFX_GPU_SCOPE_CONCAT(a, b) GFX_GPU_SCOPE_CONCAT_IMPL(a, b)
+#define GFX_GPU_SCOPE(profiler, name) gfx::GpuScope GFX_GPU_SCOPE_CONCAT(gpuScope, __LINE__) ((profiler), (name))
+
+namespace gfx {
+    struct GpuScopeStats {
+        std::string name;
+        unsigned int depth;
+        double averageMs;
+        double lastMs;
+        unsigned long samples;
+        bool active;
+    };
+
+    class GpuProfiler {
+        struct Marker {
+            const char * name;
+            unsigned int depth;
+            std::size_t beginQuery;
+            std::size_t endQuery;
+        };
+
+        struct Frame {
+            std::vector<GLuint> queries;
+            std::vector<Marker> markers;
+            std::size_t usedQueries;
+            bool pending;
+        };
+
+        struct Stats {
+            std::size_t order;
+            unsigned int depth;
+            double averageMs;
+            double lastMs;
+            unsigned long samples;
+            unsigned long lastCollected;
+        };
+
+        std::vector<Frame> _frames;
+        std::size_t _current;
+        std::vector<std::size_t> _stack;
+        std::map<std::string, Stats> _stats;
+        unsigned long _droppedFrames;
+        unsigned long _collectedFrames;
+
+        GpuProfiler(const GpuProfiler&) = delete;
+
+        GpuProfiler& operator= (const GpuProfiler&) = delete;
+
+        std::size_t timestamp();
+
+        bool isAvailable(const Frame& frame) const noexcept;
+
+        void collect(Frame& frame);
+
+    public:
+        explicit GpuProfiler(std::size_t latency = 4);
+
+        ~GpuProfiler() noexcept;
+
+        void beginFrame();
+
+        void endFrame();
+
+        void beginScope(const char * name);
+
+        void endScope();
+
+        std::vector<GpuScopeStats> getStats() const;
+
+        unsigned long getDroppedFrames() const noexcept;
+
+        void report(std::ostream& out) const;
+    };
+
+    class GpuScope {
+        GpuProfiler& _profiler;
+
+        GpuScope(const GpuScope&) = delete;
+
+        GpuScope& operator= (const GpuScope&) = delete;
+
+    public:
+        GpuScope(GpuProfiler& profiler, const char * name);
+
+        ~GpuScope();
+    };
+
+    inline GpuScope::GpuScope(GpuProfiler& profiler, const char * name) : _profiler(profiler) {
+        _profiler.beginScope(name);
+    }
+
+    inline GpuScope::~GpuScope() {
+        _profiler.endScope();
+    }
+}
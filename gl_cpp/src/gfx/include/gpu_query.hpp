@@ -0,0 +1,37 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <array>
+#include <cstddef>
+
+namespace gfx {
+    class GpuQuery {
+        static constexpr std::size_t LATENCY = 4;
+
+        GLenum _target;
+        std::array<GLuint, LATENCY> _queries;
+        std::array<bool, LATENCY> _pending;
+        std::size_t _next;
+        bool _active;
+        double _average;
+        bool _hasAverage;
+
+        GpuQuery(const GpuQuery&) = delete;
+
+        GpuQuery& operator= (const GpuQuery&) = delete;
+
+        void collect() noexcept;
+
+    public:
+        explicit GpuQuery(GLenum target) noexcept;
+
+        ~GpuQuery() noexcept;
+
+        void begin() noexcept;
+
+        void end() noexcept;
+
+        double getAverage() const noexcept;
+    };
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "shader_program.hpp"
+
+namespace gfx {
+    // Box layout read by the cull shader: a std430 array of { vec4 min; vec4 max; }, w unused.
+    struct HiZBox {
+        glm::vec4 min;
+        glm::vec4 max;
+    };
+
+    class HiZCuller {
+        int _width;
+        int _height;
+        int _levels;
+        GLuint _pyramid;
+        glm::mat4 _viewProj;
+        std::unique_ptr<ShaderProgram> _pReduceProgram;
+        std::unique_ptr<ShaderProgram> _pCullProgram;
+
+        HiZCuller(const HiZCuller&) = delete;
+
+        HiZCuller& operator= (const HiZCuller&) = delete;
+
+    public:
+        HiZCuller(int width, int height);
+
+        ~HiZCuller() noexcept;
+
+        GLuint getPyramidHandle() const noexcept;
+
+        int getLevelCount() const noexcept;
+
+        // The view the pyramid was built from; cull() projects boxes with it.
+        const glm::mat4& getViewProj() const noexcept;
+
+        // Clears the pyramid to the far plane, so the next cull() keeps everything inside viewProj's frustum.
+        // Needed before the first frame and after camera cuts, when last frame's depth says nothing about this one.
+        void reset(const glm::mat4& viewProj);
+
+        // Reduces a depth texture of the pyramid's size, rendered with viewProj, into a max-depth mip chain.
+        void build(GLuint depthTexture, const glm::mat4& viewProj);
+
+        // Tests count boxes against the last pyramid. Survivors' indices are appended to visibleBuffer by bumping
+        // instanceCount of the DrawElementsIndirectCommand in commandBuffer, which the caller resets beforehand.
+        void cull(GLuint boundsBuffer, GLuint count, GLuint visibleBuffer, GLuint commandBuffer);
+    };
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+namespace gfx {
+    // Matches the layout glMultiDrawElementsIndirect reads, and a std430 array of the same struct.
+    struct DrawElementsIndirectCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    class IndirectBatch {
+        GLsizei _capacity;
+        std::vector<DrawElementsIndirectCommand> _commands;
+        GLuint _commandBuffer;
+        GLuint _culledBuffer;
+        GLuint _drawIdBuffer;
+        bool _dirty;
+
+        IndirectBatch(const IndirectBatch&) = delete;
+
+        IndirectBatch& operator= (const IndirectBatch&) = delete;
+
+    public:
+        explicit IndirectBatch(GLsizei capacity);
+
+        ~IndirectBatch() noexcept;
+
+        GLsizei size() const noexcept;
+
+        const std::vector<DrawElementsIndirectCommand>& getCommands() const noexcept;
+
+        GLuint getCommandHandle() const noexcept;
+
+        GLuint getCulledHandle() const noexcept;
+
+        void clear() noexcept;
+
+        // Returns the draw id, which is also the command's baseInstance.
+        GLuint add(GLuint count, GLuint firstIndex, GLint baseVertex);
+
+        void flush();
+
+        // Feeds the draw id to a per-instance integer attribute; with one instance per command it equals
+        // gl_BaseInstance, without requiring GL 4.6 or ARB_shader_draw_parameters.
+        void attachDrawIds(GLuint vertexArray, GLuint attribIndex, GLuint bindingIndex) const noexcept;
+
+        // Binds the source commands and the culled output as SSBOs for a compute pass, which rewrites
+        // instanceCount per command. Issue glMemoryBarrier(GL_COMMAND_BARRIER_BIT) before drawCulled().
+        void bindForCulling(GLuint sourceIndex, GLuint culledIndex) const noexcept;
+
+        void draw(GLenum indexType) const noexcept;
+
+        void drawCulled(GLenum indexType) const noexcept;
+    };
+}
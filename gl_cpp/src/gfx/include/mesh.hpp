@@ -0,0 +1,34 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace gfx {
+    // The interleaved layout the tutorials bind: position at 0, texcoord at 12, normal at 20.
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec2 texcoord;
+        glm::vec3 normal;
+    };
+
+    // An indexed triangle list. Indices are kept 32-bit on the CPU and narrowed for upload.
+    struct Mesh {
+        std::vector<Vertex> vertices;
+        std::vector<std::uint32_t> indices;
+        bool hasTexcoords = false;
+        bool hasNormals = false;
+
+        // GL_UNSIGNED_SHORT when every vertex is addressable with 16 bits, GL_UNSIGNED_INT otherwise.
+        GLenum getIndexType() const noexcept;
+
+        std::size_t getIndexSize() const noexcept;
+
+        // The indices in getIndexType()'s width, ready for glNamedBufferData.
+        std::vector<std::uint8_t> packIndices() const;
+    };
+}
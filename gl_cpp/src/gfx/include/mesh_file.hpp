@@ -0,0 +1,137 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh.hpp"
+
+namespace gfx {
+    // A mesh file is, little-endian and with every block 64-byte aligned:
+    //
+    //   MeshFileHeader | MeshFileStream[streamCount] | MeshFileAttribute[attributeCount] | MeshFileLod[lodCount]
+    //   | stream data ... | index data
+    //
+    // Vertex streams and indices are stored exactly as GL consumes them, so loading maps the file and hands
+    // pointers into it to glNamedBufferStorage; nothing is parsed or copied on the CPU.
+    constexpr std::uint32_t MESH_FILE_MAGIC = 0x4853454D;
+    constexpr std::uint32_t MESH_FILE_VERSION = 1;
+    constexpr std::uint32_t MESH_FILE_TEXCOORDS = 1;
+    constexpr std::uint32_t MESH_FILE_NORMALS = 2;
+
+    struct MeshFileHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t fileSize;
+        std::uint32_t flags;
+        std::uint32_t streamCount;
+        std::uint32_t attributeCount;
+        std::uint32_t lodCount;
+        std::uint32_t vertexCount;
+        std::uint32_t indexCount;
+        std::uint32_t indexType;
+        std::uint32_t reserved;
+        std::uint64_t indexOffset;
+        std::uint64_t indexSize;
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        glm::vec4 boundingSphere;
+    };
+
+    // One vertex buffer; its index is the vertex array binding it is attached to.
+    struct MeshFileStream {
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::uint32_t stride;
+        std::uint32_t reserved;
+    };
+
+    // The arguments of glVertexArrayAttribFormat and glVertexArrayAttribBinding.
+    struct MeshFileAttribute {
+        std::uint32_t location;
+        std::uint32_t stream;
+        std::uint32_t components;
+        std::uint32_t type;
+        std::uint32_t normalized;
+        std::uint32_t offset;
+    };
+
+    // LOD 0 is the full mesh; every LOD draws indexCount indices from firstIndex against the same vertices.
+    // error is the object-space distance the LOD may deviate from the full mesh.
+    struct MeshFileLod {
+        std::uint32_t firstIndex;
+        std::uint32_t indexCount;
+        float error;
+        std::uint32_t reserved;
+    };
+
+    // Positions go to stream 0 and texcoords and normals to stream 1, so depth-only passes fetch 12 bytes per
+    // vertex. mesh.indices holds every LOD back to back; without lods, a single LOD covers all of them.
+    void writeMeshFile(const std::string& path, const Mesh& mesh, const std::vector<MeshFileLod>& lods = std::vector<MeshFileLod> ());
+
+    // A read-only mapping of a mesh file, validated on open. Pages are faulted in as GL reads them.
+    class MeshFile {
+        const std::uint8_t * _pData;
+        std::size_t _size;
+
+        MeshFile(const MeshFile&) = delete;
+
+        MeshFile& operator= (const MeshFile&) = delete;
+
+    public:
+        explicit MeshFile(const std::string& path);
+
+        ~MeshFile() noexcept;
+
+        const MeshFileHeader& getHeader() const noexcept;
+
+        const MeshFileStream& getStream(std::uint32_t index) const noexcept;
+
+        const MeshFileAttribute& getAttribute(std::uint32_t index) const noexcept;
+
+        const MeshFileLod& getLod(std::uint32_t index) const noexcept;
+
+        const void * getStreamData(std::uint32_t index) const noexcept;
+
+        const void * getIndexData() const noexcept;
+    };
+
+    // Immutable GL buffers filled straight from a MeshFile, and a vertex array with its attribute formats,
+    // stream bindings and element buffer already attached. The file can be closed afterwards.
+    class MeshBuffers {
+        std::vector<GLuint> _vertexBuffers;
+        std::vector<MeshFileLod> _lods;
+        GLuint _indexBuffer;
+        GLuint _vertexArray;
+        GLenum _indexType;
+
+        MeshBuffers(const MeshBuffers&) = delete;
+
+        MeshBuffers& operator= (const MeshBuffers&) = delete;
+
+    public:
+        explicit MeshBuffers(const MeshFile& file);
+
+        ~MeshBuffers() noexcept;
+
+        GLuint getVertexArray() const noexcept;
+
+        GLuint getVertexBuffer(std::uint32_t stream) const noexcept;
+
+        GLuint getIndexBuffer() const noexcept;
+
+        GLenum getIndexType() const noexcept;
+
+        std::uint32_t getLodCount() const noexcept;
+
+        const MeshFileLod& getLod(std::uint32_t lod) const noexcept;
+
+        // Draws one LOD; the caller binds getVertexArray() first, through its StateCache if it has one.
+        void draw(std::uint32_t lod = 0, GLsizei instanceCount = 1) const noexcept;
+    };
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mesh.hpp"
+
+namespace gfx {
+    class ThreadPool;
+
+    // Wavefront OBJ: v, vt, vn and f records (negative indices allowed, polygons fan-triangulated); the rest
+    // is skipped. The text is parsed in chunks split at line boundaries, and identical position/texcoord/normal
+    // triples are merged into one vertex, both across pThreadPool. Vertices keep their first-use order.
+    Mesh parseObj(const char * pText, std::size_t size, ThreadPool * pThreadPool = nullptr);
+
+    Mesh importObj(const std::string& path, ThreadPool * pThreadPool = nullptr);
+
+    // glTF 2.0 binary: every triangle primitive of every mesh, untransformed, appended in order. Attributes
+    // must be float POSITION, NORMAL and TEXCOORD_0; primitives are already indexed, so there is nothing to merge.
+    Mesh parseGlb(const std::uint8_t * pData, std::size_t size);
+
+    Mesh importGlb(const std::string& path);
+
+    // Picks the importer by extension, .obj or .glb.
+    Mesh importMesh(const std::string& path, ThreadPool * pThreadPool = nullptr);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.hpp"
+
+namespace gfx {
+    // What an index order costs the vertex stage, simulated with a FIFO post-transform cache of cacheSize
+    // entries and a FIFO of 64 byte lines in front of the vertex buffer:
+    //
+    //   acmr       vertex shader invocations per triangle (0.5 is the ideal for large regular meshes, 3 the worst)
+    //   atvr       vertex shader invocations per referenced vertex (1 is the ideal)
+    //   overfetch  bytes read from the vertex buffer per referenced vertex byte (1 is the ideal)
+    struct VertexCacheStats {
+        float acmr;
+        float atvr;
+        float overfetch;
+    };
+
+    VertexCacheStats analyzeVertexCache(const std::uint32_t * pIndices, std::size_t indexCount, std::size_t vertexCount,
+        std::size_t vertexSize = sizeof(Vertex), unsigned int cacheSize = 16);
+
+    // Reorders triangles for the post-transform cache with Tipsify (Sander et al., "Fast Triangle Reordering
+    // for Vertex Locality and Reduced Overdraw", 2007): emits all remaining faces around one vertex at a time,
+    // moving on to the oldest vertex just used that will still be cached after its own faces, and at dead ends
+    // to the most recently used vertex with faces left, then to the next such vertex in index order. Linear time.
+    void optimizeVertexCache(std::uint32_t * pIndices, std::size_t indexCount, std::size_t vertexCount, unsigned int cacheSize = 16);
+
+    // Reorders clusters of triangles so that outward facing ones come first and occlude the rest, from the
+    // same paper. Clusters start wherever the cache-optimized order misses on all three vertices, and are
+    // split further wherever the ACMR so far is within threshold of the cluster's own, so the ACMR grows by
+    // roughly that factor. Run after optimizeVertexCache.
+    void optimizeOverdraw(std::uint32_t * pIndices, std::size_t indexCount, const std::vector<Vertex>& vertices,
+        float threshold = 1.05F, unsigned int cacheSize = 16);
+
+    // Renumbers vertices in the order the indices first use them, so vertex fetches walk the buffer forwards;
+    // unreferenced vertices move to the end. Returns the new index of every old vertex.
+    std::vector<std::uint32_t> optimizeVertexFetch(Mesh& mesh);
+
+    // All three passes over the whole index buffer.
+    void optimizeMesh(Mesh& mesh, float threshold = 1.05F, unsigned int cacheSize = 16);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.hpp"
+#include "simd.hpp"
+
+namespace gfx {
+    class ThreadPool;
+
+    // Vertex attributes as one array per component, the layout the SIMD kernels below load from.
+    struct VertexStreams {
+        std::vector<float> positionX;
+        std::vector<float> positionY;
+        std::vector<float> positionZ;
+        std::vector<float> texcoordX;
+        std::vector<float> texcoordY;
+        std::vector<float> normalX;
+        std::vector<float> normalY;
+        std::vector<float> normalZ;
+        std::vector<float> tangentX;
+        std::vector<float> tangentY;
+        std::vector<float> tangentZ;
+        std::vector<float> tangentW;
+
+        std::size_t size() const noexcept;
+
+        void resize(std::size_t count);
+    };
+
+    VertexStreams toVertexStreams(const Mesh& mesh);
+
+    // Writes the streams' positions, texcoords and normals back into mesh.vertices.
+    void storeVertexStreams(const VertexStreams& streams, Mesh& mesh) noexcept;
+
+    // Both passes run over fixed ranges of faces, computing face data in SIMD batches (AVX2 gathers 8 faces at
+    // once, lower levels use the scalar path) and summing it into a window over just the vertices that range
+    // touches, so no two threads write the same vertex. Blocks of vertices then add up the windows in range
+    // order. Meshes with too little index locality for that fall back to sorting the corners by vertex block,
+    // which adds them up in the same order. The split doesn't depend on the thread count, so neither do the
+    // results. Indices must be below streams.size(); a trailing partial face is ignored.
+
+    // Area-weighted vertex normals: the sum of the unnormalized face normals around each vertex, normalized.
+    // Vertices without any non-degenerate face get (0, 1, 0).
+    void computeNormals(VertexStreams& streams, const std::vector<std::uint32_t>& indices, ThreadPool * pThreadPool = nullptr,
+        SimdLevel level = SimdLevel::AVX2);
+
+    // MikkTSpace-style tangents from positions, texcoords and the normals already in the streams: per-face
+    // tangent and bitangent directions are projected into each vertex's normal plane, weighted by the corner
+    // angle and summed. tangentW is the bitangent sign, so bitangent = tangentW * cross(normal, tangent) as
+    // in MikkTSpace. Faces with degenerate texcoords don't contribute. Unlike MikkTSpace no vertex is split
+    // where the faces around it disagree, since the index buffer is kept as is.
+    void computeTangents(VertexStreams& streams, const std::vector<std::uint32_t>& indices, ThreadPool * pThreadPool = nullptr,
+        SimdLevel level = SimdLevel::AVX2);
+}
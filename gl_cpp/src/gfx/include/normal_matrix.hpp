@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "simd.hpp"
+
+namespace gfx {
+    // MAT3 writes a glm::mat3x4, the std140/std430 layout of a GLSL mat3 (three vec4 columns).
+    // MAT4 writes a glm::mat4 whose last column is (0, 0, 0, 1).
+    enum class NormalMatrixLayout {
+        MAT3,
+        MAT4
+    };
+
+    // Writes the inverse transpose of the upper 3x3 of each affine matrix, built from the cofactors
+    // (cross products of the columns) over the determinant; singular matrices get the bare cofactors.
+    // Output i goes to pOut + i * outStride, so the results can land straight in an array of structs in
+    // a mapped uniform or storage buffer. Levels the CPU doesn't support fall back to the best one it does.
+    void computeNormalMatrices(const glm::mat4 * pMatrices, std::size_t count, void * pOut, std::size_t outStride,
+        NormalMatrixLayout layout = NormalMatrixLayout::MAT3, SimdLevel level = SimdLevel::AVX2) noexcept;
+}
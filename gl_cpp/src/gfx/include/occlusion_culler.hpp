@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace gfx {
+    class ThreadPool;
+
+    struct OcclusionStats {
+        std::size_t occluderTriangles;
+        std::size_t tested;
+        std::size_t culled;
+        double rasterizeMs;
+        double testMs;
+    };
+
+    class OcclusionCuller {
+        struct Occluder {
+            std::vector<glm::vec3> positions;
+            std::vector<std::uint32_t> indices;
+            glm::mat4 model;
+        };
+
+        // Edge functions and the screen-space depth plane, all as a * x + b * y + c.
+        struct Triangle {
+            float edgeA[3];
+            float edgeB[3];
+            float edgeC[3];
+            float depthA;
+            float depthB;
+            float depthC;
+            int minX;
+            int maxX;
+            int minY;
+            int maxY;
+        };
+
+        int _width;
+        int _height;
+        int _tilesX;
+        int _tilesY;
+        glm::mat4 _viewProj;
+        std::vector<float> _depth;
+        std::vector<float> _tileMax;
+        std::vector<Occluder> _occluders;
+        std::vector<Triangle> _triangles;
+        std::vector<glm::vec3> _boundsMin;
+        std::vector<glm::vec3> _boundsMax;
+        std::vector<std::vector<std::uint32_t>> _partitions;
+        OcclusionStats _stats;
+
+        OcclusionCuller(const OcclusionCuller&) = delete;
+
+        OcclusionCuller& operator= (const OcclusionCuller&) = delete;
+
+        void setupTriangles();
+
+        void rasterizeBand(int tileRow) noexcept;
+
+    public:
+        // The size is rounded up to whole 8x8 tiles; each tile row is rasterized as one task.
+        explicit OcclusionCuller(int width = 256, int height = 128);
+
+        int getWidth() const noexcept;
+
+        int getHeight() const noexcept;
+
+        // Depth per pixel in [0, 1], bottom row first; 1 where no occluder was drawn.
+        const std::vector<float>& getDepth() const noexcept;
+
+        const OcclusionStats& getStats() const noexcept;
+
+        // Occluders should be closed, counter-clockwise meshes that sit inside what they stand for.
+        std::size_t addOccluder(const std::vector<glm::vec3>& positions, const std::vector<std::uint32_t>& indices, const glm::mat4& model);
+
+        void setOccluderTransform(std::size_t occluder, const glm::mat4& model) noexcept;
+
+        void clearOccluders() noexcept;
+
+        std::size_t size() const noexcept;
+
+        void resize(std::size_t count);
+
+        void setBox(std::size_t index, const glm::vec3& min, const glm::vec3& max) noexcept;
+
+        void rasterize(const glm::mat4& viewProj, ThreadPool * pThreadPool = nullptr);
+
+        bool isVisible(const glm::vec3& min, const glm::vec3& max) const noexcept;
+
+        // Keeps the candidates whose box is not hidden behind the occluders drawn by the last rasterize(), in order.
+        void cull(const std::vector<std::uint32_t>& candidates, std::vector<std::uint32_t>& visible, ThreadPool * pThreadPool = nullptr);
+    };
+}
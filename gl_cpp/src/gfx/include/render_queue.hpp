@@ -0,0 +1,64 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+    class StateCache;
+
+    struct DrawPacket {
+        GLuint program;
+        GLuint vertexArray;
+        GLuint vertexBuffer;
+        GLsizei vertexStride;
+        GLuint elementBuffer;
+        GLenum indexType;
+        GLuint texture;
+        GLuint objectBuffer;
+        GLintptr objectOffset;
+        GLsizeiptr objectSize;
+        GLuint materialBuffer;
+        GLintptr materialOffset;
+        GLsizeiptr materialSize;
+        GLsizei count;
+        GLintptr first;
+    };
+
+    class RenderQueue {
+        struct Entry {
+            std::uint64_t key;
+            std::uint32_t index;
+        };
+
+        GLuint _objectBinding;
+        GLuint _materialBinding;
+        GLuint _textureUnit;
+        std::vector<DrawPacket> _packets;
+        std::vector<Entry> _entries;
+        std::vector<Entry> _scratch;
+
+        RenderQueue(const RenderQueue&) = delete;
+
+        RenderQueue& operator= (const RenderQueue&) = delete;
+
+    public:
+        // Most significant first: layer (4 bits), program (12), material (12), texture (12), depth (24).
+        // Ids are truncated to their field; a collision only costs grouping, never correctness.
+        static std::uint64_t makeKey(unsigned int layer, GLuint program, GLuint material, GLuint texture, float depth) noexcept;
+
+        explicit RenderQueue(GLuint objectBinding = 0, GLuint materialBinding = 1, GLuint textureUnit = 0);
+
+        std::size_t size() const noexcept;
+
+        void clear() noexcept;
+
+        void push(std::uint64_t key, const DrawPacket& packet);
+
+        void sort();
+
+        void submit(StateCache& cache) const;
+    };
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bvh.hpp"
+
+namespace gfx {
+    class ThreadPool;
+
+    // Objects with local bounds and a world transform, indexed by a BVH over their world bounds.
+    class Scene {
+        std::vector<Aabb> _localBounds;
+        std::vector<glm::mat4> _transforms;
+        Bvh _bvh;
+        float _rebuildRatio;
+        bool _needsBuild;
+
+        Scene(const Scene&) = delete;
+
+        Scene& operator= (const Scene&) = delete;
+
+    public:
+        // Refitting is cheap but loosens the tree; it is rebuilt once its SAH cost exceeds rebuildRatio times the built cost.
+        explicit Scene(float rebuildRatio = 1.5F);
+
+        std::size_t size() const noexcept;
+
+        std::uint32_t add(const Aabb& localBounds, const glm::mat4& transform);
+
+        const glm::mat4& getTransform(std::uint32_t object) const noexcept;
+
+        void setTransform(std::uint32_t object, const glm::mat4& transform);
+
+        const Aabb& getBounds(std::uint32_t object) const noexcept;
+
+        const Bvh& getBvh() const noexcept;
+
+        // Brings the index up to date with the moved objects; returns true when it rebuilt rather than refit.
+        bool update(ThreadPool * pThreadPool = nullptr);
+
+        // Rebuilds unconditionally, e.g. after a camera cut or on a fixed period.
+        void rebuild(ThreadPool * pThreadPool = nullptr);
+    };
+}
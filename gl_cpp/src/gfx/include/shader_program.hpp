@@ -0,0 +1,76 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+#include "shader_watcher.hpp"
+
+namespace gfx {
+    struct ShaderStage {
+        GLenum type;
+        std::string path;
+    };
+
+    // Edits arrive through reload() and go live in a later update(). With ARB_parallel_shader_compile the
+    // driver compiles and links on its own threads while the old program keeps drawing. Without it each
+    // update() compiles at most one edited stage and links in a separate call, so the render thread stalls
+    // for a single compile or link per frame rather than the whole program at once.
+    class ShaderProgram {
+        // Owns a shader object, 0 when empty.
+        class Shader {
+            GLuint _handle;
+
+            Shader(const Shader&) = delete;
+
+            Shader& operator= (const Shader&) = delete;
+
+        public:
+            explicit Shader(GLuint handle = 0) noexcept;
+
+            Shader(Shader&& other) noexcept;
+
+            Shader& operator= (Shader&& other) noexcept;
+
+            ~Shader() noexcept;
+
+            GLuint get() const noexcept;
+        };
+
+        struct Stage {
+            GLenum type;
+            std::string path;
+            Shader shader;
+            Shader pendingShader;
+            std::string pendingSource;
+            bool compilePending;
+        };
+
+        std::vector<Stage> _stages;
+        GLuint _handle;
+        GLuint _pendingHandle;
+        bool _dirty;
+
+        ShaderProgram(const ShaderProgram&) = delete;
+
+        ShaderProgram& operator= (const ShaderProgram&) = delete;
+
+        static GLuint getLinkedShader(const Stage& stage) noexcept;
+
+        void discardPending() noexcept;
+
+    public:
+        explicit ShaderProgram(const std::vector<ShaderStage>& stages);
+
+        ~ShaderProgram() noexcept;
+
+        GLuint getHandle() const noexcept;
+
+        void watch(ShaderWatcher& watcher) const;
+
+        bool reload(const FileChange& change);
+
+        bool update();
+    };
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gfx {
+    struct FileChange {
+        std::string path;
+        std::string source;
+    };
+
+    class ShaderWatcher {
+        int _inotifyFd;
+        int _wakeFd;
+        std::mutex _lock;
+        std::map<int, std::string> _directories;
+        std::map<std::string, std::string> _files;
+        std::vector<FileChange> _changes;
+        std::thread _thread;
+
+        ShaderWatcher(const ShaderWatcher&) = delete;
+
+        ShaderWatcher& operator= (const ShaderWatcher&) = delete;
+
+        void run() noexcept;
+
+    public:
+        ShaderWatcher();
+
+        ~ShaderWatcher() noexcept;
+
+        void watch(const std::string& path);
+
+        std::vector<FileChange> poll();
+    };
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+namespace gfx {
+    enum class SimdLevel {
+        SCALAR,
+        SSE,
+        AVX2
+    };
+
+    // The widest level the running CPU supports; kernels clamp requested levels to it.
+    SimdLevel getBestSimdLevel() noexcept;
+
+    const char * getSimdLevelName(SimdLevel level) noexcept;
+}
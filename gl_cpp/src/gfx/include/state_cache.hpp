@@ -0,0 +1,97 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace gfx {
+    struct StateCacheStats {
+        unsigned long issued;
+        unsigned long skipped;
+    };
+
+    // Shadows binding state and drops calls that would not change it. The cache only knows about
+    // calls made through it; call invalidate() after touching the same state directly or after
+    // deleting bound objects.
+    class StateCache {
+        static constexpr GLuint UNKNOWN = ~GLuint(0);
+        static constexpr std::size_t MAX_BUFFER_BINDINGS = 16;
+        static constexpr std::size_t MAX_TEXTURE_UNITS = 32;
+        static constexpr std::size_t MAX_VERTEX_BINDINGS = 16;
+
+        struct BufferRange {
+            GLuint buffer;
+            GLintptr offset;
+            GLsizeiptr size;
+        };
+
+        struct VertexBinding {
+            GLuint buffer;
+            GLintptr offset;
+            GLsizei stride;
+        };
+
+        struct VertexArray {
+            GLuint elementBuffer;
+            std::array<VertexBinding, MAX_VERTEX_BINDINGS> bindings;
+        };
+
+        // The bits of up to three components; scalars leave the rest 0.
+        using UniformValue = std::array<std::uint32_t, 3>;
+
+        GLuint _program;
+        GLuint _drawFramebuffer;
+        GLuint _readFramebuffer;
+        GLuint _vertexArray;
+        VertexArray * _pVertexArray;
+        std::array<BufferRange, MAX_BUFFER_BINDINGS> _uniformBuffers;
+        std::array<BufferRange, MAX_BUFFER_BINDINGS> _storageBuffers;
+        std::array<GLuint, MAX_TEXTURE_UNITS> _textures;
+        std::unordered_map<GLuint, VertexArray> _vertexArrays;
+        std::unordered_map<std::uint64_t, UniformValue> _uniforms;
+        StateCacheStats _stats;
+
+        StateCache(const StateCache&) = delete;
+
+        StateCache& operator= (const StateCache&) = delete;
+
+        BufferRange * getBufferRange(GLenum target, GLuint index) noexcept;
+
+        bool setUniform(GLint location, const UniformValue& value);
+
+        bool issue(bool changed) noexcept;
+
+    public:
+        StateCache() noexcept;
+
+        void invalidate() noexcept;
+
+        const StateCacheStats& getStats() const noexcept;
+
+        void resetStats() noexcept;
+
+        void useProgram(GLuint program) noexcept;
+
+        void bindFramebuffer(GLenum target, GLuint framebuffer) noexcept;
+
+        void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) noexcept;
+
+        void bindTextureUnit(GLuint unit, GLuint texture) noexcept;
+
+        void bindVertexArray(GLuint vertexArray);
+
+        void bindVertexBuffer(GLuint bindingIndex, GLuint buffer, GLintptr offset, GLsizei stride) noexcept;
+
+        void bindElementBuffer(GLuint buffer) noexcept;
+
+        void uniform1i(GLint location, GLint value);
+
+        void uniform1f(GLint location, GLfloat value);
+
+        // A single vec3; pValue points at its three components.
+        void uniform3fv(GLint location, const GLfloat * pValue);
+    };
+}
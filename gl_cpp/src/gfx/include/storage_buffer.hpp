@@ -0,0 +1,178 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "state_cache.hpp"
+
+namespace gfx {
+    // write() skips values whose bytes are unchanged, so T must not have implicit padding: pad it with
+    // explicit members instead, which T {} zeroes and copies carry along.
+    template<class T>
+    class StorageBuffer {
+        static_assert(std::is_trivially_copyable<T>::value, "StorageBuffer requires a trivially copyable element type");
+
+        GLuint _handle;
+        GLsizei _capacity;
+        std::vector<T> _shadow;
+        std::vector<std::pair<GLsizei, GLsizei>> _dirtyRanges;
+
+        StorageBuffer(const StorageBuffer&) = delete;
+
+        StorageBuffer& operator= (const StorageBuffer&) = delete;
+
+        void markDirty(GLsizei begin, GLsizei end);
+
+    public:
+        explicit StorageBuffer(GLsizei count);
+
+        ~StorageBuffer() noexcept;
+
+        GLuint getHandle() const noexcept;
+
+        GLsizei size() const noexcept;
+
+        void resize(GLsizei count);
+
+        const T& operator[] (GLsizei index) const noexcept;
+
+        bool write(GLsizei index, const T& value);
+
+        // Uploads each run of changed elements separately, so the cost follows the number of changes rather
+        // than the distance between the first and last one.
+        void flush();
+
+        void bind(GLuint index) const noexcept;
+
+        void bind(GLuint index, StateCache& cache) const noexcept;
+    };
+
+    template<class T>
+    StorageBuffer<T>::StorageBuffer(GLsizei count) {
+        _handle = 0;
+        _capacity = 0;
+
+        resize(count);
+    }
+
+    template<class T>
+    StorageBuffer<T>::~StorageBuffer() noexcept {
+        if (_handle) {
+            glDeleteBuffers(1, &_handle);
+        }
+    }
+
+    template<class T>
+    inline GLuint StorageBuffer<T>::getHandle() const noexcept {
+        return _handle;
+    }
+
+    template<class T>
+    inline GLsizei StorageBuffer<T>::size() const noexcept {
+        return static_cast<GLsizei> (_shadow.size());
+    }
+
+    template<class T>
+    void StorageBuffer<T>::resize(GLsizei count) {
+        auto oldSize = size();
+
+        _shadow.resize(count);
+
+        for (auto& range : _dirtyRanges) {
+            range.second = std::min(range.second, count);
+            range.first = std::min(range.first, range.second);
+        }
+
+        if (count > _capacity || 0 == _handle) {
+            // Immutable storage can't grow in place; reallocate geometrically and re-upload everything.
+            _capacity = std::max(std::max(count, _capacity * 2), 1);
+
+            if (_handle) {
+                glDeleteBuffers(1, &_handle);
+            }
+
+            glCreateBuffers(1, &_handle);
+            glNamedBufferStorage(_handle, _capacity * sizeof(T), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+            markDirty(0, count);
+        } else if (count > oldSize) {
+            markDirty(oldSize, count);
+        }
+    }
+
+    template<class T>
+    inline const T& StorageBuffer<T>::operator[] (GLsizei index) const noexcept {
+        return _shadow[index];
+    }
+
+    template<class T>
+    inline bool StorageBuffer<T>::write(GLsizei index, const T& value) {
+        auto& dst = _shadow[index];
+
+        if (0 == std::memcmp(&dst, &value, sizeof(T))) {
+            return false;
+        }
+
+        std::memcpy(&dst, &value, sizeof(T));
+        markDirty(index, index + 1);
+
+        return true;
+    }
+
+    template<class T>
+    inline void StorageBuffer<T>::markDirty(GLsizei begin, GLsizei end) {
+        // Sequential writes extend the last range; anything else is sorted out in flush().
+        if (!_dirtyRanges.empty() && begin <= _dirtyRanges.back().second && end >= _dirtyRanges.back().first) {
+            _dirtyRanges.back().first = std::min(_dirtyRanges.back().first, begin);
+            _dirtyRanges.back().second = std::max(_dirtyRanges.back().second, end);
+            return;
+        }
+
+        _dirtyRanges.emplace_back(begin, end);
+    }
+
+    template<class T>
+    void StorageBuffer<T>::flush() {
+        if (_dirtyRanges.empty()) {
+            return;
+        }
+
+        std::sort(_dirtyRanges.begin(), _dirtyRanges.end());
+
+        auto begin = _dirtyRanges[0].first;
+        auto end = _dirtyRanges[0].second;
+
+        for (std::size_t i = 1; i <= _dirtyRanges.size(); i++) {
+            if (i < _dirtyRanges.size() && _dirtyRanges[i].first <= end) {
+                end = std::max(end, _dirtyRanges[i].second);
+                continue;
+            }
+
+            if (begin < end) {
+                glNamedBufferSubData(_handle, begin * sizeof(T), (end - begin) * sizeof(T), _shadow.data() + begin);
+            }
+
+            if (i < _dirtyRanges.size()) {
+                begin = _dirtyRanges[i].first;
+                end = _dirtyRanges[i].second;
+            }
+        }
+
+        _dirtyRanges.clear();
+    }
+
+    template<class T>
+    inline void StorageBuffer<T>::bind(GLuint index) const noexcept {
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, _handle, 0, std::max(size(), 1) * sizeof(T));
+    }
+
+    template<class T>
+    inline void StorageBuffer<T>::bind(GLuint index, StateCache& cache) const noexcept {
+        cache.bindBufferRange(GL_SHADER_STORAGE_BUFFER, index, _handle, 0, std::max(size(), 1) * sizeof(T));
+    }
+}
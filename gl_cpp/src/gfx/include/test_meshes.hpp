@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "mesh.hpp"
+
+namespace gfx {
+    // Generated meshes the benchmarks share, so each one builds and checks exactly the same input.
+
+    // Point (x, y) of a width x width grid of quads, 0 <= x, y <= width: a gentle sine wave over the unit square.
+    glm::vec3 getGridPosition(std::size_t x, std::size_t y, std::size_t width) noexcept;
+
+    glm::vec2 getGridTexcoord(std::size_t x, std::size_t y, std::size_t width) noexcept;
+
+    // OBJ text for the grid with positions, texcoords and up normals. Every point is shared by up to four quads;
+    // quad (x, y) has corners (x, y), (x + 1, y), (x + 1, y + 1), (x, y + 1), fan-triangulated from the first.
+    std::string writeGridObj(std::size_t width);
+
+    // A torus around the y axis (major radius 1, minor radius 0.4) with rings segments around the axis and sides
+    // around the tube, wound outwards, with exact normals and texcoords from 0 to 1 once around each way. Closed,
+    // every vertex is shared by six triangles and the texcoords wrap. With seams, the first ring and side are
+    // repeated at the far end as an unwrapped mesh would store them; vertex (i, j) is then j * (rings + 1) + i.
+    Mesh createTorus(std::size_t rings, std::size_t sides, bool seams = false);
+}
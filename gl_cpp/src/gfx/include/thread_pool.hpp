@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gfx {
+    class ThreadPool {
+        std::vector<std::thread> _threads;
+        std::mutex _lock;
+        std::condition_variable _wake;
+        std::condition_variable _done;
+        const std::function<void (unsigned int)> * _pTask;
+        unsigned int _taskCount;
+        std::atomic<unsigned int> _nextTask;
+        unsigned int _busyWorkers;
+        unsigned long _generation;
+        bool _stop;
+
+        ThreadPool(const ThreadPool&) = delete;
+
+        ThreadPool& operator= (const ThreadPool&) = delete;
+
+        void drain(const std::function<void (unsigned int)>& task, unsigned int taskCount) noexcept;
+
+        void work() noexcept;
+
+    public:
+        // The calling thread takes part in run(), so threadCount - 1 workers are started; 0 picks one per core.
+        explicit ThreadPool(unsigned int threadCount = 0);
+
+        ~ThreadPool() noexcept;
+
+        unsigned int getThreadCount() const noexcept;
+
+        // Calls task(0) ... task(taskCount - 1) across the pool and returns once all have finished.
+        // Tasks must not throw; run() is not reentrant.
+        void run(unsigned int taskCount, const std::function<void (unsigned int)>& task);
+    };
+}
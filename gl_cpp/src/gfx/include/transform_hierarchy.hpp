@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace gfx {
+    class ThreadPool;
+
+    // Local TRS transforms in a parent/child forest, stored as parallel arrays sorted by depth so that
+    // every level is contiguous and comes after the one holding its parents. update() walks the levels
+    // in order, each as a parallel-for, and only recomputes objects whose own or an ancestor's local
+    // transform changed. Handles stay valid when objects are added; storage indices do not.
+    class TransformHierarchy {
+        std::vector<std::uint32_t> _parents;
+        std::vector<std::uint32_t> _depths;
+        std::vector<glm::vec3> _translations;
+        std::vector<glm::quat> _rotations;
+        std::vector<glm::vec3> _scales;
+        std::vector<glm::mat4> _worlds;
+        std::vector<glm::mat3x4> _normals;
+        std::vector<std::uint8_t> _dirty;
+        std::vector<std::uint8_t> _changed;
+        std::vector<std::uint32_t> _handles;
+        std::vector<std::uint32_t> _indices;
+        std::vector<std::uint32_t> _levelOffsets;
+        bool _needsSort;
+
+        TransformHierarchy(const TransformHierarchy&) = delete;
+
+        TransformHierarchy& operator= (const TransformHierarchy&) = delete;
+
+        std::uint32_t append(std::uint32_t parentIndex, std::uint32_t depth, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+
+        void sortByDepth();
+
+        void updateRange(std::uint32_t begin, std::uint32_t end) noexcept;
+
+    public:
+        TransformHierarchy();
+
+        std::size_t size() const noexcept;
+
+        std::size_t getLevelCount() const noexcept;
+
+        std::uint32_t addRoot(const glm::vec3& translation = glm::vec3(0.0F), const glm::quat& rotation = glm::quat(1.0F, 0.0F, 0.0F, 0.0F), const glm::vec3& scale = glm::vec3(1.0F));
+
+        std::uint32_t add(std::uint32_t parent, const glm::vec3& translation = glm::vec3(0.0F), const glm::quat& rotation = glm::quat(1.0F, 0.0F, 0.0F, 0.0F), const glm::vec3& scale = glm::vec3(1.0F));
+
+        // Roots are their own parent.
+        std::uint32_t getParent(std::uint32_t handle) const noexcept;
+
+        bool isRoot(std::uint32_t handle) const noexcept;
+
+        void setTranslation(std::uint32_t handle, const glm::vec3& translation) noexcept;
+
+        void setRotation(std::uint32_t handle, const glm::quat& rotation) noexcept;
+
+        void setScale(std::uint32_t handle, const glm::vec3& scale) noexcept;
+
+        void setLocal(std::uint32_t handle, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) noexcept;
+
+        const glm::vec3& getTranslation(std::uint32_t handle) const noexcept;
+
+        const glm::quat& getRotation(std::uint32_t handle) const noexcept;
+
+        const glm::vec3& getScale(std::uint32_t handle) const noexcept;
+
+        // Valid after update(). The normal matrix is the inverse transpose of the world matrix's upper 3x3,
+        // in the std140/std430 mat3 layout so it can be copied into a buffer as is.
+        const glm::mat4& getWorld(std::uint32_t handle) const noexcept;
+
+        const glm::mat3x4& getNormal(std::uint32_t handle) const noexcept;
+
+        // Whether the last update() recomputed the object, e.g. to refit its bounds or re-upload it.
+        bool wasUpdated(std::uint32_t handle) const noexcept;
+
+        void update(ThreadPool * pThreadPool = nullptr);
+    };
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh.hpp"
+
+namespace gfx {
+    // 16 bytes per vertex instead of Vertex's 32: position as UNORM16 over the mesh bounds at 0, texcoord
+    // as half floats at 8, normal octahedral-encoded as SNORM16 at 12.
+    struct PackedVertex {
+        std::uint16_t position[3];
+        std::uint16_t reserved;
+        std::uint16_t texcoord[2];
+        std::int16_t normal[2];
+    };
+
+    static_assert(16 == sizeof(PackedVertex), "PackedVertex must stay 16 bytes");
+
+    // The shader gets positions in [0, 1] and decodes them as positionOffset + position * positionScale.
+    struct QuantizedVertices {
+        std::vector<PackedVertex> vertices;
+        glm::vec3 positionOffset;
+        glm::vec3 positionScale;
+    };
+
+    // Largest errors after a round trip; positions are in mesh units and normals in degrees.
+    struct QuantizationError {
+        float maxPosition;
+        float maxTexcoord;
+        float maxNormalAngle;
+        float meanNormalAngle;
+    };
+
+    // Normals are rounded to whichever of the four neighbouring octahedral codes decodes closest. Texcoords
+    // beyond the half float range (65504) don't survive.
+    QuantizedVertices quantizeVertices(const std::vector<Vertex>& vertices);
+
+    // What the vertex shader sees, normal renormalized.
+    Vertex dequantizeVertex(const PackedVertex& vertex, const glm::vec3& positionOffset, const glm::vec3& positionScale) noexcept;
+
+    QuantizationError getQuantizationError(const std::vector<Vertex>& vertices, const QuantizedVertices& quantized) noexcept;
+
+    // Attributes 0 (vec3 position), 1 (vec2 texcoord) and 2 (vec2 octahedral normal) of vertexArray, sourced
+    // from bindingIndex; bind the buffer there with a stride of sizeof(PackedVertex).
+    void setPackedVertexFormat(GLuint vertexArray, GLuint bindingIndex = 0) noexcept;
+}
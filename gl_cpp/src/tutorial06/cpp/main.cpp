@@ -7,7 +7,6 @@
  */
 
 #include <GL/glew.h>
-#include <GLFW/glfw3.h>
 
 #include <array>
 #include <iostream>
@@ -21,11 +20,10 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-namespace {
-    void errorCallback(int error, const char * desc) {
-        std::cerr << "GLFW Error(" << std::dec << error << "): " << desc << std::endl;
-    }
+#include "context.hpp"
+#include "debug_logger.hpp"
 
+namespace {
     const std::string VERTEX_SHADER = 
         "#version 450\n"        
         "layout (location = 0) in vec3 position;\n"
@@ -100,49 +98,12 @@ namespace {
 
         return program;
     }    
-
-    void GLAPIENTRY debugCallback(GLenum source, GLenum type, GLenum id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
-        if (GL_DEBUG_TYPE_ERROR == type) {
-            std::cerr << "[ERROR]: ";
-        } else {
-            std::cerr << "[DEBUG]: ";
-        }
-
-        std::cerr << message << std::endl;
-    }
 }
 
 int main(int argc, char** argv) {
-    glfwSetErrorCallback(errorCallback);
-
-    if (GLFW_TRUE != glfwInit()) {
-        throw std::runtime_error("Failed to init GLFW!");
-    }
-
-    glfwDefaultWindowHints();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    auto pContext = gfx::Context::create(gfx::parseContextInfo(argc, argv, "Tutorial06"));
 
-    auto window = glfwCreateWindow(640, 480, "Tutorial06", nullptr, nullptr);
-
-    if (nullptr == window) {
-        throw std::runtime_error("Failed to create GLFW window!");
-    }
-
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);    
-
-    GLenum glErr = glewInit();
-    if (glErr) {
-        auto msg = std::stringstream();
-
-        msg << "Failed to init GLEW: " << glewGetErrorString(glErr);
-
-        throw std::runtime_error(msg.str());
-    }
-
-    glEnable(GL_DEBUG_OUTPUT);
-    glDebugMessageCallback(debugCallback, nullptr);
+    auto pDebugLogger = std::make_unique<gfx::DebugLogger> ();
 
     GLuint program;
     {
@@ -175,7 +136,7 @@ int main(int argc, char** argv) {
 
     glClearColor(0.0F, 0.0F, 0.0F, 0.0F);
 
-    while (!glfwWindowShouldClose(window)) {
+    while (!pContext->shouldClose()) {
         auto trModel = glm::translate(glm::mat4(1.0), glm::vec3(static_cast<float> (std::cos(t)), 0.0F, 0.0F));
 
         glClear(GL_COLOR_BUFFER_BIT);
@@ -187,8 +148,8 @@ int main(int argc, char** argv) {
         glBindVertexBuffer(0, vbo, 0, sizeof(glm::vec3));
         glDrawArrays(GL_TRIANGLES, 0, 3);
 
-        glfwSwapBuffers(window);        
-        glfwPollEvents();
+        pContext->swapBuffers();
+        pContext->pollEvents();
 
         t += 0.01F;
     }
@@ -197,9 +158,8 @@ int main(int argc, char** argv) {
     glDeleteBuffers(1, &vbo);
     glDeleteProgram(program);
 
-    glfwDestroyWindow(window);
-
-    glfwTerminate();
+    pDebugLogger = nullptr;
+    pContext = nullptr;
 
     return 0;
 }
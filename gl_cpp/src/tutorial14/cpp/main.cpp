@@ -22,12 +22,10 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "camera.hpp"
+#include "context.hpp"
+#include "debug_logger.hpp"
 
 namespace {
-    void errorCallback(int error, const char * desc) {
-        std::cerr << "GLFW Error(" << std::dec << error << "): " << desc << std::endl;
-    }
-
     const std::string VERTEX_SHADER = 
         "#version 450\n"        
         "layout (location = 0) in vec3 position;\n"
@@ -106,49 +104,12 @@ namespace {
 
         return program;
     }    
-
-    void GLAPIENTRY debugCallback(GLenum source, GLenum type, GLenum id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
-        if (GL_DEBUG_TYPE_ERROR == type) {
-            std::cerr << "[ERROR]: ";
-        } else {
-            std::cerr << "[DEBUG]: ";
-        }
-
-        std::cerr << message << std::endl;
-    }    
 }
 
 int main(int argc, char** argv) {
-    glfwSetErrorCallback(errorCallback);
+    auto pContext = gfx::Context::create(gfx::parseContextInfo(argc, argv, "Tutorial14"));
 
-    if (GLFW_TRUE != glfwInit()) {
-        throw std::runtime_error("Failed to init GLFW!");
-    }
-
-    glfwDefaultWindowHints();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
-
-    auto window = glfwCreateWindow(640, 480, "Tutorial14", nullptr, nullptr);
-
-    if (nullptr == window) {
-        throw std::runtime_error("Failed to create GLFW window!");
-    }
-
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);    
-
-    GLenum glErr = glewInit();
-    if (glErr) {
-        auto msg = std::stringstream();
-
-        msg << "Failed to init GLEW: " << glewGetErrorString(glErr);
-
-        throw std::runtime_error(msg.str());
-    }
-
-    glEnable(GL_DEBUG_OUTPUT);
-    glDebugMessageCallback(debugCallback, nullptr);
+    auto pDebugLogger = std::make_unique<gfx::DebugLogger> ();
 
     GLuint program;
     {
@@ -196,17 +157,21 @@ int main(int argc, char** argv) {
 
     auto camera = gfx::Camera();
 
-    glfwSetWindowUserPointer(window, &camera);
-    glfwSetKeyCallback(window, [](auto pWindow, auto key, auto scancode, auto action, auto mods) {
-        auto pCamera = reinterpret_cast<gfx::Camera * > (glfwGetWindowUserPointer(pWindow));
+    auto window = pContext->getWindow();
 
-        pCamera->onKeyboard(key, action);
-    });
+    if (nullptr != window) {
+        glfwSetWindowUserPointer(window, &camera);
+        glfwSetKeyCallback(window, [](auto pWindow, auto key, auto scancode, auto action, auto mods) {
+            auto pCamera = reinterpret_cast<gfx::Camera * > (glfwGetWindowUserPointer(pWindow));
 
-    while (!glfwWindowShouldClose(window)) {
+            pCamera->onKeyboard(key, action);
+        });
+    }
+
+    while (!pContext->shouldClose()) {
         auto trTrans = glm::translate(glm::mat4(1.0F), glm::vec3(0.0F, 0.0F, -5.0F));
         auto trRotate = glm::rotate(glm::mat4(1.0F), t, glm::vec3(0.0F, 1.0F, 0.0F));        
-        auto trProj = glm::perspective(glm::radians(90.0F), 4.0F / 3.0F, 1.0F, 100.0F);
+        auto trProj = glm::perspective(glm::radians(90.0F), static_cast<float> (pContext->getWidth()) / pContext->getHeight(), 1.0F, 100.0F);
         auto trModel = trTrans * trRotate;
         auto trView = camera.getViewMatrix();
         
@@ -222,8 +187,8 @@ int main(int argc, char** argv) {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
         glDrawElements(GL_TRIANGLES, 12, GL_UNSIGNED_SHORT, 0);
 
-        glfwSwapBuffers(window);        
-        glfwPollEvents();
+        pContext->swapBuffers();
+        pContext->pollEvents();
 
         camera.update(0.1F);
 
@@ -235,9 +200,8 @@ int main(int argc, char** argv) {
     glDeleteBuffers(1, &ibo);
     glDeleteProgram(program);
 
-    glfwDestroyWindow(window);
-
-    glfwTerminate();
+    pDebugLogger = nullptr;
+    pContext = nullptr;
 
     return 0;
 }
@@ -22,14 +22,12 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "camera.hpp"
+#include "context.hpp"
+#include "debug_logger.hpp"
 #include "texture.hpp"
 #include "util.hpp"
 
 namespace {
-    void errorCallback(int error, const char * desc) {
-        std::cerr << "GLFW Error(" << std::dec << error << "): " << desc << std::endl;
-    }
-
     const std::string VERTEX_SHADER = 
         "#version 450\n"        
         "layout (location = 0) in vec3 position;\n"
@@ -124,49 +122,12 @@ namespace {
 
         return program;
     }    
-
-    void GLAPIENTRY debugCallback(GLenum source, GLenum type, GLenum id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
-        if (GL_DEBUG_TYPE_ERROR == type) {
-            std::cerr << "[ERROR]: ";
-        } else {
-            std::cerr << "[DEBUG]: ";
-        }
-
-        std::cerr << message << std::endl;
-    }    
 }
 
 int main(int argc, char** argv) {
-    glfwSetErrorCallback(errorCallback);
-
-    if (GLFW_TRUE != glfwInit()) {
-        throw std::runtime_error("Failed to init GLFW!");
-    }
-
-    glfwDefaultWindowHints();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
-
-    auto window = glfwCreateWindow(640, 480, "Tutorial17", nullptr, nullptr);
-
-    if (nullptr == window) {
-        throw std::runtime_error("Failed to create GLFW window!");
-    }
-
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);    
-
-    GLenum glErr = glewInit();
-    if (glErr) {
-        auto msg = std::stringstream();
-
-        msg << "Failed to init GLEW: " << glewGetErrorString(glErr);
-
-        throw std::runtime_error(msg.str());
-    }
+    auto pContext = gfx::Context::create(gfx::parseContextInfo(argc, argv, "Tutorial17"));
 
-    glEnable(GL_DEBUG_OUTPUT);
-    glDebugMessageCallback(debugCallback, nullptr);
+    auto pDebugLogger = std::make_unique<gfx::DebugLogger> ();
 
     GLuint program;
     {
@@ -257,31 +218,35 @@ int main(int argc, char** argv) {
     userData.pCamera = std::make_unique<gfx::Camera>();
     userData.ambientIntensity = 0.5F;
 
-    glfwSetWindowUserPointer(window, &userData);
-    glfwSetKeyCallback(window, [](auto pWindow, auto key, auto scancode, auto action, auto mods) {
-        auto pUserData = reinterpret_cast<UserDataT * > (glfwGetWindowUserPointer(pWindow));
+    auto window = pContext->getWindow();
 
-        pUserData->pCamera->onKeyboard(key, action);
+    if (nullptr != window) {
+        glfwSetWindowUserPointer(window, &userData);
+        glfwSetKeyCallback(window, [](auto pWindow, auto key, auto scancode, auto action, auto mods) {
+            auto pUserData = reinterpret_cast<UserDataT * > (glfwGetWindowUserPointer(pWindow));
+
+            pUserData->pCamera->onKeyboard(key, action);
         
-        switch (key) {            
-            case GLFW_KEY_ESCAPE:
-                glfwSetWindowShouldClose(pWindow, GLFW_TRUE);
-                break;
-            case GLFW_KEY_A:
-                pUserData->ambientIntensity += 0.05F;
-                break;
-            case GLFW_KEY_S:
-                pUserData->ambientIntensity -= 0.05F;
-                break;
-        }
-    });
+            switch (key) {            
+                case GLFW_KEY_ESCAPE:
+                    glfwSetWindowShouldClose(pWindow, GLFW_TRUE);
+                    break;
+                case GLFW_KEY_A:
+                    pUserData->ambientIntensity += 0.05F;
+                    break;
+                case GLFW_KEY_S:
+                    pUserData->ambientIntensity -= 0.05F;
+                    break;
+            }
+        });
+    }
 
     auto pTexture = std::make_unique<gfx::Texture> (GL_TEXTURE_2D, "data/test.png");
 
-    while (!glfwWindowShouldClose(window)) {
+    while (!pContext->shouldClose()) {
         auto trTrans = glm::translate(glm::mat4(1.0F), glm::vec3(0.0F, 0.0F, -5.0F));
         auto trRotate = glm::rotate(glm::mat4(1.0F), t, glm::vec3(0.0F, 1.0F, 0.0F));        
-        auto trProj = glm::perspective(glm::radians(90.0F), 4.0F / 3.0F, 1.0F, 100.0F);
+        auto trProj = glm::perspective(glm::radians(90.0F), static_cast<float> (pContext->getWidth()) / pContext->getHeight(), 1.0F, 100.0F);
         auto trModel = trTrans * trRotate;
         auto trView = userData.pCamera->getViewMatrix();
         
@@ -303,8 +268,8 @@ int main(int argc, char** argv) {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
         glDrawElements(GL_TRIANGLES, 12, GL_UNSIGNED_SHORT, 0);
 
-        glfwSwapBuffers(window);        
-        glfwPollEvents();
+        pContext->swapBuffers();
+        pContext->pollEvents();
 
         userData.pCamera->update(0.1F);
 
@@ -319,9 +284,8 @@ int main(int argc, char** argv) {
     glDeleteBuffers(1, &ubo);
     glDeleteProgram(program);
 
-    glfwDestroyWindow(window);
-
-    glfwTerminate();
+    pDebugLogger = nullptr;
+    pContext = nullptr;
 
     return 0;
 }
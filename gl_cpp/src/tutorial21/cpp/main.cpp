@@ -10,6 +10,8 @@
 #include <GLFW/glfw3.h>
 
 #include <array>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <sstream>
@@ -19,347 +21,120 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "camera.hpp"
+#include "context.hpp"
+#include "cpu_profiler.hpp"
+#include "debug_logger.hpp"
+#include "gpu_profiler.hpp"
+#include "gpu_query.hpp"
+#include "mesh_importer.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_processing.hpp"
+#include "normal_matrix.hpp"
+#include "shader_program.hpp"
+#include "shader_watcher.hpp"
+#include "state_cache.hpp"
+#include "storage_buffer.hpp"
 #include "texture.hpp"
+#include "thread_pool.hpp"
+#include "transform_hierarchy.hpp"
 #include "util.hpp"
+#include "vertex_quantizer.hpp"
 
 namespace {
-    void errorCallback(int error, const char * desc) {
-        std::cerr << "GLFW Error(" << std::dec << error << "): " << desc << std::endl;
-    }
-
-    const std::string VERTEX_SHADER = 
-        "#version 450\n\n"
-
-        "layout (location = 0) in vec3 position;\n"
-        "layout (location = 1) in vec2 texcoord;\n"
-        "layout (location = 2) in vec3 normal;\n"        
-        "layout (location = 0) out vec2 vTexCoord;\n"
-        "layout (location = 1) out vec3 vNormal;\n"
-        "layout (location = 2) out vec3 vWorldPos;\n\n"
-
-        "layout (binding = 0, std140) uniform CameraData {\n"
-        "  mat4 mvp;\n"
-        "  mat4 normal;\n"
-        "  mat4 world;\n"
-        "  vec4 eye;\n"
-        "  int numPointLights;\n"
-        "  int numSpotLights;\n"
-        "} uCamera;\n\n"
-
-        "void main() {\n"
-        "  gl_Position = uCamera.mvp * vec4(position, 1.0);\n"        
-        "  vTexCoord = texcoord;\n"
-        "  vNormal = mat3(uCamera.normal) * normal;\n"
-        "  vWorldPos = (uCamera.world * vec4(position, 1.0)).xyz;\n"
-        "}\n";
-
-    const std::string FRAGMENT_SHADER =
-        "#version 450\n\n"
-
-        "const int MAX_POINT_LIGHTS = 8;\n"
-        "const int MAX_SPOT_LIGHTS = 8;\n\n"
-
-        "layout (location = 0) in vec2 vTexCoord;\n"
-        "layout (location = 1) in vec3 vNormal;\n"
-        "layout (location = 2) in vec3 vWorldPos;\n"
-        "layout (location = 0) out vec4 fColor;\n\n"
-
-        "uniform sampler2D uImage;\n\n"
-
-        "layout (binding = 0, std140) uniform CameraData {\n"
-        "  mat4 mvp;\n"
-        "  mat4 normal;\n"
-        "  mat4 world;\n"
-        "  vec4 eye;\n"
-        "  int numPointLights;\n"
-        "  int numSpotLights;\n"
-        "} uCamera;\n\n"
-
-        "layout (binding = 1, std140) uniform Material {\n"
-        "  float specularIntensity;\n"
-        "  float specularPower;\n"
-        "} uMaterial;\n\n"
-
-        "layout (binding = 2, std140) uniform DirectionalLight {\n"        
-        "  vec4 color;\n"
-        "  vec4 direction;\n"
-        "  float ambientIntensity;\n"        
-        "  float diffuseIntensity;\n"             
-        "} uSun;\n\n"
-
-        "struct PointLight {\n"
-        "  vec4 color;\n"
-        "  vec4 position;\n"
-        "  float ambientIntensity;\n"
-        "  float diffuseIntensity;\n"
-        "  float attenuationConstant;\n"
-        "  float attenuationLinear;\n"
-        "  float attenuationExponential;\n"
-        "};\n\n"
-
-        "layout (binding = 3, std140) uniform PointLights {\n"
-        "  PointLight light[MAX_POINT_LIGHTS];\n"        
-        "} uPointLights;\n\n"
-
-        "struct SpotLight {\n"
-        "  vec4 color;\n"
-        "  vec4 position;\n"
-        "  vec4 direction;\n"
-        "  float ambientIntensity;\n"
-        "  float diffuseIntensity;\n"
-        "  float attenuationConstant;\n"
-        "  float attenuationLinear;\n"
-        "  float attenuationExponential;\n"
-        "  float cutoff;\n"
-        "};\n\n"
-
-        "layout (binding = 4, std140) uniform SpotLights {\n"
-        "  SpotLight light[MAX_SPOT_LIGHTS];\n"
-        "} uSpotLights;\n\n"
-
-        "vec3 calcLight(in vec3 color, in float ambientIntensity, in float diffuseIntensity, in vec3 direction, in vec3 normal) {\n"
-        "  vec3 ambientColor = color * ambientIntensity;\n"
-        "  float diffuseFactor = dot(normal, -direction);\n"
-        "  vec3 diffuseColor = vec3(0.0);\n"
-        "  vec3 specularColor = vec3(0.0);\n\n"
-        
-        "  if (diffuseFactor > 0.0) {\n"
-        "    diffuseColor = color * diffuseIntensity * diffuseFactor;\n\n"
-        
-        "    vec3 vertexToEye = normalize(uCamera.eye.xyz - vWorldPos);\n"
-        "    vec3 lightReflect = normalize(reflect(direction, normal));\n"
-        "    float specularFactor = dot(vertexToEye, lightReflect);\n\n"
-        
-        "    if (specularFactor > 0.0) {\n"
-        "      specularFactor = pow(specularFactor, uMaterial.specularPower);\n"
-        "      specularColor = color * uMaterial.specularIntensity * specularFactor;\n"
-        "    }\n"        
-        "  }\n\n"
-
-        "  return ambientColor + diffuseColor + specularColor;\n"
-        "}\n\n"
-
-        "vec3 calcDirectionalLight(in vec3 normal) {\n"
-        "  return calcLight(uSun.color.rgb, uSun.ambientIntensity, uSun.diffuseIntensity, uSun.direction.xyz, normal);\n"
-        "}\n\n"
-
-        "vec3 calcPointLight(\n"
-        "    in vec3 color, in vec3 position, \n"
-        "    in float ambientIntensity, in float diffuseIntensity, \n"
-        "    in float attenuationConstant, in float attenuationLinear, in float attenuationExponential, \n"
-        "    in vec3 normal) {\n\n"
-
-        "  vec3 lightDirection = vWorldPos - position;\n"
-        "  float distance = length(lightDirection);\n\n"
-
-        "  lightDirection = normalize(lightDirection);\n\n"
-
-        "  vec3 result = calcLight(color, ambientIntensity, diffuseIntensity, lightDirection, normal);\n"
-        "  float attenuation = attenuationConstant + attenuationLinear * distance + attenuationExponential * distance * distance;\n\n"
-
-        "  return result / attenuation;\n"
-        "}\n\n"
-
-        "vec3 calcSpotLight(\n"
-        "    in vec3 color, in vec3 position, in vec3 direction,\n"        
-        "    in float ambientIntensity, in float diffuseIntensity, \n"
-        "    in float attenuationConstant, in float attenuationLinear, in float attenuationExponential,\n"
-        "    in float cutoff, \n"
-        "    in vec3 normal) {\n\n"
-        
-        "  vec3 lightToPixel = normalize(vWorldPos - position);\n"
-        "  float spotFactor = dot(lightToPixel, direction);\n"
-
-        "  if (spotFactor > cutoff) {\n"
-        "    vec3 result = calcPointLight(color, position, ambientIntensity, diffuseIntensity, attenuationConstant, attenuationLinear, attenuationExponential, normal);\n"
-        
-        "    return result * (1.0 - (1.0 - spotFactor) * 1.0 / (1.0 - cutoff));\n"
-        "  } else {\n"
-        "    return vec3(0.0);\n"
-        "  }\n"
-        "}\n\n"
-
-        "void main() {\n"        
-        "  vec3 normal = normalize(vNormal);\n"    
-        "  vec3 totalLight = calcDirectionalLight(normal);\n\n"
-
-        "  for (int i = 0; i < uCamera.numPointLights; i++) {\n"
-        "    PointLight light = uPointLights.light[i];\n"
-
-        "    totalLight += calcPointLight(light.color.rgb, light.position.xyz, light.ambientIntensity, light.diffuseIntensity, light.attenuationConstant, light.attenuationLinear, light.attenuationExponential, normal);\n"
-        "  }\n\n"
-
-        "  for (int i = 0; i < uCamera.numSpotLights; i++) {\n"
-        "    SpotLight light = uSpotLights.light[i];\n"
-
-        "    totalLight += calcSpotLight(light.color.rgb, light.position.xyz, light.direction.xyz, light.ambientIntensity, light.diffuseIntensity, light.attenuationConstant, light.attenuationLinear, light.attenuationExponential, light.cutoff, normal);\n"
-        "  }\n\n"
-
-        "  fColor = texture(uImage, vTexCoord) * vec4(totalLight, 1.0);\n"
-        "}\n";
-
-    constexpr GLsizei MAX_INFO_LOG_LENGTH = 1024;
-
-    auto loadShader(GLenum type, const std::string& src) -> decltype(glCreateShader(type)) {
-        auto pSrc = src.c_str();
-        auto len = static_cast<GLint> (src.length());
-        auto shader = glCreateShader(type);
-
-        glShaderSource(shader, 1, &pSrc, &len);
-        glCompileShader(shader);
-
-        GLint success;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-
-        if (!success) {
-            auto infoLog = std::make_unique<GLchar[]> (MAX_INFO_LOG_LENGTH);
-
-            glGetShaderInfoLog(shader, MAX_INFO_LOG_LENGTH, nullptr, infoLog.get());
-
-            auto msg = std::stringstream();
-            msg << "Error compiling shader: " << infoLog.get();
-            msg << "\nSource: " << src;
-
-            throw std::runtime_error(msg.str());
-        }
-
-        return shader;
-    }
-
-    auto linkProgram(const std::vector<GLuint>& shaders) -> decltype(glCreateProgram()) {
-        auto program = glCreateProgram();
-
-        for (const auto& shader : shaders) {
-            glAttachShader(program, shader);
-        }
-
-        glLinkProgram(program);
-
-        for (const auto& shader : shaders) {
-            glDetachShader(program, shader);
-        }
-
-        GLint success;
-        glGetProgramiv(program, GL_LINK_STATUS, &success);
-
-        if (!success) {
-            auto infoLog = std::make_unique<GLchar[]> (MAX_INFO_LOG_LENGTH);
-
-            glGetProgramInfoLog(program, MAX_INFO_LOG_LENGTH, nullptr, infoLog.get());
-
-            auto msg = std::stringstream();
-            msg << "Error linking program: " << infoLog.get();
-            
-            throw std::runtime_error(msg.str());
-        }
-
-        return program;
-    }    
-
-    void GLAPIENTRY debugCallback(GLenum source, GLenum type, GLenum id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
-        if (GL_DEBUG_TYPE_ERROR == type) {
-            std::cerr << "[ERROR]: ";
-        } else {
-            std::cerr << "[DEBUG]: ";
-        }
-
-        std::cerr << message << std::endl;
-    }    
+    constexpr GLsizei INSTANCE_GRID = 32;
 }
 
 int main(int argc, char** argv) {
-    glfwSetErrorCallback(errorCallback);
-
-    if (GLFW_TRUE != glfwInit()) {
-        throw std::runtime_error("Failed to init GLFW!");
-    }
-
-    glfwDefaultWindowHints();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
-
-    auto window = glfwCreateWindow(640, 480, "Tutorial20", nullptr, nullptr);
+    auto pContext = gfx::Context::create(gfx::parseContextInfo(argc, argv, "Tutorial21"));
 
-    if (nullptr == window) {
-        throw std::runtime_error("Failed to create GLFW window!");
-    }
-
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);    
+    auto pDebugLogger = std::make_unique<gfx::DebugLogger> ();
 
-    GLenum glErr = glewInit();
-    if (glErr) {
-        auto msg = std::stringstream();
+    auto pProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_VERTEX_SHADER, "data/shaders/tutorial21/lighting.vert" },
+            { GL_FRAGMENT_SHADER, "data/shaders/tutorial21/lighting.frag" }
+        }));
 
-        msg << "Failed to init GLEW: " << glewGetErrorString(glErr);
+    auto pShaderWatcher = std::make_unique<gfx::ShaderWatcher> ();
+    pProgram->watch(*pShaderWatcher);
 
-        throw std::runtime_error(msg.str());
-    }
+    // --mesh path replaces the tetrahedron with an imported .obj or .glb.
+    auto meshPath = std::string();
 
-    glEnable(GL_DEBUG_OUTPUT);
-    glDebugMessageCallback(debugCallback, nullptr);
-
-    GLuint program;
-    {
-        auto shaders = std::vector<GLuint>();
-
-        shaders.push_back(loadShader(GL_VERTEX_SHADER, VERTEX_SHADER));
-        shaders.push_back(loadShader(GL_FRAGMENT_SHADER, FRAGMENT_SHADER));
-
-        program = linkProgram(shaders);
+    for (int i = 1; i + 1 < argc; i++) {
+        if (0 == std::strcmp("--mesh", argv[i])) {
+            meshPath = argv[++i];
+        }
     }
 
-    struct Vertex {
-        glm::vec3 position;
-        glm::vec2 texcoord;
-        glm::vec3 normal;
-    };
+    auto pThreadPool = std::make_unique<gfx::ThreadPool> ();
+    auto mesh = gfx::Mesh {};
 
-    auto points = std::vector<Vertex> ();
-    points.push_back({ glm::vec3(-1.0F, -1.0F, 0.5773F), glm::vec2(0.0F, 0.0F), glm::vec3(0.0F) });
-    points.push_back({ glm::vec3(0.0F, -1.0F, -1.15475F), glm::vec2(0.5F, 0.0F), glm::vec3(0.0F) });
-    points.push_back({ glm::vec3(1.0F, -1.0F, 0.5773F), glm::vec2(1.0F, 0.0F), glm::vec3(0.0F) });
-    points.push_back({ glm::vec3(0.0F, 1.0F, 0.0F), glm::vec2(0.5F, 1.0F), glm::vec3(0.0F) });
+    if (meshPath.empty()) {
+        mesh.vertices.push_back({ glm::vec3(-1.0F, -1.0F, 0.5773F), glm::vec2(0.0F, 0.0F), glm::vec3(0.0F) });
+        mesh.vertices.push_back({ glm::vec3(0.0F, -1.0F, -1.15475F), glm::vec2(0.5F, 0.0F), glm::vec3(0.0F) });
+        mesh.vertices.push_back({ glm::vec3(1.0F, -1.0F, 0.5773F), glm::vec2(1.0F, 0.0F), glm::vec3(0.0F) });
+        mesh.vertices.push_back({ glm::vec3(0.0F, 1.0F, 0.0F), glm::vec2(0.5F, 1.0F), glm::vec3(0.0F) });
 
-    auto indices = std::array<glm::u16, 12> ({
+        mesh.indices = {
             0, 3, 1,
             1, 3, 2,
             2, 3, 0,
             0, 1, 2
-        });
+        };
+    } else {
+        mesh = gfx::importMesh(meshPath, pThreadPool.get());
+    }
 
-    for (unsigned int i = 0; i < indices.size(); i += 3) {
-        auto idx0 = indices[i];
-        auto idx1 = indices[i + 1];
-        auto idx2 = indices[i + 2];
+    auto& points = mesh.vertices;
+    auto indexCount = static_cast<GLsizei> (mesh.indices.size());
+    auto indexType = mesh.getIndexType();
 
-        auto& p0 = points[idx0];
-        auto& p1 = points[idx1];
-        auto& p2 = points[idx2];
+    if (!mesh.hasNormals) {
+        auto streams = gfx::toVertexStreams(mesh);
 
-        auto v1 = p1.position - p0.position;
-        auto v2 = p2.position - p0.position;
-        auto normal = glm::normalize(glm::cross(v1, v2));
-        
-        p0.normal += normal;
-        p1.normal += normal;
-        p2.normal += normal;
+        gfx::computeNormals(streams, mesh.indices, pThreadPool.get());
+        gfx::storeVertexStreams(streams, mesh);
     }
 
-    for (auto& p : points) {
-        p.normal = glm::normalize(p.normal);
-    }
+    // Imported meshes come in authoring order; reorder for the post-transform cache, overdraw and fetch.
+    gfx::optimizeMesh(mesh);
+
+    // 16 bytes per vertex instead of 32; the vertex shaders decode positions with the offset and scale.
+    auto quantized = gfx::quantizeVertices(points);
+    auto quantizationError = gfx::getQuantizationError(points, quantized);
+
+    std::cout << "Vertices: " << points.size() * sizeof(gfx::Vertex) << " -> "
+        << quantized.vertices.size() * sizeof(gfx::PackedVertex) << " bytes, max error position "
+        << quantizationError.maxPosition << ", texcoord " << quantizationError.maxTexcoord << ", normal "
+        << quantizationError.maxNormalAngle << " deg (mean " << quantizationError.meanNormalAngle << " deg)" << std::endl;
 
     GLuint vbo;
     glCreateBuffers(1, &vbo);
-    glNamedBufferData(vbo, points.size() * sizeof(Vertex), points.data(), GL_STATIC_DRAW);
+    glNamedBufferData(vbo, quantized.vertices.size() * sizeof(gfx::PackedVertex), quantized.vertices.data(), GL_STATIC_DRAW);
 
     GLuint ibo;
     glCreateBuffers(1, &ibo);
-    glNamedBufferData(ibo, sizeof(indices), indices.data(), GL_STATIC_DRAW);
+    {
+        auto packedIndices = mesh.packIndices();
+        glNamedBufferData(ibo, packedIndices.size(), packedIndices.data(), GL_STATIC_DRAW);
+    }
+
+    // Tightly packed copy of the quantized positions for the depth pre-pass, so it fetches 8 bytes per vertex instead of 16.
+    GLuint positionVbo;
+    {
+        auto positions = std::vector<std::uint16_t> ();
+
+        for (const auto& p : quantized.vertices) {
+            positions.insert(positions.end(), { p.position[0], p.position[1], p.position[2], 0 });
+        }
+
+        glCreateBuffers(1, &positionVbo);
+        glNamedBufferData(positionVbo, positions.size() * sizeof(std::uint16_t), positions.data(), GL_STATIC_DRAW);
+    }
 
     struct UBOCameraT {
         glm::mat4 mvp;
@@ -390,12 +165,7 @@ int main(int argc, char** argv) {
         glm::float32 attenuationConstant;
         glm::float32 attenuationLinear;
         glm::float32 attenuationExponential;
-    };
-
-    const GLsizei MAX_POINT_LIGHTS = 8;
-
-    struct UBOPointLightsT {
-        PointLightT lights[MAX_POINT_LIGHTS];
+        glm::float32 padding[3];
     };
 
     struct alignas(sizeof(glm::vec4)) SpotLightT {
@@ -408,12 +178,20 @@ int main(int argc, char** argv) {
         glm::float32 attenuationLinear;
         glm::float32 attenuationExponential;
         glm::float32 cutoff;
+        glm::float32 padding[2];
     };
 
-    const GLsizei MAX_SPOT_LIGHTS = 8;
+    // Compact TRS: rotation quaternion (xyzw) and translation with a uniform scale in w.
+    struct alignas(sizeof(glm::vec4)) InstanceT {
+        glm::vec4 rotation;
+        glm::vec4 translationScale;
+    };
 
-    struct UBOSpotLightsT {
-        SpotLightT lights[MAX_SPOT_LIGHTS];
+    struct alignas(sizeof(glm::vec4)) LightAnimationT {
+        glm::vec4 origin;
+        glm::vec4 amplitude;
+        glm::vec4 frequency;
+        glm::vec4 phase;
     };
 
     GLint uboAlignment;
@@ -422,15 +200,11 @@ int main(int argc, char** argv) {
     auto alignedSizeofUBOCameraT = gfx::util::alignUp(sizeof(UBOCameraT), uboAlignment);
     auto alignedSizeofUBOMaterialT = gfx::util::alignUp(sizeof(UBOMaterialT), uboAlignment);
     auto alignedSizeofUBOSunT = gfx::util::alignUp(sizeof(UBOSunT), uboAlignment);
-    auto alignedSizeofUBOPointLightsT = gfx::util::alignUp(sizeof(UBOPointLightsT), uboAlignment);
-    auto alignedSizeofUBOSpotLightsT = gfx::util::alignUp(sizeof(UBOSpotLightsT), uboAlignment);
-    auto totalSizeofUBO = alignedSizeofUBOCameraT + alignedSizeofUBOSunT + alignedSizeofUBOMaterialT + alignedSizeofUBOPointLightsT + alignedSizeofUBOSpotLightsT;
+    auto totalSizeofUBO = alignedSizeofUBOCameraT + alignedSizeofUBOSunT + alignedSizeofUBOMaterialT;
 
     auto alignedOffsetofUBOCamera = static_cast<GLintptr> (0);
     auto alignedOffsetofUBOMaterial = alignedOffsetofUBOCamera + alignedSizeofUBOCameraT;
     auto alignedOffsetofUBOSun = alignedOffsetofUBOMaterial + alignedSizeofUBOMaterialT;
-    auto alignedOffsetofUBOPointLights = alignedOffsetofUBOSun + alignedSizeofUBOSunT;
-    auto alignedOffsetofUBOSpotLights = alignedOffsetofUBOPointLights + alignedSizeofUBOPointLightsT;
 
     GLuint ubo;
     glCreateBuffers(1, &ubo);
@@ -439,31 +213,128 @@ int main(int argc, char** argv) {
     UBOCameraT * pCameraData;
     UBOMaterialT * pMaterialData;
     UBOSunT * pSunData;
-    UBOPointLightsT * pPointLightsData;
-    UBOSpotLightsT * pSpotLightsData;
     {
         auto pBase = reinterpret_cast<GLchar * > (glMapNamedBufferRange(ubo, 0, totalSizeofUBO, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));        
 
         pCameraData = reinterpret_cast<UBOCameraT *> (pBase + alignedOffsetofUBOCamera);
         pMaterialData = reinterpret_cast<UBOMaterialT *> (pBase + alignedOffsetofUBOMaterial);
         pSunData = reinterpret_cast<UBOSunT *> (pBase + alignedOffsetofUBOSun);
-        pPointLightsData = reinterpret_cast<UBOPointLightsT *> (pBase + alignedOffsetofUBOPointLights);
-        pSpotLightsData = reinterpret_cast<UBOSpotLightsT *> (pBase + alignedOffsetofUBOSpotLights);
     }
+
+    auto pPointLights = std::make_unique<gfx::StorageBuffer<PointLightT>> (2);
+    auto pPointLightAnimations = std::make_unique<gfx::StorageBuffer<LightAnimationT>> (2);
+    auto pSpotLights = std::make_unique<gfx::StorageBuffer<SpotLightT>> (1);
+    auto pInstances = std::make_unique<gfx::StorageBuffer<InstanceT>> (1);
+    {
+        auto light = PointLightT {};
+        light.ambientIntensity = 0.0F;
+        light.diffuseIntensity = 0.2F;
+        light.color = glm::vec4(1.0F, 0.5F, 0.0F, 1.0F);
+        light.attenuationConstant = 0.1F;
+        light.attenuationLinear = 0.0F;
+        light.attenuationExponential = 0.0F;
+
+        pPointLights->write(0, light);
+        pPointLightAnimations->write(0, {
+            glm::vec4(3.0F, 1.0F, 0.0F, 0.0F),
+            glm::vec4(0.0F, 0.0F, 20.0F, 0.0F),
+            glm::vec4(0.0F, 0.0F, 1.0F, 0.0F),
+            glm::vec4(0.0F) });
+
+        light.diffuseIntensity = 0.3F;
+        light.color = glm::vec4(0.0F, 0.5F, 1.0F, 1.0F);
+        light.attenuationConstant = 1.0F;
+        light.attenuationLinear = 0.1F;
+
+        pPointLights->write(1, light);
+        pPointLightAnimations->write(1, {
+            glm::vec4(7.0F, 1.0F, 0.0F, 0.0F),
+            glm::vec4(0.0F, 0.0F, 20.0F, 0.0F),
+            glm::vec4(0.0F, 0.0F, 1.0F, 0.0F),
+            glm::vec4(0.0F, 0.0F, glm::radians(90.0F), 0.0F) });
+    }
+
+    auto animateLight = [](const LightAnimationT& animation, float t) {
+        return animation.origin + animation.amplitude * glm::sin(animation.frequency * t + animation.phase);
+    };
+
+    auto pAnimateLightsProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_COMPUTE_SHADER, "data/shaders/tutorial21/animate_lights.comp" }
+        }));
+
+    pAnimateLightsProgram->watch(*pShaderWatcher);
+
+    auto pGBufferProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_VERTEX_SHADER, "data/shaders/tutorial21/lighting.vert" },
+            { GL_FRAGMENT_SHADER, "data/shaders/tutorial21/gbuffer.frag" }
+        }));
+
+    auto pDeferredLightingProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_VERTEX_SHADER, "data/shaders/tutorial21/fullscreen.vert" },
+            { GL_FRAGMENT_SHADER, "data/shaders/tutorial21/deferred_lighting.frag" }
+        }));
+
+    pGBufferProgram->watch(*pShaderWatcher);
+    pDeferredLightingProgram->watch(*pShaderWatcher);
+
+    // Vertex-only program: with no fragment shader attached the pre-pass writes depth and nothing else.
+    auto pDepthProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_VERTEX_SHADER, "data/shaders/tutorial21/depth.vert" }
+        }));
+
+    auto pOverdrawProgram = std::make_unique<gfx::ShaderProgram> (std::vector<gfx::ShaderStage> ({
+            { GL_VERTEX_SHADER, "data/shaders/tutorial21/lighting.vert" },
+            { GL_FRAGMENT_SHADER, "data/shaders/tutorial21/overdraw.frag" }
+        }));
+
+    pDepthProgram->watch(*pShaderWatcher);
+    pOverdrawProgram->watch(*pShaderWatcher);
+
+    auto framebufferWidth = pContext->getWidth();
+    auto framebufferHeight = pContext->getHeight();
+
+    // G-buffer: albedo + specular intensity (RGBA8), octahedral normal + log2 specular power (RGB10_A2), depth.
+    GLuint gbufferAlbedoSpecular;
+    glCreateTextures(GL_TEXTURE_2D, 1, &gbufferAlbedoSpecular);
+    glTextureStorage2D(gbufferAlbedoSpecular, 1, GL_RGBA8, framebufferWidth, framebufferHeight);
+
+    GLuint gbufferNormalPower;
+    glCreateTextures(GL_TEXTURE_2D, 1, &gbufferNormalPower);
+    glTextureStorage2D(gbufferNormalPower, 1, GL_RGB10_A2, framebufferWidth, framebufferHeight);
+
+    GLuint gbufferDepth;
+    glCreateTextures(GL_TEXTURE_2D, 1, &gbufferDepth);
+    glTextureStorage2D(gbufferDepth, 1, GL_DEPTH_COMPONENT32F, framebufferWidth, framebufferHeight);
+
+    GLuint gbuffer;
+    glCreateFramebuffers(1, &gbuffer);
+    glNamedFramebufferTexture(gbuffer, GL_COLOR_ATTACHMENT0, gbufferAlbedoSpecular, 0);
+    glNamedFramebufferTexture(gbuffer, GL_COLOR_ATTACHMENT1, gbufferNormalPower, 0);
+    glNamedFramebufferTexture(gbuffer, GL_DEPTH_ATTACHMENT, gbufferDepth, 0);
+    {
+        auto drawBuffers = std::array<GLenum, 2> ({ GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 });
+
+        glNamedFramebufferDrawBuffers(gbuffer, static_cast<GLsizei> (drawBuffers.size()), drawBuffers.data());
+    }
+
+    if (GL_FRAMEBUFFER_COMPLETE != glCheckNamedFramebufferStatus(gbuffer, GL_FRAMEBUFFER)) {
+        throw std::runtime_error("G-buffer framebuffer is incomplete!");
+    }
+
+    GLuint fullscreenVao;
+    glCreateVertexArrays(1, &fullscreenVao);
     
     GLuint vao;
     glCreateVertexArrays(1, &vao);
-    glEnableVertexArrayAttrib(vao, 0);
-    glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribBinding(vao, 0, 0);
-    glEnableVertexArrayAttrib(vao, 1);
-    glVertexArrayAttribFormat(vao, 1, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float));
-    glVertexArrayAttribBinding(vao, 1, 0);
-    glEnableVertexArrayAttrib(vao, 2);
-    glVertexArrayAttribFormat(vao, 2, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float));
-    glVertexArrayAttribBinding(vao, 2, 0);
+    gfx::setPackedVertexFormat(vao);
+
+    GLuint depthVao;
+    glCreateVertexArrays(1, &depthVao);
+    glEnableVertexArrayAttrib(depthVao, 0);
+    glVertexArrayAttribFormat(depthVao, 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0);
+    glVertexArrayAttribBinding(depthVao, 0, 0);
     
-    auto uImage = glGetUniformLocation(program, "uImage");
+    auto uImage = glGetUniformLocation(pProgram->getHandle(), "uImage");
 
     float t = 0.0F;    
 
@@ -473,118 +344,387 @@ int main(int argc, char** argv) {
     struct UserDataT {
         std::unique_ptr<gfx::Camera> pCamera;
         float ambientIntensity;
+        bool animateLightsOnGpu;
+        bool deferred;
+        bool depthPrepass;
+        bool showOverdraw;
+        bool instanced;
     } userData;
 
     userData.pCamera = std::make_unique<gfx::Camera>();
     userData.ambientIntensity = 0.1F;
+    userData.animateLightsOnGpu = true;
+    userData.deferred = false;
+    userData.depthPrepass = false;
+    userData.showOverdraw = false;
+    userData.instanced = false;
+
+    auto window = pContext->getWindow();
 
-    glfwSetWindowUserPointer(window, &userData);
-    glfwSetKeyCallback(window, [](auto pWindow, auto key, auto scancode, auto action, auto mods) {
-        auto pUserData = reinterpret_cast<UserDataT * > (glfwGetWindowUserPointer(pWindow));
+    if (nullptr != window) {
+        glfwSetWindowUserPointer(window, &userData);
+        glfwSetKeyCallback(window, [](auto pWindow, auto key, auto scancode, auto action, auto mods) {
+            auto pUserData = reinterpret_cast<UserDataT * > (glfwGetWindowUserPointer(pWindow));
 
-        pUserData->pCamera->onKeyboard(key, action);
+            pUserData->pCamera->onKeyboard(key, action);
         
-        switch (key) {            
-            case GLFW_KEY_ESCAPE:
-                glfwSetWindowShouldClose(pWindow, GLFW_TRUE);
-                break;
-            case GLFW_KEY_A:
-                pUserData->ambientIntensity += 0.05F;
-                break;
-            case GLFW_KEY_S:
-                pUserData->ambientIntensity -= 0.05F;
-                break;
-        }
-    });
+            switch (key) {            
+                case GLFW_KEY_ESCAPE:
+                    glfwSetWindowShouldClose(pWindow, GLFW_TRUE);
+                    break;
+                case GLFW_KEY_A:
+                    pUserData->ambientIntensity += 0.05F;
+                    break;
+                case GLFW_KEY_S:
+                    pUserData->ambientIntensity -= 0.05F;
+                    break;
+                case GLFW_KEY_C:
+                    if (GLFW_PRESS == action) {
+                        pUserData->animateLightsOnGpu = !pUserData->animateLightsOnGpu;
+                    }
+                    break;
+                case GLFW_KEY_D:
+                    if (GLFW_PRESS == action) {
+                        pUserData->deferred = !pUserData->deferred;
+                    }
+                    break;
+                case GLFW_KEY_P:
+                    if (GLFW_PRESS == action) {
+                        pUserData->depthPrepass = !pUserData->depthPrepass;
+                    }
+                    break;
+                case GLFW_KEY_O:
+                    if (GLFW_PRESS == action) {
+                        pUserData->showOverdraw = !pUserData->showOverdraw;
+                    }
+                    break;
+                case GLFW_KEY_I:
+                    if (GLFW_PRESS == action) {
+                        pUserData->instanced = !pUserData->instanced;
+                    }
+                    break;
+            }
+        });
+    }
 
     auto pTexture = std::make_unique<gfx::Texture> (GL_TEXTURE_2D, "data/test.png");
 
-    while (!glfwWindowShouldClose(window)) {
-        auto trTrans = glm::translate(glm::mat4(1.0F), glm::vec3(0.0F, 0.0F, -5.0F));
-        auto trRotate = glm::rotate(glm::mat4(1.0F), t, glm::vec3(0.0F, 1.0F, 0.0F));        
-        auto trProj = glm::perspective(glm::radians(90.0F), 4.0F / 3.0F, 0.1F, 100.0F);
-        auto trModel = trTrans * trRotate;
-        auto trView = userData.pCamera->getViewMatrix();
-        auto trMv = trView * trModel;
-        auto trNormal = glm::transpose(glm::inverse(trMv));        
-
-        pCameraData->mvp = trProj * trMv;
-        pCameraData->normal = glm::transpose(glm::inverse(trMv));
-        pCameraData->world = trMv;
-        pCameraData->eye = glm::vec4(userData.pCamera->getPosition(), 1.0F);
-        pCameraData->numPointLights = 2;
-        pCameraData->numSpotLights = 1;
-
-        pMaterialData->specularIntensity = 0.0F;
-        pMaterialData->specularPower = 32.0F;
-
-        pSunData->color = glm::vec4(1.0F);
-        pSunData->direction = glm::vec4(1.0F, 0.0F, 0.0F, 1.0F);
-        pSunData->ambientIntensity = userData.ambientIntensity;
-        pSunData->diffuseIntensity = 0.1F;
-        
-        pPointLightsData->lights[0].ambientIntensity = 0.0F;
-        pPointLightsData->lights[0].diffuseIntensity = 0.2F;
-        pPointLightsData->lights[0].color = glm::vec4(1.0F, 0.5F, 0.0F, 1.0F);
-        pPointLightsData->lights[0].position = glm::vec4(3.0F, 1.0F, static_cast<float> (20.0F * std::sin(t)), 0.0F);
-        pPointLightsData->lights[0].attenuationConstant = 0.1F;
-        pPointLightsData->lights[0].attenuationLinear = 0.0F;
-        pPointLightsData->lights[0].attenuationExponential = 0.0F;
-
-        pPointLightsData->lights[1].ambientIntensity = 0.0F;
-        pPointLightsData->lights[1].diffuseIntensity = 0.3F;
-        pPointLightsData->lights[1].color = glm::vec4(0.0F, 0.5F, 1.0F, 1.0F);
-        pPointLightsData->lights[1].position = glm::vec4(7.0F, 1.0F, static_cast<float> (20.0F * std::cos(t)), 0.0F);
-        pPointLightsData->lights[1].attenuationConstant = 1.0F;
-        pPointLightsData->lights[1].attenuationLinear = 0.1F;
-        pPointLightsData->lights[1].attenuationExponential = 0.0F;
-
-        pSpotLightsData->lights[0].ambientIntensity = 0.0F;
-        pSpotLightsData->lights[0].diffuseIntensity = 0.9F;
-        pSpotLightsData->lights[0].color = glm::vec4(1.0F, 1.0F, 1.0F, 1.0F);
-        pSpotLightsData->lights[0].position = glm::vec4(userData.pCamera->getPosition(), 1.0F);
-        pSpotLightsData->lights[0].direction = glm::normalize(glm::vec4(userData.pCamera->getTarget(), 1.0F));
-        pSpotLightsData->lights[0].cutoff = static_cast<float> (glm::cos(glm::radians(45.0 + t)));
-        pSpotLightsData->lights[0].attenuationConstant = 1.0F;
-        pSpotLightsData->lights[0].attenuationLinear = 0.1F;
-        pSpotLightsData->lights[0].attenuationExponential = 0.0F;            
-
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
-        glUseProgram(program);        
-        glUniform1i(uImage, 0);
-        glBindBufferRange(GL_UNIFORM_BUFFER, 0, ubo, alignedOffsetofUBOCamera, alignedSizeofUBOCameraT);
-        glBindBufferRange(GL_UNIFORM_BUFFER, 1, ubo, alignedOffsetofUBOMaterial, alignedSizeofUBOMaterialT);
-        glBindBufferRange(GL_UNIFORM_BUFFER, 2, ubo, alignedOffsetofUBOSun, alignedSizeofUBOSunT);
-        glBindBufferRange(GL_UNIFORM_BUFFER, 3, ubo, alignedOffsetofUBOPointLights, alignedSizeofUBOPointLightsT);
-        glBindBufferRange(GL_UNIFORM_BUFFER, 4, ubo, alignedOffsetofUBOSpotLights, alignedSizeofUBOSpotLightsT);
+    auto pGpuProfiler = std::make_unique<gfx::GpuProfiler> ();
+    auto pStateCache = std::make_unique<gfx::StateCache> ();
+    auto pShadedSamples = std::make_unique<gfx::GpuQuery> (GL_SAMPLES_PASSED);
+    auto pTransforms = std::make_unique<gfx::TransformHierarchy> ();
+    auto model = pTransforms->addRoot(glm::vec3(0.0F, 0.0F, -5.0F));
+    auto frame = 0U;
+
+    while (!pContext->shouldClose()) {
+        GFX_CPU_ZONE("frame");
+
+        pGpuProfiler->beginFrame();
+
+        for (const auto& change : pShaderWatcher->poll()) {
+            pProgram->reload(change);
+            pAnimateLightsProgram->reload(change);
+            pGBufferProgram->reload(change);
+            pDeferredLightingProgram->reload(change);
+            pDepthProgram->reload(change);
+            pOverdrawProgram->reload(change);
+        }
+
+        auto swapped = false;
+        swapped |= pAnimateLightsProgram->update();
+        swapped |= pGBufferProgram->update();
+        swapped |= pDeferredLightingProgram->update();
+        swapped |= pDepthProgram->update();
+        swapped |= pOverdrawProgram->update();
+
+        if (pProgram->update()) {
+            uImage = glGetUniformLocation(pProgram->getHandle(), "uImage");
+            swapped = true;
+        }
+
+        // A swapped-in program may reuse the name of the one it replaced, along with its cached uniforms.
+        if (swapped) {
+            pStateCache->invalidate();
+        }
+
+        auto trProj = glm::mat4(1.0F);
+        auto trMv = glm::mat4(1.0F);
+
+        {
+            GFX_CPU_ZONE("matrix setup");
+
+            pTransforms->setRotation(model, glm::angleAxis(t, glm::vec3(0.0F, 1.0F, 0.0F)));
+            pTransforms->update();
+
+            trProj = glm::perspective(glm::radians(90.0F), static_cast<float> (pContext->getWidth()) / pContext->getHeight(), 0.1F, 100.0F);
+            auto trModel = pTransforms->getWorld(model);
+            auto trView = userData.pCamera->getViewMatrix();
+            trMv = trView * trModel;
+        }
+
+        {
+            GFX_CPU_ZONE("uniform writes");
+
+            pCameraData->mvp = trProj * trMv;
+            gfx::computeNormalMatrices(&trMv, 1, &pCameraData->normal, sizeof(glm::mat4), gfx::NormalMatrixLayout::MAT4);
+            pCameraData->world = trMv;
+            pCameraData->eye = glm::vec4(userData.pCamera->getPosition(), 1.0F);
+            pCameraData->numPointLights = pPointLights->size();
+            pCameraData->numSpotLights = pSpotLights->size();
+
+            pMaterialData->specularIntensity = 0.0F;
+            pMaterialData->specularPower = 32.0F;
+
+            pSunData->color = glm::vec4(1.0F);
+            pSunData->direction = glm::vec4(1.0F, 0.0F, 0.0F, 1.0F);
+            pSunData->ambientIntensity = userData.ambientIntensity;
+            pSunData->diffuseIntensity = 0.1F;
+
+            // Only lights whose contents actually changed are uploaded by flush().
+            if (!userData.animateLightsOnGpu) {
+                for (GLsizei i = 0; i < pPointLights->size(); i++) {
+                    auto light = (*pPointLights)[i];
+                    light.position = animateLight((*pPointLightAnimations)[i], t);
+
+                    pPointLights->write(i, light);
+                }
+            }
+
+            {
+                auto light = SpotLightT {};
+                light.ambientIntensity = 0.0F;
+                light.diffuseIntensity = 0.9F;
+                light.color = glm::vec4(1.0F, 1.0F, 1.0F, 1.0F);
+                light.position = glm::vec4(userData.pCamera->getPosition(), 1.0F);
+                light.direction = glm::normalize(glm::vec4(userData.pCamera->getTarget(), 1.0F));
+                light.cutoff = static_cast<float> (glm::cos(glm::radians(45.0 + t)));
+                light.attenuationConstant = 1.0F;
+                light.attenuationLinear = 0.1F;
+                light.attenuationExponential = 0.0F;
+
+                pSpotLights->write(0, light);
+            }
+
+            // Every copy spins at its own rate, so the whole instance buffer is streamed each frame.
+            if (userData.instanced) {
+                pInstances->resize(INSTANCE_GRID * INSTANCE_GRID);
+
+                for (GLsizei i = 0; i < pInstances->size(); i++) {
+                    auto rotation = glm::angleAxis(t * (1.0F + (i % 7) * 0.25F), glm::vec3(0.0F, 1.0F, 0.0F));
+                    auto x = static_cast<float> (i % INSTANCE_GRID - INSTANCE_GRID / 2) * 2.5F;
+                    auto z = static_cast<float> (i / INSTANCE_GRID) * -2.5F;
+
+                    pInstances->write(i, { glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w), glm::vec4(x, 0.0F, z, 0.5F) });
+                }
+            } else {
+                pInstances->resize(1);
+                pInstances->write(0, { glm::vec4(0.0F, 0.0F, 0.0F, 1.0F), glm::vec4(0.0F, 0.0F, 0.0F, 1.0F) });
+            }
+
+            pPointLights->flush();
+            pPointLightAnimations->flush();
+            pSpotLights->flush();
+            pInstances->flush();
+        }
+
+        if (userData.animateLightsOnGpu) {
+            GFX_CPU_ZONE("animate lights");
+            GFX_GPU_SCOPE(*pGpuProfiler, "animate lights");
+
+            pStateCache->useProgram(pAnimateLightsProgram->getHandle());
+            pStateCache->uniform1f(0, t);
+            pStateCache->uniform1i(1, pPointLights->size());
+            pPointLights->bind(0, *pStateCache);
+            pPointLightAnimations->bind(2, *pStateCache);
+            glDispatchCompute((pPointLights->size() + 63) / 64, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        if (userData.deferred) {
+            GFX_CPU_ZONE("draw deferred");
+
+            pGpuProfiler->beginScope("geometry");
+
+            pStateCache->bindFramebuffer(GL_FRAMEBUFFER, gbuffer);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            pStateCache->useProgram(pGBufferProgram->getHandle());
+            pStateCache->uniform3fv(0, glm::value_ptr(quantized.positionOffset));
+            pStateCache->uniform3fv(1, glm::value_ptr(quantized.positionScale));
+            pStateCache->bindBufferRange(GL_UNIFORM_BUFFER, 0, ubo, alignedOffsetofUBOCamera, alignedSizeofUBOCameraT);
+            pStateCache->bindBufferRange(GL_UNIFORM_BUFFER, 1, ubo, alignedOffsetofUBOMaterial, alignedSizeofUBOMaterialT);
+
+            pStateCache->bindTextureUnit(0, pTexture->getHandle());
+
+            pStateCache->bindVertexArray(vao);
+            pStateCache->bindVertexBuffer(0, vbo, 0, sizeof(gfx::PackedVertex));
+            pStateCache->bindElementBuffer(ibo);
+            pInstances->bind(3, *pStateCache);
+            glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, 0, pInstances->size());
 
-        pTexture->bind(0);        
+            pGpuProfiler->endScope();
+            pGpuProfiler->beginScope("lighting");
 
-        glBindVertexArray(vao);
-        glBindVertexBuffer(0, vbo, 0, sizeof(Vertex));
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-        glDrawElements(GL_TRIANGLES, 12, GL_UNSIGNED_SHORT, 0);
+            pStateCache->bindFramebuffer(GL_FRAMEBUFFER, pContext->getFramebuffer());
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glDisable(GL_DEPTH_TEST);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+            pStateCache->useProgram(pDeferredLightingProgram->getHandle());
+            glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(glm::inverse(trProj)));
+            pStateCache->bindBufferRange(GL_UNIFORM_BUFFER, 0, ubo, alignedOffsetofUBOCamera, alignedSizeofUBOCameraT);
+            pStateCache->bindBufferRange(GL_UNIFORM_BUFFER, 2, ubo, alignedOffsetofUBOSun, alignedSizeofUBOSunT);
+            pPointLights->bind(0, *pStateCache);
+            pSpotLights->bind(1, *pStateCache);
+            pStateCache->bindTextureUnit(0, gbufferAlbedoSpecular);
+            pStateCache->bindTextureUnit(1, gbufferNormalPower);
+            pStateCache->bindTextureUnit(2, gbufferDepth);
+
+            pStateCache->bindVertexArray(fullscreenVao);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+
+            glEnable(GL_DEPTH_TEST);
+
+            pGpuProfiler->endScope();
+        } else {
+            GFX_CPU_ZONE("draw forward");
+
+            pGpuProfiler->beginScope("clear");
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            pGpuProfiler->endScope();
+
+            if (userData.depthPrepass) {
+                pGpuProfiler->beginScope("depth pre-pass");
+
+                glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                pStateCache->useProgram(pDepthProgram->getHandle());
+                pStateCache->uniform3fv(0, glm::value_ptr(quantized.positionOffset));
+                pStateCache->uniform3fv(1, glm::value_ptr(quantized.positionScale));
+                pStateCache->bindBufferRange(GL_UNIFORM_BUFFER, 0, ubo, alignedOffsetofUBOCamera, alignedSizeofUBOCameraT);
+                pStateCache->bindVertexArray(depthVao);
+                pStateCache->bindVertexBuffer(0, positionVbo, 0, 4 * sizeof(std::uint16_t));
+                pStateCache->bindElementBuffer(ibo);
+                pInstances->bind(3, *pStateCache);
+                glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, 0, pInstances->size());
+                glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+                // Depth is final now; only the front-most fragment of each pixel passes GL_EQUAL.
+                glDepthFunc(GL_EQUAL);
+                glDepthMask(GL_FALSE);
+
+                pGpuProfiler->endScope();
+            }
+
+            if (userData.showOverdraw) {
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_ONE, GL_ONE);
+            }
+
+            pGpuProfiler->beginScope("shading");
+            pShadedSamples->begin();
+
+            if (userData.showOverdraw) {
+                pStateCache->useProgram(pOverdrawProgram->getHandle());
+            } else {
+                pStateCache->useProgram(pProgram->getHandle());
+                pStateCache->uniform1i(uImage, 0);
+            }
+
+            pStateCache->uniform3fv(0, glm::value_ptr(quantized.positionOffset));
+            pStateCache->uniform3fv(1, glm::value_ptr(quantized.positionScale));
+
+            pStateCache->bindBufferRange(GL_UNIFORM_BUFFER, 0, ubo, alignedOffsetofUBOCamera, alignedSizeofUBOCameraT);
+            pStateCache->bindBufferRange(GL_UNIFORM_BUFFER, 1, ubo, alignedOffsetofUBOMaterial, alignedSizeofUBOMaterialT);
+            pStateCache->bindBufferRange(GL_UNIFORM_BUFFER, 2, ubo, alignedOffsetofUBOSun, alignedSizeofUBOSunT);
+            pPointLights->bind(0, *pStateCache);
+            pSpotLights->bind(1, *pStateCache);
+
+            pStateCache->bindTextureUnit(0, pTexture->getHandle());
+
+            pStateCache->bindVertexArray(vao);
+            pStateCache->bindVertexBuffer(0, vbo, 0, sizeof(gfx::PackedVertex));
+            pStateCache->bindElementBuffer(ibo);
+            pInstances->bind(3, *pStateCache);
+            glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, 0, pInstances->size());
+
+            pShadedSamples->end();
+            pGpuProfiler->endScope();
+
+            glDisable(GL_BLEND);
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_TRUE);
+        }
+
+        if (0 == ++frame % 60) {
+            auto title = std::stringstream();
+            title.precision(3);
+            title << std::fixed << "Tutorial21 - " << (userData.deferred ? "deferred" : "forward");
+
+            for (const auto& stats : pGpuProfiler->getStats()) {
+                if (stats.active) {
+                    title << " | " << stats.name << " " << stats.averageMs << " ms";
+                }
+            }
+
+            if (userData.instanced) {
+                title << " | " << pInstances->size() << " instances";
+            }
+
+            if (!userData.deferred) {
+                title << " | " << static_cast<unsigned long> (pShadedSamples->getAverage()) << " shaded samples";
+            }
+
+            pContext->setTitle(title.str());
+        }
+
+        pGpuProfiler->beginScope("present");
+        pContext->swapBuffers();
+        pGpuProfiler->endFrame();
+
+        pContext->pollEvents();
 
         userData.pCamera->update(0.1F);
 
         t += 0.01F;
     }
 
+    pGpuProfiler->report(std::cout);
+
+    std::cout << "State cache: " << pStateCache->getStats().issued << " calls issued, "
+        << pStateCache->getStats().skipped << " skipped" << std::endl;
+
     pTexture = nullptr;
+    pGpuProfiler = nullptr;
+    pStateCache = nullptr;
+    pShadedSamples = nullptr;
+    pTransforms = nullptr;
+    pPointLights = nullptr;
+    pPointLightAnimations = nullptr;
+    pSpotLights = nullptr;
+    pInstances = nullptr;
     
     glDeleteVertexArrays(1, &vao);    
     glDeleteBuffers(1, &vbo);
     glDeleteBuffers(1, &ibo);
+    glDeleteBuffers(1, &positionVbo);
+    glDeleteVertexArrays(1, &depthVao);
     glDeleteBuffers(1, &ubo);
-    glDeleteProgram(program);
-
-    glfwDestroyWindow(window);
-
-    glfwTerminate();
+    glDeleteVertexArrays(1, &fullscreenVao);
+    glDeleteFramebuffers(1, &gbuffer);
+    glDeleteTextures(1, &gbufferAlbedoSpecular);
+    glDeleteTextures(1, &gbufferNormalPower);
+    glDeleteTextures(1, &gbufferDepth);
+
+    pShaderWatcher = nullptr;
+    pProgram = nullptr;
+    pAnimateLightsProgram = nullptr;
+    pGBufferProgram = nullptr;
+    pDeferredLightingProgram = nullptr;
+    pDepthProgram = nullptr;
+    pOverdrawProgram = nullptr;
+    pThreadPool = nullptr;
+
+    pDebugLogger = nullptr;
+    pContext = nullptr;
 
     return 0;
 }
@@ -5,6 +5,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "cpu_profiler.hpp"
+
 namespace gfx {
     class Camera {
         glm::vec3 _pos, _target, _up;
@@ -83,6 +85,8 @@ namespace gfx {
     }
 
     inline void Camera::update(float stepSize) noexcept {
+        GFX_CPU_ZONE("Camera::update");
+
         auto step = glm::vec3(0.0F);
 
         if (_upPressed) {
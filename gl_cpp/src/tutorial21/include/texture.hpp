@@ -28,6 +28,8 @@ namespace gfx {
 
         Texture& operator= (Texture&& other) noexcept;
 
+        GLuint getHandle() const noexcept;
+
         void bind(GLuint unit) noexcept;
     };
 
@@ -79,6 +81,10 @@ namespace gfx {
         return *this;
     }
 
+    GLuint Texture::getHandle() const noexcept {
+        return _handle;
+    }
+
     void Texture::bind(GLuint unit) noexcept {
         glBindTextureUnit(unit, _handle);
     }
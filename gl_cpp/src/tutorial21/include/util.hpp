@@ -1,11 +0,0 @@
-#pragma once
-
-#include <GL/glew.h>
-
-namespace gfx {
-    namespace util {
-        constexpr GLsizei alignUp(GLsizei a, GLsizei b) {
-            return (a + b - 1) / b * b;
-        }
-    }
-}
\ No newline at end of file